@@ -0,0 +1,130 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# decoder for the deferred log messages (FEAT_DEFERRED_LOG).
+#
+# The firmware prints deferred log records as lines like:
+#     #D10004a3c 10000100 00000100
+# The first number is the address of the format string (the lowest two bits
+# are the number of arguments), the following numbers are the arguments.
+#
+# usage:
+#     dlog_decode.py table <firmware.elf> <table file>
+#         extract the format strings from the elf file into a table file.
+#
+#     dlog_decode.py decode <table file> [log file]
+#         replace the records in the log (stdin if no log file given) with
+#         the formatted messages.
+
+import re
+import struct
+import sys
+
+LINE_PREFIX = '#D'
+SYMBOL_PREFIX = 'dlog_fmt'
+NUM_ARGS_MASK = 3
+
+
+def read_elf_strings(fileName):
+    # minimal ELF32 little endian reader: find all symbols that start with
+    # SYMBOL_PREFIX and read the zero terminated string they point to.
+    res = {}
+    with open(fileName, mode='rb') as file:
+        elf = file.read()
+    if elf[0:4] != b'\x7fELF' or elf[4] != 1:
+        raise ValueError(fileName + ' is not a 32 bit elf file')
+    e_shoff = struct.unpack_from('<I', elf, 0x20)[0]
+    e_shentsize, e_shnum = struct.unpack_from('<HH', elf, 0x2e)
+    sections = []
+    for i in range(e_shnum):
+        sections.append(struct.unpack_from('<IIIIIIIIII', elf, e_shoff + i * e_shentsize))
+    for sec in sections:
+        # sh_type 2 = SYMTAB
+        if sec[1] != 2:
+            continue
+        strtab = sections[sec[6]]
+        for off in range(sec[4], sec[4] + sec[5], 16):
+            st_name, st_value, st_size, st_info, st_other, st_shndx = struct.unpack_from('<IIIBBH', elf, off)
+            end = elf.index(b'\x00', strtab[4] + st_name)
+            name = elf[strtab[4] + st_name:end].decode('utf-8', 'replace')
+            if not name.startswith(SYMBOL_PREFIX) or st_shndx >= len(sections):
+                continue
+            data_sec = sections[st_shndx]
+            pos = data_sec[4] + (st_value - data_sec[3])
+            end = elf.index(b'\x00', pos)
+            res[st_value] = elf[pos:end].decode('utf-8', 'replace')
+    return res
+
+
+def write_table(strings, fileName):
+    with open(fileName, 'w') as f:
+        for address in sorted(strings.keys()):
+            f.write('%08x %s\n' % (address, strings[address].encode('unicode_escape').decode('ascii')))
+
+
+def read_table(fileName):
+    res = {}
+    with open(fileName, 'r') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if len(line) < 10:
+                continue
+            res[int(line[0:8], 16)] = line[9:].encode('ascii').decode('unicode_escape')
+    return res
+
+
+def c_format(fmt, args):
+    # the firmware uses %ld / %lx for 32 bit values
+    values = list(args)
+    out = ''
+    pos = 0
+    for m in re.finditer(r'%([-0 #+]*\d*)(l?)([diuxXc%])', fmt):
+        out = out + fmt[pos:m.start()]
+        pos = m.end()
+        if m.group(3) == '%':
+            out = out + '%'
+            continue
+        val = values.pop(0) if values else 0
+        if m.group(3) in 'di' and val >= 0x80000000:
+            val = val - 0x100000000
+        if m.group(3) in 'diu':
+            out = out + ('%' + m.group(1) + 'd') % val
+        elif m.group(3) == 'c':
+            out = out + chr(val & 0xff)
+        else:
+            out = out + ('%' + m.group(1) + m.group(3)) % val
+    return out + fmt[pos:]
+
+
+def decode_line(line, table):
+    idx = line.find(LINE_PREFIX)
+    if idx < 0:
+        return line
+    fields = line[idx + len(LINE_PREFIX):].split()
+    if len(fields) < 1:
+        return line
+    if fields[0] == 'dropped':
+        return line[:idx] + '(' + ' '.join(fields[1:]) + ' log messages dropped)'
+    try:
+        header = int(fields[0], 16)
+        args = [int(x, 16) for x in fields[1:]]
+    except ValueError:
+        return line
+    address = header & ~NUM_ARGS_MASK
+    if address not in table:
+        return line + ' (unknown format string)'
+    return line[:idx] + c_format(table[address], args)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) == 4 and sys.argv[1] == 'table':
+        write_table(read_elf_strings(sys.argv[2]), sys.argv[3])
+    elif len(sys.argv) in (3, 4) and sys.argv[1] == 'decode':
+        table = read_table(sys.argv[2])
+        src = open(sys.argv[3], 'r') if len(sys.argv) == 4 else sys.stdin
+        for l in src:
+            print(decode_line(l.rstrip('\r\n'), table))
+    else:
+        print('usage: ' + sys.argv[0] + ' table <firmware.elf> <table file>')
+        print('       ' + sys.argv[0] + ' decode <table file> [log file]')
+        sys.exit(1)
@@ -0,0 +1,450 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "agent_expr.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+// op codes (gdb/common/ax.def)
+#define OP_ADD            0x02
+#define OP_SUB            0x03
+#define OP_MUL            0x04
+#define OP_DIV_SIGNED     0x05
+#define OP_DIV_UNSIGNED   0x06
+#define OP_REM_SIGNED     0x07
+#define OP_REM_UNSIGNED   0x08
+#define OP_LSH            0x09
+#define OP_RSH_SIGNED     0x0a
+#define OP_RSH_UNSIGNED   0x0b
+#define OP_LOG_NOT        0x0e
+#define OP_BIT_AND        0x0f
+#define OP_BIT_OR         0x10
+#define OP_BIT_XOR        0x11
+#define OP_BIT_NOT        0x12
+#define OP_EQUAL          0x13
+#define OP_LESS_SIGNED    0x14
+#define OP_LESS_UNSIGNED  0x15
+#define OP_EXT            0x16
+#define OP_REF8           0x17
+#define OP_REF16          0x18
+#define OP_REF32          0x19
+#define OP_REF64          0x1a
+#define OP_IF_GOTO        0x20
+#define OP_GOTO           0x21
+#define OP_CONST8         0x22
+#define OP_CONST16        0x23
+#define OP_CONST32        0x24
+#define OP_CONST64        0x25
+#define OP_REG            0x26
+#define OP_END            0x27
+#define OP_DUP            0x28
+#define OP_POP            0x29
+#define OP_ZERO_EXT       0x2a
+#define OP_SWAP           0x2b
+#define OP_PICK           0x32
+#define OP_ROT            0x33
+
+#define PHASE_EXECUTE     0
+#define PHASE_READ_MEMORY 1
+#define PHASE_READ_REG    2
+
+static Result fail(agent_expr_data_typ* const state, const char* reason)
+{
+    debug_error("agent expression: %s at %ld !", reason, state->pos);
+    return ERR_WRONG_VALUE;
+}
+
+static bool push(agent_expr_data_typ* const state, int64_t value)
+{
+    if(AGENT_EXPR_STACK_SIZE == state->sp)
+    {
+        return false;
+    }
+    state->stack[state->sp] = value;
+    state->sp++;
+    return true;
+}
+
+static bool pop(agent_expr_data_typ* const state, int64_t* value)
+{
+    if(0 == state->sp)
+    {
+        return false;
+    }
+    state->sp--;
+    *value = state->stack[state->sp];
+    return true;
+}
+
+// operands are big endian
+static bool get_operand(agent_expr_data_typ* const state, const uint8_t* code, uint32_t length, uint32_t num_bytes, uint64_t* value)
+{
+    uint32_t i;
+    if((state->pos + num_bytes) > length)
+    {
+        return false;
+    }
+    *value = 0;
+    for(i = 0; i < num_bytes; i++)
+    {
+        *value = (*value << 8) | code[state->pos];
+        state->pos++;
+    }
+    return true;
+}
+
+static Result binary_op(agent_expr_data_typ* const state, uint8_t op)
+{
+    int64_t a;
+    int64_t b;
+    int64_t res;
+
+    if((false == pop(state, &b)) || (false == pop(state, &a)))
+    {
+        return fail(state, "stack underflow");
+    }
+    switch(op)
+    {
+    case OP_ADD: res = (int64_t)((uint64_t)a + (uint64_t)b); break;
+    case OP_SUB: res = (int64_t)((uint64_t)a - (uint64_t)b); break;
+    case OP_MUL: res = (int64_t)((uint64_t)a * (uint64_t)b); break;
+    case OP_LSH: res = (64 > b) ? (int64_t)((uint64_t)a << b) : 0; break;
+    case OP_RSH_SIGNED: res = a >> ((64 > b) ? b : 63); break;
+    case OP_RSH_UNSIGNED: res = (64 > b) ? (int64_t)((uint64_t)a >> b) : 0; break;
+    case OP_BIT_AND: res = a & b; break;
+    case OP_BIT_OR: res = a | b; break;
+    case OP_BIT_XOR: res = a ^ b; break;
+    case OP_EQUAL: res = (a == b) ? 1 : 0; break;
+    case OP_LESS_SIGNED: res = (a < b) ? 1 : 0; break;
+    case OP_LESS_UNSIGNED: res = ((uint64_t)a < (uint64_t)b) ? 1 : 0; break;
+    default:
+        // division
+        if(0 == b)
+        {
+            return fail(state, "division by zero");
+        }
+        switch(op)
+        {
+        case OP_DIV_SIGNED: res = a / b; break;
+        case OP_DIV_UNSIGNED: res = (int64_t)((uint64_t)a / (uint64_t)b); break;
+        case OP_REM_SIGNED: res = a % b; break;
+        default: res = (int64_t)((uint64_t)a % (uint64_t)b); break;
+        }
+        break;
+    }
+    push(state, res);
+    return RESULT_OK;
+}
+
+static Result start_memory_read(agent_expr_data_typ* const state, uint32_t size)
+{
+    int64_t address;
+    if(false == pop(state, &address))
+    {
+        return fail(state, "stack underflow");
+    }
+    state->address = (uint32_t)address;
+    state->size = size;
+    state->word = 0;
+    state->act_state.first_call = true;
+    state->phase = PHASE_READ_MEMORY;
+    return ERR_NOT_COMPLETED;
+}
+
+static Result read_memory(agent_expr_data_typ* const state)
+{
+    uint32_t first = state->address & ~3u;
+    uint32_t last = (state->address + state->size - 1) & ~3u;
+    uint32_t value;
+    uint64_t res = 0;
+    uint32_t i;
+    Result r;
+
+    r = act_read_register(&(state->act_state), (volatile uint32_t*)(first + state->word * 4), &value);
+    if(ERR_NOT_COMPLETED == r)
+    {
+        return r;
+    }
+    state->act_state.first_call = true;
+    if(RESULT_OK != r)
+    {
+        return r;
+    }
+    for(i = 0; i < 4; i++)
+    {
+        state->bytes[state->word * 4 + i] = (uint8_t)(value >> (8 * i));
+    }
+    state->word++;
+    if((first + state->word * 4) <= last)
+    {
+        return ERR_NOT_COMPLETED;
+    }
+    // little endian
+    for(i = state->size; i > 0; i--)
+    {
+        res = (res << 8) | state->bytes[(state->address & 3) + i - 1];
+    }
+    state->phase = PHASE_EXECUTE;
+    if(false == push(state, (int64_t)res))
+    {
+        return fail(state, "stack overflow");
+    }
+    return RESULT_OK;
+}
+
+static Result execute(agent_expr_data_typ* const state, const uint8_t* code, uint32_t length)
+{
+    uint64_t operand;
+    int64_t a;
+    int64_t b;
+    int64_t c;
+    uint8_t op;
+
+    for(;;)
+    {
+        if(state->pos >= length)
+        {
+            return fail(state, "no end");
+        }
+        state->num_ops++;
+        if(AGENT_EXPR_MAX_OPS < state->num_ops)
+        {
+            return fail(state, "too many operations");
+        }
+        op = code[state->pos];
+        state->pos++;
+
+        switch(op)
+        {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV_SIGNED:
+        case OP_DIV_UNSIGNED:
+        case OP_REM_SIGNED:
+        case OP_REM_UNSIGNED:
+        case OP_LSH:
+        case OP_RSH_SIGNED:
+        case OP_RSH_UNSIGNED:
+        case OP_BIT_AND:
+        case OP_BIT_OR:
+        case OP_BIT_XOR:
+        case OP_EQUAL:
+        case OP_LESS_SIGNED:
+        case OP_LESS_UNSIGNED:
+            if(RESULT_OK != binary_op(state, op))
+            {
+                return ERR_WRONG_VALUE;
+            }
+            break;
+
+        case OP_LOG_NOT:
+        case OP_BIT_NOT:
+            if(false == pop(state, &a))
+            {
+                return fail(state, "stack underflow");
+            }
+            push(state, (OP_LOG_NOT == op) ? ((0 == a) ? 1 : 0) : ~a);
+            break;
+
+        case OP_EXT:
+        case OP_ZERO_EXT:
+            if((false == get_operand(state, code, length, 1, &operand)) || (false == pop(state, &a)))
+            {
+                return fail(state, "missing value");
+            }
+            if((0 < operand) && (64 > operand))
+            {
+                if(OP_EXT == op)
+                {
+                    a = (int64_t)((uint64_t)a << (64 - operand)) >> (64 - operand);
+                }
+                else
+                {
+                    a = (int64_t)((uint64_t)a & ((1ull << operand) - 1));
+                }
+            }
+            push(state, a);
+            break;
+
+        case OP_REF8:  return start_memory_read(state, 1);
+        case OP_REF16: return start_memory_read(state, 2);
+        case OP_REF32: return start_memory_read(state, 4);
+        case OP_REF64: return start_memory_read(state, 8);
+
+        case OP_IF_GOTO:
+        case OP_GOTO:
+            if(false == get_operand(state, code, length, 2, &operand))
+            {
+                return fail(state, "missing offset");
+            }
+            if(OP_IF_GOTO == op)
+            {
+                if(false == pop(state, &a))
+                {
+                    return fail(state, "stack underflow");
+                }
+                if(0 == a)
+                {
+                    break;
+                }
+            }
+            state->pos = (uint32_t)operand;
+            break;
+
+        case OP_CONST8:
+        case OP_CONST16:
+        case OP_CONST32:
+        case OP_CONST64:
+            if(false == get_operand(state, code, length, 1u << (op - OP_CONST8), &operand))
+            {
+                return fail(state, "missing constant");
+            }
+            if(false == push(state, (int64_t)operand))
+            {
+                return fail(state, "stack overflow");
+            }
+            break;
+
+        case OP_REG:
+            if(false == get_operand(state, code, length, 2, &operand))
+            {
+                return fail(state, "missing register");
+            }
+            if(REGSEL_PC >= operand)
+            {
+                state->address = (uint32_t)operand;
+            }
+            else if(GDB_REG_XPSR == operand)
+            {
+                state->address = REGSEL_XPSR;
+            }
+            else
+            {
+                return fail(state, "unknown register");
+            }
+            state->reg_state.first_call = true;
+            state->phase = PHASE_READ_REG;
+            return ERR_NOT_COMPLETED;
+
+        case OP_END:
+            if(false == pop(state, &(state->result)))
+            {
+                return fail(state, "empty stack");
+            }
+            return RESULT_OK;
+
+        case OP_DUP:
+        case OP_PICK:
+            operand = 0;
+            if((OP_PICK == op) && (false == get_operand(state, code, length, 1, &operand)))
+            {
+                return fail(state, "missing operand");
+            }
+            if(operand >= state->sp)
+            {
+                return fail(state, "stack underflow");
+            }
+            if(false == push(state, state->stack[state->sp - 1 - operand]))
+            {
+                return fail(state, "stack overflow");
+            }
+            break;
+
+        case OP_POP:
+            if(false == pop(state, &a))
+            {
+                return fail(state, "stack underflow");
+            }
+            break;
+
+        case OP_SWAP:
+            if((false == pop(state, &b)) || (false == pop(state, &a)))
+            {
+                return fail(state, "stack underflow");
+            }
+            push(state, b);
+            push(state, a);
+            break;
+
+        case OP_ROT:
+            // a b c => c a b
+            if((false == pop(state, &c)) || (false == pop(state, &b)) || (false == pop(state, &a)))
+            {
+                return fail(state, "stack underflow");
+            }
+            push(state, c);
+            push(state, a);
+            push(state, b);
+            break;
+
+        default:
+            debug_error("agent expression: op 0x%02x not supported !", op);
+            return ERR_WRONG_VALUE;
+        }
+    }
+}
+
+Result agent_expr_run(agent_expr_data_typ* const state, const uint8_t* code, uint32_t length)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == code))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->pos = 0;
+        state->sp = 0;
+        state->num_ops = 0;
+        state->phase = PHASE_EXECUTE;
+    }
+
+    if(PHASE_READ_MEMORY == state->phase)
+    {
+        res = read_memory(state);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+    }
+
+    if(PHASE_READ_REG == state->phase)
+    {
+        uint32_t value;
+        res = core_register_read(&(state->reg_state), state->address, &value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_EXECUTE;
+        if(false == push(state, (int64_t)value))
+        {
+            return fail(state, "stack overflow");
+        }
+    }
+
+    if(PHASE_EXECUTE == state->phase)
+    {
+        return execute(state, code, length);
+    }
+
+    return ERR_WRONG_STATE;
+}
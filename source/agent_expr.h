@@ -0,0 +1,57 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_AGENT_EXPR_H_
+#define SOURCE_AGENT_EXPR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "cortex_m_debug.h"
+
+// Interpreter for GDB agent expressions (bytecode, see "Agent Expressions" in
+// the GDB manual). The values are 64 bit. Registers ("reg n", GDB register
+// numbers of the M-profile target description) and memory ("ref8" ..
+// "ref64") are read from the halted core.
+//
+// Not supported: floating point, trace state variables (getv, setv, tracev)
+// and printf.
+
+#define AGENT_EXPR_STACK_SIZE  32
+// limit for expressions with loops
+#define AGENT_EXPR_MAX_OPS     1000
+
+typedef struct {
+    bool first_call;
+    uint32_t pos;        // in the bytecode
+    uint32_t sp;         // number of values on the stack
+    uint32_t num_ops;
+    uint32_t phase;
+    uint32_t address;    // of the memory read
+    uint32_t size;       // of the memory read
+    uint32_t word;       // words read so far
+    uint8_t bytes[12];   // read words
+    int64_t stack[AGENT_EXPR_STACK_SIZE];
+    int64_t result;      // top of the stack at "end"
+    activity_data_typ act_state;
+    core_register_data_typ reg_state;
+} agent_expr_data_typ;
+
+// runs the expression. state->result is the value it returned.
+Result agent_expr_run(agent_expr_data_typ* const state, const uint8_t* code, uint32_t length);
+
+#endif /* SOURCE_AGENT_EXPR_H_ */
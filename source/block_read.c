@@ -0,0 +1,104 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "block_read.h"
+#include "probe_api/steps.h"
+#include "time_critical.h"
+
+void block_read_start(block_read_typ* const rd, uint32_t address, uint32_t num_words)
+{
+    rd->address = address & ~3u;
+    rd->addresses = NULL;
+    rd->num_words = num_words;
+    rd->requested = 0;
+    rd->done = 0;
+}
+
+void block_read_start_list(block_read_typ* const rd, const uint32_t* addresses, uint32_t num_words)
+{
+    rd->address = 0;
+    rd->addresses = addresses;
+    rd->num_words = num_words;
+    rd->requested = 0;
+    rd->done = 0;
+}
+
+bool block_read_is_done(const block_read_typ* const rd)
+{
+    return (rd->num_words == rd->done);
+}
+
+void block_read_stop(block_read_typ* const rd)
+{
+    rd->num_words = rd->requested;
+}
+
+Result TIME_CRITICAL(block_read_next)(block_read_typ* const rd, uint32_t* value)
+{
+    Result res;
+    uint32_t address;
+
+    if(rd->num_words == rd->done)
+    {
+        return ERR_WRONG_STATE;
+    }
+    // keep some reads in flight, so that the SWD interface does not wait for us
+    if((rd->requested < rd->num_words) && ((rd->requested - rd->done) < BLOCK_READ_IN_FLIGHT))
+    {
+        if(NULL == rd->addresses)
+        {
+            address = rd->address + rd->requested * 4;
+        }
+        else
+        {
+            address = rd->addresses[rd->requested];
+        }
+        res = step_read_ap((volatile uint32_t*)address);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        rd->requested++;
+        return ERR_NOT_COMPLETED;
+    }
+    res = step_get_Result_data(value);
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    rd->done++;
+    return RESULT_OK;
+}
+
+Result TIME_CRITICAL(block_read_all)(block_read_typ* const rd, uint32_t* words)
+{
+    Result res;
+
+    if(rd->num_words == rd->done)
+    {
+        return RESULT_OK;
+    }
+    res = block_read_next(rd, &(words[rd->done]));
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    if(rd->num_words == rd->done)
+    {
+        return RESULT_OK;
+    }
+    return ERR_NOT_COMPLETED;
+}
@@ -0,0 +1,55 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_BLOCK_READ_H_
+#define SOURCE_BLOCK_READ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+
+// Pipelined reads of target words over the MEM-AP.
+//
+// Each SWD read has to wait for the answer of the target. So several reads
+// are queued (BLOCK_READ_IN_FLIGHT) before the first result is collected,
+// and the SWD interface does not have to wait for the probe. The words are
+// either consecutive (block_read_start()) or taken from a list of addresses
+// (block_read_start_list()). The list must stay valid until all words are read.
+
+// reads that are started before the first result is collected
+#define BLOCK_READ_IN_FLIGHT  4
+
+typedef struct {
+    uint32_t address;
+    const uint32_t* addresses;
+    uint32_t num_words;
+    uint32_t requested;
+    uint32_t done;
+} block_read_typ;
+
+// num_words words starting at address (rounded down to a word)
+void block_read_start(block_read_typ* const rd, uint32_t address, uint32_t num_words);
+// one word from each address of the list
+void block_read_start_list(block_read_typ* const rd, const uint32_t* addresses, uint32_t num_words);
+// queues the next read or collects the next result.
+// RESULT_OK: *value is the word number rd->done - 1. ERR_NOT_COMPLETED: call again.
+Result block_read_next(block_read_typ* const rd, uint32_t* value);
+// reads all words into words[]. RESULT_OK when all words are there.
+Result block_read_all(block_read_typ* const rd, uint32_t* words);
+bool block_read_is_done(const block_read_typ* const rd);
+// no more reads are started, the reads in flight still need to be collected
+void block_read_stop(block_read_typ* const rd);
+
+#endif /* SOURCE_BLOCK_READ_H_ */
@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "block_write.h"
+#include "probe_api/steps.h"
+#include "time_critical.h"
+
+void block_write_start(block_write_typ* const wr, uint32_t address, const uint32_t* words, uint32_t num_words)
+{
+    wr->address = address & ~3u;
+    wr->words = words;
+    wr->fill = 0;
+    wr->num_words = num_words;
+    wr->done = 0;
+}
+
+void block_write_start_fill(block_write_typ* const wr, uint32_t address, uint32_t value, uint32_t num_words)
+{
+    wr->address = address & ~3u;
+    wr->words = NULL;
+    wr->fill = value;
+    wr->num_words = num_words;
+    wr->done = 0;
+}
+
+Result TIME_CRITICAL(block_write_all)(block_write_typ* const wr)
+{
+    Result res;
+    uint32_t i;
+    uint32_t value;
+
+    for(i = 0; (i < BLOCK_WRITE_PER_CALL) && (wr->done < wr->num_words); i++)
+    {
+        value = (NULL == wr->words) ? wr->fill : wr->words[wr->done];
+        res = step_write_ap((volatile uint32_t*)(wr->address + wr->done * 4), value);
+        if(RESULT_OK != res)
+        {
+            // the words queued so far stay queued
+            return res;
+        }
+        wr->done++;
+    }
+    if(wr->done < wr->num_words)
+    {
+        return ERR_NOT_COMPLETED;
+    }
+    // all writes are queued, wait until they are done
+    return step_get_Result_OK();
+}
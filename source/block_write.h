@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_BLOCK_WRITE_H_
+#define SOURCE_BLOCK_WRITE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+
+// Pipelined writes of consecutive target words over the MEM-AP.
+//
+// A write has no answer that the probe needs. So several writes are queued
+// in one call (BLOCK_WRITE_PER_CALL) and the results are only collected once,
+// after the last word (step_get_Result_OK()). The words must stay valid until
+// all of them are written. block_write_start_fill() writes the same value to
+// every word (e.g. clears RAM).
+
+// writes that are queued in one call
+#define BLOCK_WRITE_PER_CALL  4
+
+typedef struct {
+    uint32_t address;
+    const uint32_t* words;
+    uint32_t fill;  // used if words is NULL
+    uint32_t num_words;
+    uint32_t done;  // words queued
+} block_write_typ;
+
+// num_words words starting at address (rounded down to a word)
+void block_write_start(block_write_typ* const wr, uint32_t address, const uint32_t* words, uint32_t num_words);
+// num_words words starting at address, all of them are value
+void block_write_start_fill(block_write_typ* const wr, uint32_t address, uint32_t value, uint32_t num_words);
+// queues the next writes. RESULT_OK when all words are written.
+Result block_write_all(block_write_typ* const wr);
+
+#endif /* SOURCE_BLOCK_WRITE_H_ */
@@ -24,5 +24,43 @@ Result handle_target_reply_vFlashErase(action_data_typ* const action);
 Result handle_target_reply_vFlashWrite(action_data_typ* const action);
 // reading some special regions of the memory might be target specific
 Result handle_target_reply_read_memory(action_data_typ* const action);
+// monitor reset: the caches in the probe are cleared, then the reset of the cortex-m code
+Result handle_target_monitor_reset(action_data_typ* const action);
+#ifdef FEAT_SWD_TUNING
+// monitor swd_tune
+Result handle_swd_tune(action_data_typ* const action);
+#endif
+#ifdef FEAT_RANGE_STEP
+// vCont;r
+Result handle_range_step(action_data_typ* const action);
+#endif
+#ifdef FEAT_TRACEPOINTS
+// QTStart and QTStop
+Result handle_trace_start(action_data_typ* const action);
+Result handle_trace_stop(action_data_typ* const action);
+#endif
+#ifdef FEAT_DUAL_CORE
+// both cores as GDB threads
+Result handle_dual_core_halt(action_data_typ* const action);
+Result handle_dual_core_resume(action_data_typ* const action);
+Result handle_dual_core_set_thread(action_data_typ* const action);
+#endif
+#ifdef FEAT_RTOS
+// FreeRTOS tasks as GDB threads
+Result handle_rtos_thread_registers(action_data_typ* const action);
+#endif
+#ifdef FEAT_LIVE_WATCH
+// one sample of the live watch
+Result handle_live_watch_sample(action_data_typ* const action);
+#endif
+#ifdef FEAT_RTT
+// move data of the RTT channels
+Result handle_rtt_poll(action_data_typ* const action);
+#endif
+#if (defined FEAT_SEMIHOSTING) || (defined FEAT_TRACEPOINTS) || (defined FEAT_COND_BREAKPOINTS) \
+ || (defined FEAT_DUAL_CORE) || (defined FEAT_RTOS) || (defined FEAT_LIVE_WATCH) || (defined FEAT_RTT)
+// did the core halt? semihosting call, then tracepoint, then breakpoint condition
+Result handle_target_halted(action_data_typ* const action);
+#endif
 
 #endif /* SOURCE_CFG_TARGET_ACTIONS_H_ */
@@ -16,25 +16,89 @@
 #ifndef CFG_TARGET_SPECIFIC_ACTIONS_H_
 #define CFG_TARGET_SPECIFIC_ACTIONS_H_
 
-#define TARGET_SPECIFIC_ACTIONS_ENUM \
-    GDB_CMD_MON_HALT,                \
-    GDB_CMD_MON_RESET,               \
-    GDB_MONITOR_REG,                 \
-    HALT_CORTEX_M_CPU,               \
-    RELEASE_CORTEX_M_CPU,
-
-#define TARGET_SPECIFIC_ACTION_HANDLERS                     \
-    handle_monitor_halt,       /* GDB_CMD_MON_HALT */       \
-    handle_monitor_reset,      /* GDB_CMD_MON_RESET */      \
-    handle_monitor_reg,        /* GDB_MONITOR_REG, */       \
-    handle_cortex_m_halt,      /* HALT_CORTEX_M_CPU */      \
-    handle_cortex_m_release,   /* RELEASE_CORTEX_M_CPU */
-
-#define TARGET_SPECIFIC_ACTION_NAMES \
-    "monitor_halt",                  \
-    "monitor_reset",                 \
-    "monitor_reg",                   \
-    "cortex-m_halt",                 \
-    "cortex-m_release",
+// one X(enum, handler, name) entry per action
+
+#ifdef FEAT_SWD_TUNING
+#define SWD_TUNING_ACTIONS(X)                                                          \
+    X(SWD_TUNE,              handle_swd_tune,              "swd_tune")
+#else
+#define SWD_TUNING_ACTIONS(X)
+#endif
+
+#ifdef FEAT_RANGE_STEP
+#define RANGE_STEP_ACTIONS(X)                                                          \
+    X(RANGE_STEP,            handle_range_step,            "range_step")
+#else
+#define RANGE_STEP_ACTIONS(X)
+#endif
+
+#ifdef FEAT_TRACEPOINTS
+#define TRACE_ACTIONS(X)                                                               \
+    X(TRACE_START,           handle_trace_start,           "trace_start")              \
+    X(TRACE_STOP,            handle_trace_stop,            "trace_stop")
+#else
+#define TRACE_ACTIONS(X)
+#endif
+
+#ifdef FEAT_DUAL_CORE
+#define DUAL_CORE_ACTIONS(X)                                                           \
+    X(DUAL_CORE_HALT,        handle_dual_core_halt,        "dual_core_halt")           \
+    X(DUAL_CORE_RESUME,      handle_dual_core_resume,      "dual_core_resume")         \
+    X(DUAL_CORE_SET_THREAD,  handle_dual_core_set_thread,  "dual_core_set_thread")
+#else
+#define DUAL_CORE_ACTIONS(X)
+#endif
+
+#ifdef FEAT_RTOS
+#define RTOS_ACTIONS(X)                                                                \
+    X(RTOS_THREAD_REGISTERS, handle_rtos_thread_registers, "rtos_thread_registers")
+#else
+#define RTOS_ACTIONS(X)
+#endif
+
+#ifdef FEAT_LIVE_WATCH
+#define LIVE_WATCH_ACTIONS(X)                                                          \
+    X(LIVE_WATCH_SAMPLE,     handle_live_watch_sample,     "live_watch_sample")
+#else
+#define LIVE_WATCH_ACTIONS(X)
+#endif
+
+#ifdef FEAT_RTT
+#define RTT_ACTIONS(X)                                                                 \
+    X(RTT_POLL,              handle_rtt_poll,              "rtt_poll")
+#else
+#define RTT_ACTIONS(X)
+#endif
+
+#if (defined FEAT_SEMIHOSTING) || (defined FEAT_TRACEPOINTS) || (defined FEAT_COND_BREAKPOINTS) \
+ || (defined FEAT_DUAL_CORE) || (defined FEAT_RTOS) || (defined FEAT_LIVE_WATCH) || (defined FEAT_RTT)
+#define HALTED_ACTIONS(X)                                                              \
+    X(TARGET_HALTED,         handle_target_halted,         "target_halted")
+#else
+#define HALTED_ACTIONS(X)
+#endif
+
+#define TARGET_SPECIFIC_ACTIONS(X)                                                     \
+    X(GDB_CMD_MON_HALT,      handle_monitor_halt,          "monitor_halt")             \
+    X(GDB_CMD_MON_RESET,     handle_target_monitor_reset,  "monitor_reset")            \
+    X(GDB_MONITOR_REG,       handle_monitor_reg,           "monitor_reg")              \
+    X(HALT_CORTEX_M_CPU,     handle_cortex_m_halt,         "cortex-m_halt")            \
+    X(RELEASE_CORTEX_M_CPU,  handle_cortex_m_release,      "cortex-m_release")         \
+    SWD_TUNING_ACTIONS(X)                                                              \
+    RANGE_STEP_ACTIONS(X)                                                              \
+    TRACE_ACTIONS(X)                                                                   \
+    DUAL_CORE_ACTIONS(X)                                                               \
+    RTOS_ACTIONS(X)                                                                    \
+    LIVE_WATCH_ACTIONS(X)                                                              \
+    RTT_ACTIONS(X)                                                                     \
+    HALTED_ACTIONS(X)
+
+#define TARGET_ACTION_ENUM(action, handler, name)      action,
+#define TARGET_ACTION_HANDLER(action, handler, name)   handler,
+#define TARGET_ACTION_NAME(action, handler, name)      name,
+
+#define TARGET_SPECIFIC_ACTIONS_ENUM      TARGET_SPECIFIC_ACTIONS(TARGET_ACTION_ENUM)
+#define TARGET_SPECIFIC_ACTION_HANDLERS   TARGET_SPECIFIC_ACTIONS(TARGET_ACTION_HANDLER)
+#define TARGET_SPECIFIC_ACTION_NAMES      TARGET_SPECIFIC_ACTIONS(TARGET_ACTION_NAME)
 
 #endif /* CFG_TARGET_SPECIFIC_ACTIONS_H_ */
@@ -0,0 +1,238 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "cond_breakpoint.h"
+#include "cortex_m_debug.h"
+#include "text_util.h"
+#include "probe_api/debug_log.h"
+
+#define PHASE_LOOKUP        0
+#define PHASE_EVALUATE      1
+#define PHASE_STEP_OVER     2
+
+typedef struct {
+    bool used;
+    uint32_t address;
+    uint32_t num_conditions;
+    uint32_t start[COND_BP_MAX_CONDITIONS];
+    uint32_t length[COND_BP_MAX_CONDITIONS];
+    uint8_t code[COND_BP_MAX_CODE_BYTES];
+} breakpoint_typ;
+
+static breakpoint_typ breakpoints[COND_BP_MAX_BREAKPOINTS];
+static uint32_t num_evaluations;
+static uint32_t num_resumes;
+
+void cond_bp_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < COND_BP_MAX_BREAKPOINTS; i++)
+    {
+        breakpoints[i].used = false;
+    }
+    num_evaluations = 0;
+    num_resumes = 0;
+}
+
+static uint32_t find(uint32_t address)
+{
+    uint32_t i;
+    for(i = 0; i < COND_BP_MAX_BREAKPOINTS; i++)
+    {
+        if((true == breakpoints[i].used) && ((address & ~1u) == (breakpoints[i].address & ~1u)))
+        {
+            return i;
+        }
+    }
+    return COND_BP_MAX_BREAKPOINTS;
+}
+
+// parses ";X<len>,<hex bytes>" entries. Stops at the end or at ";cmds".
+static Result parse_conditions(breakpoint_typ* const bp, const char* conditions)
+{
+    const char* c = conditions;
+    uint32_t used = 0;
+    uint32_t len;
+    uint32_t i;
+
+    bp->num_conditions = 0;
+    while((NULL != c) && (';' == c[0]) && ('X' == c[1]))
+    {
+        if(COND_BP_MAX_CONDITIONS == bp->num_conditions)
+        {
+            debug_error("breakpoint 0x%08lx: too many conditions !", bp->address);
+            return ERR_WRONG_VALUE;
+        }
+        c = c + 2;
+        if(   (false == text_parse_hex(&c, &len)) || (',' != *c)
+           || (0 == len) || ((used + len) > COND_BP_MAX_CODE_BYTES) )
+        {
+            debug_error("breakpoint 0x%08lx: invalid condition !", bp->address);
+            return ERR_WRONG_VALUE;
+        }
+        c++;
+        bp->start[bp->num_conditions] = used;
+        bp->length[bp->num_conditions] = len;
+        for(i = 0; i < len; i++)
+        {
+            if(false == text_parse_hex_byte(c, &(bp->code[used])))
+            {
+                debug_error("breakpoint 0x%08lx: invalid condition !", bp->address);
+                return ERR_WRONG_VALUE;
+            }
+            used++;
+            c = c + 2;
+        }
+        bp->num_conditions++;
+    }
+    return RESULT_OK;
+}
+
+Result cond_bp_set(uint32_t address, const char* conditions)
+{
+    uint32_t idx;
+    Result res;
+
+    cond_bp_remove(address);
+    if((NULL == conditions) || (';' != conditions[0]) || ('X' != conditions[1]))
+    {
+        // no conditions
+        return RESULT_OK;
+    }
+    for(idx = 0; idx < COND_BP_MAX_BREAKPOINTS; idx++)
+    {
+        if(false == breakpoints[idx].used)
+        {
+            break;
+        }
+    }
+    if(COND_BP_MAX_BREAKPOINTS == idx)
+    {
+        debug_error("breakpoint 0x%08lx: no space for the conditions !", address);
+        return ERR_WRONG_VALUE;
+    }
+    breakpoints[idx].address = address;
+    res = parse_conditions(&(breakpoints[idx]), conditions);
+    if(RESULT_OK == res)
+    {
+        breakpoints[idx].used = true;
+    }
+    return res;
+}
+
+void cond_bp_remove(uint32_t address)
+{
+    uint32_t idx = find(address);
+    if(COND_BP_MAX_BREAKPOINTS != idx)
+    {
+        breakpoints[idx].used = false;
+    }
+}
+
+bool cond_bp_has_condition(uint32_t address)
+{
+    return (COND_BP_MAX_BREAKPOINTS != find(address));
+}
+
+Result cond_bp_on_halt(cond_bp_data_typ* const state, uint32_t pc, bool* resume)
+{
+    Result res;
+    breakpoint_typ* bp;
+
+    if((NULL == state) || (NULL == resume))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_LOOKUP;
+        *resume = false;
+    }
+
+    if(PHASE_LOOKUP == state->phase)
+    {
+        state->idx = find(pc);
+        if(COND_BP_MAX_BREAKPOINTS == state->idx)
+        {
+            // not a conditional breakpoint
+            return RESULT_OK;
+        }
+        num_evaluations++;
+        state->condition = 0;
+        state->expr_state.first_call = true;
+        state->phase = PHASE_EVALUATE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    bp = &(breakpoints[state->idx]);
+
+    if(PHASE_EVALUATE == state->phase)
+    {
+        res = agent_expr_run(&(state->expr_state), &(bp->code[bp->start[state->condition]]), bp->length[state->condition]);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if((RESULT_OK != res) || (0 != state->expr_state.result))
+        {
+            // the condition is true (or could not be evaluated) -> GDB gets the halt
+            return RESULT_OK;
+        }
+        state->condition++;
+        if(state->condition < bp->num_conditions)
+        {
+            state->expr_state.first_call = true;
+            return ERR_NOT_COMPLETED;
+        }
+        state->step_state.first_call = true;
+        state->phase = PHASE_STEP_OVER;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_STEP_OVER == state->phase)
+    {
+        res = core_step_over_breakpoint(&(state->step_state), pc, resume);
+        if((RESULT_OK == res) && (true == *resume))
+        {
+            num_resumes++;
+        }
+        return res;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_CLI
+bool cond_bp_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("breakpoint conditions: %ld evaluated, %ld resumed on the probe", num_evaluations, num_resumes);
+    }
+    if(loop < COND_BP_MAX_BREAKPOINTS)
+    {
+        if(true == breakpoints[loop].used)
+        {
+            cli_line("breakpoint 0x%08lx: %ld conditions", breakpoints[loop].address, breakpoints[loop].num_conditions);
+        }
+        return false;
+    }
+    return true;
+}
+#endif
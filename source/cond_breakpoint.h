@@ -0,0 +1,65 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_COND_BREAKPOINT_H_
+#define SOURCE_COND_BREAKPOINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "agent_expr.h"
+#include "cortex_m_debug.h"
+
+// Breakpoint conditions that are evaluated on the probe (FEAT_COND_BREAKPOINTS).
+//
+// GDB sends the conditions of a breakpoint as agent expressions with the Z
+// packet: "Z1,addr,kind;X3,220127;X..." (target side breakpoint conditions).
+// When the core halts on such a breakpoint the probe evaluates the
+// conditions. If one of them is true the halt is reported to GDB. If all are
+// false the probe steps over the breakpoint (the FPB comparator is disabled
+// for that step) and lets the core run again, without GDB noticing.
+//
+// An expression that fails (unsupported op code, division by zero, ...)
+// counts as true, so the halt is reported.
+
+#define COND_BP_MAX_BREAKPOINTS  FP_NUM_COMP
+#define COND_BP_MAX_CONDITIONS   4
+// bytecode of all conditions of one breakpoint
+#define COND_BP_MAX_CODE_BYTES   128
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t idx;
+    uint32_t condition;
+    agent_expr_data_typ expr_state;
+    core_step_over_data_typ step_state;
+} cond_bp_data_typ;
+
+void cond_bp_init(void);
+// conditions: the part of the Z packet after "kind" (";X3,220127;X..."). No
+// conditions removes the conditions of that breakpoint.
+Result cond_bp_set(uint32_t address, const char* conditions);
+void cond_bp_remove(uint32_t address);
+bool cond_bp_has_condition(uint32_t address);
+// the core halted at pc. *resume = true: all conditions were false and the core runs again.
+Result cond_bp_on_halt(cond_bp_data_typ* const state, uint32_t pc, bool* resume);
+#ifdef FEAT_CLI
+bool cond_bp_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_COND_BREAKPOINT_H_ */
@@ -0,0 +1,333 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "cortex_m_debug.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+// debug events of the step over a breakpoint that GDB must see
+#define DFSR_STOP_EVENTS    (DFSR_BKPT | DFSR_DWTTRAP | DFSR_VCATCH | DFSR_EXTERNAL)
+
+#define PHASE_FIND_COMP     0
+#define PHASE_DISABLE       1
+#define PHASE_CLEAR_DFSR    2
+#define PHASE_STEP          3
+#define PHASE_WAIT_HALT     4
+#define PHASE_READ_DFSR     5
+#define PHASE_RESTORE       6
+#define PHASE_RESUME        7
+
+Result core_register_read(core_register_data_typ* const state, uint32_t regsel, uint32_t* value)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == value))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = 0;
+        state->num_polls = 0;
+        state->act_state.first_call = true;
+    }
+
+    if(0 == state->phase)
+    {
+        res = step_write_ap(DCRSR_ADDRESS, regsel);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == state->phase)
+    {
+        // wait for the transfer
+        res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == (state->value & DHCSR_S_REGRDY))
+        {
+            state->num_polls++;
+            if(CORE_MAX_POLLS == state->num_polls)
+            {
+                debug_error("core register %ld: not ready !", regsel);
+                return ERR_TARGET_ERROR;
+            }
+            return ERR_NOT_COMPLETED;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == state->phase)
+    {
+        res = act_read_register(&(state->act_state), DCRDR_ADDRESS, value);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        return res;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+Result core_register_write(core_register_data_typ* const state, uint32_t regsel, uint32_t value)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = 0;
+        state->num_polls = 0;
+        state->act_state.first_call = true;
+    }
+
+    if(0 == state->phase)
+    {
+        res = step_write_ap(DCRDR_ADDRESS, value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == state->phase)
+    {
+        res = step_write_ap(DCRSR_ADDRESS, DCRSR_REGWNR | regsel);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == state->phase)
+    {
+        // wait for the transfer
+        res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == (state->value & DHCSR_S_REGRDY))
+        {
+            state->num_polls++;
+            if(CORE_MAX_POLLS == state->num_polls)
+            {
+                debug_error("core register %ld: not ready !", regsel);
+                return ERR_TARGET_ERROR;
+            }
+            return ERR_NOT_COMPLETED;
+        }
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+// reads DHCSR until the core has halted
+static Result wait_for_halt(core_step_over_data_typ* const state)
+{
+    Result res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->act_state.first_call = true;
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    if(0 != (state->value & DHCSR_S_HALT))
+    {
+        return RESULT_OK;
+    }
+    state->num_polls++;
+    if(CORE_MAX_POLLS == state->num_polls)
+    {
+        debug_error("step over breakpoint: core does not halt !");
+        return ERR_TARGET_ERROR;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+Result core_step_over_breakpoint(core_step_over_data_typ* const state, uint32_t pc, bool* resumed)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == resumed))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_FIND_COMP;
+        state->comp = 0;
+        state->stop = false;
+        state->act_state.first_call = true;
+        *resumed = false;
+    }
+
+    if(PHASE_FIND_COMP == state->phase)
+    {
+        res = act_read_register(&(state->act_state), FP_COMP0_ADDRESS + state->comp, &(state->comp_value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(   (0 != (state->comp_value & FP_COMP_ENABLE))
+           && ((state->comp_value & FP_COMP_ADDR_MASK) == (pc & FP_COMP_ADDR_MASK)) )
+        {
+            state->phase = PHASE_DISABLE;
+            return ERR_NOT_COMPLETED;
+        }
+        state->comp++;
+        if(FP_NUM_COMP == state->comp)
+        {
+            // BKPT instruction in the code -> can not step over it
+            return RESULT_OK;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_DISABLE == state->phase)
+    {
+        res = step_write_ap(FP_COMP0_ADDRESS + state->comp, 0);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CLEAR_DFSR;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CLEAR_DFSR == state->phase)
+    {
+        res = step_write_ap(DFSR_ADDRESS, DFSR_ALL);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_STEP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_STEP == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_STEP);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->num_polls = 0;
+        state->phase = PHASE_WAIT_HALT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_WAIT_HALT == state->phase)
+    {
+        res = wait_for_halt(state);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_READ_DFSR;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_READ_DFSR == state->phase)
+    {
+        res = act_read_register(&(state->act_state), DFSR_ADDRESS, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        // the step itself hit something (watchpoint, other breakpoint) -> GDB gets that halt
+        state->stop = (0 != (state->value & DFSR_STOP_EVENTS));
+        state->phase = PHASE_RESTORE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RESTORE == state->phase)
+    {
+        res = step_write_ap(FP_COMP0_ADDRESS + state->comp, state->comp_value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(true == state->stop)
+        {
+            return RESULT_OK;
+        }
+        state->phase = PHASE_RESUME;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RESUME == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        *resumed = true;
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
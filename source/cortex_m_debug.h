@@ -0,0 +1,106 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_CORTEX_M_DEBUG_H_
+#define SOURCE_CORTEX_M_DEBUG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+
+// ARMv6-M debug registers of the Cortex-M0+ cores and reading core registers
+// of a halted core through DCRSR/DCRDR.
+
+#define DFSR_ADDRESS        ((volatile uint32_t*)0xe000ed30)
+#define DHCSR_ADDRESS       ((volatile uint32_t*)0xe000edf0)
+#define DCRSR_ADDRESS       ((volatile uint32_t*)0xe000edf4)
+#define DCRDR_ADDRESS       ((volatile uint32_t*)0xe000edf8)
+#define FP_CTRL_ADDRESS     ((volatile uint32_t*)0xe0002000)
+#define FP_COMP0_ADDRESS    ((volatile uint32_t*)0xe0002008)
+
+#define DHCSR_DBGKEY        0xa05f0000
+#define DHCSR_C_DEBUGEN     (1u << 0)
+#define DHCSR_C_HALT        (1u << 1)
+#define DHCSR_C_STEP        (1u << 2)
+#define DHCSR_C_MASKINTS    (1u << 3)
+#define DHCSR_S_REGRDY      (1u << 16)
+#define DHCSR_S_HALT        (1u << 17)
+
+#define DFSR_HALTED         (1u << 0)
+#define DFSR_BKPT           (1u << 1)
+#define DFSR_DWTTRAP        (1u << 2)
+#define DFSR_VCATCH         (1u << 3)
+#define DFSR_EXTERNAL       (1u << 4)
+#define DFSR_ALL            0x1f
+
+// FPB (v1): comparator matches bits 28:2 of the address
+#define FP_NUM_COMP         4
+#define FP_COMP_ENABLE      (1u << 0)
+#define FP_COMP_ADDR_MASK   0x1ffffffc
+#define FP_COMP_REPLACE_LOW (1u << 30)
+#define FP_COMP_REPLACE_HIGH (2u << 30)
+#define FP_COMP_VALUE(addr) (  (((addr) & 2) ? FP_COMP_REPLACE_HIGH : FP_COMP_REPLACE_LOW) \
+                             | ((addr) & FP_COMP_ADDR_MASK) | FP_COMP_ENABLE)
+#define FP_CTRL_KEY         (1u << 1)
+#define FP_CTRL_ENABLE      (1u << 0)
+
+// DCRSR register selector
+#define REGSEL_SP           13
+#define REGSEL_LR           14
+#define REGSEL_PC           15
+#define REGSEL_XPSR         16
+#define REGSEL_MSP          17
+#define REGSEL_PSP          18
+// CONTROL, FAULTMASK, BASEPRI and PRIMASK in one word
+#define REGSEL_CONTROL      20
+#define DCRSR_REGWNR        (1u << 16)
+// GDB register number of xPSR in the M-profile target description (0-15 are r0-r15)
+#define GDB_REG_XPSR        25
+
+// number of DHCSR reads while waiting for the core
+#define CORE_MAX_POLLS      100
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t num_polls;
+    uint32_t value;
+    activity_data_typ act_state;
+} core_register_data_typ;
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t comp;
+    uint32_t comp_value;
+    uint32_t num_polls;
+    uint32_t value;
+    bool stop;
+    activity_data_typ act_state;
+} core_step_over_data_typ;
+
+// reads a register of the halted core (regsel = DCRSR register selector)
+Result core_register_read(core_register_data_typ* const state, uint32_t regsel, uint32_t* value);
+// writes a register of the halted core
+Result core_register_write(core_register_data_typ* const state, uint32_t regsel, uint32_t value);
+// the core halted on the FPB breakpoint at pc: the comparator is disabled for
+// one single step, then restored and the core runs again (*resumed = true).
+// The core stays halted if there is no comparator for pc (BKPT instruction)
+// or if the step hit a debug event that GDB must see.
+Result core_step_over_breakpoint(core_step_over_data_typ* const state, uint32_t pc, bool* resumed);
+
+#endif /* SOURCE_CORTEX_M_DEBUG_H_ */
@@ -0,0 +1,139 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "deferred_log.h"
+#include "time_critical.h"
+#include "probe_api/debug_log.h"
+
+// number of 32bit words in the ring buffer
+#ifndef DLOG_BUFFER_WORDS
+#define DLOG_BUFFER_WORDS  512
+#endif
+
+// A record is one header word followed by 0 to 3 argument words.
+// The header word is the address of the format string. Format strings are 4
+// byte aligned, so the lowest two bits hold the number of arguments.
+#define DLOG_NUM_ARGS_MASK   3u
+
+static uint32_t buffer[DLOG_BUFFER_WORDS];
+static uint32_t read_pos;
+static uint32_t write_pos;
+static uint32_t used_words;
+static uint32_t dropped_records;
+
+void dlog_init(void)
+{
+    read_pos = 0;
+    write_pos = 0;
+    used_words = 0;
+    dropped_records = 0;
+}
+
+static void TIME_CRITICAL(put_word)(uint32_t word)
+{
+    buffer[write_pos] = word;
+    write_pos++;
+    if(DLOG_BUFFER_WORDS == write_pos)
+    {
+        write_pos = 0;
+    }
+    used_words++;
+}
+
+static uint32_t get_word(void)
+{
+    uint32_t word = buffer[read_pos];
+    read_pos++;
+    if(DLOG_BUFFER_WORDS == read_pos)
+    {
+        read_pos = 0;
+    }
+    used_words--;
+    return word;
+}
+
+void TIME_CRITICAL(dlog_record)(const char* fmt, uint32_t num_args, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    if(num_args > DLOG_NUM_ARGS_MASK)
+    {
+        num_args = DLOG_NUM_ARGS_MASK;
+    }
+    if((DLOG_BUFFER_WORDS - used_words) < (num_args + 1))
+    {
+        // buffer full -> the oldest messages are more important than this one
+        dropped_records++;
+        return;
+    }
+    put_word((uint32_t)(uintptr_t)fmt | num_args);
+    if(0 < num_args)
+    {
+        put_word(arg0);
+    }
+    if(1 < num_args)
+    {
+        put_word(arg1);
+    }
+    if(2 < num_args)
+    {
+        put_word(arg2);
+    }
+}
+
+// prints one record (as hex). returns true if a record was printed.
+bool dlog_flush_one(void)
+{
+    uint32_t header;
+    uint32_t num_args;
+    uint32_t args[DLOG_NUM_ARGS_MASK];
+    uint32_t i;
+
+    if(0 == used_words)
+    {
+        if(0 != dropped_records)
+        {
+            debug_line(DLOG_LINE_PREFIX "dropped %ld", dropped_records);
+            dropped_records = 0;
+            return true;
+        }
+        return false;
+    }
+
+    header = get_word();
+    num_args = header & DLOG_NUM_ARGS_MASK;
+    for(i = 0; i < num_args; i++)
+    {
+        args[i] = get_word();
+    }
+
+    switch(num_args)
+    {
+    case 0: debug_line(DLOG_LINE_PREFIX "%08lx", header); break;
+    case 1: debug_line(DLOG_LINE_PREFIX "%08lx %08lx", header, args[0]); break;
+    case 2: debug_line(DLOG_LINE_PREFIX "%08lx %08lx %08lx", header, args[0], args[1]); break;
+    default: debug_line(DLOG_LINE_PREFIX "%08lx %08lx %08lx %08lx", header, args[0], args[1], args[2]); break;
+    }
+    return true;
+}
+
+uint32_t dlog_get_num_dropped(void)
+{
+    return dropped_records;
+}
+
+uint32_t dlog_get_num_waiting_words(void)
+{
+    return used_words;
+}
@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_DEFERRED_LOG_H_
+#define SOURCE_DEFERRED_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/debug_log.h"
+
+// Deferred (binary) logging for messages in the hot path.
+//
+// With FEAT_DEFERRED_LOG the dlog_x() macros do not format anything. They
+// store the address of the format string and the raw arguments in a ring
+// buffer. The records are printed later (when the flash is idle) as hex
+// lines starting with DLOG_LINE_PREFIX. dlog_decode.py extracts the format
+// strings from the elf file and turns these lines back into text.
+//
+// Without FEAT_DEFERRED_LOG the macros are plain debug_line() calls.
+//
+// The format strings are stored in the section ".rodata.dlog" with a symbol
+// name starting with "dlog_fmt". That is how dlog_decode.py finds them.
+// All arguments must fit into an uint32_t.
+
+#define DLOG_LINE_PREFIX  "#D"
+
+#ifdef FEAT_DEFERRED_LOG
+
+#define DLOG_FORMAT_STRING(fmt) \
+    static const char dlog_fmt[] __attribute__((section(".rodata.dlog"), aligned(4), used)) = fmt
+
+#define dlog_0(fmt)                                                           \
+    do {                                                                      \
+        DLOG_FORMAT_STRING(fmt);                                              \
+        dlog_record(dlog_fmt, 0, 0, 0, 0);                                    \
+    } while(0)
+
+#define dlog_1(fmt, a)                                                        \
+    do {                                                                      \
+        DLOG_FORMAT_STRING(fmt);                                              \
+        dlog_record(dlog_fmt, 1, (uint32_t)(a), 0, 0);                        \
+    } while(0)
+
+#define dlog_2(fmt, a, b)                                                     \
+    do {                                                                      \
+        DLOG_FORMAT_STRING(fmt);                                              \
+        dlog_record(dlog_fmt, 2, (uint32_t)(a), (uint32_t)(b), 0);            \
+    } while(0)
+
+#define dlog_3(fmt, a, b, c)                                                  \
+    do {                                                                      \
+        DLOG_FORMAT_STRING(fmt);                                              \
+        dlog_record(dlog_fmt, 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c));\
+    } while(0)
+
+#else
+
+#define dlog_0(fmt)              debug_line(fmt)
+#define dlog_1(fmt, a)           debug_line(fmt, a)
+#define dlog_2(fmt, a, b)        debug_line(fmt, a, b)
+#define dlog_3(fmt, a, b, c)     debug_line(fmt, a, b, c)
+
+#endif
+
+void dlog_init(void);
+void dlog_record(const char* fmt, uint32_t num_args, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+bool dlog_flush_one(void);
+uint32_t dlog_get_num_dropped(void);
+uint32_t dlog_get_num_waiting_words(void);
+
+#endif /* SOURCE_DEFERRED_LOG_H_ */
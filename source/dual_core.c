@@ -0,0 +1,344 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "dual_core.h"
+#include "cortex_m_debug.h"
+#include "text_util.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+#define PHASE_SELECT        0
+#define PHASE_READ_DHCSR    1
+#define PHASE_HALT_SELECT   2
+#define PHASE_HALT_WRITE    3
+#define PHASE_RESELECT      4
+
+#define PHASE_RUN_SELECT    0
+#define PHASE_RUN_WRITE     1
+
+static uint32_t selected_core;
+static uint32_t thread_core;
+static bool halted[DUAL_CORE_NUM_CORES];
+static bool halt_together;
+static bool switching;
+static uint32_t num_switches;
+static uint32_t num_cached;
+
+void dual_core_init(void)
+{
+    halt_together = false;
+    num_switches = 0;
+    num_cached = 0;
+    dual_core_forget();
+}
+
+void dual_core_forget(void)
+{
+    uint32_t i;
+    for(i = 0; i < DUAL_CORE_NUM_CORES; i++)
+    {
+        halted[i] = false;
+    }
+    selected_core = DUAL_CORE_NO_CORE;
+    thread_core = 0;
+    switching = false;
+}
+
+void dual_core_set_halt_together(bool together)
+{
+    halt_together = together;
+}
+
+bool dual_core_get_halt_together(void)
+{
+    return halt_together;
+}
+
+Result dual_core_select(uint32_t core)
+{
+    Result res;
+
+    if(DUAL_CORE_NUM_CORES <= core)
+    {
+        return ERR_WRONG_VALUE;
+    }
+    if(core == selected_core)
+    {
+        num_cached++;
+        return RESULT_OK;
+    }
+    if(false == switching)
+    {
+        // the steps that are still queued go to the old core
+        res = step_get_Result_OK();
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        switching = true;
+    }
+    res = swd_switch_core(core);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    switching = false;
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    selected_core = core;
+    num_switches++;
+    return RESULT_OK;
+}
+
+uint32_t dual_core_get_selected(void)
+{
+    return selected_core;
+}
+
+Result dual_core_set_thread(uint32_t thread_id)
+{
+    if((0 == thread_id) || (0xffffffff == thread_id))
+    {
+        // any thread -> keep the current one
+        return RESULT_OK;
+    }
+    if((DUAL_CORE_THREAD_ID(0) > thread_id) || (DUAL_CORE_THREAD_ID(DUAL_CORE_NUM_CORES - 1) < thread_id))
+    {
+        return ERR_WRONG_VALUE;
+    }
+    thread_core = thread_id - DUAL_CORE_THREAD_ID(0);
+    return RESULT_OK;
+}
+
+uint32_t dual_core_get_thread(void)
+{
+    return DUAL_CORE_THREAD_ID(thread_core);
+}
+
+bool dual_core_is_halted(uint32_t core)
+{
+    if(DUAL_CORE_NUM_CORES <= core)
+    {
+        return false;
+    }
+    return halted[core];
+}
+
+Result dual_core_set_run_state(dual_core_data_typ* const state, bool halt)
+{
+    Result res;
+    uint32_t value = DHCSR_DBGKEY | DHCSR_C_DEBUGEN;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_RUN_SELECT;
+        state->core = 0;
+    }
+
+    if(PHASE_RUN_SELECT == state->phase)
+    {
+        if(DUAL_CORE_NUM_CORES == state->core)
+        {
+            // the following accesses go to the current thread
+            return dual_core_select(thread_core);
+        }
+        res = dual_core_select(state->core);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_RUN_WRITE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RUN_WRITE == state->phase)
+    {
+        if(true == halt)
+        {
+            value = value | DHCSR_C_HALT;
+        }
+        res = step_write_ap(DHCSR_ADDRESS, value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        halted[state->core] = halt;
+        state->core++;
+        state->phase = PHASE_RUN_SELECT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+Result dual_core_poll(dual_core_data_typ* const state, bool* stopped)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == stopped))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_SELECT;
+        state->core = 0;
+        state->found = false;
+        state->act_state.first_call = true;
+        *stopped = false;
+    }
+
+    if(PHASE_SELECT == state->phase)
+    {
+        res = dual_core_select(state->core);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_READ_DHCSR;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_READ_DHCSR == state->phase)
+    {
+        bool now_halted;
+        res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        now_halted = (0 != (state->value & DHCSR_S_HALT));
+        if((true == now_halted) && (false == halted[state->core]) && (false == state->found))
+        {
+            // the first core that halted is reported to GDB
+            state->found = true;
+            thread_core = state->core;
+        }
+        halted[state->core] = now_halted;
+        state->core++;
+        if(DUAL_CORE_NUM_CORES != state->core)
+        {
+            state->phase = PHASE_SELECT;
+        }
+        else if((true == state->found) && (true == halt_together))
+        {
+            state->core = 0;
+            state->phase = PHASE_HALT_SELECT;
+        }
+        else
+        {
+            state->phase = PHASE_RESELECT;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_HALT_SELECT == state->phase)
+    {
+        while((DUAL_CORE_NUM_CORES > state->core) && (true == halted[state->core]))
+        {
+            state->core++;
+        }
+        if(DUAL_CORE_NUM_CORES == state->core)
+        {
+            state->phase = PHASE_RESELECT;
+            return ERR_NOT_COMPLETED;
+        }
+        res = dual_core_select(state->core);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_HALT_WRITE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_HALT_WRITE == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        halted[state->core] = true;
+        state->phase = PHASE_HALT_SELECT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RESELECT == state->phase)
+    {
+        // the following accesses go to the current thread
+        res = dual_core_select(thread_core);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        *stopped = state->found;
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+uint32_t dual_core_get_stop_reply(char* buf, uint32_t size, uint32_t signal)
+{
+    uint32_t pos;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    pos = text_add_string(buf, size, 0, "T");
+    pos = text_add_hex_byte(buf, size, pos, signal);
+    pos = text_add_string(buf, size, pos, "thread:");
+    pos = text_add_hex_byte(buf, size, pos, DUAL_CORE_THREAD_ID(thread_core));
+    pos = text_add_string(buf, size, pos, ";");
+    buf[pos] = 0;
+    return pos;
+}
+
+#ifdef FEAT_CLI
+bool dual_core_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("cores: %ld switches, %ld times already selected%s", num_switches, num_cached,
+                 (true == halt_together) ? ", halted together" : "");
+    }
+    if(loop < DUAL_CORE_NUM_CORES)
+    {
+        cli_line("core %ld: %s%s", loop, (true == halted[loop]) ? "halted" : "running",
+                 (loop == selected_core) ? " (selected)" : "");
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_DUAL_CORE_H_
+#define SOURCE_DUAL_CORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "swd_link.h"
+
+// Both Cortex-M0+ cores of the RP2040 as GDB threads (FEAT_DUAL_CORE).
+//
+// Each core has its own DP, selected with TARGETSEL (SWD multi drop). A
+// switch is a connect of the SWD engine to the other DP (swd_switch_core()).
+// The steps that are still queued for the old core are finished before the
+// switch, so that they can not end up on the other core. Selecting the core
+// that is already selected costs nothing.
+//
+// Thread 1 is core 0, thread 2 is core 1. The halt state of both cores is
+// tracked. If "halt_together" is set ([cores] section, see target_config.h)
+// a halt of one core also halts the other one.
+
+#define DUAL_CORE_NUM_CORES     2
+#define DUAL_CORE_THREAD_ID(core)   ((core) + 1)
+#define DUAL_CORE_NO_CORE       0xffffffff
+
+#define DUAL_CORE_THREADS_CONTENT \
+"<?xml version=\"1.0\"?>\r\n" \
+"<threads>\r\n" \
+    "<thread id=\"1\" core=\"0\" name=\"core 0\"/>\r\n" \
+    "<thread id=\"2\" core=\"1\" name=\"core 1\"/>\r\n" \
+"</threads>\r\n"
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t core;
+    bool found;
+    uint32_t value;
+    activity_data_typ act_state;
+} dual_core_data_typ;
+
+void dual_core_init(void);
+// target reset or new connection: all cores need the full setup again
+void dual_core_forget(void);
+// value of "halt_together" from the [cores] section
+void dual_core_set_halt_together(bool together);
+bool dual_core_get_halt_together(void);
+// makes sure that the SWD accesses go to this core
+Result dual_core_select(uint32_t core);
+uint32_t dual_core_get_selected(void);
+// Hg: core of the following register and memory accesses (0 = any thread)
+Result dual_core_set_thread(uint32_t thread_id);
+// qC
+uint32_t dual_core_get_thread(void);
+bool dual_core_is_halted(uint32_t core);
+// halts (halt = true) or resumes both cores
+Result dual_core_set_run_state(dual_core_data_typ* const state, bool halt);
+// reads the halt state of both cores. *stopped = true if a core has halted
+// since the last poll; that core becomes the current thread.
+Result dual_core_poll(dual_core_data_typ* const state, bool* stopped);
+// "T<signal>thread:<id>;" for the current thread. Returns the length.
+uint32_t dual_core_get_stop_reply(char* buf, uint32_t size, uint32_t signal);
+#ifdef FEAT_CLI
+bool dual_core_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_DUAL_CORE_H_ */
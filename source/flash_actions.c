@@ -15,21 +15,64 @@
 
 #include <stddef.h>
 #include "flash_actions.h"
-#include "probe_api/activity.h"
+#include "deferred_log.h"
+#include "qspi_program.h"
+#include "time_critical.h"
 #include "probe_api/debug_log.h"
-#include "probe_api/steps.h"
+#include "hal/hw/CLOCKS.h"
+#include "hal/hw/DMA.h"
+#include "hal/hw/PLL_SYS.h"
 #include "hal/hw/RESETS.h"
 #include "hal/hw/PSM.h"
 #include "hal/hw/PADS_QSPI.h"
 #include "hal/hw/IO_QSPI.h"
 #include "hal/hw/XIP_CTRL.h"
 #include "hal/hw/XIP_SSI.h"
+#include "hal/hw/XOSC.h"
 #include "hal/qspi_flash.h"
 
-// TODO user configurable!
+// used if the calibration does not find anything faster
 #define QSPI_BAUDRATE_DIVIDOR     8
-
-#define FIFO_SIZE 10  // is probably 16 but just to be sure
+#define QSPI_RX_SAMPLE_DELAY      1
+
+// SSI calibration: the JEDEC ID is read at a slow reference setting and then
+// at faster settings. For each clock divider all sample delays are tried. The
+// fastest divider that reads the ID correctly with at least two neighbouring
+// sample delays (margin) is used. XIP reads the flash with quad I/O, so the
+// chosen setting must also read the same data with a quad read (0xeb) as the
+// reference setting. The result is kept until flash_actions_init() or until
+// clk_sys is configured differently than during the calibration.
+#define CAL_REFERENCE_SCKDV      32
+#define CAL_MIN_SCKDV             2
+#define CAL_MAX_RSD               3
+// every setting must read the ID this many times
+#define CAL_NUM_READS             2
+// flash address of the quad read check
+#define CAL_QUAD_ADDRESS          0
+
+#ifndef FLASHCMD_READ_JEDEC_ID
+#define FLASHCMD_READ_JEDEC_ID 0x9f
+#endif
+
+#ifdef FEAT_ERASE_SUSPEND
+// Erase suspend: the SFDP table of the flash (JESD216) tells if the flash can
+// suspend an erase and which commands it uses for that. The table is read once
+// (until flash_actions_init()) at the end of flash_initialize().
+#ifndef FLASHCMD_READ_SFDP
+#define FLASHCMD_READ_SFDP     0x5a
+#endif
+#ifndef FLASHCMD_READ_DATA
+#define FLASHCMD_READ_DATA     0x03
+#endif
+#define FLASHCMD_ERASE_SUSPEND 0x75
+#define FLASHCMD_ERASE_RESUME  0x7a
+#define SFDP_SIGNATURE         0x50444653  // "SFDP"
+// Basic Flash Parameter Table: DWORD 12 bit 31 = 0 -> suspend/resume supported
+// DWORD 13: bits 31-24 = suspend command, bits 23-16 = resume command
+#define BFPT_SUSPEND_DWORD     12
+#define BFPT_SUSPEND_NOT_SUPPORTED  0x80000000
+#define BFPT_SUSPEND_CMD_DWORD 13
+#endif
 
 // Register address offsets for atomic RMW aliases
 #define REG_ALIAS_RW_BITS  (0x0u << 12u)
@@ -37,2787 +80,1079 @@
 #define REG_ALIAS_SET_BITS (0x2u << 12u)
 #define REG_ALIAS_CLR_BITS (0x3u << 12u)
 
-static Result flash_erase_param(flash_action_data_typ* const state, uint32_t start_address, uint32_t erase_cmd);
+#define REG_ALIAS(reg, alias)  ((volatile uint32_t*)((volatile uint8_t*)(reg) + (alias)))
+
+// parameters of the programs
+#define PARAM_CMD       0
+#define PARAM_ADDRESS   1
+#define PARAM_SCKDV     2
+#define PARAM_RSD       3
+#define PARAM_LENGTH    4
+
+// slots in prog.saved (the clock boost uses the slots 0 to 10)
+// initialize_program saves, enter_XIP_program restores
+#define SAVED_XIP_CTRL        11
+#define SAVED_SSI_DMACR       12
+#define SAVED_SSI_DMATDLR     13
+// the page staging takes the DMA out of reset and uses channel 11
+#define SAVED_RESETS          14
+#define SAVED_DMA_READ_ADDR   15
+#define SAVED_DMA_WRITE_ADDR  16
+#define SAVED_DMA_TRANS_COUNT 17
+#define SAVED_DMA_CTRL        18
+// clk_sys configuration the SSI setting belongs to
+#define SAVED_CAL_CLOCKS      19
+#define NUM_CAL_CLOCKS         5
+
+// all QSPI pads have the same layout:
+// Input enable, 4mA, schmitt trigger, slew rate fast and pull down or pull up
+#define PAD_QSPI_PULL_DOWN   ( (1 << PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)                                     \
+                             | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)  \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_PDE_OFFSET)                                    \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)                                \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET) )
+
+#define PAD_QSPI_PULL_UP     ( (1 << PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)                                     \
+                             | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)  \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_PUE_OFFSET)                                    \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)                                \
+                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET) )
+
+#define PAD_QSPI_OUTPUT_DISABLE  (1 << PADS_QSPI_GPIO_QSPI_SD0_OD_OFFSET)
+
+#define QSPI_RESET_MASK  ((1 << RESETS_RESET_IO_QSPI_OFFSET) | (1 << RESETS_RESET_PADS_QSPI_OFFSET))
+
+// SSI in standard SPI mode, tmod = XIP_SSI_CTRLR0_TMOD_*
+// SSTE = Slave select toggle enable
+// CFS = Control Frame size = Microwire only !
+// SRL = Shift Register loop (test mode)
+// SLV_OE = Slave Output enable
+// SPI MOD = 0 = (SCPOL = 0; SCPH = 0)
+// FRF = 00 = Motorola SPI
+// DFS = invalid (dfs_32 is used) writing has no effect!
+#define SSI_CTRLR0_SPI(tmod)  ( (1 << XIP_SSI_CTRLR0_SSTE_OFFSET)                               \
+                              | (XIP_SSI_CTRLR0_SPI_FRF_STD << XIP_SSI_CTRLR0_SPI_FRF_OFFSET)   \
+                              | (7 << XIP_SSI_CTRLR0_DFS_32_OFFSET) /* 8 clocks per data frame */ \
+                              | ((tmod) << XIP_SSI_CTRLR0_TMOD_OFFSET) )
+
+// building blocks of the programs
+#define OP_WRITE(reg, value)       {QOP_WRITE, &(reg), (value), 0}
+#define OP_WRITE_PARAM(reg, idx)   {QOP_WRITE_PARAM, &(reg), (idx), 0}
+#define OP_READ(reg)               {QOP_READ, &(reg), 0, 0}
+#define OP_POLL(reg, mask, value)  {QOP_POLL, &(reg), (value), (mask)}
+#define OP_SEND(value)             {QOP_SEND, NULL, (value), 0}
+#define OP_SEND_PARAM(idx, shift)  {QOP_SEND_PARAM, NULL, (idx), (shift)}
+#define OP_DRAIN_RX(additional)    {QOP_DRAIN_RX, NULL, (additional), 0}
+#define OP_SAVE(reg, slot)                 {QOP_SAVE, &(reg), (slot), 0}
+#define OP_RESTORE(reg, slot)              {QOP_RESTORE, &(reg), (slot), 0xffffffff}
+#define OP_RESTORE_MASKED(reg, slot, mask) {QOP_RESTORE, &(reg), (slot), (mask)}
+#define OP_SKIP_IF_SAVED(slot, mask)       {QOP_SKIP_IF_SAVED, NULL, (slot), (mask)}
+#define OP_END                     {QOP_END, NULL, 0, 0}
+
+#define OP_CS_LOW                  OP_WRITE(IO_QSPI->GPIO_QSPI_SS_CTRL, (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET))
+#define OP_CS_HIGH                 OP_WRITE(IO_QSPI->GPIO_QSPI_SS_CTRL, (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET))
+// wait for TFE (Transmit FIFO Empty) = 1
+#define OP_WAIT_TX_EMPTY           OP_POLL(XIP_SSI->SR, XIP_SSI_SR_TFE_MASK, XIP_SSI_SR_TFE_MASK)
+// wait for busy = idle
+#define OP_WAIT_NOT_BUSY           OP_POLL(XIP_SSI->SR, XIP_SSI_SR_BUSY_MASK, 0)
+
+// end of a command: wait until all bytes are out, read all received bytes and release /CS
+#define OPS_END_OF_COMMAND         \
+    OP_WAIT_TX_EMPTY,              \
+    OP_DRAIN_RX(0),                \
+    OP_WAIT_NOT_BUSY,              \
+    OP_CS_HIGH
+
+#define OPS_WRITE_ENABLE           \
+    OP_CS_LOW,                     \
+    OP_SEND(FLASHCMD_WRITE_ENABLE),\
+    OPS_END_OF_COMMAND
+
+// read the status register until the flash is not busy anymore
+#define OPS_WAIT_WHILE_FLASH_BUSY            \
+    OP_CS_LOW,                               \
+    OP_SEND(FLASHCMD_READ_STATUS),           \
+    OP_SEND(0xff),                           \
+    OPS_END_OF_COMMAND,                      \
+    {QOP_LOOP_WHILE_BUSY, NULL, 7, 0}
+
+#ifdef FEAT_PIPELINED_FLASH
+// The flash erases or programs while the probe prepares the next operation
+// (uploads the next page). So the programs do not wait for the flash at their
+// end, they wait for the previous operation before they send a command.
+// flash_enter_XIP() waits for the last operation.
+#define OPS_WAIT_FOR_PREVIOUS      OPS_WAIT_WHILE_FLASH_BUSY,
+#define OPS_WAIT_FOR_THIS
+#else
+#define OPS_WAIT_FOR_PREVIOUS
+#define OPS_WAIT_FOR_THIS          OPS_WAIT_WHILE_FLASH_BUSY,
+#endif
+
+#ifdef FEAT_TARGET_CLOCK_BOOST
+// After reset the target runs from the ROSC (a few MHz). The SSI (and so the
+// QSPI clock) runs from clk_sys. While programming the target runs from the
+// 12MHz crystal and the PLL (125MHz). The original configuration is restored
+// when the flash goes back to XIP mode.
+
+// slots in prog.saved
+#define SAVED_CLK_REF_CTRL    0
+#define SAVED_CLK_REF_DIV     1
+#define SAVED_CLK_SYS_CTRL    2
+#define SAVED_CLK_SYS_DIV     3
+#define SAVED_CLK_PERI_CTRL   4
+#define SAVED_XOSC_CTRL       5
+#define SAVED_XOSC_STARTUP    6
+#define SAVED_PLL_CS          7
+#define SAVED_PLL_PWR         8
+#define SAVED_PLL_FBDIV       9
+#define SAVED_PLL_PRIM       10
+// number of operations at the start of clock_boost_program that save registers
+#define NUM_CLOCK_SAVE_OPS   11
+
+// 12MHz * 125 = 1500MHz VCO / 6 / 2 = 125MHz
+#define BOOST_PLL_FBDIV         125
+#define BOOST_PLL_POSTDIV1        6
+#define BOOST_PLL_POSTDIV2        2
+// ~1ms at 12MHz (in units of 256 clocks)
+#define BOOST_XOSC_STARTUP       47
+
+// clk_sys must not run from the PLL or an aux source while these change
+#define OPS_CLK_SYS_FROM_CLK_REF                                                                       \
+    OP_WRITE(CLOCKS->CLK_SYS_CTRL, (CLOCKS_CLK_SYS_CTRL_SRC_clk_ref << CLOCKS_CLK_SYS_CTRL_SRC_OFFSET)), \
+    OP_POLL(CLOCKS->CLK_SYS_SELECTED, 1, 1)
+
+static const qspi_op_typ TIME_CRITICAL_DATA(clock_boost_program)[] = {
+    // save (NUM_CLOCK_SAVE_OPS operations)
+    OP_SAVE(CLOCKS->CLK_REF_CTRL, SAVED_CLK_REF_CTRL),
+    OP_SAVE(CLOCKS->CLK_REF_DIV, SAVED_CLK_REF_DIV),
+    OP_SAVE(CLOCKS->CLK_SYS_CTRL, SAVED_CLK_SYS_CTRL),
+    OP_SAVE(CLOCKS->CLK_SYS_DIV, SAVED_CLK_SYS_DIV),
+    OP_SAVE(CLOCKS->CLK_PERI_CTRL, SAVED_CLK_PERI_CTRL),
+    OP_SAVE(XOSC->CTRL, SAVED_XOSC_CTRL),
+    OP_SAVE(XOSC->STARTUP, SAVED_XOSC_STARTUP),
+    OP_SAVE(PLL_SYS->CS, SAVED_PLL_CS),
+    OP_SAVE(PLL_SYS->PWR, SAVED_PLL_PWR),
+    OP_SAVE(PLL_SYS->FBDIV_INT, SAVED_PLL_FBDIV),
+    OP_SAVE(PLL_SYS->PRIM, SAVED_PLL_PRIM),
+
+    OPS_CLK_SYS_FROM_CLK_REF,
+
+    // start the crystal oscillator
+    OP_WRITE(XOSC->STARTUP, BOOST_XOSC_STARTUP),
+    OP_WRITE(XOSC->CTRL, (XOSC_CTRL_ENABLE_ENABLE << XOSC_CTRL_ENABLE_OFFSET) | XOSC_CTRL_FREQ_RANGE_1_15MHZ),
+    OP_POLL(XOSC->STATUS, XOSC_STATUS_STABLE_MASK, XOSC_STATUS_STABLE_MASK),
+    // clk_ref = XOSC
+    OP_WRITE(CLOCKS->CLK_REF_DIV, (1 << CLOCKS_CLK_REF_DIV_INT_OFFSET)),
+    OP_WRITE(CLOCKS->CLK_REF_CTRL, (CLOCKS_CLK_REF_CTRL_SRC_xosc_clksrc << CLOCKS_CLK_REF_CTRL_SRC_OFFSET)),
+    OP_POLL(CLOCKS->CLK_REF_SELECTED, (1 << CLOCKS_CLK_REF_CTRL_SRC_xosc_clksrc), (1 << CLOCKS_CLK_REF_CTRL_SRC_xosc_clksrc)),
+
+    // PLL_SYS: power down, configure, power up, wait for lock, enable post dividers
+    OP_WRITE(PLL_SYS->PWR, PLL_SYS_PWR_VCOPD_MASK | PLL_SYS_PWR_POSTDIVPD_MASK | PLL_SYS_PWR_DSMPD_MASK | PLL_SYS_PWR_PD_MASK),
+    OP_WRITE(PLL_SYS->CS, (1 << PLL_SYS_CS_REFDIV_OFFSET)),
+    OP_WRITE(PLL_SYS->FBDIV_INT, BOOST_PLL_FBDIV),
+    OP_WRITE(PLL_SYS->PWR, PLL_SYS_PWR_POSTDIVPD_MASK | PLL_SYS_PWR_DSMPD_MASK),
+    OP_POLL(PLL_SYS->CS, PLL_SYS_CS_LOCK_MASK, PLL_SYS_CS_LOCK_MASK),
+    OP_WRITE(PLL_SYS->PRIM, (BOOST_PLL_POSTDIV1 << PLL_SYS_PRIM_POSTDIV1_OFFSET) | (BOOST_PLL_POSTDIV2 << PLL_SYS_PRIM_POSTDIV2_OFFSET)),
+    OP_WRITE(PLL_SYS->PWR, PLL_SYS_PWR_DSMPD_MASK),
+
+    // clk_sys = PLL_SYS (select the aux source first, then switch the glitch less mux)
+    OP_WRITE(CLOCKS->CLK_SYS_DIV, (1 << CLOCKS_CLK_SYS_DIV_INT_OFFSET)),
+    OP_WRITE(CLOCKS->CLK_SYS_CTRL, (CLOCKS_CLK_SYS_CTRL_AUXSRC_clksrc_pll_sys << CLOCKS_CLK_SYS_CTRL_AUXSRC_OFFSET)),
+    OP_WRITE(CLOCKS->CLK_SYS_CTRL, (CLOCKS_CLK_SYS_CTRL_AUXSRC_clksrc_pll_sys << CLOCKS_CLK_SYS_CTRL_AUXSRC_OFFSET)
+                                 | (CLOCKS_CLK_SYS_CTRL_SRC_clksrc_clk_sys_aux << CLOCKS_CLK_SYS_CTRL_SRC_OFFSET)),
+    OP_POLL(CLOCKS->CLK_SYS_SELECTED, 2, 2),
+    // clk_peri = clk_sys
+    OP_WRITE(CLOCKS->CLK_PERI_CTRL, CLOCKS_CLK_PERI_CTRL_ENABLE_MASK | (CLOCKS_CLK_PERI_CTRL_AUXSRC_clk_sys << CLOCKS_CLK_PERI_CTRL_AUXSRC_OFFSET)),
+    OP_END
+};
+
+static const qspi_op_typ TIME_CRITICAL_DATA(clock_restore_program)[] = {
+    OPS_CLK_SYS_FROM_CLK_REF,
+    OP_RESTORE(CLOCKS->CLK_PERI_CTRL, SAVED_CLK_PERI_CTRL),
+    // clk_ref back to its original source, the ROSC is always running
+    OP_WRITE(CLOCKS->CLK_REF_CTRL, (CLOCKS_CLK_REF_CTRL_SRC_rosc_clksrc_ph << CLOCKS_CLK_REF_CTRL_SRC_OFFSET)),
+    OP_POLL(CLOCKS->CLK_REF_SELECTED, 1, 1),
+    OP_RESTORE(CLOCKS->CLK_REF_DIV, SAVED_CLK_REF_DIV),
+    OP_RESTORE(CLOCKS->CLK_REF_CTRL, SAVED_CLK_REF_CTRL),
+    // PLL and XOSC (if they were off they are switched off again)
+    OP_WRITE(PLL_SYS->PWR, PLL_SYS_PWR_VCOPD_MASK | PLL_SYS_PWR_POSTDIVPD_MASK | PLL_SYS_PWR_DSMPD_MASK | PLL_SYS_PWR_PD_MASK),
+    OP_RESTORE(PLL_SYS->CS, SAVED_PLL_CS),
+    OP_RESTORE(PLL_SYS->FBDIV_INT, SAVED_PLL_FBDIV),
+    OP_RESTORE(PLL_SYS->PRIM, SAVED_PLL_PRIM),
+    OP_RESTORE(PLL_SYS->PWR, SAVED_PLL_PWR),
+    // clk_sys can run from the PLL again once it is locked (a PLL that was off never locks)
+    OP_SKIP_IF_SAVED(SAVED_PLL_PWR, PLL_SYS_PWR_VCOPD_MASK | PLL_SYS_PWR_PD_MASK),
+    OP_POLL(PLL_SYS->CS, PLL_SYS_CS_LOCK_MASK, PLL_SYS_CS_LOCK_MASK),
+    OP_RESTORE(XOSC->STARTUP, SAVED_XOSC_STARTUP),
+    OP_RESTORE(XOSC->CTRL, SAVED_XOSC_CTRL),
+    // clk_sys: divider, aux source, then the glitch less mux
+    OP_RESTORE(CLOCKS->CLK_SYS_DIV, SAVED_CLK_SYS_DIV),
+    OP_RESTORE_MASKED(CLOCKS->CLK_SYS_CTRL, SAVED_CLK_SYS_CTRL, ~(uint32_t)CLOCKS_CLK_SYS_CTRL_SRC_MASK),
+    OP_RESTORE(CLOCKS->CLK_SYS_CTRL, SAVED_CLK_SYS_CTRL),
+    OP_END
+};
+#endif
+
+static const qspi_op_typ TIME_CRITICAL_DATA(initialize_program)[] = {
+    // the current clk_sys configuration (NUM_CAL_CLOCKS registers)
+    OP_SAVE(CLOCKS->CLK_REF_CTRL, SAVED_CAL_CLOCKS),
+    OP_SAVE(CLOCKS->CLK_SYS_CTRL, SAVED_CAL_CLOCKS + 1),
+    OP_SAVE(CLOCKS->CLK_SYS_DIV, SAVED_CAL_CLOCKS + 2),
+    OP_SAVE(PLL_SYS->FBDIV_INT, SAVED_CAL_CLOCKS + 3),
+    OP_SAVE(PLL_SYS->PRIM, SAVED_CAL_CLOCKS + 4),
+    // power on QSPI
+    {QOP_READ_ACC, &(PSM->FRCE_ON), 0, 0},
+    {QOP_WRITE_ACC_SET, &(PSM->FRCE_ON), 0, (1 << PSM_FRCE_ON_XIP_OFFSET)},
+    // reset QSPI
+    {QOP_READ_ACC, &(RESETS->RESET), 0, 0},
+    {QOP_WRITE_ACC_SET, &(RESETS->RESET), 0, QSPI_RESET_MASK},
+    {QOP_WRITE_ACC_CLR, &(RESETS->RESET), 0, QSPI_RESET_MASK},
+    OP_POLL(RESETS->RESET, QSPI_RESET_MASK, 0), // bit is 0 if reset is done
+
+    // set PADS_QSPI Registers
+    OP_WRITE(PADS_QSPI->VOLTAGE_SELECT, 0), // 3.3V
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SCLK, PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[0], PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[1], PAD_QSPI_PULL_DOWN),
+    // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[2], PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[3], PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SS, PAD_QSPI_PULL_DOWN),
 
-static uint32_t val; // a value read from a register or prepared to be written into a register
-static uint32_t status; // read status value from Flash
-static uint32_t tx_level; // number of bytes in transmit buffer
-static uint32_t rx_level; // number of bytes in receive buffer
-static uint32_t cnt; // a counter
-static uint32_t cnt_2; // another counter
-static activity_data_typ act_state;  // sub state state variables
+    // set IO_QSPI Registers
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SCLK_CTRL, 0),
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SS_CTRL, 0),
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SD0_CTRL, 0),
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SD1_CTRL, 0),
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SD2_CTRL, 0),
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SD3_CTRL, 0),
+    OP_WRITE(IO_QSPI->INTR, 0xcccccc), // write to clear
+    OP_WRITE(IO_QSPI->PROC0_INTE, 0),
+    OP_WRITE(IO_QSPI->PROC0_INTF, 0),
+    OP_WRITE(IO_QSPI->PROC1_INTE, 0),
+    OP_WRITE(IO_QSPI->PROC1_INTF, 0),
+    OP_WRITE(IO_QSPI->DORMANT_WAKE_INTE, 0),
+    OP_WRITE(IO_QSPI->DORMANT_WAKE_INTF, 0),
+
+    // set XIP_CTRL Registers (flash_enter_XIP() restores the value)
+    OP_SAVE(XIP_CTRL->CTRL, SAVED_XIP_CTRL),
+    OP_WRITE(XIP_CTRL->CTRL, 0), // ignore bad memory accesses, keep cache powered, cache disabled
+#ifdef FEAT_XIP_CACHE_STAGING
+    // the DMA sends the staged page data to the SSI (flash_enter_XIP() gives
+    // channel 11 and the DMA reset back to the application)
+    OP_SAVE(RESETS->RESET, SAVED_RESETS),
+    {QOP_READ_ACC, &(RESETS->RESET), 0, 0},
+    {QOP_WRITE_ACC_CLR, &(RESETS->RESET), 0, RESETS_RESET_DMA_MASK},
+    OP_POLL(RESETS->RESET_DONE, RESETS_RESET_DMA_MASK, RESETS_RESET_DMA_MASK),
+    // a transfer of the application must not be cut off (times out if the channel stays busy)
+    OP_POLL(DMA->CH11_CTRL_TRIG, DMA_CH11_CTRL_TRIG_BUSY_MASK, 0),
+    OP_SAVE(DMA->CH11_READ_ADDR, SAVED_DMA_READ_ADDR),
+    OP_SAVE(DMA->CH11_WRITE_ADDR, SAVED_DMA_WRITE_ADDR),
+    OP_SAVE(DMA->CH11_TRANS_COUNT, SAVED_DMA_TRANS_COUNT),
+    OP_SAVE(DMA->CH11_AL1_CTRL, SAVED_DMA_CTRL),
+#endif
 
-Result flash_initialize(flash_action_data_typ* const state)
+    // set XIP_SSI Registers
+    OP_SAVE(XIP_SSI->DMACR, SAVED_SSI_DMACR),
+    OP_SAVE(XIP_SSI->DMATDLR, SAVED_SSI_DMATDLR),
+    OP_WRITE(XIP_SSI->SSIENR, 0), // Disable SSI for further configuration
+    OP_WRITE(XIP_SSI->SER, (1 << XIP_SSI_SER_SER_OFFSET)), // 1 = slave selected; 0 = slave not selected
+    OP_WRITE_PARAM(XIP_SSI->BAUDR, PARAM_SCKDV), // set baud rate
+    OP_WRITE(XIP_SSI->TXFTLR, 0), // TX FIFO threshold
+    OP_WRITE(XIP_SSI->RXFTLR, 0), // RX FIFO threshold
+    OP_WRITE(XIP_SSI->IMR, 0), // no interrupts masked
+    OP_WRITE(XIP_SSI->DMACR, 0), // no DMA
+    OP_WRITE(XIP_SSI->DMATDLR, 0), // transmit data water mark level
+    OP_WRITE(XIP_SSI->DMARDLR, 4), // receive data water mark level (data sheet says it should not be changed from 4)
+    OP_WRITE_PARAM(XIP_SSI->RX_SAMPLE_DLY, PARAM_RSD), // delay in System clock cycles
+    OP_WRITE(XIP_SSI->TXD_DRIVE_EDGE, 0),
+    OP_WRITE(XIP_SSI->CTRLR[0], SSI_CTRLR0_SPI(XIP_SSI_CTRLR0_TMOD_TX_AND_RX)), // TX and RX FIFOs are both used for every byte
+    OP_WRITE(XIP_SSI->CTRLR[1], 0), // NDF = 0 = number of data frames used with Quad SPI
+    OP_WRITE(XIP_SSI->SPI_CTRLR0,
+                  (0x03 << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET) //   Command 0x03 = read SPI (1 bit per clock); 0xeb = read QSPI (4 bits per clock)
+                | (0 << XIP_SSI_SPI_CTRLR0_WAIT_CYCLES_OFFSET)
+                | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
+                | (6 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET) // in 4 bit increments -> 24 bit = 6
+                ),
+    OP_READ(XIP_SSI->ICR), // clear all active interrupts
+    OP_READ(XIP_SSI->SR), // Clear sticky errors (clear-on-read)
+    OP_READ(XIP_SSI->ICR), // Clear sticky errors (clear-on-read)
+    OP_WRITE(XIP_SSI->SSIENR, 1), // Re-enable SSI
+
+    // make sure we are not in XIP mode (Continuous Read Mode)
+    // Sequence:
+    // 1. CSn = 1, IO = 4'h0 (via pull-down to avoid contention), x32 clocks
+    // 2. CSn = 0, IO = 4'hf (via pull-up to avoid contention), x32 clocks
+    // 3. CSn = 1 (brief deassertion)
+    // 4. CSn = 0, MOSI = 1'b1 driven, x16 clocks
+    //
+    // Part 4 is the sequence suggested in W25X10CL data sheet.
+    // Parts 1 and 2 are to improve compatibility with Micron parts
+    OP_WAIT_TX_EMPTY,
+    OP_WAIT_NOT_BUSY,
+    OP_CS_HIGH,
+
+    // 1. CSn = 1, IO = 4'h0 (via pull-down to avoid contention), x32 clocks
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[0], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[1], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[2], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[3], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_DOWN),
+    OP_SEND(0),
+    OP_SEND(0),
+    OP_SEND(0),
+    OP_SEND(0),
+    OPS_END_OF_COMMAND,
+    OP_CS_LOW,
+
+    // 2. CSn = 0, IO = 4'hf (via pull-up to avoid contention), x32 clocks
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[0], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[1], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[2], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[3], PAD_QSPI_OUTPUT_DISABLE | PAD_QSPI_PULL_UP),
+    OP_SEND(0),
+    OP_SEND(0),
+    OP_SEND(0),
+    OP_SEND(0),
+    // 3. CSn = 1 (brief de-assertion)
+    OPS_END_OF_COMMAND,
+    OP_CS_LOW,
+
+    // 4. CSn = 0, MOSI = 1'b1 driven, x16 clocks
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SCLK, PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[0], PAD_QSPI_PULL_DOWN),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[1], PAD_QSPI_PULL_DOWN),
+    // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[2], PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SD[3], PAD_QSPI_PULL_UP),
+    OP_WRITE(PADS_QSPI->GPIO_QSPI_SS, PAD_QSPI_PULL_DOWN),
+    OP_CS_LOW,
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OPS_END_OF_COMMAND,
+    OP_END
+};
+
+// parameters: PARAM_SCKDV, PARAM_RSD; result: JEDEC ID in the lowest 24 bits of rx_word
+static const qspi_op_typ TIME_CRITICAL_DATA(read_id_program)[] = {
+    OP_WRITE(XIP_SSI->SSIENR, 0), // the baud rate can only be changed while the SSI is disabled
+    OP_WRITE_PARAM(XIP_SSI->BAUDR, PARAM_SCKDV),
+    OP_WRITE_PARAM(XIP_SSI->RX_SAMPLE_DLY, PARAM_RSD),
+    OP_WRITE(XIP_SSI->SSIENR, 1),
+    OP_CS_LOW,
+    OP_SEND(FLASHCMD_READ_JEDEC_ID),
+    OP_SEND(0),
+    OP_SEND(0),
+    OP_SEND(0),
+    OPS_END_OF_COMMAND,
+    OP_END
+};
+
+// parameters: PARAM_SCKDV, PARAM_RSD, PARAM_ADDRESS = flash address << 8
+// result: 4 bytes in rx_word. Same read as the XIP mode, but with the mode
+// bits 0x00 the flash does not stay in continuous read mode.
+static const qspi_op_typ TIME_CRITICAL_DATA(read_quad_program)[] = {
+    OP_WRITE(XIP_SSI->SSIENR, 0),
+    OP_WRITE_PARAM(XIP_SSI->BAUDR, PARAM_SCKDV),
+    OP_WRITE_PARAM(XIP_SSI->RX_SAMPLE_DLY, PARAM_RSD),
+    OP_WRITE(XIP_SSI->CTRLR[0],
+                (XIP_SSI_CTRLR0_SPI_FRF_QUAD << XIP_SSI_CTRLR0_SPI_FRF_OFFSET)
+                | (1 << XIP_SSI_CTRLR0_DFS_32_OFFSET) // 8 bits per data frame -> 2 clock in QSPI
+                | (7 << XIP_SSI_CTRLR0_CFS_OFFSET)
+                | (XIP_SSI_CTRLR0_TMOD_RX_ONLY << XIP_SSI_CTRLR0_TMOD_OFFSET)
+                | (8 << XIP_SSI_CTRLR0_DFS_OFFSET)
+                ),
+    OP_WRITE(XIP_SSI->CTRLR[1], 3), // read this many bytes (value is n+1)
+    OP_WRITE(XIP_SSI->SPI_CTRLR0,
+                (0xebul << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET)
+              | (4 << XIP_SSI_SPI_CTRLR0_WAIT_CYCLES_OFFSET)
+              | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
+              | (8 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET) // 24 bit address + 8 mode bits
+              | (XIP_SSI_SPI_CTRLR0_TRANS_TYPE_1C2A << XIP_SSI_SPI_CTRLR0_TRANS_TYPE_OFFSET)
+                ),
+    OP_WRITE(XIP_SSI->SER, 0), // the transfer starts when the slave gets selected
+    OP_WRITE(XIP_SSI->SSIENR, 1),
+    OP_CS_LOW,
+    // RX only mode: command and address do not create received bytes
+    OP_WRITE(XIP_SSI->DR0, 0xeb),
+    OP_WRITE_PARAM(XIP_SSI->DR0, PARAM_ADDRESS),
+    OP_WRITE(XIP_SSI->SER, 1),
+    OP_WAIT_TX_EMPTY,
+    OP_DRAIN_RX(4),
+    OP_WAIT_NOT_BUSY,
+    OP_CS_HIGH,
+    // back to standard SPI for the commands
+    OP_WRITE(XIP_SSI->SSIENR, 0),
+    OP_WRITE(XIP_SSI->CTRLR[0], SSI_CTRLR0_SPI(XIP_SSI_CTRLR0_TMOD_TX_AND_RX)),
+    OP_WRITE(XIP_SSI->CTRLR[1], 0),
+    OP_WRITE(XIP_SSI->SPI_CTRLR0,
+                  (0x03 << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET)
+                | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
+                | (6 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET)
+                ),
+    OP_WRITE(XIP_SSI->SSIENR, 1),
+    OP_END
+};
+
+// parameters: PARAM_CMD = erase command, PARAM_ADDRESS = start address
+static const qspi_op_typ TIME_CRITICAL_DATA(erase_program)[] = {
+    OPS_WAIT_FOR_PREVIOUS
+    OPS_WRITE_ENABLE,
+    OP_CS_LOW,
+    OP_SEND_PARAM(PARAM_CMD, 0),
+    OP_SEND_PARAM(PARAM_ADDRESS, 16),
+    OP_SEND_PARAM(PARAM_ADDRESS, 8),
+    OP_SEND_PARAM(PARAM_ADDRESS, 0),
+    OPS_END_OF_COMMAND,
+    OPS_WAIT_FOR_THIS
+    OP_END
+};
+
+#ifndef FEAT_XIP_CACHE_STAGING
+// parameters: PARAM_ADDRESS = start address, data
+static const qspi_op_typ TIME_CRITICAL_DATA(write_page_program)[] = {
+    OPS_WAIT_FOR_PREVIOUS
+    OPS_WRITE_ENABLE,
+    OP_CS_LOW,
+    OP_SEND(FLASHCMD_PAGE_PROGRAM),
+    OP_SEND_PARAM(PARAM_ADDRESS, 16),
+    OP_SEND_PARAM(PARAM_ADDRESS, 8),
+    OP_SEND_PARAM(PARAM_ADDRESS, 0),
+    {QOP_SEND_DATA, NULL, 0, 0},
+    OPS_END_OF_COMMAND,
+    OPS_WAIT_FOR_THIS
+    OP_END
+};
+#else
+// The XIP cache is disabled while the flash is in command mode. Its 16KB
+// are then plain SRAM at XIP_STAGING_ADDRESS. The page is uploaded there (one
+// SWD write per 4 bytes instead of one write to DR0 per byte plus reading the
+// received bytes back) and a DMA channel of the target sends it to the SSI.
+// The SSI only transmits while the DMA runs, so nothing needs to be drained.
+// The application's SRAM is not touched. flash_enter_XIP() flushes the cache.
+#define XIP_STAGING_ADDRESS     0x15000000
+#define XIP_SSI_DR0_ADDRESS     0x18000060
+#define DREQ_XIP_SSITX          38
+// the DMA channel used for the staged data (chain to itself = no chaining)
+#define STAGING_DMA_CHANNEL     11
+#define STAGING_DMA_CTRL        ( (1 << DMA_CH11_CTRL_TRIG_EN_OFFSET)                                        \
+                                | (DMA_CH11_CTRL_TRIG_DATA_SIZE_SIZE_BYTE << DMA_CH11_CTRL_TRIG_DATA_SIZE_OFFSET) \
+                                | (1 << DMA_CH11_CTRL_TRIG_INCR_READ_OFFSET)                                 \
+                                | (STAGING_DMA_CHANNEL << DMA_CH11_CTRL_TRIG_CHAIN_TO_OFFSET)                \
+                                | (DREQ_XIP_SSITX << DMA_CH11_CTRL_TRIG_TREQ_SEL_OFFSET) )
+// DMA request while the TX FIFO has less than this many bytes
+#define STAGING_TX_WATERMARK    8
+
+// parameters: PARAM_ADDRESS = start address, PARAM_LENGTH = length, data
+static const qspi_op_typ TIME_CRITICAL_DATA(write_page_staged_program)[] = {
+    // the DMA of the last page has finished, so the staging area is free
+    // (with FEAT_PIPELINED_FLASH the flash is still busy with the last page)
+    {QOP_UPLOAD_DATA, (volatile uint32_t*)XIP_STAGING_ADDRESS, 0, 0},
+    OPS_WAIT_FOR_PREVIOUS
+    OPS_WRITE_ENABLE,
+    OP_CS_LOW,
+    OP_SEND(FLASHCMD_PAGE_PROGRAM),
+    OP_SEND_PARAM(PARAM_ADDRESS, 16),
+    OP_SEND_PARAM(PARAM_ADDRESS, 8),
+    OP_SEND_PARAM(PARAM_ADDRESS, 0),
+    OP_WAIT_TX_EMPTY,
+    OP_DRAIN_RX(0),
+    // /CS stays low (override) while the SSI is reconfigured for TX only
+    OP_WRITE(XIP_SSI->SSIENR, 0),
+    OP_WRITE(XIP_SSI->CTRLR[0], SSI_CTRLR0_SPI(XIP_SSI_CTRLR0_TMOD_TX_ONLY)),
+    OP_WRITE(XIP_SSI->DMATDLR, STAGING_TX_WATERMARK),
+    OP_WRITE(XIP_SSI->DMACR, XIP_SSI_DMACR_TDMAE_MASK),
+    OP_WRITE(XIP_SSI->SSIENR, 1),
+    OP_WRITE(DMA->CH11_READ_ADDR, XIP_STAGING_ADDRESS),
+    OP_WRITE(DMA->CH11_WRITE_ADDR, XIP_SSI_DR0_ADDRESS),
+    OP_WRITE_PARAM(DMA->CH11_TRANS_COUNT, PARAM_LENGTH),
+    OP_WRITE(DMA->CH11_CTRL_TRIG, STAGING_DMA_CTRL),
+    OP_POLL(DMA->CH11_CTRL_TRIG, DMA_CH11_CTRL_TRIG_BUSY_MASK, 0),
+    OP_WAIT_TX_EMPTY,
+    OP_WAIT_NOT_BUSY,
+    OP_CS_HIGH,
+    // back to TX and RX
+    OP_WRITE(XIP_SSI->SSIENR, 0),
+    OP_WRITE(XIP_SSI->DMACR, 0),
+    OP_WRITE(XIP_SSI->DMATDLR, 0),
+    OP_WRITE(XIP_SSI->CTRLR[0], SSI_CTRLR0_SPI(XIP_SSI_CTRLR0_TMOD_TX_AND_RX)),
+    OP_WRITE(XIP_SSI->SSIENR, 1),
+    OPS_WAIT_FOR_THIS
+    OP_END
+};
+#endif
+
+#ifdef FEAT_ERASE_SUSPEND
+// parameters: PARAM_ADDRESS = address in the SFDP table; result: 4 bytes in rx_word
+static const qspi_op_typ TIME_CRITICAL_DATA(read_sfdp_program)[] = {
+    OP_CS_LOW,
+    OP_SEND(FLASHCMD_READ_SFDP),
+    OP_SEND_PARAM(PARAM_ADDRESS, 16),
+    OP_SEND_PARAM(PARAM_ADDRESS, 8),
+    OP_SEND_PARAM(PARAM_ADDRESS, 0),
+    OP_SEND(0xff), // dummy byte
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OPS_END_OF_COMMAND,
+    OP_END
+};
+
+// parameters: PARAM_ADDRESS = flash address; result: 4 bytes in rx_word
+// If the flash can not suspend this waits until the erase has finished.
+static const qspi_op_typ TIME_CRITICAL_DATA(read_data_program)[] = {
+    OPS_WAIT_WHILE_FLASH_BUSY,
+    OP_CS_LOW,
+    OP_SEND(FLASHCMD_READ_DATA),
+    OP_SEND_PARAM(PARAM_ADDRESS, 16),
+    OP_SEND_PARAM(PARAM_ADDRESS, 8),
+    OP_SEND_PARAM(PARAM_ADDRESS, 0),
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OP_SEND(0xff),
+    OPS_END_OF_COMMAND,
+    OP_END
+};
+
+// parameters: PARAM_CMD = suspend command
+// The flash is not busy anymore once the erase is suspended.
+static const qspi_op_typ TIME_CRITICAL_DATA(suspend_program)[] = {
+    OP_CS_LOW,
+    OP_SEND_PARAM(PARAM_CMD, 0),
+    OPS_END_OF_COMMAND,
+    OPS_WAIT_WHILE_FLASH_BUSY,
+    OP_END
+};
+
+// parameters: PARAM_CMD = resume command
+static const qspi_op_typ TIME_CRITICAL_DATA(resume_program)[] = {
+    OP_CS_LOW,
+    OP_SEND_PARAM(PARAM_CMD, 0),
+    OPS_END_OF_COMMAND,
+    OP_END
+};
+#endif
+
+static const qspi_op_typ TIME_CRITICAL_DATA(enter_XIP_program)[] = {
+    OPS_WAIT_FOR_PREVIOUS
+    // do the initial read (command + Address + continuation code + read)
+    OP_WRITE(XIP_SSI->SSIENR, 0), // disable SSI
+    // configure the SSI
+    OP_WRITE(XIP_SSI->CTRLR[0],
+                (XIP_SSI_CTRLR0_SPI_FRF_QUAD << XIP_SSI_CTRLR0_SPI_FRF_OFFSET) // QSPI frames / SPI Frames
+                | (1 << XIP_SSI_CTRLR0_DFS_32_OFFSET) // 8 bits per data frame -> 2 clock in QSPI (value is n+1)
+                | (7 << XIP_SSI_CTRLR0_CFS_OFFSET)    // 8 clocks per control fame (value is n+1)
+                | (XIP_SSI_CTRLR0_TMOD_RX_ONLY << XIP_SSI_CTRLR0_TMOD_OFFSET)
+                | (8 << XIP_SSI_CTRLR0_DFS_OFFSET)
+                ),
+    OP_WRITE(XIP_SSI->CTRLR[1], 3), // read this many bytes
+    // configure the SPI
+    OP_WRITE(XIP_SSI->SPI_CTRLR0,
+                (0xebul << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET) // Command 0x03 = read SPI (1 bit per clock); 0xeb = read QSPI (4 bits per clock)
+                                                              // or append to address (INST_L = 0)
+              | (4 << XIP_SSI_SPI_CTRLR0_WAIT_CYCLES_OFFSET)
+              | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
+              | (8 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET) // in 4 bit increments -> 24 bit = 6; 32bit = 8;
+              | (XIP_SSI_SPI_CTRLR0_TRANS_TYPE_1C2A << XIP_SSI_SPI_CTRLR0_TRANS_TYPE_OFFSET)  // command is SPI, Address and data is QSPI
+                ),
+    OP_WRITE(XIP_SSI->SER, 0), // disable slave
+    OP_WRITE(XIP_SSI->SSIENR, 1), // enable SSI
+    OP_CS_LOW,
+    // RX only mode: command and address do not create received bytes
+    OP_WRITE(XIP_SSI->DR0, 0xeb),
+    OP_WRITE(XIP_SSI->DR0, 0xa0),
+    OP_WRITE(XIP_SSI->SER, 1), // enable slave
+    OP_WAIT_TX_EMPTY,
+    OP_DRAIN_RX(4),  // we read 4 bytes from the Flash
+    OP_WAIT_NOT_BUSY,
+    OP_CS_HIGH,
+
+    // flash_flush_cache()
+    OP_WRITE(XIP_CTRL->FLUSH, 1),
+    OP_POLL(XIP_CTRL->STAT, 1, 1), // wait until flush has completed
+    // restore XIP_CTRL (the cache must stay powered) and enable the cache
+    OP_RESTORE_MASKED(XIP_CTRL->CTRL, SAVED_XIP_CTRL, ~(uint32_t)XIP_CTRL_CTRL_POWER_DOWN_MASK),
+    {QOP_WRITE, REG_ALIAS(&(XIP_CTRL->CTRL), REG_ALIAS_SET_BITS), XIP_CTRL_CTRL_EN_MASK, 0}, // enable cache
+    OP_WRITE(IO_QSPI->GPIO_QSPI_SS_CTRL, 0), // QSPI Chip Select signal back to normal
+
+    // flash_enter_cmd_xip()
+    OP_WRITE(XIP_SSI->SSIENR, 0), // disable SSI
+    OP_WRITE(XIP_SSI->CTRLR[0], 0x005f0300), // magic value needed by XiP peripheral
+    OP_WRITE(XIP_SSI->SPI_CTRLR0, 0xa0002022), // magic value needed by XiP peripheral
+    OP_WRITE(XIP_SSI->CTRLR[1], 0),
+    OP_RESTORE(XIP_SSI->DMACR, SAVED_SSI_DMACR),
+    OP_RESTORE(XIP_SSI->DMATDLR, SAVED_SSI_DMATDLR),
+    OP_WRITE(XIP_SSI->SSIENR, 1), // enable SSI
+#ifdef FEAT_XIP_CACHE_STAGING
+    // DMA channel 11 as the application left it (AL1_CTRL does not trigger a transfer)
+    OP_RESTORE(DMA->CH11_READ_ADDR, SAVED_DMA_READ_ADDR),
+    OP_RESTORE(DMA->CH11_WRITE_ADDR, SAVED_DMA_WRITE_ADDR),
+    OP_RESTORE(DMA->CH11_TRANS_COUNT, SAVED_DMA_TRANS_COUNT),
+    OP_RESTORE(DMA->CH11_AL1_CTRL, SAVED_DMA_CTRL),
+    // back into reset if the DMA was in reset
+    {QOP_RESTORE, REG_ALIAS(&(RESETS->RESET), REG_ALIAS_SET_BITS), SAVED_RESETS, RESETS_RESET_DMA_MASK},
+#endif
+    OP_END
+};
+
+typedef enum {
+    CAL_REFERENCE,
+    CAL_SEARCH,
+    CAL_VERIFY,
+    CAL_QUAD_REFERENCE,
+    CAL_QUAD_VERIFY,
+    CAL_USE_DEFAULT,
+} calibration_phase_typ;
+
+static qspi_program_typ prog;
+// SSI setting for this session
+static bool ssi_calibrated;
+static uint32_t ssi_sckdv;
+static uint32_t ssi_rsd;
+static uint32_t ssi_clocks[NUM_CAL_CLOCKS];  // clk_sys configuration of the calibration
+// calibration
+static bool calibrating;
+static calibration_phase_typ cal_phase;
+static uint32_t cal_reference_id;
+static uint32_t cal_sckdv;
+static uint32_t cal_rsd;
+static uint32_t cal_reads;
+static bool cal_rsd_ok;
+static uint32_t cal_ok_mask;  // bit n = sample delay n worked
+static uint32_t cal_quad_reference;
+#ifdef FEAT_ERASE_SUSPEND
+static bool suspend_checked;
+static bool checking_suspend;
+static uint32_t sfdp_step;
+static uint32_t sfdp_bfpt_address;
+static bool suspend_supported;
+static uint32_t suspend_cmd;
+static uint32_t resume_cmd;
+// block of the last erase command (start == end: a page program came after it)
+static uint32_t erase_block_start;
+static uint32_t erase_block_end;
+#endif
+#ifdef FEAT_TARGET_CLOCK_BOOST
+static bool clocks_saved;  // prog.saved has the original clock configuration of the target
+static bool boosting;
+static bool restoring;
+#endif
+
+static Result flash_erase_param(flash_action_data_typ* const state, uint32_t start_address, uint32_t erase_cmd, uint32_t size);
+static Result run_program(flash_action_data_typ* const state);
+static void start_initialize_program(void);
+static void start_read_id(uint32_t sckdv, uint32_t rsd);
+static Result calibrate(flash_action_data_typ* const state);
+static bool select_rsd(uint32_t ok_mask, uint32_t* rsd);
+#ifdef FEAT_TARGET_CLOCK_BOOST
+static Result boost_clocks(flash_action_data_typ* const state);
+static Result restore_clocks(flash_action_data_typ* const state);
+#endif
+#ifdef FEAT_ERASE_SUSPEND
+static Result start_suspend_check(void);
+static Result check_suspend(flash_action_data_typ* const state);
+#endif
+
+
+void flash_actions_init(void)
 {
-    Result res;
+    // the next flash_initialize() calibrates again
+    ssi_calibrated = false;
+    ssi_sckdv = QSPI_BAUDRATE_DIVIDOR;
+    ssi_rsd = QSPI_RX_SAMPLE_DELAY;
+#ifdef FEAT_ERASE_SUSPEND
+    suspend_checked = false;
+    suspend_supported = false;
+    erase_block_start = 0;
+    erase_block_end = 0;
+#endif
+#ifdef FEAT_TARGET_CLOCK_BOOST
+    // after a reset the target runs from its reset clocks, nothing to restore
+    clocks_saved = false;
+    boosting = false;
+    restoring = false;
+#endif
+}
 
-    if(NULL == state)
-    {
-        return ERR_ACTION_NULL;
-    }
+static Result run_program(flash_action_data_typ* const state)
+{
+    Result res = qspi_program_run(&prog);
+    state->phase = prog.pc;
+    return res;
+}
 
-    if(true == state->first_call)
+static void start_initialize_program(void)
+{
+    if(false == ssi_calibrated)
     {
-        debug_line("starting flash_initialize()");
-        state->phase = 0;
-        state->first_call = false;
-        act_state.first_call =true;
+        // start slow, calibrate later
+        ssi_sckdv = QSPI_BAUDRATE_DIVIDOR;
+        ssi_rsd = QSPI_RX_SAMPLE_DELAY;
     }
+    qspi_program_start(&prog, initialize_program);
+    prog.param[PARAM_SCKDV] = ssi_sckdv;
+    prog.param[PARAM_RSD] = ssi_rsd;
+}
 
-    // power on QSPI
-    if(0 == state->phase)
+static void start_read_id(uint32_t sckdv, uint32_t rsd)
+{
+    qspi_program_start(&prog, read_id_program);
+    prog.param[PARAM_SCKDV] = sckdv;
+    prog.param[PARAM_RSD] = rsd;
+}
+
+static void start_read_quad(uint32_t sckdv, uint32_t rsd)
+{
+    qspi_program_start(&prog, read_quad_program);
+    prog.param[PARAM_SCKDV] = sckdv;
+    prog.param[PARAM_RSD] = rsd;
+    prog.param[PARAM_ADDRESS] = CAL_QUAD_ADDRESS << 8;
+}
+
+// true if clk_sys (saved by initialize_program) is configured as during the calibration
+static bool same_clocks(void)
+{
+    uint32_t i;
+    for(i = 0; i < NUM_CAL_CLOCKS; i++)
     {
-        res = act_read_register(&act_state, &(PSM->FRCE_ON), &val);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call =true;
-        }
-        else
+        if(ssi_clocks[i] != prog.saved[SAVED_CAL_CLOCKS + i])
         {
-            return res;
+            return false;
         }
     }
+    return true;
+}
 
-    if(1 == state->phase)
+// longest run of working sample delays, at least 2 long -> its middle
+static bool select_rsd(uint32_t ok_mask, uint32_t* rsd)
+{
+    uint32_t i;
+    uint32_t run_start = 0;
+    uint32_t run_length = 0;
+    uint32_t best_start = 0;
+    uint32_t best_length = 0;
+    for(i = 0; i <= CAL_MAX_RSD + 1; i++)
     {
-        val = val | (1 << PSM_FRCE_ON_XIP_OFFSET);
-        res = step_write_ap(&(PSM->FRCE_ON), val);
-        if(RESULT_OK == res)
+        if((i <= CAL_MAX_RSD) && (0 != (ok_mask & (1u << i))))
         {
-            state->phase++;
-            act_state.first_call = true;
+            if(0 == run_length)
+            {
+                run_start = i;
+            }
+            run_length++;
         }
         else
         {
-            return res;
+            if(run_length > best_length)
+            {
+                best_start = run_start;
+                best_length = run_length;
+            }
+            run_length = 0;
         }
     }
-
-    // reset QSPI
-    // read currently in reset peripherals
-    if(2 == state->phase)
+    if(2 > best_length)
     {
-        res = act_read_register(&act_state, &(RESETS->RESET), &val);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call =true;
-        }
-        else
-        {
-            return res;
-        }
+        return false;
     }
+    *rsd = best_start + (best_length - 1) / 2;
+    return true;
+}
 
-    // put QSPI in Reset
-    if(3 == state->phase)
+static Result calibrate(flash_action_data_typ* const state)
+{
+    uint32_t i;
+    uint32_t id;
+    Result res = run_program(state);
+    if(ERR_NOT_COMPLETED == res)
     {
-        val = val | (1 << RESETS_RESET_IO_QSPI_OFFSET) | (1 << RESETS_RESET_PADS_QSPI_OFFSET);
-        res = step_write_ap(&(RESETS->RESET), val);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return res;
     }
-
-    // end QSPI Reset
-    if(4 == state->phase)
+    if(RESULT_OK != res)
     {
-        val = val & ~((uint32_t)(1 << RESETS_RESET_IO_QSPI_OFFSET) | (uint32_t)(1 << RESETS_RESET_PADS_QSPI_OFFSET));
-        res = step_write_ap(&(RESETS->RESET), val);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
+        calibrating = false;
+        return res;
     }
+    id = prog.rx_word & 0xffffff;
 
-    // wait for reset done
-    if(5 == state->phase)
+    switch(cal_phase)
     {
-        res = act_read_register(&act_state, &(RESETS->RESET), &val);
-        if(RESULT_OK == res)
+    case CAL_REFERENCE:
+        if((0 == id) || (0xffffff == id))
         {
-            act_state.first_call = true;
-            uint32_t reset_mask = (1 << RESETS_RESET_IO_QSPI_OFFSET) | (1 << RESETS_RESET_PADS_QSPI_OFFSET);
-            if(0 == (val & reset_mask))  // bit is 0 if reset is done
-            {
-                // Reset is now done
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
+            debug_line("no JEDEC ID (0x%06lx) -> no SSI calibration", id);
+            cal_phase = CAL_USE_DEFAULT;
+            start_read_id(QSPI_BAUDRATE_DIVIDOR, QSPI_RX_SAMPLE_DELAY);
+            return ERR_NOT_COMPLETED;
         }
-        else
+        cal_reference_id = id;
+        cal_sckdv = CAL_MIN_SCKDV;
+        cal_rsd = 0;
+        cal_reads = 0;
+        cal_rsd_ok = true;
+        cal_ok_mask = 0;
+        cal_phase = CAL_SEARCH;
+        start_read_id(cal_sckdv, cal_rsd);
+        return ERR_NOT_COMPLETED;
+
+    case CAL_SEARCH:
+        cal_reads++;
+        if(id != cal_reference_id)
         {
-            return res;
+            cal_rsd_ok = false;
         }
-    }
-
-    // set PADS_QSPI Registers
-    if(6 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->VOLTAGE_SELECT), 0); // 3.3V
-        if(RESULT_OK == res)
+        if((true == cal_rsd_ok) && (CAL_NUM_READS > cal_reads))
         {
-            state->phase++;
+            // read again with the same setting
+            start_read_id(cal_sckdv, cal_rsd);
+            return ERR_NOT_COMPLETED;
         }
-        else
+        if(true == cal_rsd_ok)
         {
-            return res;
+            cal_ok_mask = cal_ok_mask | (1u << cal_rsd);
         }
-    }
-
-    if(7 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SCLK),
-                               (1<< PADS_QSPI_GPIO_QSPI_SCLK_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SCLK_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SCLK_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
+        cal_rsd++;
+        cal_reads = 0;
+        cal_rsd_ok = true;
+        if((CAL_MAX_RSD >= cal_rsd) && (cal_rsd < cal_sckdv))
         {
-            state->phase++;
+            // next sample delay
+            start_read_id(cal_sckdv, cal_rsd);
+            return ERR_NOT_COMPLETED;
         }
-        else
+        if(true == select_rsd(cal_ok_mask, &cal_rsd))
         {
-            return res;
+            cal_phase = CAL_VERIFY;
+            start_read_id(cal_sckdv, cal_rsd);
+            return ERR_NOT_COMPLETED;
         }
-    }
-
-    if(8 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[0]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
+        // next slower clock
+        cal_sckdv = cal_sckdv + 2; // SCKDV must be even
+        cal_rsd = 0;
+        cal_ok_mask = 0;
+        if(QSPI_BAUDRATE_DIVIDOR <= cal_sckdv)
         {
-            state->phase++;
+            cal_phase = CAL_USE_DEFAULT;
+            start_read_id(QSPI_BAUDRATE_DIVIDOR, QSPI_RX_SAMPLE_DELAY);
         }
         else
         {
-            return res;
+            start_read_id(cal_sckdv, cal_rsd);
         }
-    }
+        return ERR_NOT_COMPLETED;
 
-    if(9 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[1]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD1_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD1_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD1_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
+    case CAL_VERIFY:
+        if(id != cal_reference_id)
         {
-            state->phase++;
+            debug_error("ERROR: SSI setting %ld/%ld read 0x%06lx !", cal_sckdv, cal_rsd, id);
+            cal_phase = CAL_USE_DEFAULT;
+            start_read_id(QSPI_BAUDRATE_DIVIDOR, QSPI_RX_SAMPLE_DELAY);
+            return ERR_NOT_COMPLETED;
         }
-        else
+        cal_phase = CAL_QUAD_REFERENCE;
+        start_read_quad(CAL_REFERENCE_SCKDV, QSPI_RX_SAMPLE_DELAY);
+        return ERR_NOT_COMPLETED;
+
+    case CAL_QUAD_REFERENCE:
+        cal_quad_reference = prog.rx_word;
+        cal_phase = CAL_QUAD_VERIFY;
+        start_read_quad(cal_sckdv, cal_rsd);
+        return ERR_NOT_COMPLETED;
+
+    case CAL_QUAD_VERIFY:
+        if(cal_quad_reference != prog.rx_word)
         {
-            return res;
+            debug_error("ERROR: SSI setting %ld/%ld quad read 0x%08lx instead of 0x%08lx !",
+                        cal_sckdv, cal_rsd, prog.rx_word, cal_quad_reference);
+            cal_phase = CAL_USE_DEFAULT;
+            start_read_id(QSPI_BAUDRATE_DIVIDOR, QSPI_RX_SAMPLE_DELAY);
+            return ERR_NOT_COMPLETED;
         }
-    }
+        ssi_sckdv = cal_sckdv;
+        ssi_rsd = cal_rsd;
+        break;
 
-    if(10 == state->phase)
+    case CAL_USE_DEFAULT:
+    default:
+        ssi_sckdv = QSPI_BAUDRATE_DIVIDOR;
+        ssi_rsd = QSPI_RX_SAMPLE_DELAY;
+        break;
+    }
+    debug_line("SSI: clock divider %ld, RX sample delay %ld (JEDEC ID 0x%06lx)", ssi_sckdv, ssi_rsd, cal_reference_id);
+    for(i = 0; i < NUM_CAL_CLOCKS; i++)
     {
-        // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[2]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD2_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD2_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD2_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_PUE_OFFSET)         // Pull up enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_SLEWFAST_OFFSET) ); // slew rate fast
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        ssi_clocks[i] = prog.saved[SAVED_CAL_CLOCKS + i];
     }
+    ssi_calibrated = true;
+    calibrating = false;
+    return RESULT_OK;
+}
+
+Result flash_initialize(flash_action_data_typ* const state)
+{
+    Result res;
 
-    if(11 == state->phase)
+    if(NULL == state)
     {
-        // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[3]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD3_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD3_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD3_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_PUE_OFFSET)         // Pull up enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_SLEWFAST_OFFSET) ); // slew rate fast
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    if(12 == state->phase)
+    if(true == state->first_call)
     {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SS),
-                               (1<< PADS_QSPI_GPIO_QSPI_SS_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SS_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SS_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_SLEWFAST_OFFSET) ); // slew rate fast
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        debug_line("starting flash_initialize()");
+        start_initialize_program();
+        calibrating = false;
+#ifdef FEAT_ERASE_SUSPEND
+        checking_suspend = false;
+#endif
+#ifdef FEAT_TARGET_CLOCK_BOOST
+        if(false == clocks_saved)
+        {
+            qspi_program_start(&prog, clock_boost_program);
+            boosting = true;
+        }
+#endif
+        state->first_call = false;
     }
-
-    // set IO_QSPI Registers
-    if(13 == state->phase)
+#ifdef FEAT_TARGET_CLOCK_BOOST
+    if(true == boosting)
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SCLK_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return boost_clocks(state);
     }
-
-    if(14 == state->phase)
+#endif
+    if(true == calibrating)
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), 0);
+        res = calibrate(state);
+#ifdef FEAT_ERASE_SUSPEND
         if(RESULT_OK == res)
         {
-            state->phase++;
-        }
-        else
-        {
-            return res;
+            res = start_suspend_check();
         }
+#endif
+        return res;
     }
-
-    if(15 == state->phase)
+#ifdef FEAT_ERASE_SUSPEND
+    if(true == checking_suspend)
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SD0_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return check_suspend(state);
     }
-
-    if(16 == state->phase)
+#endif
+    res = run_program(state);
+    if((RESULT_OK == res) && (true == ssi_calibrated) && (false == same_clocks()))
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SD1_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        // the SSI clock comes from clk_sys
+        debug_line("clk_sys changed -> SSI calibration");
+        ssi_calibrated = false;
     }
-
-    if(17 == state->phase)
+    if((RESULT_OK == res) && (false == ssi_calibrated))
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SD2_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        calibrating = true;
+        cal_phase = CAL_REFERENCE;
+        cal_reference_id = 0;
+        start_read_id(CAL_REFERENCE_SCKDV, QSPI_RX_SAMPLE_DELAY);
+        return ERR_NOT_COMPLETED;
     }
-
-    if(18 == state->phase)
+#ifdef FEAT_ERASE_SUSPEND
+    if(RESULT_OK == res)
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SD3_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        res = start_suspend_check();
     }
+#endif
+    return res;
+}
+
+Result flash_erase_64kb(flash_action_data_typ* const state, uint32_t start_address)
+{
+    // erase sector of size 64KB
+    return flash_erase_param(state, start_address, FLASHCMD_BLOCK_ERASE_64KB, 64 * 1024);
+}
+
+Result flash_erase_32kb(flash_action_data_typ* const state, uint32_t start_address)
+{
+    // erase sector of size 32KB
+    return flash_erase_param(state, start_address, FLASHCMD_BLOCK_ERASE_32KB, 32 * 1024);
+}
+
+Result flash_erase_4kb(flash_action_data_typ* const state, uint32_t start_address)
+{
+    // erase sector of size 4KB
+    return flash_erase_param(state, start_address, FLASHCMD_SECTOR_ERASE, 4 * 1024);
+}
 
-    if(19 == state->phase)
+static Result flash_erase_param(flash_action_data_typ* const state, uint32_t start_address, uint32_t erase_cmd, uint32_t size)
+{
+    if(NULL == state)
     {
-        res = step_write_ap(&(IO_QSPI->INTR), 0xcccccc); // write to clear
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    if(20 == state->phase)
+    if(true == state->first_call)
     {
-        res = step_write_ap(&(IO_QSPI->PROC0_INTE), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        dlog_2("starting flash_erase(0x%02lx @0x%08lx)", erase_cmd, start_address);
+        qspi_program_start(&prog, erase_program);
+        prog.param[PARAM_CMD] = erase_cmd;
+        prog.param[PARAM_ADDRESS] = start_address;
+#ifdef FEAT_ERASE_SUSPEND
+        erase_block_start = start_address;
+        erase_block_end = start_address + size;
+#else
+        (void)size;
+#endif
+        state->first_call = false;
     }
+    return run_program(state);
+}
 
-    if(21 == state->phase)
+Result flash_write_page(flash_action_data_typ* const state, uint32_t start_address, uint8_t* data , uint32_t length)
+{
+    if(NULL == state)
     {
-        res = step_write_ap(&(IO_QSPI->PROC0_INTF), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    if(22 == state->phase)
+    if(true == state->first_call)
     {
-        res = step_write_ap(&(IO_QSPI->PROC1_INTE), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
+        dlog_2("starting flash_write_page(@0x%08lx %ld)", start_address, length);
+        // write up to 256 bytes
+        if(start_address < 0x10000000)
         {
-            return res;
+            debug_error("ERROR: invalid start address(0x%08lx)", start_address);
+            return ERR_WRONG_VALUE;
         }
-    }
-
-    if(23 == state->phase)
-    {
-        res = step_write_ap(&(IO_QSPI->PROC1_INTF), 0);
-        if(RESULT_OK == res)
+        if(0 != (start_address & 0xffu))
         {
-            state->phase++;
+            debug_error("ERROR: start address not aligned (0x%08lx)", start_address);
+            return ERR_WRONG_VALUE;
         }
-        else
+        if(256 < length)
         {
-            return res;
+            debug_error("ERROR: write too long (%ld)", length);
+            return ERR_WRONG_VALUE;
         }
+#ifdef FEAT_XIP_CACHE_STAGING
+        qspi_program_start(&prog, write_page_staged_program);
+        prog.param[PARAM_LENGTH] = length;
+#else
+        qspi_program_start(&prog, write_page_program);
+#endif
+        prog.param[PARAM_ADDRESS] = start_address;
+        prog.data = data;
+        prog.length = length;
+#ifdef FEAT_ERASE_SUSPEND
+        // the flash is now busy with the page program, not the erase
+        erase_block_end = erase_block_start;
+#endif
+        state->first_call = false;
     }
-
-    if(24 == state->phase)
-    {
-        res = step_write_ap(&(IO_QSPI->DORMANT_WAKE_INTE), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(25 == state->phase)
-    {
-        res = step_write_ap(&(IO_QSPI->DORMANT_WAKE_INTF), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // set XIP_CTRL Registers
-    if(26 == state->phase)
-    {
-        res = step_write_ap(&(XIP_CTRL->CTRL), 0); // ignore bad memory accesses, keep cache powered
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // set XIP_SSI Registers
-    if(27 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 0); // Disable SSI for further configuration
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(28 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SER), (1 << XIP_SSI_SER_SER_OFFSET)); // 1 = slave selected; 0 = slave not selected
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(29 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->BAUDR), (QSPI_BAUDRATE_DIVIDOR << XIP_SSI_BAUDR_SCKDV_OFFSET)); // set baud rate
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(30 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->TXFTLR), 0); // TX FIFO threshold
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(31 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->RXFTLR), 0); // RX FIFO threshold
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(32 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->IMR), 0); // no interrupts masked
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(33 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DMACR), 0); // no DMA
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(34 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DMATDLR), 0); // transmit data water mark level
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(35 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DMARDLR), 4); // receive data water mark level (data sheet says it should not be changed from 4)
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(36 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->RX_SAMPLE_DLY), (1 << XIP_SSI_RX_SAMPLE_DLY_RSD_OFFSET)); // delay in System clock cycles
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(37 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->TXD_DRIVE_EDGE), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(38 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->CTRLR[0]),
-                                    // SSTE = Slave select toggle enable
-                                    (1 << XIP_SSI_CTRLR0_SSTE_OFFSET) |
-                                    (XIP_SSI_CTRLR0_SPI_FRF_STD << XIP_SSI_CTRLR0_SPI_FRF_OFFSET) | // QSPI frames / SPI Frames
-                                    (7 << XIP_SSI_CTRLR0_DFS_32_OFFSET) | // 8 clocks per data frame
-                                    (XIP_SSI_CTRLR0_TMOD_TX_AND_RX << XIP_SSI_CTRLR0_TMOD_OFFSET)  // TX and RX FIFOs are both used for every byte
-                                    // CFS = Control Frame size = Microwire only !
-                                    // SRL = Shift Register loop (test mode)
-                                    // SLV_OE = Slave Output enable
-                                    // SPI MOD = 0 = (SCPOL = 0; SCPH = 0)
-                                    // FRF = 00 = Motorola SPI
-                                    // DFS = invalid (dfs_32 is used) writing has no effect!
-                                    );
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(39 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->CTRLR[1]), 0); // NDF = 0 = number of data frames used with Quad SPI
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(40 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SPI_CTRLR0),
-                                    (0x03 << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET) //   Command 0x03 = read SPI (1 bit per clock); 0xeb = read QSPI (4 bits per clock)
-                                  | (0 << XIP_SSI_SPI_CTRLR0_WAIT_CYCLES_OFFSET)
-                                  | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
-                                  | (6 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET) // in 4 bit increments -> 24 bit = 6
-                                    );
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(41 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->ICR), &val); // clear all active interrupts
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call =true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(42 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val); // Clear sticky errors (clear-on-read)
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call =true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(43 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->ICR), &val); // Clear sticky errors (clear-on-read)
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call =true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(44 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 1); // Re-enable SSI
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // make sure we are not in XIP mode (Continuous Read Mode)
-    // Sequence:
-    // 1. CSn = 1, IO = 4'h0 (via pull-down to avoid contention), x32 clocks
-    // 2. CSn = 0, IO = 4'hf (via pull-up to avoid contention), x32 clocks
-    // 3. CSn = 1 (brief deassertion)
-    // 4. CSn = 0, MOSI = 1'b1 driven, x16 clocks
-    //
-    // Part 4 is the sequence suggested in W25X10CL data sheet.
-    // Parts 1 and 2 are to improve compatibility with Micron parts
-
-    // 1. CSn = 1, IO = 4'h0 (via pull-down to avoid contention), x32 clocks
-        // First two 32-clock sequences
-        // CSn is held high for the first 32 clocks, then asserted low for next 32
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(45 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(46 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(47 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(48 == state->phase)
-    {
-        val = (1 < PADS_QSPI_GPIO_QSPI_SD0_OD_OFFSET)          // output disabled
-            | (1<< PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)          // Input enable
-            | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_PDE_OFFSET)        // Pull down enable
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)    // enable schmitt trigger
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET);  // slew rate fast
-
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[0]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(49 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[1]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(50 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[2]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(51 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[3]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(52 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(53 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(54 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(55 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(56 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 4;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(57 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(58 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 57; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(59 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(60 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(61 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // 2. CSn = 0, IO = 4'hf (via pull-up to avoid contention), x32 clocks
-
-    if(62 == state->phase)
-    {
-        val = (1 < PADS_QSPI_GPIO_QSPI_SD0_OD_OFFSET)          // output disabled
-            | (1<< PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)          // Input enable
-            | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_PUE_OFFSET)        // Pull up enable
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)    // enable schmitt trigger
-            | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET);  // slew rate fast
-
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[0]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(63 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[1]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(64 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[2]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(65 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[3]), val);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(66 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(67 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(68 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(69 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(70 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 4;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(71 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(72 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 71; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(73 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // 3. CSn = 1 (brief de-assertion)
-
-    if(74 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(75 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // 4. CSn = 0, MOSI = 1'b1 driven, x16 clocks
-
-    if(76 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SCLK),
-                               (1<< PADS_QSPI_GPIO_QSPI_SCLK_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SCLK_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SCLK_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SCLK_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(77 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[0]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD0_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD0_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD0_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD0_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(78 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[1]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD1_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD1_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD1_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD1_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(79 == state->phase)
-    {
-        // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[2]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD2_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD2_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD2_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_PUE_OFFSET)         // Pull up enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD2_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(80 == state->phase)
-    {
-        // put pull-up on SD2/SD3 as these may be used as WPn/HOLDn
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SD[3]),
-                               (1<< PADS_QSPI_GPIO_QSPI_SD3_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SD3_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SD3_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_PUE_OFFSET)         // Pull up enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SD3_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(81 == state->phase)
-    {
-        res = step_write_ap(&(PADS_QSPI->GPIO_QSPI_SS),
-                               (1<< PADS_QSPI_GPIO_QSPI_SS_IE_OFFSET)           // Input enable
-                             | (PADS_QSPI_GPIO_QSPI_SS_DRIVE_4MA << PADS_QSPI_GPIO_QSPI_SS_DRIVE_OFFSET)
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_PDE_OFFSET)         // Pull down enable
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_SCHMITT_OFFSET)     // enable schmitt trigger
-                             | (1 << PADS_QSPI_GPIO_QSPI_SS_SLEWFAST_OFFSET) ); // slew rate fast
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(82 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(83 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0xff);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(84 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0xff);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(85 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 2;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(86 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(87 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 86; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(88 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(89 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            // action->cur_phase++;
-            return RESULT_OK;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    return ERR_WRONG_STATE;
-}
-
-Result flash_erase_64kb(flash_action_data_typ* const state, uint32_t start_address)
-{
-    // erase sector of size 64KB
-    return flash_erase_param(state, start_address, FLASHCMD_BLOCK_ERASE_64KB);
-}
-
-Result flash_erase_32kb(flash_action_data_typ* const state, uint32_t start_address)
-{
-    // erase sector of size 32KB
-    return flash_erase_param(state, start_address, FLASHCMD_BLOCK_ERASE_32KB);
-}
-
-Result flash_erase_4kb(flash_action_data_typ* const state, uint32_t start_address)
-{
-    // erase sector of size 4KB
-    return flash_erase_param(state, start_address, FLASHCMD_SECTOR_ERASE);
-}
-
-static Result flash_erase_param(flash_action_data_typ* const state, uint32_t start_address, uint32_t erase_cmd)
-{
-    Result res;
-
-    if(NULL == state)
-    {
-        return ERR_ACTION_NULL;
-    }
-
-    if(true == state->first_call)
-    {
-        debug_line("starting flash_erase(0x%02lx @0x%08lx)", erase_cmd, start_address);
-        state->phase = 0;
-        state->first_call = false;
-        act_state.first_call =true;
-    }
-
-    if(0 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(1 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), FLASHCMD_WRITE_ENABLE);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(2 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 1;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(3 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(4 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 3; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(5 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(6 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(7 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(8 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & erase_cmd));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(9 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address>>16));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(10 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address>>8));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(11 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(12 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 4;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(13 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(14 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 13; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(15 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(16 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            cnt = 5;
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // begin of status read loop
-    if(17 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(18 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & FLASHCMD_READ_STATUS));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(19 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(20 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(21 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);  // skip a byte
-        if(RESULT_OK == res)
-        {
-            // debug_line("INFO: skip status as 0x%02lx!",val );
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(22 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(23 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &status);
-        if(RESULT_OK == res)
-        {
-            debug_line("INFO: read status as 0x%02lx!",status );
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(24 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(25 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(26 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            cnt = 5;
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(27 == state->phase)
-    {
-        if(0xff == status)
-        {
-            // something is wrong here
-            debug_error("ERROR: could not read QSPI Flash status !");
-            return ERR_TARGET_ERROR;
-        }
-        if(status & STATUS_REGISTER_BUSY)
-        {
-            // still busy
-            state->phase = 17; // go back to start of loop
-            return ERR_NOT_COMPLETED;
-        }
-        else
-        {
-            return RESULT_OK;
-        }
-    }
-
-    return ERR_WRONG_STATE;
-}
-
-Result flash_write_page(flash_action_data_typ* const state, uint32_t start_address, uint8_t* data , uint32_t length)
-{
-    Result res;
-
-    if(NULL == state)
-    {
-        return ERR_ACTION_NULL;
-    }
-
-    if(true == state->first_call)
-    {
-        debug_line("starting flash_write_page(@0x%08lx %ld)", start_address, length);
-        // write up to 256 bytes
-        if(start_address < 0x10000000)
-        {
-            debug_error("ERROR: invalid start address(0x%08lx)", start_address);
-            return ERR_WRONG_VALUE;
-        }
-        if(0 != (start_address & 0xffu))
-        {
-            debug_error("ERROR: start address not aligned (0x%08lx)", start_address);
-            return ERR_WRONG_VALUE;
-        }
-        if(256 < length)
-        {
-            debug_error("ERROR: write too long (%ld)", length);
-            return ERR_WRONG_VALUE;
-        }
-
-        state->phase = 0;
-        state->first_call = false;
-        act_state.first_call = true;
-    }
-
-    if(0 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(1 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), FLASHCMD_WRITE_ENABLE);
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(2 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(3 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(4 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(5 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(6 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & FLASHCMD_PAGE_PROGRAM));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(7 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address>>16));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(8 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address>>8));
-
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(9 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & start_address));
-
-        if(RESULT_OK == res)
-        {
-            cnt = 5;
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(10 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if((RESULT_OK == res) && (0 < val))
-        {
-            act_state.first_call = true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(11 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == val)
-            {
-                state->phase = 10; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // start of copy loop
-    if(12 == state->phase)
-    {
-        cnt = 0;  // no byte send
-        cnt_2 = 0; // no byte received
-        state->phase++;
-        act_state.first_call = true;
-    }
-
-    if(13 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->TXFLR), &tx_level);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(tx_level < FIFO_SIZE)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // FIFO is full
-                // -> read it again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(14 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &rx_level);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(15 == state->phase)
-    {
-        if(0 < rx_level)
-        {
-            res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-            if(RESULT_OK == res)
-            {
-                cnt_2++; // received a byte
-                rx_level--;
-                state->phase++;
-                act_state.first_call = true;
-            }
-            else
-            {
-                return res;
-            }
-        }
-        else
-        {
-            state->phase++;
-        }
-    }
-
-    if(16 == state->phase)
-    {
-        if(length > cnt)
-        {
-            res = step_write_ap(&(XIP_SSI->DR0), data[cnt]);
-            if(RESULT_OK == res)
-            {
-                cnt++; // send a byte
-                tx_level++;
-                if(tx_level > FIFO_SIZE)
-                {
-                    state->phase = 13; // read FIFO levels next
-                }
-                else
-                {
-                    state->phase = 15;  // read/write another byte
-                }
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return res;
-            }
-        }
-        else
-        {
-            // we send all data
-            state->phase++;
-            act_state.first_call = true;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(17 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(18 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-                act_state.first_call = true;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(19 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // read last bytes - make sure no bytes remain in read queue
-    if(20 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &rx_level);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(21 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);  // skip a byte
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            rx_level--;
-            if(0 == rx_level)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // read another byte
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // just to be super sure - check again
-    if(22 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &rx_level);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == rx_level)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // another byte arrive wile we were reading the last ones
-                state->phase = 21;
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // begin of status read loop
-    if(23 == state->phase)
-    {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(24 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff & FLASHCMD_READ_STATUS));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(25 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), (0xff));
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(26 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(27 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);  // skip a byte
-        if(RESULT_OK == res)
-        {
-            debug_line("INFO: skip status as 0x%02lx!",val );
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(28 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 < val)
-            {
-                state->phase++;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(29 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &status);
-        if(RESULT_OK == res)
-        {
-            debug_line("INFO: read status as 0x%02lx!",status );
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(30 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    // wait for busy = idle
-    if(31 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(32 == state->phase)
-    {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
-
-    if(33 == state->phase)
-    {
-        if(0xff == status)
-        {
-            // something is wrong here
-            return ERR_TARGET_ERROR;
-        }
-        if(status & STATUS_REGISTER_BUSY)
-        {
-            // still busy
-            state->phase = 23; // go back to start of loop
-        }
-        else
-        {
-            return RESULT_OK;
-        }
-    }
-
-    debug_error("ERROR: wrong state (%ld) in flash_write_page()!", state->phase);
-    return ERR_WRONG_STATE;
-}
+    return run_program(state);
+}
 
 Result flash_enter_XIP(flash_action_data_typ* const state)
 {
+#ifdef FEAT_TARGET_CLOCK_BOOST
     Result res;
-
+#endif
     if(NULL == state)
     {
         debug_error("ERROR: state is NULL !");
@@ -2827,430 +1162,245 @@ Result flash_enter_XIP(flash_action_data_typ* const state)
     if(true == state->first_call)
     {
         debug_line("starting enter XiP mode sequence...");
-        state->phase = 0;
+        qspi_program_start(&prog, enter_XIP_program);
+#ifdef FEAT_TARGET_CLOCK_BOOST
+        restoring = false;
+#endif
         state->first_call = false;
-        act_state.first_call =true;
-        cnt = 0;
     }
-
-    // do the initial read (command + Address + continuation code + read)
-
-    // disable SSI
-    if(0 == state->phase)
+#ifdef FEAT_TARGET_CLOCK_BOOST
+    if(true == restoring)
     {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return restore_clocks(state);
     }
-
-    // configure the SSI
-    if(1 == state->phase)
+    res = run_program(state);
+    if((RESULT_OK == res) && (true == clocks_saved))
     {
-        res = step_write_ap(&(XIP_SSI->CTRLR[0]),
-                                    (XIP_SSI_CTRLR0_SPI_FRF_QUAD << XIP_SSI_CTRLR0_SPI_FRF_OFFSET) // QSPI frames / SPI Frames
-                                    | (1 << XIP_SSI_CTRLR0_DFS_32_OFFSET) // 8 bits per data frame -> 2 clock in QSPI (value is n+1)
-                                    | (7 << XIP_SSI_CTRLR0_CFS_OFFSET)    // 8 clocks per control fame (value is n+1)
-                                    | (XIP_SSI_CTRLR0_TMOD_RX_ONLY << XIP_SSI_CTRLR0_TMOD_OFFSET)
-                                    | (8 << XIP_SSI_CTRLR0_DFS_OFFSET)
-                                    );
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        // XIP mode works -> back to the original clocks of the target
+        qspi_program_start(&prog, clock_restore_program);
+        restoring = true;
+        return ERR_NOT_COMPLETED;
     }
+    return res;
+#else
+    return run_program(state);
+#endif
+}
 
-    if(2 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->CTRLR[1]), 3);  // read this many bytes
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
+#ifdef FEAT_ERASE_SUSPEND
+// the bytes arrive in address order, the first one ends up in the highest byte of rx_word
+static uint32_t rx_word_as_little_endian(void)
+{
+    return ((prog.rx_word >> 24) & 0xff)
+         | ((prog.rx_word >> 8) & 0xff00)
+         | ((prog.rx_word << 8) & 0xff0000)
+         | ((prog.rx_word << 24) & 0xff000000);
+}
 
-    // configure the SPI
-    if(3 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SPI_CTRLR0),
-                            (0xebul << XIP_SSI_SPI_CTRLR0_XIP_CMD_OFFSET) // Command 0x03 = read SPI (1 bit per clock); 0xeb = read QSPI (4 bits per clock)
-                                                                          // or append to address (INST_L = 0)
-                          | (4 << XIP_SSI_SPI_CTRLR0_WAIT_CYCLES_OFFSET)
-                          | (XIP_SSI_SPI_CTRLR0_INST_L_8B << XIP_SSI_SPI_CTRLR0_INST_L_OFFSET)
-                          | (8 << XIP_SSI_SPI_CTRLR0_ADDR_L_OFFSET) // in 4 bit increments -> 24 bit = 6; 32bit = 8;
-                          | (XIP_SSI_SPI_CTRLR0_TRANS_TYPE_1C2A << XIP_SSI_SPI_CTRLR0_TRANS_TYPE_OFFSET)  // command is SPI, Address and data is QSPI
-                            );
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
-    }
+static void start_read_sfdp(uint32_t address)
+{
+    qspi_program_start(&prog, read_sfdp_program);
+    prog.param[PARAM_ADDRESS] = address;
+}
 
-    // disable slave
-    if(4 == state->phase)
+static Result start_suspend_check(void)
+{
+    if(true == suspend_checked)
     {
-        res = step_write_ap(&(XIP_SSI->SER), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return RESULT_OK;
     }
+    checking_suspend = true;
+    sfdp_step = 0;
+    start_read_sfdp(0);
+    return ERR_NOT_COMPLETED;
+}
 
-    // enable SSI
-    if(5 == state->phase)
+// reads: signature, parameter header (length, pointer), BFPT DWORD 12 and 13
+static Result check_suspend(flash_action_data_typ* const state)
+{
+    uint32_t val;
+    Result res = run_program(state);
+    if(ERR_NOT_COMPLETED == res)
     {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 1);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return res;
     }
-
-    if(6 == state->phase)
+    checking_suspend = false;
+    if(RESULT_OK != res)
     {
-        // /CS Low
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return res;
     }
+    val = rx_word_as_little_endian();
 
-    if(7 == state->phase)
+    switch(sfdp_step)
     {
-        res = step_write_ap(&(XIP_SSI->DR0), 0xeb);
-
-        if(RESULT_OK == res)
+    case 0:
+        if(SFDP_SIGNATURE != val)
         {
-            state->phase++;
-            act_state.first_call = true;
+            debug_line("flash has no SFDP table -> no erase suspend");
+            break;
         }
-        else
+        sfdp_step++;
+        checking_suspend = true;
+        start_read_sfdp(8);  // first parameter header
+        return ERR_NOT_COMPLETED;
+
+    case 1:
+        if(BFPT_SUSPEND_CMD_DWORD > (val >> 24))
         {
-            return res;
+            debug_line("SFDP: BFPT too short (%ld DWORDs) -> no erase suspend", (val >> 24));
+            break;
         }
-    }
+        sfdp_step++;
+        checking_suspend = true;
+        start_read_sfdp(12);
+        return ERR_NOT_COMPLETED;
 
-    if(8 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->DR0), 0xa0);
+    case 2:
+        sfdp_bfpt_address = val & 0xffffff;
+        sfdp_step++;
+        checking_suspend = true;
+        start_read_sfdp(sfdp_bfpt_address + (BFPT_SUSPEND_DWORD - 1) * 4);
+        return ERR_NOT_COMPLETED;
 
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
+    case 3:
+        if(0 != (val & BFPT_SUSPEND_NOT_SUPPORTED))
         {
-            return res;
+            debug_line("SFDP: flash can not suspend an erase");
+            break;
         }
-    }
+        sfdp_step++;
+        checking_suspend = true;
+        start_read_sfdp(sfdp_bfpt_address + (BFPT_SUSPEND_CMD_DWORD - 1) * 4);
+        return ERR_NOT_COMPLETED;
 
-    // enable slave
-    if(9 == state->phase)
-    {
-        res = step_write_ap(&(XIP_SSI->SER), 1);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
+    case 4:
+    default:
+        suspend_cmd = (val >> 24) & 0xff;
+        resume_cmd = (val >> 16) & 0xff;
+        if((0 == suspend_cmd) || (0xff == suspend_cmd) || (0 == resume_cmd) || (0xff == resume_cmd))
         {
-            return res;
+            suspend_cmd = FLASHCMD_ERASE_SUSPEND;
+            resume_cmd = FLASHCMD_ERASE_RESUME;
         }
+        suspend_supported = true;
+        debug_line("SFDP: erase suspend 0x%02lx, resume 0x%02lx", suspend_cmd, resume_cmd);
+        break;
     }
+    suspend_checked = true;
+    return RESULT_OK;
+}
 
-    // wait for TFE (Transmit FIFO Empty) = 1
-    if(10 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(XIP_SSI_SR_TFE_MASK == (val & XIP_SSI_SR_TFE_MASK))
-            {
-                // TFE (Transmit FIFO Empty) = 1
-                state->phase++;
-                cnt = 4;  // we read 4 bytes from the Flash
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
+bool flash_can_suspend_erase(void)
+{
+    return suspend_supported;
+}
 
-    if(11 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_SSI->RXFLR), &rx_level);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(0 < rx_level)
-            {
-                state->phase++;
-            }
-            else
-            {
-                // try again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
+bool flash_is_in_erased_block(uint32_t address)
+{
+    return (erase_block_start <= address) && (erase_block_end > address);
+}
 
-    if(12 == state->phase)
+Result flash_erase_suspend(flash_action_data_typ* const state)
+{
+    if(NULL == state)
     {
-        res = act_read_register(&act_state, &(XIP_SSI->DR0), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            cnt--;
-            rx_level--;
-            if(0 == cnt)
-            {
-                state->phase++;
-            }
-            else if(0 == rx_level)
-            {
-                state->phase = 11; // read RXFLR again
-                return ERR_NOT_COMPLETED;
-            }
-            else
-            {
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    // wait for busy = idle
-    if(13 == state->phase)
+    if(true == state->first_call)
     {
-        res = act_read_register(&act_state, &(XIP_SSI->SR), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call = true;
-            if(0 == (val & XIP_SSI_SR_BUSY_MASK))
-            {
-                // busy = idle
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
+        if(false == suspend_supported)
         {
-            return res;
+            return ERR_WRONG_STATE;
         }
+        dlog_0("erase suspend");
+        qspi_program_start(&prog, suspend_program);
+        prog.param[PARAM_CMD] = suspend_cmd;
+        state->first_call = false;
     }
+    return run_program(state);
+}
 
-    if(14 == state->phase)
+Result flash_erase_resume(flash_action_data_typ* const state)
+{
+    if(NULL == state)
     {
-        // /CS High
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), (3 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET));
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    // start of flash_flush_cache()
-
-    // flush the cache
-    if(15 == state->phase)
+    if(true == state->first_call)
     {
-        res = step_write_ap(&(XIP_CTRL->FLUSH), 1);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
+        if(false == suspend_supported)
         {
-            return res;
+            return ERR_WRONG_STATE;
         }
+        dlog_0("erase resume");
+        qspi_program_start(&prog, resume_program);
+        prog.param[PARAM_CMD] = resume_cmd;
+        state->first_call = false;
     }
+    return run_program(state);
+}
 
-    // wait until flush has completed
-    if(16 == state->phase)
-    {
-        res = act_read_register(&act_state, &(XIP_CTRL->STAT), &val);
-        if(RESULT_OK == res)
-        {
-            act_state.first_call =true;
-            if(1 == (val & 1))
-            {
-                // Flush completed
-                state->phase++;
-            }
-            else
-            {
-                // read again
-                return ERR_NOT_COMPLETED;
-            }
-        }
-        else
-        {
-            return res;
-        }
-    }
+Result flash_read_word(flash_action_data_typ* const state, uint32_t address, uint32_t* value)
+{
+    Result res;
 
-    // enable cache
-    if(17 == state->phase)
+    if((NULL == state) || (NULL == value))
     {
-        res = step_write_ap(&(XIP_CTRL->CTRL) + REG_ALIAS_SET_BITS, 1);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-            act_state.first_call = true;
-        }
-        else
-        {
-            return res;
-        }
+        return ERR_ACTION_NULL;
     }
 
-    // QSPI Chip Select signal back to normal
-    if(18 == state->phase)
+    if(true == state->first_call)
     {
-        res = step_write_ap(&(IO_QSPI->GPIO_QSPI_SS_CTRL), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        qspi_program_start(&prog, read_data_program);
+        prog.param[PARAM_ADDRESS] = address & 0xffffff;
+        state->first_call = false;
     }
-    // end of flash_flush_cache()
-
-    // start of flash_enter_cmd_xip()
-
-    // disable SSI
-    if(19 == state->phase)
+    res = run_program(state);
+    if(RESULT_OK == res)
     {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        *value = rx_word_as_little_endian();
     }
+    return res;
+}
+#endif
 
-    // configure the SSI
-    if(20 == state->phase)
+#ifdef FEAT_TARGET_CLOCK_BOOST
+static Result boost_clocks(flash_action_data_typ* const state)
+{
+    Result res = run_program(state);
+    if(ERR_NOT_COMPLETED == res)
     {
-        res = step_write_ap(&(XIP_SSI->CTRLR[0]), 0x005f0300 ); // magic value needed by XiP peripheral
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return res;
     }
-
-    // configure the SPI
-    if(21 == state->phase)
+    if(NUM_CLOCK_SAVE_OPS <= prog.pc)
     {
-        res = step_write_ap(&(XIP_SSI->SPI_CTRLR0), 0xa0002022); // magic value needed by XiP peripheral
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        clocks_saved = true;
     }
-
-    if(22 == state->phase)
+    if(RESULT_OK != res)
     {
-        res = step_write_ap(&(XIP_SSI->CTRLR[1]), 0);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        // no crystal ? -> program with the clocks the target has
+        debug_error("ERROR: clock boost failed (%ld), using target clocks !", res);
     }
+    boosting = false;
+    start_initialize_program();
+    return ERR_NOT_COMPLETED;
+}
 
-    // enable SSI
-    if(23 == state->phase)
+static Result restore_clocks(flash_action_data_typ* const state)
+{
+    Result res = run_program(state);
+    if(ERR_NOT_COMPLETED == res)
     {
-        res = step_write_ap(&(XIP_SSI->SSIENR), 1);
-        if(RESULT_OK == res)
-        {
-            state->phase++;
-        }
-        else
-        {
-            return res;
-        }
+        return res;
     }
-
-    // end of flash_enter_cmd_xip()
-
-    if(24 == state->phase)
+    if(RESULT_OK != res)
     {
-        return RESULT_OK;
+        debug_error("ERROR: restoring the target clocks failed (%ld) !", res);
     }
-
-    return ERR_WRONG_STATE;
+    clocks_saved = false;
+    restoring = false;
+    return res;
 }
-
+#endif
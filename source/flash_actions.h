@@ -19,17 +19,44 @@
 #include <stdint.h>
 #include "probe_api/common.h"
 #include "probe_api/result.h"
+#ifdef FEAT_EXECUTE_CODE_ON_TARGET
+#include "stub_residency.h"
+#include "ram_planner.h"
+#endif
 
 typedef struct {
     uint32_t phase;
     bool first_call;
+#ifdef FEAT_EXECUTE_CODE_ON_TARGET
+    stub_residency_data_typ stub_state;
+    stub_call_data_typ call_state;
+    ram_planner_data_typ ram_state;
+    uint32_t stub_address;
+    uint32_t ram_size;
+    uint32_t stack_size;
+    Result call_result;
+#endif
 } flash_action_data_typ;
 
+#ifndef FEAT_EXECUTE_CODE_ON_TARGET
+// forget what is known about the flash (SSI setting, saved clocks)
+void flash_actions_init(void);
+#endif
 Result flash_erase_32kb(flash_action_data_typ* const state, uint32_t start_address);
 Result flash_erase_4kb(flash_action_data_typ* const state, uint32_t start_address);
 Result flash_erase_64kb(flash_action_data_typ* const state, uint32_t start_address);
 Result flash_write_page(flash_action_data_typ* const state, uint32_t start_address, uint8_t* data , uint32_t length);
 Result flash_initialize(flash_action_data_typ* const state);
 Result flash_enter_XIP(flash_action_data_typ* const state);
+#ifdef FEAT_ERASE_SUSPEND
+// erase suspend / resume, known after flash_initialize()
+bool flash_can_suspend_erase(void);
+// true if the address is in the block of the last erase command (its content is 0xff once the erase is done)
+bool flash_is_in_erased_block(uint32_t address);
+Result flash_erase_suspend(flash_action_data_typ* const state);
+Result flash_erase_resume(flash_action_data_typ* const state);
+// reads 4 bytes from the flash while the flash is not in XIP mode
+Result flash_read_word(flash_action_data_typ* const state, uint32_t address, uint32_t* value);
+#endif
 
 #endif /* SOURCE_FLASH_ACTIONS_H_ */
@@ -15,13 +15,21 @@
 
 #include <stddef.h>
 #include "flash_actions.h"
-#include "target/execute.h"
+#include "stub_residency.h"
+#include "target_progs.h"
+#ifdef FEAT_HALT_CACHE
+#include "halt_cache.h"
+#endif
 #include "probe_api/debug_log.h"
 #include "probe_api/result.h"
 
+// stack for stubs that do not have a .su file
+#define MIN_STACK_BYTES   256
+
 Result flash_initialize(flash_action_data_typ* const state)
 {
     Result res;
+    uint32_t offset;
 
     if(NULL == state)
     {
@@ -33,20 +41,105 @@ Result flash_initialize(flash_action_data_typ* const state)
         debug_line("starting flash_initialize()");
         state->phase = 0;
         state->first_call = false;
+        state->stub_state.first_call = true;
+        state->call_state.first_call = true;
+        state->ram_state.first_call = true;
     }
 
     if(0 == state->phase)
     {
-        res = target_execute(BLINK); // do something here
-        if(RESULT_OK == res)
+        // code, .bss and stack of the stub in one reservation: the application
+        // gets all of it back after the call. The residency check needs the
+        // word behind the code, that is the .bss or the bottom of the stack.
+        state->stack_size = target_progs_get_descriptor(BLINK)->stack_size;
+        if(MIN_STACK_BYTES > state->stack_size)
         {
-            // action->cur_phase++;
-            return RESULT_OK;
+            state->stack_size = MIN_STACK_BYTES;
+        }
+        state->ram_size = ((target_progs_get_size(BLINK) + 3) & ~3u)
+                        + ((target_progs_get_descriptor(BLINK)->bss_size + 3) & ~3u)
+                        + state->stack_size;
+        res = ram_planner_reserve(state->ram_size, &(state->stub_address));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == state->phase)
+    {
+        res = ram_planner_save(&(state->ram_state));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->ram_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            ram_planner_release();
+            return res;
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == state->phase)
+    {
+        // only uploads the stub if it is not in the target RAM anymore
+        state->call_result = stub_residency_ensure(&(state->stub_state), BLINK, target_progs_get_code(BLINK),
+                                                   target_progs_get_size(BLINK),
+                                                   target_progs_get_descriptor(BLINK)->bss_size,
+                                                   state->stub_address);
+        if(ERR_NOT_COMPLETED == state->call_result)
+        {
+            return ERR_NOT_COMPLETED;
+        }
+        // the RAM of the application gets restored, even if the upload failed
+        state->phase = (RESULT_OK == state->call_result) ? 3 : 4;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(3 == state->phase)
+    {
+        // run the stub where it is resident
+        offset = target_progs_get_entry_offset(BLINK, BLINK_ENTRY_EXEC_FUNC);
+        if(TARGET_PROGS_NO_ENTRY == offset)
+        {
+            state->call_result = ERR_WRONG_VALUE;
         }
         else
+        {
+            state->call_result = stub_residency_call(&(state->call_state), state->stub_address + offset,
+                                                     state->stub_address + state->ram_size);
+            if(ERR_NOT_COMPLETED == state->call_result)
+            {
+                return ERR_NOT_COMPLETED;
+            }
+        }
+        // the RAM of the application gets restored, even if the stub failed
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(4 == state->phase)
+    {
+        res = ram_planner_restore(&(state->ram_state));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        ram_planner_release();
+#ifdef FEAT_HALT_CACHE
+        // the upload, the stub and the restore wrote RAM and core registers
+        halt_cache_invalidate();
+#endif
+        if(RESULT_OK != res)
         {
             return res;
         }
+        return state->call_result;
     }
 
     return ERR_WRONG_STATE;
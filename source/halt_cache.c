@@ -0,0 +1,247 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "halt_cache.h"
+#include "cortex_m_debug.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "block_read.h"
+#include "swd_link.h"
+
+#define WORDS_PER_BLOCK    (HALT_CACHE_BLOCK_BYTES / 4)
+// block addresses are aligned -> this is never a valid block address
+#define NO_BLOCK           0xffffffff
+
+#define PHASE_DRAIN        0
+#define PHASE_SWITCH       1
+#define PHASE_CHECK_HALT   2
+#define PHASE_SWITCH_BACK  3
+#define PHASE_LOOKUP       4
+#define PHASE_FILL         5
+
+typedef struct {
+    uint32_t address;  // of the first byte in the block
+    uint32_t words[WORDS_PER_BLOCK];
+} block_typ;
+
+static block_typ blocks[HALT_CACHE_NUM_BLOCKS];
+static uint32_t next_victim;
+// the core is halted in this epoch
+static bool halted;
+static uint32_t num_epochs;
+static uint32_t num_hits;
+static uint32_t num_misses;
+
+void halt_cache_init(void)
+{
+    num_epochs = 0;
+    num_hits = 0;
+    num_misses = 0;
+    halt_cache_invalidate();
+}
+
+void halt_cache_invalidate(void)
+{
+    uint32_t i;
+    for(i = 0; i < HALT_CACHE_NUM_BLOCKS; i++)
+    {
+        blocks[i].address = NO_BLOCK;
+    }
+    next_victim = 0;
+    halted = false;
+}
+
+bool halt_cache_is_cacheable(uint32_t address)
+{
+    if(0 != (address & 3))
+    {
+        return false;
+    }
+    return (HALT_CACHE_RAM_START <= address) && (HALT_CACHE_RAM_END > address);
+}
+
+uint32_t halt_cache_get_num_hits(void)
+{
+    return num_hits;
+}
+
+uint32_t halt_cache_get_num_misses(void)
+{
+    return num_misses;
+}
+
+static uint32_t find_block(uint32_t block_address)
+{
+    uint32_t i;
+    for(i = 0; i < HALT_CACHE_NUM_BLOCKS; i++)
+    {
+        if(block_address == blocks[i].address)
+        {
+            return i;
+        }
+    }
+    return HALT_CACHE_NUM_BLOCKS;
+}
+
+Result halt_cache_read(halt_cache_data_typ* const state, uint32_t address, uint32_t* value)
+{
+    Result res;
+    uint32_t target_core;
+    uint32_t block_address = address & ~(uint32_t)(HALT_CACHE_BLOCK_BYTES - 1);
+    uint32_t word = (address - block_address) / 4;
+
+    if((NULL == state) || (NULL == value))
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(false == halt_cache_is_cacheable(address))
+    {
+        return ERR_WRONG_VALUE;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->act_state.first_call = true;
+        if(true == halted)
+        {
+            state->phase = PHASE_LOOKUP;
+        }
+        else
+        {
+            state->core = 0;
+            state->start_core = swd_get_connected_core();
+            state->running = false;
+            state->phase = PHASE_DRAIN;
+        }
+    }
+
+    if(PHASE_DRAIN == state->phase)
+    {
+        // queued steps (e.g. of a memory write) must not end up on the other core
+        res = step_get_Result_OK();
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_SWITCH;
+    }
+
+    if(PHASE_SWITCH == state->phase)
+    {
+        // the connected core first: if it runs no switch is needed
+        target_core = (state->start_core + state->core) % HALT_CACHE_NUM_CORES;
+        if(target_core != swd_get_connected_core())
+        {
+            res = swd_switch_core(target_core);
+            if(RESULT_OK != res)
+            {
+                return res;
+            }
+        }
+        state->phase = PHASE_CHECK_HALT;
+    }
+
+    if(PHASE_CHECK_HALT == state->phase)
+    {
+        res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->core++;
+        if(0 == (state->value & DHCSR_S_HALT))
+        {
+            // running -> RAM can change any time
+            state->running = true;
+            state->phase = PHASE_SWITCH_BACK;
+        }
+        else if(HALT_CACHE_NUM_CORES == state->core)
+        {
+            state->phase = PHASE_SWITCH_BACK;
+        }
+        else
+        {
+            state->phase = PHASE_SWITCH;
+            return ERR_NOT_COMPLETED;
+        }
+    }
+
+    if(PHASE_SWITCH_BACK == state->phase)
+    {
+        if(state->start_core != swd_get_connected_core())
+        {
+            res = swd_switch_core(state->start_core);
+            if(RESULT_OK != res)
+            {
+                return res;
+            }
+        }
+        if(true == state->running)
+        {
+            return ERR_WRONG_STATE;
+        }
+        halted = true;
+        num_epochs++;
+        state->phase = PHASE_LOOKUP;
+    }
+
+    if(PHASE_LOOKUP == state->phase)
+    {
+        state->idx = find_block(block_address);
+        if(HALT_CACHE_NUM_BLOCKS != state->idx)
+        {
+            num_hits++;
+            *value = blocks[state->idx].words[word];
+            return RESULT_OK;
+        }
+        num_misses++;
+        state->idx = next_victim;
+        next_victim = (next_victim + 1) % HALT_CACHE_NUM_BLOCKS;
+        // the block is not valid until all words have been read
+        blocks[state->idx].address = NO_BLOCK;
+        block_read_start(&(state->read), block_address, WORDS_PER_BLOCK);
+        state->phase = PHASE_FILL;
+    }
+
+    if(PHASE_FILL == state->phase)
+    {
+        res = block_read_all(&(state->read), blocks[state->idx].words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        blocks[state->idx].address = block_address;
+        *value = blocks[state->idx].words[word];
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_CLI
+bool halt_cache_cmd_info(uint32_t loop)
+{
+    (void)loop;
+    cli_line("halt cache: %ld halts, %ld hits, %ld block reads", num_epochs, num_hits, num_misses);
+    return true;
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_HALT_CACHE_H_
+#define SOURCE_HALT_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "block_read.h"
+
+// Cache for reads of the target RAM while the target is halted (FEAT_HALT_CACHE).
+//
+// While the core is halted the RAM does not change. GDB reads stack frames,
+// locals and structures with many small, overlapping reads. On a miss the
+// whole aligned block around the address is read (read-ahead, pipelined with
+// block_read.h), the following reads of that block come from the probe.
+//
+// The cached content belongs to one "halt epoch". Both cores share the SRAM,
+// so the first read of an epoch checks DHCSR.S_HALT of every core (a switch
+// to the DP of the other core and back, see swd_switch_core()). If one of the
+// cores is running nothing is cached. The DMA is not checked: a DMA transfer
+// that runs while the cores are halted is not seen by the cache. Everything
+// that can change the RAM ends the epoch and must call halt_cache_invalidate():
+// resume, step, reset, memory writes and register writes.
+//
+// Only SRAM (HALT_CACHE_RAM_START - HALT_CACHE_RAM_END) is cached, reads of
+// peripherals can have side effects.
+
+#define HALT_CACHE_RAM_START       0x20000000
+#define HALT_CACHE_RAM_END         0x20042000
+#define HALT_CACHE_NUM_CORES       2
+#define HALT_CACHE_BLOCK_BYTES     64
+#ifndef HALT_CACHE_NUM_BLOCKS
+#define HALT_CACHE_NUM_BLOCKS      16
+#endif
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t core;  // number of cores checked
+    uint32_t start_core;
+    bool running;
+    uint32_t idx;
+    block_read_typ read;
+    uint32_t value;
+    activity_data_typ act_state;
+} halt_cache_data_typ;
+
+void halt_cache_init(void);
+// ends the halt epoch
+void halt_cache_invalidate(void);
+// true if the word at this address can be cached
+bool halt_cache_is_cacheable(uint32_t address);
+// RESULT_OK: *value is the word at address.
+// ERR_WRONG_STATE: a core is running -> read the target directly.
+Result halt_cache_read(halt_cache_data_typ* const state, uint32_t address, uint32_t* value);
+uint32_t halt_cache_get_num_hits(void);
+uint32_t halt_cache_get_num_misses(void);
+#ifdef FEAT_CLI
+bool halt_cache_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_HALT_CACHE_H_ */
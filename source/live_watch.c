@@ -0,0 +1,289 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "live_watch.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "spsc_ring.h"
+#include "text_util.h"
+#include "time_us.h"
+
+#define READS_IN_FLIGHT     4
+
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    uint32_t word;  // index into the words of the sample
+} variable_typ;
+
+static variable_typ variables[LIVE_WATCH_MAX_VARS];
+static uint32_t num_variables;
+static uint32_t word_addresses[LIVE_WATCH_MAX_WORDS];
+static uint32_t num_words;
+static uint32_t interval_us;
+static bool running;
+static uint32_t next_sample_time;
+static live_watch_sample_typ sample_buffer[LIVE_WATCH_NUM_SAMPLES];
+static spsc_ring_typ sample_ring;
+static uint32_t num_samples;
+static uint32_t num_dropped;
+static uint32_t num_late;
+
+void live_watch_init(void)
+{
+    interval_us = LIVE_WATCH_DEFAULT_INTERVAL;
+    spsc_ring_init(&sample_ring, sample_buffer, sizeof(live_watch_sample_typ), LIVE_WATCH_NUM_SAMPLES);
+    num_samples = 0;
+    num_dropped = 0;
+    num_late = 0;
+    live_watch_clear();
+}
+
+Result live_watch_add(uint32_t address, uint32_t size)
+{
+    uint32_t word_address = address & ~3u;
+    uint32_t i;
+
+    if(true == running)
+    {
+        return ERR_WRONG_STATE;
+    }
+    if(((1 != size) && (2 != size) && (4 != size)) || (0 != (address & (size - 1))))
+    {
+        return ERR_WRONG_VALUE;
+    }
+    if(LIVE_WATCH_MAX_VARS == num_variables)
+    {
+        return ERR_WRONG_VALUE;
+    }
+    for(i = 0; i < num_words; i++)
+    {
+        if(word_address == word_addresses[i])
+        {
+            break;
+        }
+    }
+    if(num_words == i)
+    {
+        if(LIVE_WATCH_MAX_WORDS == num_words)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        word_addresses[num_words] = word_address;
+        num_words++;
+    }
+    variables[num_variables].address = address;
+    variables[num_variables].size = size;
+    variables[num_variables].word = i;
+    num_variables++;
+    return RESULT_OK;
+}
+
+void live_watch_clear(void)
+{
+    running = false;
+    num_variables = 0;
+    num_words = 0;
+}
+
+Result live_watch_set_interval_us(uint32_t interval)
+{
+    if(LIVE_WATCH_MIN_INTERVAL > interval)
+    {
+        return ERR_WRONG_VALUE;
+    }
+    interval_us = interval;
+    return RESULT_OK;
+}
+
+Result live_watch_start(void)
+{
+    if(0 == num_variables)
+    {
+        return ERR_WRONG_STATE;
+    }
+    spsc_ring_init(&sample_ring, sample_buffer, sizeof(live_watch_sample_typ), LIVE_WATCH_NUM_SAMPLES);
+    num_samples = 0;
+    num_dropped = 0;
+    num_late = 0;
+    next_sample_time = time_us_now();
+    running = true;
+    return RESULT_OK;
+}
+
+void live_watch_stop(void)
+{
+    running = false;
+}
+
+bool live_watch_is_running(void)
+{
+    return running;
+}
+
+bool live_watch_is_due(void)
+{
+    if(false == running)
+    {
+        return false;
+    }
+    return (0 <= (int32_t)(time_us_now() - next_sample_time));
+}
+
+// schedules the next sample. Keeps the rate, unless we are behind.
+static void schedule_next(uint32_t now)
+{
+    next_sample_time = next_sample_time + interval_us;
+    if(0 <= (int32_t)(now - next_sample_time))
+    {
+        // missed at least one sample -> start over from now
+        num_late++;
+        next_sample_time = now + interval_us;
+    }
+}
+
+Result live_watch_sample(live_watch_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(false == running)
+    {
+        return ERR_WRONG_STATE;
+    }
+
+    if(true == state->first_call)
+    {
+        uint32_t now = time_us_now();
+        state->first_call = false;
+        schedule_next(now);
+        state->sample = spsc_ring_get_write_slot(&sample_ring);
+        if(NULL == state->sample)
+        {
+            // nobody reads the samples
+            num_dropped++;
+            return RESULT_OK;
+        }
+        state->sample->time_us = now;
+        state->requested = 0;
+        state->done = 0;
+    }
+
+    // keep some reads in flight, so that the SWD interface does not wait for us
+    if((state->requested < num_words) && ((state->requested - state->done) < READS_IN_FLIGHT))
+    {
+        res = step_read_ap((volatile uint32_t*)word_addresses[state->requested]);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->requested++;
+        return ERR_NOT_COMPLETED;
+    }
+    res = step_get_Result_data(&(state->sample->words[state->done]));
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    state->done++;
+    if(num_words == state->done)
+    {
+        spsc_ring_commit(&sample_ring);
+        num_samples++;
+        return RESULT_OK;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+uint32_t live_watch_get_header(char* buf, uint32_t size)
+{
+    uint32_t pos;
+    uint32_t i;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    pos = text_add_string(buf, size, 0, "time_us");
+    for(i = 0; i < num_variables; i++)
+    {
+        pos = text_add_string(buf, size, pos, ",0x");
+        pos = text_add_hex(buf, size, pos, variables[i].address);
+    }
+    pos = text_add_string(buf, size, pos, "\r\n");
+    buf[pos] = 0;
+    return pos;
+}
+
+uint32_t live_watch_get_line(char* buf, uint32_t size)
+{
+    live_watch_sample_typ* sample;
+    uint32_t pos;
+    uint32_t i;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    sample = spsc_ring_peek(&sample_ring);
+    if(NULL == sample)
+    {
+        buf[0] = 0;
+        return 0;
+    }
+    pos = text_add_decimal(buf, size, 0, sample->time_us);
+    for(i = 0; i < num_variables; i++)
+    {
+        uint32_t value = sample->words[variables[i].word] >> (8 * (variables[i].address & 3));
+        if(4 != variables[i].size)
+        {
+            value = value & ((1u << (8 * variables[i].size)) - 1);
+        }
+        pos = text_add_string(buf, size, pos, ",");
+        pos = text_add_decimal(buf, size, pos, value);
+    }
+    pos = text_add_string(buf, size, pos, "\r\n");
+    buf[pos] = 0;
+    spsc_ring_release(&sample_ring);
+    return pos;
+}
+
+uint32_t live_watch_get_num_dropped(void)
+{
+    return num_dropped;
+}
+
+#ifdef FEAT_CLI
+bool live_watch_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("live watch: %s, %ld variables (%ld reads per sample), every %ld us",
+                 (true == running) ? "running" : "stopped", num_variables, num_words, interval_us);
+        cli_line("live watch: %ld samples, %ld dropped, %ld late", num_samples, num_dropped, num_late);
+    }
+    if(loop < num_variables)
+    {
+        cli_line("variable 0x%08lx, %ld bytes", variables[loop].address, variables[loop].size);
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_LIVE_WATCH_H_
+#define SOURCE_LIVE_WATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+
+// Live watch (FEAT_LIVE_WATCH): samples variables while the target runs.
+//
+// The MEM-AP reads the target RAM without halting the core. While the live
+// watch runs, target_tick() queues the LIVE_WATCH_SAMPLE action each time
+// live_watch_is_due() says so. The action is scheduled like all other actions,
+// so the reads are interleaved with the other SWD work. Variables that share a
+// word are read with one SWD read, the reads of one sample are pipelined.
+//
+// Each sample gets the time stamp (probe micro seconds) of its first read and
+// goes into a ring buffer. target_tick() sends the samples as text lines
+// ("time_us,value,value,...\r\n") to the GDB console while GDB waits for the
+// stop reply. If the lines can not be sent fast enough new samples are
+// dropped (and counted). The variables are set with
+// "monitor live_watch add <address> <size>", then "monitor live_watch start".
+
+#define LIVE_WATCH_MAX_VARS          8
+// different words read for one sample
+#define LIVE_WATCH_MAX_WORDS         8
+// must be a power of two
+#define LIVE_WATCH_NUM_SAMPLES       64
+#define LIVE_WATCH_DEFAULT_INTERVAL  1000
+#define LIVE_WATCH_MIN_INTERVAL      100
+
+typedef struct {
+    uint32_t time_us;
+    uint32_t words[LIVE_WATCH_MAX_WORDS];
+} live_watch_sample_typ;
+
+typedef struct {
+    bool first_call;
+    uint32_t requested;
+    uint32_t done;
+    live_watch_sample_typ* sample;
+} live_watch_data_typ;
+
+void live_watch_init(void);
+// variable with 1, 2 or 4 bytes at a naturally aligned address. Only while stopped.
+Result live_watch_add(uint32_t address, uint32_t size);
+void live_watch_clear(void);
+// time between two samples ("interval_us" in the [live_watch] section)
+Result live_watch_set_interval_us(uint32_t interval);
+Result live_watch_start(void);
+void live_watch_stop(void);
+bool live_watch_is_running(void);
+// true if the next sample should be taken now
+bool live_watch_is_due(void);
+// LIVE_WATCH_SAMPLE action: reads all variables once
+Result live_watch_sample(live_watch_data_typ* const state);
+// first line of the stream: "time_us,0x20000100,...\r\n". Returns the length.
+uint32_t live_watch_get_header(char* buf, uint32_t size);
+// oldest sample as text line (removed from the buffer). Returns the length, 0 if there is no sample.
+uint32_t live_watch_get_line(char* buf, uint32_t size);
+uint32_t live_watch_get_num_dropped(void);
+#ifdef FEAT_CLI
+bool live_watch_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_LIVE_WATCH_H_ */
@@ -0,0 +1,276 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "loop_monitor.h"
+#include "time_critical.h"
+#include "time_us.h"
+#include "probe_api/debug_log.h"
+
+#ifdef LOOP_MONITOR
+
+static const char* const subsystem_names[LM_NUM_SUBSYSTEMS] = {
+    "other (main loop)",
+    "USB",
+    "GDB",
+    "SWD step",
+    "flash action",
+};
+
+static uint32_t histogram[LM_NUM_BUCKETS];
+static uint32_t num_iterations;
+static uint32_t max_iteration_us;
+static loop_monitor_subsystem_stat_typ subsystems[LM_NUM_SUBSYSTEMS];
+
+// current iteration
+static bool has_last_start;
+static uint32_t last_start;
+static uint32_t annotated_us;
+
+// open section (LM_OTHER = none) and the section that waits for it to end
+static loop_monitor_subsystem_typ current;
+static uint32_t section_start;
+static uint32_t section_us;
+static loop_monitor_subsystem_typ waiting;
+static uint32_t waiting_us;
+
+// flash throughput (of the current or last flash operation)
+static bool flash_was_busy;
+static uint32_t flash_start;
+static uint32_t flash_ticks;
+static uint32_t flash_time_us;
+
+
+static uint32_t get_bucket_of(uint32_t duration_us)
+{
+    uint32_t bucket = 0;
+    while((0 != duration_us) && (bucket < (LM_NUM_BUCKETS - 1)))
+    {
+        duration_us = duration_us >> 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void add_sample(loop_monitor_subsystem_typ subsystem, uint32_t duration_us)
+{
+    subsystems[subsystem].calls++;
+    subsystems[subsystem].total_us += duration_us;
+    if(duration_us > subsystems[subsystem].max_us)
+    {
+        subsystems[subsystem].max_us = duration_us;
+    }
+}
+
+void loop_monitor_init(void)
+{
+    has_last_start = false;
+    current = LM_OTHER;
+    waiting = LM_OTHER;
+    flash_was_busy = false;
+    flash_ticks = 0;
+    flash_time_us = 0;
+    loop_monitor_reset();
+}
+
+// clears the statistics, but not the state of the current iteration.
+void loop_monitor_reset(void)
+{
+    uint32_t i;
+    for(i = 0; i < LM_NUM_BUCKETS; i++)
+    {
+        histogram[i] = 0;
+    }
+    for(i = 0; i < LM_NUM_SUBSYSTEMS; i++)
+    {
+        subsystems[i].calls = 0;
+        subsystems[i].total_us = 0;
+        subsystems[i].max_us = 0;
+    }
+    num_iterations = 0;
+    max_iteration_us = 0;
+}
+
+void loop_monitor_tick_start(void)
+{
+    uint32_t now = time_us_now();
+    if(true == has_last_start)
+    {
+        uint32_t duration = now - last_start;
+        histogram[get_bucket_of(duration)]++;
+        num_iterations++;
+        if(duration > max_iteration_us)
+        {
+            max_iteration_us = duration;
+        }
+        if(duration > annotated_us)
+        {
+            add_sample(LM_OTHER, duration - annotated_us);
+        }
+        else
+        {
+            add_sample(LM_OTHER, 0);
+        }
+    }
+    has_last_start = true;
+    last_start = now;
+    annotated_us = 0;
+}
+
+void loop_monitor_tick_end(bool flash_busy)
+{
+    if(true == flash_busy)
+    {
+        if(false == flash_was_busy)
+        {
+            // a new flash operation started
+            flash_start = last_start;
+            flash_ticks = 0;
+        }
+        flash_ticks++;
+        flash_time_us = time_us_now() - flash_start;
+    }
+    flash_was_busy = flash_busy;
+}
+
+// the clock of the open section runs until now
+static void TIME_CRITICAL(stop_clock)(uint32_t now)
+{
+    uint32_t duration = now - section_start;
+    section_us += duration;
+    annotated_us += duration;
+    section_start = now;
+}
+
+void TIME_CRITICAL(loop_monitor_enter)(loop_monitor_subsystem_typ subsystem)
+{
+    uint32_t now = time_us_now();
+    if(LM_OTHER != current)
+    {
+        if(LM_OTHER != waiting)
+        {
+            // a section already waits -> the time stays with the open section
+            return;
+        }
+        stop_clock(now);
+        waiting = current;
+        waiting_us = section_us;
+    }
+    current = subsystem;
+    section_start = now;
+    section_us = 0;
+}
+
+void TIME_CRITICAL(loop_monitor_leave)(loop_monitor_subsystem_typ subsystem)
+{
+    if((LM_OTHER == current) || (subsystem != current))
+    {
+        // leave without enter
+        return;
+    }
+    stop_clock(time_us_now());
+    add_sample(subsystem, section_us);
+    current = waiting;
+    section_us = waiting_us;
+    waiting = LM_OTHER;
+}
+
+uint32_t loop_monitor_get_bucket(uint32_t bucket)
+{
+    if(bucket < LM_NUM_BUCKETS)
+    {
+        return histogram[bucket];
+    }
+    return 0;
+}
+
+uint32_t loop_monitor_get_max_iteration_us(void)
+{
+    return max_iteration_us;
+}
+
+const loop_monitor_subsystem_stat_typ* loop_monitor_get_subsystem(loop_monitor_subsystem_typ subsystem)
+{
+    if(subsystem < LM_NUM_SUBSYSTEMS)
+    {
+        return &subsystems[subsystem];
+    }
+    return NULL;
+}
+
+uint32_t loop_monitor_get_flash_ticks(void)
+{
+    return flash_ticks;
+}
+
+uint32_t loop_monitor_get_flash_time_us(void)
+{
+    return flash_time_us;
+}
+
+#ifdef FEAT_CLI
+// prints the statistics collected since the last report and then clears them.
+bool loop_monitor_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("Main loop monitor");
+        cli_line("iterations: %ld, longest: %ld us", num_iterations, max_iteration_us);
+        return false;
+    }
+    loop--;
+    if(loop < LM_NUM_BUCKETS)
+    {
+        if(0 != histogram[loop])
+        {
+            if(0 == loop)
+            {
+                cli_line("     < 1 us : %ld", histogram[loop]);
+            }
+            else if((LM_NUM_BUCKETS - 1) == loop)
+            {
+                cli_line(">= %6ld us : %ld", (1ul << (loop - 1)), histogram[loop]);
+            }
+            else
+            {
+                cli_line("< %6ld us : %ld", (1ul << loop), histogram[loop]);
+            }
+        }
+        return false;
+    }
+    loop = loop - LM_NUM_BUCKETS;
+    if(loop < LM_NUM_SUBSYSTEMS)
+    {
+        if(0 != subsystems[loop].calls)
+        {
+            cli_line("%s: calls: %ld, total: %ld us, longest: %ld us",
+                     subsystem_names[loop],
+                     subsystems[loop].calls,
+                     subsystems[loop].total_us,
+                     subsystems[loop].max_us);
+        }
+        return false;
+    }
+    if(0 != flash_ticks)
+    {
+        cli_line("flash: %ld ticks in %ld us (%ld us per tick)",
+                 flash_ticks, flash_time_us, flash_time_us / flash_ticks);
+    }
+    loop_monitor_reset();
+    return true;
+}
+#endif
+
+#endif /* LOOP_MONITOR */
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_LOOP_MONITOR_H_
+#define SOURCE_LOOP_MONITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Main loop latency instrumentation (LOOP_MONITOR).
+//
+// One main loop iteration is the time from one call of target_tick() to the
+// next. The duration of every iteration goes into a histogram with
+// logarithmic (power of two) micro second buckets.
+//
+// Sections of the loop are annotated with loop_monitor_enter() and
+// loop_monitor_leave(). The sections are exclusive: at any time the clock
+// runs for one subsystem only. Entering a section while another one is open
+// stops the clock of the open section until the new one is left (a flash
+// action runs inside the SWD step engine). Only one section can wait like
+// that. For each subsystem the number of calls, the total time and the
+// longest call are recorded.
+// The SWD step and flash sections are annotated in target_tick(). The USB and
+// GDB server calls are in the main loop of the probe firmware, which is
+// outside of the target code. The probe firmware annotates them with
+// loop_monitor_enter(LM_USB) / loop_monitor_leave(LM_USB) around the USB (and
+// NCM) task and LM_GDB around the GDB server task. Time in the iteration that
+// is not inside an annotated section is counted as LM_OTHER.
+//
+// While the flash driver is busy the number of iterations and the time is
+// counted. This gives the number of ticks per second during flash operations.
+//
+// Without LOOP_MONITOR the enter/leave calls compile to nothing.
+
+typedef enum {
+    LM_OTHER = 0,
+    LM_USB,
+    LM_GDB,
+    LM_SWD,
+    LM_FLASH,
+    LM_NUM_SUBSYSTEMS,
+} loop_monitor_subsystem_typ;
+
+// bucket n counts iterations with a duration of 2^(n-1) <= t < 2^n micro seconds.
+// The last bucket counts all longer iterations.
+#define LM_NUM_BUCKETS  18
+
+typedef struct {
+    uint32_t calls;
+    uint32_t total_us;
+    uint32_t max_us;
+} loop_monitor_subsystem_stat_typ;
+
+#ifdef LOOP_MONITOR
+
+void loop_monitor_init(void);
+void loop_monitor_reset(void);
+void loop_monitor_tick_start(void);
+void loop_monitor_tick_end(bool flash_busy);
+void loop_monitor_enter(loop_monitor_subsystem_typ subsystem);
+void loop_monitor_leave(loop_monitor_subsystem_typ subsystem);
+uint32_t loop_monitor_get_bucket(uint32_t bucket);
+uint32_t loop_monitor_get_max_iteration_us(void);
+const loop_monitor_subsystem_stat_typ* loop_monitor_get_subsystem(loop_monitor_subsystem_typ subsystem);
+uint32_t loop_monitor_get_flash_ticks(void);
+uint32_t loop_monitor_get_flash_time_us(void);
+#ifdef FEAT_CLI
+bool loop_monitor_cmd_info(uint32_t loop);
+#endif
+
+#else
+
+#define loop_monitor_enter(subsystem)
+#define loop_monitor_leave(subsystem)
+
+#endif
+
+#endif /* SOURCE_LOOP_MONITOR_H_ */
@@ -0,0 +1,393 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "qspi_program.h"
+#include "deferred_log.h"
+#include "tick_budget.h"
+#include "time_critical.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "hal/hw/XIP_SSI.h"
+#include "hal/qspi_flash.h"
+
+#define FIFO_SIZE 10  // is probably 16 but just to be sure
+
+static Result read_register(qspi_program_typ* const prog, volatile uint32_t* reg, uint32_t* value);
+static Result write_register(qspi_program_typ* const prog, volatile uint32_t* reg, uint32_t value);
+static Result send_data(qspi_program_typ* const prog);
+static Result drain_rx(qspi_program_typ* const prog, uint32_t additional_bytes);
+static Result upload_data(qspi_program_typ* const prog, volatile uint32_t* reg);
+
+
+void qspi_program_start(qspi_program_typ* const prog, const qspi_op_typ* program)
+{
+    prog->program = program;
+    prog->pc = 0;
+    prog->sub_phase = 0;
+    prog->poll_count = 0;
+    prog->busy_count = 0;
+    prog->rx_pending = 0;
+    prog->rx_word = 0;
+    prog->sent = 0;
+    prog->act_state.first_call = true;
+}
+
+static Result TIME_CRITICAL(read_register)(qspi_program_typ* const prog, volatile uint32_t* reg, uint32_t* value)
+{
+    Result res = act_read_register(&(prog->act_state), reg, value);
+    if(RESULT_OK == res)
+    {
+        prog->act_state.first_call = true;
+        prog->progress++;
+    }
+    return res;
+}
+
+static Result TIME_CRITICAL(write_register)(qspi_program_typ* const prog, volatile uint32_t* reg, uint32_t value)
+{
+    Result res = step_write_ap(reg, value);
+    if(RESULT_OK == res)
+    {
+        prog->progress++;
+    }
+    return res;
+}
+
+// one transaction
+Result TIME_CRITICAL(qspi_program_step)(qspi_program_typ* const prog)
+{
+    Result res;
+    uint32_t val;
+    const qspi_op_typ* op;
+
+    if((NULL == prog) || (NULL == prog->program))
+    {
+        return ERR_ACTION_NULL;
+    }
+    op = &(prog->program[prog->pc]);
+
+    switch(op->op)
+    {
+    case QOP_END:
+        return RESULT_OK;
+
+    case QOP_WRITE:
+        res = write_register(prog, op->reg, op->value);
+        break;
+
+    case QOP_WRITE_PARAM:
+        if(QSPI_NUM_PARAMETERS <= op->value)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        res = write_register(prog, op->reg, prog->param[op->value]);
+        break;
+
+    case QOP_READ:
+        res = read_register(prog, op->reg, &val);
+        break;
+
+    case QOP_POLL:
+        res = read_register(prog, op->reg, &val);
+        if((RESULT_OK == res) && (op->value != (val & op->mask)))
+        {
+            prog->poll_count++;
+            if(QSPI_POLL_LIMIT < prog->poll_count)
+            {
+                debug_error("ERROR: timeout polling 0x%08lx (0x%08lx) !", (uint32_t)(uintptr_t)op->reg, val);
+                return ERR_TARGET_ERROR;
+            }
+            // read again
+            return ERR_NOT_COMPLETED;
+        }
+        break;
+
+    case QOP_READ_ACC:
+        res = read_register(prog, op->reg, &(prog->accumulator));
+        break;
+
+    case QOP_WRITE_ACC_SET:
+        res = write_register(prog, op->reg, prog->accumulator | op->mask);
+        if(RESULT_OK == res)
+        {
+            prog->accumulator = prog->accumulator | op->mask;
+        }
+        break;
+
+    case QOP_WRITE_ACC_CLR:
+        res = write_register(prog, op->reg, prog->accumulator & ~op->mask);
+        if(RESULT_OK == res)
+        {
+            prog->accumulator = prog->accumulator & ~op->mask;
+        }
+        break;
+
+    case QOP_SEND:
+        res = write_register(prog, &(XIP_SSI->DR0), op->value);
+        if(RESULT_OK == res)
+        {
+            prog->rx_pending++;
+        }
+        break;
+
+    case QOP_SEND_PARAM:
+        if(QSPI_NUM_PARAMETERS <= op->value)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        res = write_register(prog, &(XIP_SSI->DR0), 0xff & (prog->param[op->value] >> op->mask));
+        if(RESULT_OK == res)
+        {
+            prog->rx_pending++;
+        }
+        break;
+
+    case QOP_SEND_DATA:
+        res = send_data(prog);
+        break;
+
+    case QOP_DRAIN_RX:
+        res = drain_rx(prog, op->value);
+        break;
+
+    case QOP_LOOP_WHILE_BUSY:
+        if(0xff == prog->last_rx)
+        {
+            // something is wrong here
+            debug_error("ERROR: could not read QSPI Flash status !");
+            return ERR_TARGET_ERROR;
+        }
+        dlog_1("INFO: read status as 0x%02lx!", prog->last_rx);
+        if((prog->last_rx & STATUS_REGISTER_BUSY) && (op->value <= prog->pc))
+        {
+            // still busy
+            prog->busy_count++;
+            if(QSPI_BUSY_LIMIT < prog->busy_count)
+            {
+                debug_error("ERROR: timeout waiting for the QSPI flash (status 0x%02lx) !", prog->last_rx);
+                return ERR_TIMEOUT;
+            }
+            prog->pc = prog->pc - op->value;
+            prog->progress++;
+            return ERR_NOT_COMPLETED;
+        }
+        prog->busy_count = 0;
+        res = RESULT_OK;
+        break;
+
+    case QOP_SAVE:
+        if(QSPI_NUM_SAVED <= op->value)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        res = read_register(prog, op->reg, &(prog->saved[op->value]));
+        break;
+
+    case QOP_RESTORE:
+        if(QSPI_NUM_SAVED <= op->value)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        res = write_register(prog, op->reg, prog->saved[op->value] & op->mask);
+        break;
+
+    case QOP_UPLOAD_DATA:
+        res = upload_data(prog, op->reg);
+        break;
+
+    case QOP_SKIP_IF_SAVED:
+        if(QSPI_NUM_SAVED <= op->value)
+        {
+            return ERR_WRONG_VALUE;
+        }
+        if(0 != (prog->saved[op->value] & op->mask))
+        {
+            prog->pc++;
+        }
+        res = RESULT_OK;
+        break;
+
+    default:
+        debug_error("ERROR: invalid QSPI operation %ld !", (uint32_t)op->op);
+        return ERR_WRONG_STATE;
+    }
+
+    if(RESULT_OK == res)
+    {
+        // this operation is done -> next operation
+        prog->pc++;
+        prog->sub_phase = 0;
+        prog->poll_count = 0;
+        prog->progress++;
+        return ERR_NOT_COMPLETED;
+    }
+    return res;
+}
+
+// as many transactions as the budget allows
+Result TIME_CRITICAL(qspi_program_run)(qspi_program_typ* const prog)
+{
+    Result res;
+    uint32_t progress_before;
+
+    if(NULL == prog)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        progress_before = prog->progress;
+        res = qspi_program_step(prog);
+    } while(true == tick_budget_continue(res, progress_before, prog->progress));
+    return res;
+}
+
+// returns RESULT_OK once all data has been written to DR0
+static Result TIME_CRITICAL(send_data)(qspi_program_typ* const prog)
+{
+    Result res;
+
+    if(0 == prog->sub_phase)
+    {
+        if(prog->sent == prog->length)
+        {
+            return RESULT_OK;
+        }
+        if(prog->rx_pending < FIFO_SIZE)
+        {
+            res = write_register(prog, &(XIP_SSI->DR0), prog->data[prog->sent]);
+            if(RESULT_OK == res)
+            {
+                prog->sent++;
+                prog->rx_pending++;
+                return ERR_NOT_COMPLETED;
+            }
+            return res;
+        }
+        // FIFO is full -> receive some bytes first
+        prog->sub_phase = 1;
+    }
+
+    if(1 == prog->sub_phase)
+    {
+        res = read_register(prog, &(XIP_SSI->RXFLR), &(prog->rx_level));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == prog->rx_level)
+        {
+            // read again
+            return ERR_NOT_COMPLETED;
+        }
+        prog->sub_phase = 2;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == prog->sub_phase)
+    {
+        res = read_register(prog, &(XIP_SSI->DR0), &(prog->last_rx));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        prog->rx_pending--;
+        prog->rx_level--;
+        if(0 == prog->rx_level)
+        {
+            prog->sub_phase = 0;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+// returns RESULT_OK once all expected bytes have been received
+static Result TIME_CRITICAL(drain_rx)(qspi_program_typ* const prog, uint32_t additional_bytes)
+{
+    Result res;
+
+    if(0 == prog->sub_phase)
+    {
+        prog->rx_pending = prog->rx_pending + additional_bytes;
+        prog->sub_phase = 1;
+    }
+
+    if(1 == prog->sub_phase)
+    {
+        if(0 == prog->rx_pending)
+        {
+            return RESULT_OK;
+        }
+        res = read_register(prog, &(XIP_SSI->RXFLR), &(prog->rx_level));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == prog->rx_level)
+        {
+            // read again
+            return ERR_NOT_COMPLETED;
+        }
+        prog->sub_phase = 2;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == prog->sub_phase)
+    {
+        res = read_register(prog, &(XIP_SSI->DR0), &(prog->last_rx));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        prog->rx_word = (prog->rx_word << 8) | (0xff & prog->last_rx);
+        prog->rx_pending--;
+        prog->rx_level--;
+        if((0 == prog->rx_level) || (0 == prog->rx_pending))
+        {
+            prog->sub_phase = 1;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+// returns RESULT_OK once all data has been written to the target memory
+static Result TIME_CRITICAL(upload_data)(qspi_program_typ* const prog, volatile uint32_t* reg)
+{
+    Result res;
+    uint32_t word = 0;
+    uint32_t i;
+
+    if(prog->sent >= prog->length)
+    {
+        return RESULT_OK;
+    }
+    // little endian, a last incomplete word is filled with 0
+    for(i = 0; (i < 4) && ((prog->sent + i) < prog->length); i++)
+    {
+        word = word | ((uint32_t)prog->data[prog->sent + i] << (8 * i));
+    }
+    res = write_register(prog, reg + (prog->sent / 4), word);
+    if(RESULT_OK == res)
+    {
+        prog->sent = prog->sent + 4;
+        return ERR_NOT_COMPLETED;
+    }
+    return res;
+}
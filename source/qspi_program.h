@@ -0,0 +1,111 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_QSPI_PROGRAM_H_
+#define SOURCE_QSPI_PROGRAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+
+// Interpreter for QSPI flash access sequences.
+//
+// The sequences that talk to the QSPI flash of the target (through the SSI
+// of the RP2040) are constant tables of micro operations (qspi_op_typ). The
+// interpreter executes them using SWD transactions. Every call of
+// qspi_program_step() does (at most) one transaction. qspi_program_run() does
+// as many transactions as the tick budget allows, so that consecutive writes
+// get queued back to back.
+//
+// All bytes written to DR0 with QOP_SEND* also produce a received byte (SSI
+// in TX and RX mode). The interpreter counts these bytes, QOP_DRAIN_RX reads
+// them from the RX FIFO. The last four received bytes are in rx_word (the
+// last byte in the lowest 8 bits).
+//
+// QOP_SAVE and QOP_RESTORE keep register values in "saved". The saved values
+// survive qspi_program_start(), so one program can save a register and a
+// later program can restore it.
+//
+// QOP_UPLOAD_DATA writes data (data, length) to the memory of the target
+// starting at reg, one SWD write per 4 bytes.
+//
+// A QOP_POLL that does not see the expected value after QSPI_POLL_LIMIT
+// reads fails with ERR_TARGET_ERROR. A QOP_LOOP_WHILE_BUSY that still sees
+// the busy bit after QSPI_BUSY_LIMIT loops fails with ERR_TIMEOUT.
+
+typedef enum {
+    QOP_END = 0,        // program finished -> RESULT_OK
+    QOP_WRITE,          // *reg = value
+    QOP_WRITE_PARAM,    // *reg = param[value]
+    QOP_READ,           // read *reg (for clear on read registers), value is ignored
+    QOP_POLL,           // read *reg until (*reg & mask) == value
+    QOP_READ_ACC,       // accumulator = *reg
+    QOP_WRITE_ACC_SET,  // accumulator |= mask; *reg = accumulator
+    QOP_WRITE_ACC_CLR,  // accumulator &= ~mask; *reg = accumulator
+    QOP_SEND,           // DR0 = value
+    QOP_SEND_PARAM,     // DR0 = 0xff & (param[value] >> mask)
+    QOP_SEND_DATA,      // send data (data, length) to DR0, received bytes are dropped
+    QOP_DRAIN_RX,       // expect value additional bytes, then read all expected bytes from the RX FIFO
+    QOP_LOOP_WHILE_BUSY,// last received byte is the flash status: if busy go back value operations
+    QOP_SAVE,           // saved[value] = *reg
+    QOP_RESTORE,        // *reg = saved[value] & mask
+    QOP_UPLOAD_DATA,    // copy data (data, length) to the target memory at reg
+    QOP_SKIP_IF_SAVED,  // if (saved[value] & mask) != 0 the next operation is skipped
+} qspi_opcode_typ;
+
+typedef struct {
+    qspi_opcode_typ op;
+    volatile uint32_t* reg;
+    uint32_t value;
+    uint32_t mask;
+} qspi_op_typ;
+
+#define QSPI_NUM_PARAMETERS  5
+#define QSPI_NUM_SAVED      24
+
+#ifndef QSPI_POLL_LIMIT
+#define QSPI_POLL_LIMIT  10000
+#endif
+// one loop is at least 7 SWD transactions. 64KB block erase: max 2s
+#ifndef QSPI_BUSY_LIMIT
+#define QSPI_BUSY_LIMIT  200000
+#endif
+
+typedef struct {
+    const qspi_op_typ* program;
+    uint32_t pc;          // index of the current operation
+    uint32_t sub_phase;   // for operations that need more than one transaction
+    uint32_t progress;    // number of finished transactions
+    uint32_t accumulator;
+    uint32_t rx_pending;  // number of bytes that are still in (or will arrive in) the RX FIFO
+    uint32_t rx_level;
+    uint32_t last_rx;
+    uint32_t rx_word;
+    uint32_t param[QSPI_NUM_PARAMETERS];
+    uint32_t saved[QSPI_NUM_SAVED];
+    uint32_t poll_count;
+    uint32_t busy_count;
+    const uint8_t* data;
+    uint32_t length;
+    uint32_t sent;
+    activity_data_typ act_state;
+} qspi_program_typ;
+
+void qspi_program_start(qspi_program_typ* const prog, const qspi_op_typ* program);
+Result qspi_program_step(qspi_program_typ* const prog);
+Result qspi_program_run(qspi_program_typ* const prog);
+
+#endif /* SOURCE_QSPI_PROGRAM_H_ */
@@ -0,0 +1,211 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "ram_planner.h"
+#include "probe_api/debug_log.h"
+#include "block_read.h"
+#include "block_write.h"
+
+typedef struct {
+    uint32_t start;
+    uint32_t size;
+    bool save;
+} ram_region_typ;
+
+static ram_region_typ user_region;
+static uint32_t save_budget;
+static bool reserved;
+static bool saved;
+static uint32_t reserved_start;
+static uint32_t reserved_size;
+static bool reserved_needs_save;
+static uint32_t saved_words[RAM_PLANNER_MAX_SAVE_BYTES / 4];
+
+void ram_planner_init(void)
+{
+    user_region.start = 0;
+    user_region.size = 0;
+    user_region.save = true;
+    save_budget = RAM_PLANNER_MAX_SAVE_BYTES;
+    reserved = false;
+    saved = false;
+}
+
+void ram_planner_set_user_region(uint32_t start, uint32_t size, bool save)
+{
+    user_region.start = start & ~3u;
+    user_region.size = size & ~3u;
+    user_region.save = save;
+}
+
+void ram_planner_set_save_budget(uint32_t bytes)
+{
+    if(bytes > RAM_PLANNER_MAX_SAVE_BYTES)
+    {
+        bytes = RAM_PLANNER_MAX_SAVE_BYTES;
+    }
+    save_budget = bytes & ~3u;
+}
+
+uint32_t ram_planner_get_save_budget(void)
+{
+    return save_budget;
+}
+
+static bool fits(const ram_region_typ* const region, uint32_t size)
+{
+    if(size > region->size)
+    {
+        return false;
+    }
+    if((true == region->save) && (size > save_budget))
+    {
+        return false;
+    }
+    return true;
+}
+
+Result ram_planner_reserve(uint32_t size, uint32_t* start)
+{
+    ram_region_typ sram45;
+    const ram_region_typ* region;
+
+    if(NULL == start)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(true == reserved)
+    {
+        debug_error("RAM planner: already reserved !");
+        return ERR_WRONG_STATE;
+    }
+    size = (size + 3) & ~3u;
+    if(0 == size)
+    {
+        return ERR_WRONG_VALUE;
+    }
+
+    sram45.start = RAM_PLANNER_DEFAULT_START;
+    sram45.size = RAM_PLANNER_DEFAULT_END - RAM_PLANNER_DEFAULT_START;
+    sram45.save = true;
+
+    // the region from nomagic.ini first
+    region = &user_region;
+    if(false == fits(region, size))
+    {
+        region = &sram45;
+        if(false == fits(region, size))
+        {
+            debug_error("RAM planner: %ld bytes do not fit (budget %ld bytes) !", size, save_budget);
+            return ERR_WRONG_VALUE;
+        }
+    }
+    reserved = true;
+    saved = false;
+    reserved_start = region->start;
+    reserved_size = size;
+    reserved_needs_save = region->save;
+    *start = reserved_start;
+    return RESULT_OK;
+}
+
+Result ram_planner_save(ram_planner_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(false == reserved)
+    {
+        return ERR_WRONG_STATE;
+    }
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        block_read_start(&(state->read), reserved_start, reserved_size / 4);
+    }
+    if(false == reserved_needs_save)
+    {
+        return RESULT_OK;
+    }
+
+    res = block_read_all(&(state->read), saved_words);
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    saved = true;
+    return RESULT_OK;
+}
+
+Result ram_planner_restore(ram_planner_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        block_write_start(&(state->write), reserved_start, saved_words, reserved_size / 4);
+    }
+    if(false == saved)
+    {
+        // nothing to restore
+        return RESULT_OK;
+    }
+
+    res = block_write_all(&(state->write));
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    saved = false;
+    return RESULT_OK;
+}
+
+void ram_planner_release(void)
+{
+    if(true == saved)
+    {
+        debug_error("RAM planner: 0x%08lx - 0x%08lx released without restore !",
+                    reserved_start, reserved_start + reserved_size);
+        saved = false;
+    }
+    reserved = false;
+}
+
+#ifdef FEAT_CLI
+bool ram_planner_cmd_info(uint32_t loop)
+{
+    (void)loop;
+    if(0 != user_region.size)
+    {
+        cli_line("scratch RAM: 0x%08lx - 0x%08lx (nomagic.ini)%s", user_region.start,
+                 user_region.start + user_region.size, (true == user_region.save) ? "" : ", not saved");
+    }
+    else
+    {
+        cli_line("scratch RAM: 0x%08lx - 0x%08lx", RAM_PLANNER_DEFAULT_START, RAM_PLANNER_DEFAULT_END);
+    }
+    cli_line("scratch save budget: %ld bytes", save_budget);
+    return true;
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_RAM_PLANNER_H_
+#define SOURCE_RAM_PLANNER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+#include "block_read.h"
+#include "block_write.h"
+
+// Target RAM for code that runs on the target (code, stack, buffers).
+//
+// The application on the target might use that RAM. So the planner saves the
+// content of the reserved RAM into the probe before the helper runs and writes
+// it back afterwards:
+//     ram_planner_reserve() -> ram_planner_save() -> run the helper
+//         -> ram_planner_restore() -> ram_planner_release()
+//
+// The RAM is taken from the region declared in the [scratch] section of
+// nomagic.ini. Without that section, or if the request does not fit into it,
+// SRAM4 and SRAM5 are used. The stacks of both cores are there, so that RAM
+// is always saved. Stubs (stub_residency.h) only stay resident in a region
+// that is not saved:
+//     [scratch]
+//     start = 0x20030000
+//     size = 4096
+//     save = no
+// "save = no" means the application does not use that RAM, so nothing needs
+// to be saved. The [scratch] section only has an effect once the ini parser
+// of the probe firmware hands it to target_config_set() (target_config.h).
+//
+// The probe has RAM_PLANNER_MAX_SAVE_BYTES bytes for the saved content. The
+// limit used can be made smaller with "save_budget" in the [scratch] section
+// (ram_planner_set_save_budget()). A reservation that needs to be saved and is
+// larger than the budget fails.
+
+#define RAM_PLANNER_DEFAULT_START      0x20040000
+#define RAM_PLANNER_DEFAULT_END        0x20042000
+#ifndef RAM_PLANNER_MAX_SAVE_BYTES
+#define RAM_PLANNER_MAX_SAVE_BYTES     8192
+#endif
+typedef struct {
+    bool first_call;
+    block_read_typ read;
+    block_write_typ write;
+} ram_planner_data_typ;
+
+void ram_planner_init(void);
+// region from the [scratch] section of nomagic.ini (size 0 = use the default region).
+void ram_planner_set_user_region(uint32_t start, uint32_t size, bool save);
+void ram_planner_set_save_budget(uint32_t bytes);
+uint32_t ram_planner_get_save_budget(void);
+// reserves size bytes of target RAM. *start is the first address.
+Result ram_planner_reserve(uint32_t size, uint32_t* start);
+// copies the reserved target RAM into the probe
+Result ram_planner_save(ram_planner_data_typ* const state);
+// writes the saved content back to the target
+Result ram_planner_restore(ram_planner_data_typ* const state);
+void ram_planner_release(void);
+#ifdef FEAT_CLI
+bool ram_planner_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_RAM_PLANNER_H_ */
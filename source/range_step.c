@@ -0,0 +1,187 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "range_step.h"
+#include "text_util.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+// debug events that are not caused by the step
+#define DFSR_STOP_EVENTS    (DFSR_BKPT | DFSR_DWTTRAP | DFSR_VCATCH | DFSR_EXTERNAL)
+
+#define PHASE_CLEAR_DFSR    0
+#define PHASE_STEP          1
+#define PHASE_WAIT_HALT     2
+#define PHASE_READ_PC       3
+#define PHASE_READ_DFSR     4
+
+// reads DHCSR until one of the bits is set
+static Result wait_for(range_step_data_typ* const state, uint32_t bits)
+{
+    Result res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->act_state.first_call = true;
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    if(0 != (state->value & bits))
+    {
+        state->num_polls = 0;
+        return RESULT_OK;
+    }
+    state->num_polls++;
+    if(CORE_MAX_POLLS == state->num_polls)
+    {
+        debug_error("range step: core does not halt (DHCSR 0x%08lx) !", state->value);
+        return ERR_TARGET_ERROR;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result read_register(range_step_data_typ* const state, volatile uint32_t* address)
+{
+    Result res = act_read_register(&(state->act_state), address, &(state->value));
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->act_state.first_call = true;
+    return res;
+}
+
+Result range_step_run(range_step_data_typ* const state, uint32_t start, uint32_t end)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_CLEAR_DFSR;
+        state->num_steps = 0;
+        state->num_polls = 0;
+        state->act_state.first_call = true;
+    }
+
+    if(PHASE_CLEAR_DFSR == state->phase)
+    {
+        // bits are write one to clear
+        res = step_write_ap(DFSR_ADDRESS, DFSR_ALL);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_STEP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_STEP == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_STEP);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->num_steps++;
+        state->phase = PHASE_WAIT_HALT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_WAIT_HALT == state->phase)
+    {
+        res = wait_for(state, DHCSR_S_HALT);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->reg_state.first_call = true;
+        state->phase = PHASE_READ_PC;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_READ_PC == state->phase)
+    {
+        res = core_register_read(&(state->reg_state), REGSEL_PC, &(state->pc));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_READ_DFSR;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_READ_DFSR == state->phase)
+    {
+        res = read_register(state, DFSR_ADDRESS);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 != (state->value & DFSR_STOP_EVENTS))
+        {
+            state->reason = RANGE_STEP_DEBUG_EVENT;
+            return RESULT_OK;
+        }
+        if((state->pc < start) || (state->pc >= end))
+        {
+            state->reason = RANGE_STEP_LEFT_RANGE;
+            return RESULT_OK;
+        }
+        if(RANGE_STEP_MAX_STEPS == state->num_steps)
+        {
+            state->reason = RANGE_STEP_STEP_LIMIT;
+            return RESULT_OK;
+        }
+        state->phase = PHASE_STEP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+bool range_step_parse_vcont(const char* packet, uint32_t* start, uint32_t* end)
+{
+    const char* c = packet;
+
+    if((NULL == packet) || (NULL == start) || (NULL == end))
+    {
+        return false;
+    }
+    if(0 != strncmp(c, "vCont;r", 7))
+    {
+        return false;
+    }
+    c = c + 7;
+    if(   (false == text_parse_hex(&c, start)) || (false == text_expect(&c, ','))
+       || (false == text_parse_hex(&c, end)) )
+    {
+        return false;
+    }
+    if((0 != *c) && (':' != *c) && (';' != *c))
+    {
+        return false;
+    }
+    return (*start < *end);
+}
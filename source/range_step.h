@@ -0,0 +1,67 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_RANGE_STEP_H_
+#define SOURCE_RANGE_STEP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "cortex_m_debug.h"
+
+// Range stepping (FEAT_RANGE_STEP, GDB "vCont;r start,end").
+//
+// The probe single steps the halted core (DHCSR.C_STEP) until the PC is
+// outside of [start, end). GDB only gets the final stop instead of one stop
+// reply per instruction.
+//
+// The stepping also ends if the step hit a breakpoint, a watchpoint or a
+// vector catch (DFSR), or after RANGE_STEP_MAX_STEPS steps (the code loops
+// inside the range). GDB then continues with the next step or range.
+
+#define RANGE_STEP_MAX_STEPS   100000
+
+typedef enum {
+    RANGE_STEP_LEFT_RANGE,
+    RANGE_STEP_DEBUG_EVENT,
+    RANGE_STEP_STEP_LIMIT,
+} range_step_stop_typ;
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t num_steps;
+    uint32_t num_polls;
+    uint32_t pc;
+    uint32_t value;
+    range_step_stop_typ reason;
+    activity_data_typ act_state;
+    core_register_data_typ reg_state;
+} range_step_data_typ;
+
+// actions for the "vCont?" reply of the probe
+#define RANGE_STEP_VCONT_REPLY "vCont;c;C;s;S;r"
+
+// steps until the PC leaves [start, end). state->pc and state->reason tell where and why it stopped.
+Result range_step_run(range_step_data_typ* const state, uint32_t start, uint32_t end);
+// parses "vCont;r<start>,<end>[:<thread>][;<action>...]". The actions of the
+// other threads are ignored, the step runs the whole core. Returns false if
+// the packet is not a range step or the range is empty.
+// target_handle_gdb_packet() queues RANGE_STEP with address = start and
+// length = end - start.
+bool range_step_parse_vcont(const char* packet, uint32_t* start, uint32_t* end);
+
+#endif /* SOURCE_RANGE_STEP_H_ */
@@ -0,0 +1,169 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "region_cache.h"
+#include "probe_api/debug_log.h"
+
+#define WORDS_PER_LINE   (REGION_CACHE_LINE_BYTES / 4)
+#define MAX_LINES        (REGION_CACHE_MAX_BYTES / REGION_CACHE_LINE_BYTES)
+// line addresses are aligned -> this is never a valid line address
+#define NO_LINE          0xffffffff
+
+typedef struct {
+    uint32_t address;  // of the first byte in the line
+    uint32_t valid;    // bit n = words[n] is valid
+    uint32_t words[WORDS_PER_LINE];
+} line_typ;
+
+static line_typ lines[MAX_LINES];
+static uint32_t num_lines;
+static uint32_t num_hits;
+static uint32_t num_misses;
+
+void region_cache_init(void)
+{
+    num_hits = 0;
+    num_misses = 0;
+    num_lines = MAX_LINES;
+    region_cache_invalidate_all();
+}
+
+void region_cache_set_budget(uint32_t bytes)
+{
+    uint32_t requested = bytes / REGION_CACHE_LINE_BYTES;
+    if(requested > MAX_LINES)
+    {
+        requested = MAX_LINES;
+    }
+    if(requested != num_lines)
+    {
+        // lines move to other places
+        num_lines = requested;
+        region_cache_invalidate_all();
+    }
+}
+
+uint32_t region_cache_get_budget(void)
+{
+    return num_lines * REGION_CACHE_LINE_BYTES;
+}
+
+bool region_cache_is_cacheable(uint32_t address)
+{
+    if(0 != (address & 3))
+    {
+        return false;
+    }
+    if((REGION_CACHE_ROM_START <= address) && (REGION_CACHE_ROM_END > address))
+    {
+        return true;
+    }
+    if((REGION_CACHE_FLASH_START <= address) && (REGION_CACHE_FLASH_END > address))
+    {
+        return true;
+    }
+    return false;
+}
+
+static line_typ* get_line(uint32_t address)
+{
+    return &(lines[(address / REGION_CACHE_LINE_BYTES) % num_lines]);
+}
+
+bool region_cache_read(uint32_t address, uint32_t* value)
+{
+    line_typ* line;
+    uint32_t word;
+
+    if((0 == num_lines) || (NULL == value) || (false == region_cache_is_cacheable(address)))
+    {
+        return false;
+    }
+    line = get_line(address);
+    word = (address % REGION_CACHE_LINE_BYTES) / 4;
+    if(   ((address - word * 4) == line->address)
+       && (0 != (line->valid & (1u << word))) )
+    {
+        *value = line->words[word];
+        num_hits++;
+        return true;
+    }
+    num_misses++;
+    return false;
+}
+
+void region_cache_store(uint32_t address, uint32_t value)
+{
+    line_typ* line;
+    uint32_t word;
+
+    if((0 == num_lines) || (false == region_cache_is_cacheable(address)))
+    {
+        return;
+    }
+    line = get_line(address);
+    word = (address % REGION_CACHE_LINE_BYTES) / 4;
+    if((address - word * 4) != line->address)
+    {
+        // evict the old line
+        line->address = address - word * 4;
+        line->valid = 0;
+    }
+    line->words[word] = value;
+    line->valid = line->valid | (1u << word);
+}
+
+void region_cache_invalidate_flash(void)
+{
+    uint32_t i;
+    for(i = 0; i < num_lines; i++)
+    {
+        if((REGION_CACHE_FLASH_START <= lines[i].address) && (REGION_CACHE_FLASH_END > lines[i].address))
+        {
+            lines[i].address = NO_LINE;
+            lines[i].valid = 0;
+        }
+    }
+}
+
+void region_cache_invalidate_all(void)
+{
+    uint32_t i;
+    for(i = 0; i < MAX_LINES; i++)
+    {
+        lines[i].address = NO_LINE;
+        lines[i].valid = 0;
+    }
+}
+
+uint32_t region_cache_get_num_hits(void)
+{
+    return num_hits;
+}
+
+uint32_t region_cache_get_num_misses(void)
+{
+    return num_misses;
+}
+
+#ifdef FEAT_CLI
+bool region_cache_cmd_info(uint32_t loop)
+{
+    (void)loop;
+    cli_line("read cache: %ld bytes, %ld hits, %ld misses", region_cache_get_budget(), num_hits, num_misses);
+    return true;
+}
+#endif
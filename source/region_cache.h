@@ -0,0 +1,75 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_REGION_CACHE_H_
+#define SOURCE_REGION_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Probe side cache for memory that does not change (FEAT_REGION_CACHE).
+//
+// GDB reads the boot ROM and the code and constants in the flash again and
+// again (disassembly, unwinding, symbol lookups). The words read from these
+// regions are kept in the probe, so that the next read of the same word does
+// not need a SWD transaction.
+//
+// - boot ROM: cached until region_cache_invalidate_all() (target reset)
+// - XIP flash: cached until the flash gets programmed (vFlashErase,
+//   vFlashWrite, vFlashDone) or the target gets reset. Code on the target
+//   that writes to the flash is not detected.
+//
+// The cache is direct mapped. Each line holds REGION_CACHE_LINE_BYTES bytes
+// and remembers which of its words are valid. So only words that have been
+// read before are served from the cache.
+//
+// REGION_CACHE_MAX_BYTES is the RAM reserved in the probe. The limit used can
+// be made smaller with "budget" in the [cache] section of nomagic.ini
+// (region_cache_set_budget()). 0 disables the cache. Without the
+// target_config_set() call in the ini parser of the probe firmware the
+// section is not read and the full size is used.
+//     [cache]
+//     budget = 4096
+
+#ifndef REGION_CACHE_MAX_BYTES
+#define REGION_CACHE_MAX_BYTES     4096
+#endif
+#define REGION_CACHE_LINE_BYTES    32
+
+#define REGION_CACHE_ROM_START     0x00000000
+#define REGION_CACHE_ROM_END       0x00004000
+#define REGION_CACHE_FLASH_START   0x10000000
+#define REGION_CACHE_FLASH_END     0x11000000
+
+void region_cache_init(void);
+void region_cache_set_budget(uint32_t bytes);
+uint32_t region_cache_get_budget(void);
+// true if the word at this address can be cached
+bool region_cache_is_cacheable(uint32_t address);
+// true = hit, *value is the cached word
+bool region_cache_read(uint32_t address, uint32_t* value);
+// adds a word that has been read from the target
+void region_cache_store(uint32_t address, uint32_t value);
+// flash content changes
+void region_cache_invalidate_flash(void);
+// target reset
+void region_cache_invalidate_all(void);
+uint32_t region_cache_get_num_hits(void);
+uint32_t region_cache_get_num_misses(void);
+#ifdef FEAT_CLI
+bool region_cache_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_REGION_CACHE_H_ */
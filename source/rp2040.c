@@ -30,12 +30,44 @@
 #include "probe_api/steps.h"
 #include "probe_api/swd.h"
 #include "probe_api/util.h"
+#include "cond_breakpoint.h"
+#include "cortex_m_debug.h"
+#include "deferred_log.h"
+#include "dual_core.h"
+#include "halt_cache.h"
+#include "live_watch.h"
+#include "loop_monitor.h"
+#include "range_step.h"
+#include "region_cache.h"
 #include "rp2040_flash_driver.h"
+#include "rtos.h"
+#include "rtt.h"
+#include "semihosting.h"
+#include "swd_tuning.h"
 #include "target.h"
+#include "target_config.h"
+#include "text_util.h"
+#include "tick_budget.h"
+#include "time_critical.h"
+#include "time_us.h"
+#include "tracepoint.h"
 #ifdef FEAT_EXECUTE_CODE_ON_TARGET
+#include "ram_planner.h"
+#include "stub_residency.h"
 #include "target/execute.h"
 #endif
 
+#if (defined FEAT_SEMIHOSTING) || (defined FEAT_TRACEPOINTS) || (defined FEAT_COND_BREAKPOINTS) \
+ || (defined FEAT_DUAL_CORE) || (defined FEAT_RTOS) || (defined FEAT_LIVE_WATCH) || (defined FEAT_RTT)
+// target_tick() checks for the halt while GDB waits for the stop reply (TARGET_HALTED)
+#define HALT_DETECTION
+#endif
+
+#if (defined FEAT_LIVE_WATCH) || (defined FEAT_RTT) || (defined FEAT_SEMIHOSTING)
+// target_tick() prints to the GDB console while GDB waits for the stop reply
+#define CONSOLE_OUTPUT
+#endif
+
 // RP2040:
 // Core 0: 0x01002927
 // Core 1: 0x11002927
@@ -76,26 +108,217 @@
 
 static flash_driver_data_typ flash_driver_state;
 
+static Result vFlashDone(action_data_typ* const action);
+static Result vFlashErase(action_data_typ* const action);
+static Result vFlashWrite(action_data_typ* const action);
+
 
 void target_init(void)
 {
+    time_critical_init();
     flash_write_buffer_init(256); // flash page size = 256 Bytes
     flash_driver_init();
+#ifdef FEAT_DEFERRED_LOG
+    dlog_init();
+#endif
+#ifdef LOOP_MONITOR
+    loop_monitor_init();
+#endif
 #ifdef FEAT_EXECUTE_CODE_ON_TARGET
     target_execute_init();
+    ram_planner_init();
+    stub_residency_init();
+#endif
+#ifdef FEAT_SWD_TUNING
+    swd_tuning_init();
+#endif
+#ifdef FEAT_REGION_CACHE
+    region_cache_init();
+#endif
+#ifdef FEAT_HALT_CACHE
+    halt_cache_init();
+#endif
+#ifdef FEAT_COND_BREAKPOINTS
+    cond_bp_init();
+#endif
+#ifdef FEAT_TRACEPOINTS
+    trace_init();
+#endif
+#ifdef FEAT_DUAL_CORE
+    dual_core_init();
+#endif
+#ifdef FEAT_RTOS
+    rtos_init();
+#endif
+#ifdef FEAT_LIVE_WATCH
+    live_watch_init();
+#endif
+#ifdef FEAT_RTT
+    rtt_init();
+#endif
+#ifdef FEAT_SEMIHOSTING
+    semihost_init();
 #endif
     common_target_init();
 }
 
+// the target has been reset: nothing that was read from it is valid any more
+static void forget_target_state(void)
+{
+#ifdef FEAT_REGION_CACHE
+    region_cache_invalidate_all();
+#endif
+#ifdef FEAT_HALT_CACHE
+    halt_cache_invalidate();
+#endif
+#ifdef FEAT_DUAL_CORE
+    dual_core_forget();
+#endif
+#ifdef FEAT_RTOS
+    rtos_forget();
+#endif
+#ifdef FEAT_RTT
+    rtt_forget();
+#endif
+}
+
 void target_re_init(void)
 {
     flash_write_buffer_clear();
     flash_driver_init();
+    forget_target_state();
+}
+
+// GDB_CMD_MON_RESET
+Result handle_target_monitor_reset(action_data_typ* const action)
+{
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(true == action->first_call)
+    {
+        forget_target_state();
+    }
+    return handle_monitor_reset(action);
+}
+
+#ifdef HALT_DETECTION
+// time between two checks of DHCSR while the core runs for GDB
+#define HALT_CHECK_INTERVAL_US   1000
+
+// GDB continued the core and waits for the stop reply
+static bool waiting_for_halt;
+// a TARGET_HALTED action is in the queue or running
+static bool halt_check_queued;
+static uint32_t last_halt_check;
+#endif
+
+#ifdef FEAT_LIVE_WATCH
+// a LIVE_WATCH_SAMPLE action is in the queue or running
+static bool live_watch_queued;
+#endif
+#ifdef FEAT_RTT
+// a RTT_POLL action is in the queue or running
+static bool rtt_poll_queued;
+#endif
+
+#ifdef CONSOLE_OUTPUT
+// longest text of one "O" packet
+#define CONSOLE_MAX_CHARS        112
+
+// "O" packet: text for the GDB console. Only while GDB waits for the stop
+// reply or before the reply to a monitor command.
+static void send_console_output(const char* text, uint32_t length)
+{
+    char hex[1 + 2 * CONSOLE_MAX_CHARS + 1];
+    uint32_t pos;
+    uint32_t i;
+
+    pos = text_add_string(hex, sizeof(hex), 0, "O");
+    for(i = 0; (i < length) && (i < CONSOLE_MAX_CHARS); i++)
+    {
+        pos = text_add_hex_byte(hex, sizeof(hex), pos, (uint8_t)text[i]);
+    }
+    hex[pos] = 0;
+    reply_packet_prepare();
+    reply_packet_add(hex);
+    reply_packet_send();
 }
+#endif
 
 void target_tick(void)
 {
+#ifdef LOOP_MONITOR
+    loop_monitor_tick_start();
+#endif
+    tick_budget_start();
+    loop_monitor_enter(LM_SWD);
     common_target_tick();
+    loop_monitor_leave(LM_SWD);
+#ifdef HALT_DETECTION
+    if(   (true == waiting_for_halt) && (false == halt_check_queued)
+       && (HALT_CHECK_INTERVAL_US <= (uint32_t)(time_us_now() - last_halt_check)) )
+    {
+        last_halt_check = time_us_now();
+        halt_check_queued = add_action(TARGET_HALTED);
+    }
+#endif
+#ifdef FEAT_LIVE_WATCH
+    if((false == live_watch_queued) && (true == live_watch_is_due()))
+    {
+        live_watch_queued = add_action(LIVE_WATCH_SAMPLE);
+    }
+    if(true == waiting_for_halt)
+    {
+        // one line per tick, the rest waits in the sample buffer
+        char line[CONSOLE_MAX_CHARS];
+        uint32_t length = live_watch_get_line(line, sizeof(line));
+        if(0 != length)
+        {
+            send_console_output(line, length);
+        }
+    }
+#endif
+#ifdef FEAT_SEMIHOSTING
+    if((true == waiting_for_halt) && (0 == semihost_get_tcp_port()))
+    {
+        // a call that waits for space in the output buffer keeps the core
+        // halted, so the output is sent while TARGET_HALTED runs, too
+        uint8_t data[CONSOLE_MAX_CHARS];
+        uint32_t length = semihost_read_output(data, sizeof(data));
+        if(0 != length)
+        {
+            send_console_output((const char*)data, length);
+        }
+    }
+#endif
+#ifdef FEAT_RTT
+    if((false == rtt_poll_queued) && (true == rtt_is_due()))
+    {
+        rtt_poll_queued = add_action(RTT_POLL);
+    }
+    if((true == waiting_for_halt) && (0 == rtt_get_tcp_port()))
+    {
+        // without a TCP port channel 0 goes to the GDB console
+        uint8_t data[CONSOLE_MAX_CHARS];
+        uint32_t length = rtt_read_up(0, data, sizeof(data));
+        if(0 != length)
+        {
+            send_console_output((const char*)data, length);
+        }
+    }
+#endif
+#ifdef FEAT_DEFERRED_LOG
+    if(false == flash_driver_is_busy())
+    {
+        // printing the log messages is slow -> not while flashing
+        dlog_flush_one();
+    }
+#endif
+#ifdef LOOP_MONITOR
+    loop_monitor_tick_end(flash_driver_is_busy());
+#endif
 }
 
 bool target_is_SWDv2(void)
@@ -120,17 +343,75 @@ uint32_t target_get_SWD_APSel(uint32_t core_num)
 }
 
 #ifdef FEAT_CLI
+typedef bool (*info_section_func)(uint32_t loop);
+
+// the sections of the "target info" output. Each function gets called with
+// loop counting up from 0 until it returns true.
+static const info_section_func info_sections[] = {
+#ifdef LOOP_MONITOR
+    loop_monitor_cmd_info,
+#endif
+#ifdef FEAT_SWD_TUNING
+    swd_tuning_cmd_info,
+#endif
+#ifdef FEAT_REGION_CACHE
+    region_cache_cmd_info,
+#endif
+#ifdef FEAT_HALT_CACHE
+    halt_cache_cmd_info,
+#endif
+#ifdef FEAT_COND_BREAKPOINTS
+    cond_bp_cmd_info,
+#endif
+#ifdef FEAT_TRACEPOINTS
+    trace_cmd_info,
+#endif
+#ifdef FEAT_DUAL_CORE
+    dual_core_cmd_info,
+#endif
+#ifdef FEAT_RTOS
+    rtos_cmd_info,
+#endif
+#ifdef FEAT_LIVE_WATCH
+    live_watch_cmd_info,
+#endif
+#ifdef FEAT_RTT
+    rtt_cmd_info,
+#endif
+#ifdef FEAT_SEMIHOSTING
+    semihost_cmd_info,
+#endif
+#ifdef FEAT_EXECUTE_CODE_ON_TARGET
+    ram_planner_cmd_info,
+    stub_residency_cmd_info,
+#endif
+    common_cmd_target_info,
+};
+
 bool cmd_target_info(uint32_t loop)
 {
+    static uint32_t section;
+    static uint32_t section_start;
+
     if(0 == loop)
     {
         cli_line("Target Status");
         cli_line("=============");
         cli_line("target: RP2040");
+        section = 0;
+        section_start = 1;
     }
     else
     {
-        return common_cmd_target_info(loop -1);
+        if(true == info_sections[section](loop - section_start))
+        {
+            section++;
+            section_start = loop + 1;
+            if((sizeof(info_sections)/sizeof(info_sections[0])) == section)
+            {
+                return true;
+            }
+        }
     }
     return false; // true == Done; false = call me again
 }
@@ -145,7 +426,21 @@ void target_send_file(char* filename, uint32_t offset, uint32_t len)
     }
     else if(0 == strncmp(filename, "threads", 7))
     {
-        send_part(THREADS_CONTENT, sizeof(THREADS_CONTENT), offset, len);  // TODO fix for dual core
+#ifdef FEAT_RTOS
+        if(true == rtos_is_active())
+        {
+            // 32 tasks with 16 character names
+            static char threads_xml[1600];
+            uint32_t size = rtos_get_threads_xml(threads_xml, sizeof(threads_xml));
+            send_part(threads_xml, size + 1, offset, len);
+            return;
+        }
+#endif
+#ifdef FEAT_DUAL_CORE
+        send_part(DUAL_CORE_THREADS_CONTENT, sizeof(DUAL_CORE_THREADS_CONTENT), offset, len);
+#else
+        send_part(THREADS_CONTENT, sizeof(THREADS_CONTENT), offset, len);  // only core 0, see FEAT_DUAL_CORE
+#endif
         return;
     }
     else if(0 == strncmp(filename, "memory-map", 10))
@@ -161,164 +456,1179 @@ void target_send_file(char* filename, uint32_t offset, uint32_t len)
     reply_packet_send();
 }
 
-// GDB_CMD_VFLASH_DONE
-Result handle_target_reply_vFlashDone(action_data_typ* const action)
+#if (defined FEAT_RANGE_STEP) || (defined FEAT_DUAL_CORE) || (defined FEAT_RTOS)
+// queues a target specific action with an address / length parameter
+static bool queue_action_with_range(action_typ act, uint32_t address, uint32_t length)
 {
-    Result res;
-
+    action_data_typ* const action = book_action_slot();
     if(NULL == action)
     {
-        return ERR_ACTION_NULL;
+        debug_error("ERROR: no free action slot !");
+        return false;
     }
+    action->gdb_parameter.type = ADDRESS_LENGTH;
+    action->gdb_parameter.address_length.address = address;
+    action->gdb_parameter.address_length.length = length;
+    return add_action_with_parameter(act, action);
+}
+#endif
 
-    if(true == action->first_call)
-    {
-        debug_line("Flash Done!");
-        action->first_call = false;
-        action->cur_phase = 0;
-        flash_driver_state.first_call = true;
-    }
+#ifdef FEAT_TRACEPOINTS
+static void send_reply(const char* reply)
+{
+    reply_packet_prepare();
+    reply_packet_add(reply);
+    reply_packet_send();
+}
 
-    if(0 == action->cur_phase)
+// QTFrame:n and QTFrame:pc:addr
+static void select_trace_frame(const char* c)
+{
+    char buf[24];
+    uint32_t pos;
+    uint32_t value;
+    uint32_t tracepoint = 0;
+    int32_t frame;
+
+    if(0 == strncmp(c, "pc:", 3))
     {
-        // finish erasing the flash
-        res = flash_driver_erase_finish(&flash_driver_state);
-        if(ERR_NOT_COMPLETED == res)
+        c = c + 3;
+        if(false == text_parse_hex(&c, &value))
         {
-            // Try again next time
-            return res;
+            send_reply(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+            return;
         }
-        if(RESULT_OK != res)
+        frame = trace_find_frame(value, trace_get_selected_frame());
+    }
+    else
+    {
+        if(false == text_parse_hex(&c, &value))
         {
-            debug_error("ERROR: finishing erase failed !");
-            reply_packet_prepare();
-            reply_packet_add(ERROR_TARGET_FAILED);
-            reply_packet_send();
-            return res;
+            send_reply(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+            return;
         }
-        action->cur_phase++;
-        flash_driver_state.first_call = true;
-        return ERR_NOT_COMPLETED;
+        // GDB sends -1 as ffffffff
+        frame = (int32_t)value;
+    }
+    if(RESULT_OK != trace_select_frame(frame, &tracepoint))
+    {
+        frame = TRACE_NO_FRAME;
+        trace_select_frame(TRACE_NO_FRAME, NULL);
     }
+    if(TRACE_NO_FRAME == frame)
+    {
+        send_reply("F-1");
+        return;
+    }
+    pos = text_add_string(buf, sizeof(buf), 0, "F");
+    pos = text_add_hex(buf, sizeof(buf), pos, (uint32_t)frame);
+    pos = text_add_string(buf, sizeof(buf), pos, "T");
+    text_add_hex(buf, sizeof(buf), pos, tracepoint);
+    send_reply(buf);
+}
 
-    if(1 == action->cur_phase)
+static bool handle_trace_packet(const char* packet)
+{
+    if(0 == strcmp(packet, "QTinit"))
     {
-        // finish writing to flash
-        res = flash_driver_write_finish(&flash_driver_state);
-        if(ERR_NOT_COMPLETED == res)
+        trace_clear();
+        send_reply("OK");
+        return true;
+    }
+    if(0 == strncmp(packet, "QTDP:", 5))
+    {
+        if(RESULT_OK == trace_define(packet + 5))
         {
-            // Try again next time
-            return res;
+            send_reply("OK");
         }
-        if(RESULT_OK != res)
+        else
         {
-            debug_error("ERROR: finishing write failed !");
-            reply_packet_prepare();
-            reply_packet_add(ERROR_TARGET_FAILED);
-            reply_packet_send();
-            return res;
+            send_reply(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
         }
-
-        action->cur_phase++;
-        flash_driver_state.first_call = true;
-        return ERR_NOT_COMPLETED;
+        return true;
+    }
+    if(0 == strcmp(packet, "QTStart"))
+    {
+        // the action sends the reply
+        return add_action(TRACE_START);
+    }
+    if(0 == strcmp(packet, "QTStop"))
+    {
+        return add_action(TRACE_STOP);
     }
+    if(0 == strcmp(packet, "qTStatus"))
+    {
+        char buf[128];
+        trace_get_status(buf, sizeof(buf));
+        send_reply(buf);
+        return true;
+    }
+    if(0 == strncmp(packet, "QTFrame:", 8))
+    {
+        select_trace_frame(packet + 8);
+        return true;
+    }
+    return false;
+}
+#endif
 
-    if(2 == action->cur_phase)
+#ifdef FEAT_RTOS
+// thread of "Hg" while the tasks are the GDB threads (0 = the running task)
+static uint32_t selected_task;
+
+static bool handle_rtos_packet(const char* packet)
+{
+    if(0 == strncmp(packet, "qSymbol", 7))
     {
-        // switch to XIP Mode
-        res = flash_driver_enter_xip_mode(&flash_driver_state);
-        if(ERR_NOT_COMPLETED == res)
+        char buf[80];
+        if(0 == rtos_handle_qsymbol(packet, buf, sizeof(buf)))
         {
-            // Try again next time
-            return res;
+            return false;
         }
-        if(RESULT_OK != res)
+        reply_packet_prepare();
+        reply_packet_add(buf);
+        reply_packet_send();
+        return true;
+    }
+    if(false == rtos_is_active())
+    {
+        return false;
+    }
+    if(('H' == packet[0]) && ('g' == packet[1]))
+    {
+        const char* c = packet + 2;
+        uint32_t thread_id;
+        if(false == text_parse_hex(&c, &thread_id))
         {
-            debug_error("ERROR: enter XiP mode failed !");
-            reply_packet_prepare();
-            reply_packet_add(ERROR_TARGET_FAILED);
-            reply_packet_send();
-            return res;
+            // "Hg-1"
+            thread_id = 0;
         }
-        // erase + write has finished now -> send OK
+        selected_task = (thread_id == rtos_get_current_thread()) ? 0 : thread_id;
         reply_packet_prepare();
         reply_packet_add("OK");
         reply_packet_send();
-        return RESULT_OK;
+        return true;
     }
-
-    return ERR_WRONG_STATE;
+    if((0 == strcmp(packet, "g")) && (0 != selected_task))
+    {
+        // the registers of the running task are the registers of the core
+        return queue_action_with_range(RTOS_THREAD_REGISTERS, selected_task, 0);
+    }
+    return false;
 }
+#endif
 
-// GDB_CMD_VFLASH_ERASE
-Result handle_target_reply_vFlashErase(action_data_typ* const action)
+#ifdef CONSOLE_OUTPUT
+// a monitor command arrives hex encoded as "qRcmd,<hex>"
+static bool decode_monitor_command(const char* packet, char* cmd, uint32_t size)
 {
-    Result res;
-    uint32_t start_address = action->gdb_parameter.address_length.address;
-    uint32_t length = action->gdb_parameter.address_length.length;
-
-    if(NULL == action)
-    {
-        return ERR_ACTION_NULL;
-    }
+    const char* c;
+    uint32_t i = 0;
 
-    if(ADDRESS_LENGTH != action->gdb_parameter.type)
+    if(0 != strncmp(packet, "qRcmd,", 6))
     {
-        // wrong parameter type
-        debug_error("ERROR: wrong parameter type !");
-        reply_packet_prepare();
-        reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
-        reply_packet_send();
-        return ERR_WRONG_VALUE;
+        return false;
     }
-
-    if(true == action->first_call)
+    c = packet + 6;
+    while((0 != c[0]) && ((i + 1) < size))
     {
-        debug_line("Flash erase: address : 0x%08lx, length: 0x%08lx", start_address, length);
-        action->first_call = false;
-        flash_driver_state.first_call = true;
+        uint8_t val;
+        if(false == text_parse_hex_byte(c, &val))
+        {
+            return false;
+        }
+        cmd[i] = (char)val;
+        i++;
+        c = c + 2;
     }
+    cmd[i] = 0;
+    return true;
+}
 
-    res = flash_driver_add_erase_range(&flash_driver_state, start_address, length);
-    if(ERR_NOT_COMPLETED == res)
-    {
-        // Try again next time
-        return res;
-    }
+// the output of a monitor command comes before the "OK"
+static void send_monitor_result(Result res, const char* usage)
+{
     if(RESULT_OK != res)
     {
-        debug_error("ERROR: adding erase range failed !");
-        reply_packet_prepare();
-        reply_packet_add(ERROR_TARGET_FAILED);
-        reply_packet_send();
-        return res;
+        send_console_output(usage, strlen(usage));
     }
-
-    // driver finished with RESULT_OK -> send OK
     reply_packet_prepare();
     reply_packet_add("OK");
     reply_packet_send();
-    return RESULT_OK;
 }
+#endif
 
-// GDB_CMD_VFLASH_WRITE
-Result handle_target_reply_vFlashWrite(action_data_typ* const action)
+#ifdef FEAT_LIVE_WATCH
+// "monitor live_watch ..."
+static bool handle_live_watch_command(const char* cmd)
 {
-    Result res;
-    uint32_t start_address = action->gdb_parameter.address_binary.address;
-    uint32_t length = action->gdb_parameter.address_binary.data_length; // length can be up to MAX_BINARY_SIZE_BYTES
-    uint8_t* data = (uint8_t*)action->gdb_parameter.address_binary.data;
+    const char* c;
+    Result res = RESULT_OK;
 
-    if(NULL == action)
+    if(0 != strncmp(cmd, "live_watch ", 11))
     {
-        return ERR_ACTION_NULL;
+        return false;
     }
-
-    if(ADDRESS_MEMORY != action->gdb_parameter.type)
+    c = cmd + 11;
+    if(0 == strncmp(c, "add ", 4))
     {
-        // wrong parameter type
-        debug_error("ERROR: wrong parameter type !");
+        uint32_t address;
+        uint32_t size;
+        c = c + 4;
+        if(('0' == c[0]) && ('x' == c[1]))
+        {
+            c = c + 2;
+        }
+        if(   (false == text_parse_hex(&c, &address)) || (false == text_expect(&c, ' '))
+           || (false == text_parse_hex(&c, &size)) )
+        {
+            res = ERR_WRONG_VALUE;
+        }
+        else
+        {
+            res = live_watch_add(address, size);
+        }
+    }
+    else if(0 == strcmp(c, "start"))
+    {
+        res = live_watch_start();
+        if(RESULT_OK == res)
+        {
+            char header[CONSOLE_MAX_CHARS];
+            uint32_t length = live_watch_get_header(header, sizeof(header));
+            send_console_output(header, length);
+        }
+    }
+    else if(0 == strcmp(c, "stop"))
+    {
+        live_watch_stop();
+    }
+    else if(0 == strcmp(c, "clear"))
+    {
+        live_watch_clear();
+    }
+    else
+    {
+        res = ERR_WRONG_VALUE;
+    }
+    send_monitor_result(res, "live_watch add <address> <size> (while stopped) | start | stop | clear\n");
+    return true;
+}
+#endif
+
+#ifdef FEAT_RTT
+// "monitor rtt on|off": without the [rtt] section RTT is off
+static bool handle_rtt_command(const char* cmd)
+{
+    Result res = RESULT_OK;
+
+    if(0 == strcmp(cmd, "rtt on"))
+    {
+        rtt_set_enabled(true);
+    }
+    else if(0 == strcmp(cmd, "rtt off"))
+    {
+        rtt_set_enabled(false);
+    }
+    else if(0 == strncmp(cmd, "rtt", 3))
+    {
+        res = ERR_WRONG_VALUE;
+    }
+    else
+    {
+        return false;
+    }
+    send_monitor_result(res, "rtt on | off\n");
+    return true;
+}
+#endif
+
+bool target_handle_gdb_packet(const char* packet)
+{
+    if(NULL == packet)
+    {
+        return false;
+    }
+#ifdef FEAT_RANGE_STEP
+    if(0 == strcmp(packet, "vCont?"))
+    {
+        reply_packet_prepare();
+        reply_packet_add(RANGE_STEP_VCONT_REPLY);
+        reply_packet_send();
+        return true;
+    }
+    if(0 == strncmp(packet, "vCont;r", 7))
+    {
+        uint32_t start;
+        uint32_t end;
+        if(true == range_step_parse_vcont(packet, &start, &end))
+        {
+            return queue_action_with_range(RANGE_STEP, start, end - start);
+        }
+        return false;
+    }
+#endif
+#ifdef FEAT_COND_BREAKPOINTS
+    if(   (('Z' == packet[0]) || ('z' == packet[0]))
+       && (('0' == packet[1]) || ('1' == packet[1])) )
+    {
+        // "Z0,addr,kind;X3,220127;..." the probe firmware still sets or removes
+        // the breakpoint itself, only the conditions are kept here.
+        const char* c = packet + 2;
+        uint32_t address;
+        if((false == text_expect(&c, ',')) || (false == text_parse_hex(&c, &address)))
+        {
+            return false;
+        }
+        if('z' == packet[0])
+        {
+            cond_bp_remove(address);
+        }
+        else if(RESULT_OK != cond_bp_set(address, strchr(c, ';')))
+        {
+            debug_error("ERROR: breakpoint 0x%08lx: invalid conditions !", address);
+        }
+        return false;
+    }
+#endif
+#ifdef FEAT_RTOS
+    // while the tasks are the threads the cores are not
+    if(true == handle_rtos_packet(packet))
+    {
+        return true;
+    }
+#endif
+#ifdef FEAT_DUAL_CORE
+    if(('H' == packet[0]) && ('g' == packet[1]))
+    {
+        const char* c = packet + 2;
+        uint32_t thread_id;
+        if(false == text_parse_hex(&c, &thread_id))
+        {
+            // "Hg-1"
+            return false;
+        }
+        return queue_action_with_range(DUAL_CORE_SET_THREAD, thread_id, 0);
+    }
+#endif
+#ifdef FEAT_TRACEPOINTS
+    if(true == handle_trace_packet(packet))
+    {
+        return true;
+    }
+#endif
+#ifdef CONSOLE_OUTPUT
+    {
+        char cmd[64];
+        if(true == decode_monitor_command(packet, cmd, sizeof(cmd)))
+        {
+#ifdef FEAT_LIVE_WATCH
+            if(true == handle_live_watch_command(cmd))
+            {
+                return true;
+            }
+#endif
+#ifdef FEAT_RTT
+            if(true == handle_rtt_command(cmd))
+            {
+                return true;
+            }
+#endif
+        }
+    }
+#endif
+    return false;
+}
+
+// the flash actions are measured by the loop monitor
+Result handle_target_reply_vFlashDone(action_data_typ* const action)
+{
+    Result res;
+    loop_monitor_enter(LM_FLASH);
+    res = vFlashDone(action);
+    loop_monitor_leave(LM_FLASH);
+    return res;
+}
+
+Result handle_target_reply_vFlashErase(action_data_typ* const action)
+{
+    Result res;
+    loop_monitor_enter(LM_FLASH);
+    res = vFlashErase(action);
+    loop_monitor_leave(LM_FLASH);
+    return res;
+}
+
+Result handle_target_reply_vFlashWrite(action_data_typ* const action)
+{
+    Result res;
+    loop_monitor_enter(LM_FLASH);
+    res = vFlashWrite(action);
+    loop_monitor_leave(LM_FLASH);
+    return res;
+}
+
+// GDB_CMD_VFLASH_DONE
+static Result vFlashDone(action_data_typ* const action)
+{
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        debug_line("Flash Done!");
+        action->first_call = false;
+#ifdef FEAT_REGION_CACHE
+        region_cache_invalidate_flash();
+#endif
+        action->cur_phase = 0;
+        flash_driver_state.first_call = true;
+    }
+
+    if(0 == action->cur_phase)
+    {
+        // finish erasing the flash
+        res = flash_driver_erase_finish(&flash_driver_state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: finishing erase failed !");
+            reply_packet_prepare();
+            reply_packet_add(ERROR_TARGET_FAILED);
+            reply_packet_send();
+            return res;
+        }
+        action->cur_phase++;
+        flash_driver_state.first_call = true;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == action->cur_phase)
+    {
+        // finish writing to flash
+        res = flash_driver_write_finish(&flash_driver_state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: finishing write failed !");
+            reply_packet_prepare();
+            reply_packet_add(ERROR_TARGET_FAILED);
+            reply_packet_send();
+            return res;
+        }
+
+        action->cur_phase++;
+        flash_driver_state.first_call = true;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(2 == action->cur_phase)
+    {
+        // switch to XIP Mode
+        res = flash_driver_enter_xip_mode(&flash_driver_state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: enter XiP mode failed !");
+            reply_packet_prepare();
+            reply_packet_add(ERROR_TARGET_FAILED);
+            reply_packet_send();
+            return res;
+        }
+        // erase + write has finished now -> send OK
+        reply_packet_prepare();
+        reply_packet_add("OK");
+        reply_packet_send();
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+// GDB_CMD_VFLASH_ERASE
+static Result vFlashErase(action_data_typ* const action)
+{
+    Result res;
+    uint32_t start_address = action->gdb_parameter.address_length.address;
+    uint32_t length = action->gdb_parameter.address_length.length;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(ADDRESS_LENGTH != action->gdb_parameter.type)
+    {
+        // wrong parameter type
+        debug_error("ERROR: wrong parameter type !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+        reply_packet_send();
+        return ERR_WRONG_VALUE;
+    }
+
+    if(true == action->first_call)
+    {
+        debug_line("Flash erase: address : 0x%08lx, length: 0x%08lx", start_address, length);
+        action->first_call = false;
+#ifdef FEAT_REGION_CACHE
+        region_cache_invalidate_flash();
+#endif
+        flash_driver_state.first_call = true;
+    }
+
+    res = flash_driver_add_erase_range(&flash_driver_state, start_address, length);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: adding erase range failed !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_TARGET_FAILED);
+        reply_packet_send();
+        return res;
+    }
+
+    // driver finished with RESULT_OK -> send OK
+    reply_packet_prepare();
+    reply_packet_add("OK");
+    reply_packet_send();
+    return RESULT_OK;
+}
+
+// GDB_CMD_VFLASH_WRITE
+static Result vFlashWrite(action_data_typ* const action)
+{
+    Result res;
+    uint32_t start_address = action->gdb_parameter.address_binary.address;
+    uint32_t length = action->gdb_parameter.address_binary.data_length; // length can be up to MAX_BINARY_SIZE_BYTES
+    uint8_t* data = (uint8_t*)action->gdb_parameter.address_binary.data;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(ADDRESS_MEMORY != action->gdb_parameter.type)
+    {
+        // wrong parameter type
+        debug_error("ERROR: wrong parameter type !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+        reply_packet_send();
+        return ERR_WRONG_VALUE;
+    }
+
+    if(true == action->first_call)
+    {
+        dlog_2("Flash write: address : 0x%08lx, length : %ld", start_address, length);
+        action->intern[INTERN_ALREADY_WRITTEN_BYTES] = 0;
+        action->first_call = false;
+#ifdef FEAT_REGION_CACHE
+        region_cache_invalidate_flash();
+#endif
+        flash_driver_state.first_call = true;
+    }
+
+    res = flash_write_buffer_add_data(start_address, length, data);
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: flash write buffer issue ! (%ld)", res);
+        reply_packet_prepare();
+        reply_packet_add(ERROR_TARGET_FAILED);
+        reply_packet_send();
+        return res;
+    }
+    res = flash_driver_write(&flash_driver_state);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: flash write failed !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_TARGET_FAILED);
+        reply_packet_send();
+        return res;
+    }
+
+    if(true == flash_write_buffer_has_data_block())
+    {
+        // the buffer still has enough bytes for an additional write
+        // -> try again
+        return ERR_NOT_COMPLETED;
+    }
+
+    // driver finished with RESULT_OK -> send OK
+    reply_packet_prepare();
+    reply_packet_add("OK");
+    reply_packet_send();
+    return RESULT_OK;
+}
+
+// GDB_CMD_READ_MEMORY
+Result handle_target_reply_read_memory(action_data_typ* const action)
+{
+    // ‘m addr,length’
+    //     Read length addressable memory units starting at address addr
+    // (see addressable memory unit). Note that addr may not be aligned to any
+    // particular boundary.
+    //     The stub need not use any particular size or alignment when gathering
+    // data from memory for the response; even if addr is word-aligned and
+    // length is a multiple of the word size, the stub is free to use byte
+    // accesses, or not. For this reason, this packet may not be suitable for
+    // accessing memory-mapped I/O devices.
+    //     Reply:
+    //     ‘XX…’
+    //         Memory contents; each byte is transmitted as a two-digit
+    // hexadecimal number. The reply may contain fewer addressable memory units
+    // than requested if the server was able to read only part of the region of
+    // memory.
+    //     ‘E NN’
+    //         NN is errno
+
+#define INTERN_MEMORY_OFFSET     1
+
+#ifdef FEAT_ERASE_SUSPEND
+// during a flash programming session the flash is not in XIP mode. Reads of
+// the flash then go through the flash driver (that suspends a running erase).
+#define READ_FLASH_THROUGH_DRIVER
+#define FLASH_START   0x10000000
+#define FLASH_END     0x11000000
+static bool read_through_driver;
+static Result read_through_driver_result;
+static flash_driver_data_typ flash_read_state;
+#endif
+#ifdef FEAT_REGION_CACHE
+// the flash content changes during a flash programming session
+static bool use_region_cache;
+#endif
+#ifdef FEAT_HALT_CACHE
+static bool use_halt_cache;
+static halt_cache_data_typ halt_cache_state;
+#endif
+
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        reply_packet_prepare();
+        if(ADDRESS_LENGTH != action->gdb_parameter.type)
+        {
+            // wrong parameter type
+            debug_error("ERROR: wrong parameter type !");
+            reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+            reply_packet_send();
+            return ERR_WRONG_VALUE;
+        }
+        else
+        {
+            action->cur_phase = 0;
+            action->intern[INTERN_MEMORY_OFFSET] = 0;
+        }
+#ifdef READ_FLASH_THROUGH_DRIVER
+        read_through_driver = false;
+        if(   (FLASH_START <= action->gdb_parameter.address_length.address)
+           && (FLASH_END > action->gdb_parameter.address_length.address)
+           && (true == flash_driver_is_busy()) )
+        {
+            read_through_driver = true;
+            read_through_driver_result = RESULT_OK;
+            flash_read_state.first_call = true;
+        }
+#endif
+#ifdef FEAT_REGION_CACHE
+        use_region_cache = !flash_driver_is_busy();
+#endif
+#ifdef FEAT_HALT_CACHE
+        use_halt_cache = halt_cache_is_cacheable(action->gdb_parameter.address_length.address);
+        halt_cache_state.first_call = true;
+#endif
+        action->first_call = false;
+    }
+
+#ifdef FEAT_HALT_CACHE
+    if(   (0 == action->cur_phase)
+       && (true == use_halt_cache)
+       && (true == halt_cache_is_cacheable(action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET])) )
+    {
+        res = halt_cache_read(&halt_cache_state,
+                              action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET],
+                              &action->read_0);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        halt_cache_state.first_call = true;
+        if(RESULT_OK == res)
+        {
+            action->cur_phase = 2;
+        }
+        else if(ERR_WRONG_STATE == res)
+        {
+            // the core is running -> read the target directly
+            use_halt_cache = false;
+        }
+        else
+        {
+            return res;
+        }
+    }
+#endif
+
+#ifdef FEAT_REGION_CACHE
+    if(   (0 == action->cur_phase)
+       && (true == use_region_cache)
+       && (true == region_cache_read(action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET], &action->read_0)) )
+    {
+        action->cur_phase = 2;
+    }
+#endif
+
+#ifdef READ_FLASH_THROUGH_DRIVER
+    if((0 == action->cur_phase) && (true == read_through_driver))
+    {
+        res = flash_driver_read_word(&flash_read_state,
+                                     action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET],
+                                     &action->read_0);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        flash_read_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            // the erase must continue even if the read failed
+            read_through_driver_result = res;
+            action->cur_phase = 3;
+        }
+        else
+        {
+            action->cur_phase = 2;
+        }
+    }
+#endif
+
+    if(0 == action->cur_phase)
+    {
+        res = step_read_ap((uint32_t *)(action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET]));
+        if(RESULT_OK == res)
+        {
+            action->cur_phase++;
+        }
+        else
+        {
+            return res;
+        }
+    }
+
+    if(1 == action->cur_phase)
+    {
+        res = step_get_Result_data(&action->read_0);
+        if(RESULT_OK == res)
+        {
+#ifdef FEAT_REGION_CACHE
+            if(true == use_region_cache)
+            {
+                region_cache_store(action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET], action->read_0);
+            }
+#endif
+            action->cur_phase++;
+        }
+        else
+        {
+            return res;
+        }
+    }
+
+    if(2 == action->cur_phase)
+    {
+        char buf[9];
+        int_to_hex(buf, action->read_0, 8);
+        buf[8] = 0;
+        reply_packet_add(buf);
+        // debug_line("read 0x%08lx / %s from 0x%08lx", action->read_0, buf, (action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET]));
+        action->intern[INTERN_MEMORY_OFFSET] = action->intern[INTERN_MEMORY_OFFSET] + 4;
+        action->cur_phase = 0;
+        if(action->gdb_parameter.address_length.length <= action->intern[INTERN_MEMORY_OFFSET])
+        {
+#ifdef READ_FLASH_THROUGH_DRIVER
+            if(true == read_through_driver)
+            {
+                // resume the erase
+                action->cur_phase = 3;
+                return ERR_NOT_COMPLETED;
+            }
+#endif
+            // finished
+            reply_packet_send();
+            return RESULT_OK;
+        }
+        else
+        {
+            // continue with next register
+            return ERR_NOT_COMPLETED;
+        }
+    }
+
+#ifdef READ_FLASH_THROUGH_DRIVER
+    if(3 == action->cur_phase)
+    {
+        res = flash_driver_read_done(&flash_read_state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        if(RESULT_OK != read_through_driver_result)
+        {
+            // GDB waits for an answer to the read
+            reply_packet_prepare();
+            reply_packet_add(ERROR_TARGET_FAILED);
+            reply_packet_send();
+            return read_through_driver_result;
+        }
+        reply_packet_send();
+        return res;
+    }
+#endif
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_SWD_TUNING
+// SWD_TUNE
+Result handle_swd_tune(action_data_typ* const action)
+{
+    static swd_tuning_data_typ tuning_state;
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        debug_line("SWD clock tuning started");
+        action->first_call = false;
+        tuning_state.first_call = true;
+    }
+
+    res = swd_tuning_run(&tuning_state);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    reply_packet_prepare();
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: SWD clock tuning failed !");
+        reply_packet_add(ERROR_TARGET_FAILED);
+    }
+    else
+    {
+        // The probe does not write nomagic.ini. GDB prints the [swd] section
+        // (hex encoded command output), the user puts it into nomagic.ini.
+        char section[40];
+        char buf[3];
+        uint32_t len;
+        uint32_t i;
+        len = target_config_get_changed(section, sizeof(section));
+        for(i = 0; i < len; i++)
+        {
+            int_to_hex(buf, (uint32_t)section[i], 2);
+            buf[2] = 0;
+            reply_packet_add(buf);
+        }
+        if(0 == len)
+        {
+            reply_packet_add("OK");
+        }
+    }
+    reply_packet_send();
+    return res;
+}
+#endif
+
+#ifdef FEAT_RANGE_STEP
+// RANGE_STEP (range_step_parse_vcont(): address = start, length = end - start)
+Result handle_range_step(action_data_typ* const action)
+{
+    static range_step_data_typ range_state;
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(ADDRESS_LENGTH != action->gdb_parameter.type)
+    {
+        // wrong parameter type
+        debug_error("ERROR: wrong parameter type !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+        reply_packet_send();
+        return ERR_WRONG_VALUE;
+    }
+
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        range_state.first_call = true;
+#ifdef FEAT_HALT_CACHE
+        halt_cache_invalidate();
+#endif
+    }
+
+    res = range_step_run(&range_state,
+                         action->gdb_parameter.address_length.address,
+                         action->gdb_parameter.address_length.address + action->gdb_parameter.address_length.length);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    reply_packet_prepare();
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: range step failed !");
+        reply_packet_add(ERROR_TARGET_FAILED);
+    }
+    else
+    {
+        dlog_2("range step: %ld steps, stopped at 0x%08lx", range_state.num_steps, range_state.pc);
+        // only the final stop is reported (SIGTRAP)
+        reply_packet_add("S05");
+    }
+    reply_packet_send();
+    return res;
+}
+#endif
+
+#ifdef FEAT_TRACEPOINTS
+static Result trace_arm_action(action_data_typ* const action, bool enable)
+{
+    static trace_arm_data_typ arm_state;
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        arm_state.first_call = true;
+    }
+
+    res = trace_arm(&arm_state, enable);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    reply_packet_prepare();
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: could not write the tracepoints to the FPB !");
+        reply_packet_add(ERROR_TARGET_FAILED);
+    }
+    else
+    {
+        if(true == enable)
+        {
+            res = trace_start();
+        }
+        else
+        {
+            trace_stop();
+        }
+        reply_packet_add("OK");
+    }
+    reply_packet_send();
+    return res;
+}
+
+// TRACE_START (QTStart)
+Result handle_trace_start(action_data_typ* const action)
+{
+    return trace_arm_action(action, true);
+}
+
+// TRACE_STOP (QTStop)
+Result handle_trace_stop(action_data_typ* const action)
+{
+    return trace_arm_action(action, false);
+}
+#endif
+
+#ifdef FEAT_DUAL_CORE
+static void send_stop_reply(uint32_t signal)
+{
+    char buf[20];
+    dual_core_get_stop_reply(buf, sizeof(buf), signal);
+    reply_packet_prepare();
+    reply_packet_add(buf);
+    reply_packet_send();
+}
+
+static Result dual_core_run_action(action_data_typ* const action, bool halt)
+{
+    static dual_core_data_typ run_state;
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        run_state.first_call = true;
+#ifdef FEAT_HALT_CACHE
+        halt_cache_invalidate();
+#endif
+    }
+
+    res = dual_core_set_run_state(&run_state, halt);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: could not %s the cores !", (true == halt) ? "halt" : "resume");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_TARGET_FAILED);
+        reply_packet_send();
+    }
+    else if(true == halt)
+    {
+        // SIGINT
+        send_stop_reply(2);
+    }
+    // else: GDB gets the stop reply when a core halts (TARGET_HALTED)
+    return res;
+}
+
+// DUAL_CORE_HALT (interrupt from GDB)
+Result handle_dual_core_halt(action_data_typ* const action)
+{
+    return dual_core_run_action(action, true);
+}
+
+// DUAL_CORE_RESUME (continue both cores)
+Result handle_dual_core_resume(action_data_typ* const action)
+{
+    return dual_core_run_action(action, false);
+}
+
+// DUAL_CORE_SET_THREAD (Hg: address = thread id)
+Result handle_dual_core_set_thread(action_data_typ* const action)
+{
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(ADDRESS_LENGTH != action->gdb_parameter.type)
+    {
+        // wrong parameter type
+        debug_error("ERROR: wrong parameter type !");
+        reply_packet_prepare();
+        reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
+        reply_packet_send();
+        return ERR_WRONG_VALUE;
+    }
+
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        res = dual_core_set_thread(action->gdb_parameter.address_length.address);
+        if(RESULT_OK != res)
+        {
+            reply_packet_prepare();
+            reply_packet_add("E01");
+            reply_packet_send();
+            return res;
+        }
+    }
+
+    res = dual_core_select(dual_core_get_thread() - DUAL_CORE_THREAD_ID(0));
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    reply_packet_prepare();
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: could not select the core !");
+        reply_packet_add(ERROR_TARGET_FAILED);
+    }
+    else
+    {
+        reply_packet_add("OK");
+    }
+    reply_packet_send();
+    return res;
+}
+#endif
+
+#ifdef FEAT_RTOS
+// RTOS_THREAD_REGISTERS (g for a task that does not run: address = thread id)
+Result handle_rtos_thread_registers(action_data_typ* const action)
+{
+    static rtos_data_typ reg_state;
+    static uint32_t regs[RTOS_NUM_REGS];
+    Result res;
+    uint32_t i;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(ADDRESS_LENGTH != action->gdb_parameter.type)
+    {
+        // wrong parameter type
+        debug_error("ERROR: wrong parameter type !");
         reply_packet_prepare();
         reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
         reply_packet_send();
@@ -327,75 +1637,152 @@ Result handle_target_reply_vFlashWrite(action_data_typ* const action)
 
     if(true == action->first_call)
     {
-        debug_line("Flash write: address : 0x%08lx", start_address);
-        debug_line("Flash write: length : %ld", length);
-        action->intern[INTERN_ALREADY_WRITTEN_BYTES] = 0;
         action->first_call = false;
-        flash_driver_state.first_call = true;
+        reg_state.first_call = true;
     }
 
-    res = flash_write_buffer_add_data(start_address, length, data);
-    if(RESULT_OK != res)
+    res = rtos_read_thread_registers(&reg_state, action->gdb_parameter.address_length.address, regs);
+    if(ERR_NOT_COMPLETED == res)
     {
-        debug_error("ERROR: flash write buffer issue ! (%ld)", res);
-        reply_packet_prepare();
-        reply_packet_add(ERROR_TARGET_FAILED);
-        reply_packet_send();
+        // Try again next time
         return res;
     }
-    res = flash_driver_write(&flash_driver_state);
+    reply_packet_prepare();
+    if(ERR_WRONG_VALUE == res)
+    {
+        // running task or unknown thread
+        reply_packet_add("E01");
+    }
+    else if(RESULT_OK != res)
+    {
+        debug_error("ERROR: could not read the stack of the task !");
+        reply_packet_add(ERROR_TARGET_FAILED);
+    }
+    else
+    {
+        for(i = 0; i < RTOS_NUM_REGS; i++)
+        {
+            char buf[9];
+            int_to_hex(buf, regs[i], 8);
+            buf[8] = 0;
+            reply_packet_add(buf);
+        }
+    }
+    reply_packet_send();
+    return res;
+}
+#endif
+
+#ifdef FEAT_LIVE_WATCH
+// LIVE_WATCH_SAMPLE (queued by target_tick() when live_watch_is_due())
+Result handle_live_watch_sample(action_data_typ* const action)
+{
+    static live_watch_data_typ sample_state;
+    Result res;
+
+    if(NULL == action)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        sample_state.first_call = true;
+    }
+
+    res = live_watch_sample(&sample_state);
     if(ERR_NOT_COMPLETED == res)
     {
         // Try again next time
         return res;
     }
+    live_watch_queued = false;
     if(RESULT_OK != res)
     {
-        debug_error("ERROR: flash write failed !");
-        reply_packet_prepare();
-        reply_packet_add(ERROR_TARGET_FAILED);
-        reply_packet_send();
-        return res;
+        // no GDB packet to answer, the stream just ends
+        debug_error("ERROR: live watch could not read the target !");
+        live_watch_stop();
     }
+    return res;
+}
+#endif
 
-    if(true == flash_write_buffer_has_data_block())
+#ifdef FEAT_RTT
+// RTT_POLL (queued by target_tick() when rtt_is_due())
+Result handle_rtt_poll(action_data_typ* const action)
+{
+    static rtt_data_typ poll_state;
+    Result res;
+
+    if(NULL == action)
     {
-        // the buffer still has enough bytes for an additional write
-        // -> try again
-        return ERR_NOT_COMPLETED;
+        return ERR_ACTION_NULL;
     }
 
-    // driver finished with RESULT_OK -> send OK
-    reply_packet_prepare();
-    reply_packet_add("OK");
-    reply_packet_send();
-    return RESULT_OK;
-}
+    if(true == action->first_call)
+    {
+        action->first_call = false;
+        poll_state.first_call = true;
+    }
 
-// GDB_CMD_READ_MEMORY
-Result handle_target_reply_read_memory(action_data_typ* const action)
-{
-    // ‘m addr,length’
-    //     Read length addressable memory units starting at address addr
-    // (see addressable memory unit). Note that addr may not be aligned to any
-    // particular boundary.
-    //     The stub need not use any particular size or alignment when gathering
-    // data from memory for the response; even if addr is word-aligned and
-    // length is a multiple of the word size, the stub is free to use byte
-    // accesses, or not. For this reason, this packet may not be suitable for
-    // accessing memory-mapped I/O devices.
-    //     Reply:
-    //     ‘XX…’
-    //         Memory contents; each byte is transmitted as a two-digit
-    // hexadecimal number. The reply may contain fewer addressable memory units
-    // than requested if the server was able to read only part of the region of
-    // memory.
-    //     ‘E NN’
-    //         NN is errno
+    res = rtt_poll(&poll_state);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    rtt_poll_queued = false;
+#ifdef FEAT_HALT_CACHE
+    // the poll wrote read / write offsets and down data into the target RAM
+    halt_cache_invalidate();
+#endif
+    if(RESULT_OK != res)
+    {
+        // rtt_poll() backs off, the control block gets searched again later
+        debug_error("ERROR: RTT poll failed !");
+    }
+    return res;
+}
+#endif
 
-#define INTERN_MEMORY_OFFSET     1
+#ifdef HALT_DETECTION
+#define HALT_PHASE_CHECK        0
+#define HALT_PHASE_READ_PC      1
+#define HALT_PHASE_SEMIHOSTING  2
+#define HALT_PHASE_TRACEPOINT   3
+#define HALT_PHASE_CONDITION    4
+#define HALT_PHASE_RTOS         5
+#define HALT_PHASE_REPORT       6
 
-    Result res;
+// A semihosting call, a tracepoint and a breakpoint with false conditions are
+// handled on the probe and the core runs again. Everything else is reported to GDB.
+static Result target_halted(action_data_typ* const action)
+{
+#ifdef FEAT_DUAL_CORE
+    static dual_core_data_typ poll_state;
+#else
+    static activity_data_typ dhcsr_state;
+    static uint32_t dhcsr;
+#endif
+    static bool halted;
+#ifdef FEAT_SEMIHOSTING
+    static semihost_data_typ semihost_state;
+#endif
+#ifdef FEAT_TRACEPOINTS
+    static trace_data_typ trace_state;
+#endif
+#ifdef FEAT_COND_BREAKPOINTS
+    static cond_bp_data_typ cond_state;
+#endif
+#ifdef FEAT_RTOS
+    static rtos_data_typ rtos_state;
+    static bool task_known;
+#endif
+    static core_register_data_typ pc_state;
+    static uint32_t pc;
+    static bool resumed;
+    Result res = RESULT_OK;
 
     if(NULL == action)
     {
@@ -404,86 +1791,247 @@ Result handle_target_reply_read_memory(action_data_typ* const action)
 
     if(true == action->first_call)
     {
-        reply_packet_prepare();
-        if(ADDRESS_LENGTH != action->gdb_parameter.type)
+        action->first_call = false;
+        action->cur_phase = HALT_PHASE_CHECK;
+#ifdef FEAT_DUAL_CORE
+        poll_state.first_call = true;
+#else
+        dhcsr_state.first_call = true;
+#endif
+        pc_state.first_call = true;
+        resumed = false;
+#ifdef FEAT_SEMIHOSTING
+        semihost_state.first_call = true;
+#endif
+#ifdef FEAT_TRACEPOINTS
+        trace_state.first_call = true;
+#endif
+#ifdef FEAT_COND_BREAKPOINTS
+        cond_state.first_call = true;
+#endif
+#ifdef FEAT_RTOS
+        rtos_state.first_call = true;
+        task_known = false;
+#endif
+    }
+
+    if(HALT_PHASE_CHECK == action->cur_phase)
+    {
+        if(false == waiting_for_halt)
         {
-            // wrong parameter type
-            debug_error("ERROR: wrong parameter type !");
-            reply_packet_add(ERROR_CODE_INVALID_PARAMETER_FORMAT_TYPE);
-            reply_packet_send();
-            return ERR_WRONG_VALUE;
+            // GDB halted the core in the meantime
+            return RESULT_OK;
         }
-        else
+#ifdef FEAT_DUAL_CORE
+        // the core that halted becomes the current thread and stays selected
+        res = dual_core_poll(&poll_state, &halted);
+#else
+        res = act_read_register(&dhcsr_state, DHCSR_ADDRESS, &dhcsr);
+        halted = (0 != (dhcsr & DHCSR_S_HALT));
+#endif
+        if(ERR_NOT_COMPLETED == res)
         {
-            action->cur_phase = 0;
-            action->intern[INTERN_MEMORY_OFFSET] = 0;
+            return res;
         }
-        action->first_call = false;
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: could not read the state of the core !");
+            return res;
+        }
+        if(false == halted)
+        {
+            // still running
+            return RESULT_OK;
+        }
+        // GDB waits until the stop reply has been sent
+        action->cur_phase = HALT_PHASE_READ_PC;
     }
 
-    if(0 == action->cur_phase)
+    if(HALT_PHASE_READ_PC == action->cur_phase)
     {
-        res = step_read_ap((uint32_t *)(action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET]));
-        if(RESULT_OK == res)
+        res = core_register_read(&pc_state, REGSEL_PC, &pc);
+        if(ERR_NOT_COMPLETED == res)
         {
-            action->cur_phase++;
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: could not read the PC !");
+            action->cur_phase = HALT_PHASE_REPORT;
         }
         else
         {
+            action->cur_phase = HALT_PHASE_SEMIHOSTING;
+            return ERR_NOT_COMPLETED;
+        }
+    }
+
+    if(HALT_PHASE_SEMIHOSTING == action->cur_phase)
+    {
+#ifdef FEAT_SEMIHOSTING
+        res = semihost_on_halt(&semihost_state, pc, &resumed);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time (also while the output buffer is full)
             return res;
         }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: semihosting call failed !");
+        }
+#endif
+        action->cur_phase = ((RESULT_OK == res) && (false == resumed)) ? HALT_PHASE_TRACEPOINT : HALT_PHASE_REPORT;
     }
 
-    if(1 == action->cur_phase)
+    if(HALT_PHASE_TRACEPOINT == action->cur_phase)
     {
-        res = step_get_Result_data(&action->read_0);
-        if(RESULT_OK == res)
+#ifdef FEAT_TRACEPOINTS
+        res = trace_on_halt(&trace_state, pc, &resumed);
+        if(ERR_NOT_COMPLETED == res)
         {
-            action->cur_phase++;
+            // Try again next time
+            return res;
         }
-        else
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: tracepoint collection failed !");
+        }
+#endif
+        action->cur_phase = ((RESULT_OK == res) && (false == resumed)) ? HALT_PHASE_CONDITION : HALT_PHASE_REPORT;
+    }
+
+    if(HALT_PHASE_CONDITION == action->cur_phase)
+    {
+#ifdef FEAT_COND_BREAKPOINTS
+        res = cond_bp_on_halt(&cond_state, pc, &resumed);
+        if(ERR_NOT_COMPLETED == res)
         {
+            // Try again next time
             return res;
         }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: breakpoint condition failed !");
+        }
+#endif
+        action->cur_phase = ((RESULT_OK == res) && (false == resumed)) ? HALT_PHASE_RTOS : HALT_PHASE_REPORT;
     }
 
-    if(2 == action->cur_phase)
+    if(HALT_PHASE_RTOS == action->cur_phase)
     {
-        char buf[9];
-        int_to_hex(buf, action->read_0, 8);
-        buf[8] = 0;
-        reply_packet_add(buf);
-        // debug_line("read 0x%08lx / %s from 0x%08lx", action->read_0, buf, (action->gdb_parameter.address_length.address + action->intern[INTERN_MEMORY_OFFSET]));
-        action->intern[INTERN_MEMORY_OFFSET] = action->intern[INTERN_MEMORY_OFFSET] + 4;
-        action->cur_phase = 0;
-        if(action->gdb_parameter.address_length.length <= action->intern[INTERN_MEMORY_OFFSET])
+#ifdef FEAT_RTOS
+        if(true == rtos_is_active())
         {
-            // finished
-            reply_packet_send();
-            return RESULT_OK;
+            Result rtos_res = rtos_update(&rtos_state);
+            if(ERR_NOT_COMPLETED == rtos_res)
+            {
+                // Try again next time
+                return rtos_res;
+            }
+            // scheduler not started yet or the task lists could not be read
+            // -> the halt is reported without a task
+            task_known = (RESULT_OK == rtos_res) && (0 != rtos_get_current_thread());
         }
-        else
+        // GDB selects the thread again after the stop reply
+        selected_task = 0;
+#endif
+        action->cur_phase = HALT_PHASE_REPORT;
+    }
+
+    if((RESULT_OK == res) && (true == resumed))
+    {
+        // handled on the probe -> the core runs again, GDB keeps waiting
+#ifdef FEAT_HALT_CACHE
+        halt_cache_invalidate();
+#endif
+        return RESULT_OK;
+    }
+    waiting_for_halt = false;
+#ifdef FEAT_SEMIHOSTING
+    if(0 == semihost_get_tcp_port())
+    {
+        // GDB shows all output of the program before the halt
+        uint8_t data[CONSOLE_MAX_CHARS];
+        uint32_t length = semihost_read_output(data, sizeof(data));
+        while(0 != length)
         {
-            // continue with next register
-            return ERR_NOT_COMPLETED;
+            send_console_output((const char*)data, length);
+            length = semihost_read_output(data, sizeof(data));
         }
     }
+#endif
+#ifdef FEAT_RTOS
+    if(true == task_known)
+    {
+        char buf[30];
+        rtos_get_stop_reply(buf, sizeof(buf), 5);
+        reply_packet_prepare();
+        reply_packet_add(buf);
+        reply_packet_send();
+        return res;
+    }
+#endif
+#ifdef FEAT_DUAL_CORE
+    // SIGTRAP
+    send_stop_reply(5);
+#else
+    reply_packet_prepare();
+    reply_packet_add("S05");
+    reply_packet_send();
+#endif
+    return res;
+}
 
-    return ERR_WRONG_STATE;
+// TARGET_HALTED (queued by target_tick() while GDB waits for a stop reply)
+// checks if the core halted and reports that to GDB.
+Result handle_target_halted(action_data_typ* const action)
+{
+    Result res = target_halted(action);
+    if(ERR_NOT_COMPLETED != res)
+    {
+        halt_check_queued = false;
+    }
+    return res;
 }
+#endif
 
 bool target_command_halt_cpu(void)
 {
+#ifdef FEAT_HALT_CACHE
+    halt_cache_invalidate();
+#endif
+#ifdef HALT_DETECTION
+    waiting_for_halt = false;
+#endif
+#ifdef FEAT_DUAL_CORE
+    // halts both cores, the action sends the stop reply
+    return add_action(DUAL_CORE_HALT);
+#else
     return target_command_halt_cortex_m_cpu();
+#endif
 }
 
 bool target_command_release_cpu(void)
 {
+#ifdef FEAT_HALT_CACHE
+    halt_cache_invalidate();
+#endif
+#ifdef HALT_DETECTION
+    waiting_for_halt = true;
+    last_halt_check = time_us_now();
+#endif
+#ifdef FEAT_DUAL_CORE
+    return add_action(DUAL_CORE_RESUME);
+#else
     return target_command_release_cortex_m_cpu();
+#endif
 }
 
 Result target_write(uint32_t start_address, uint8_t* data, uint32_t length)
 {
+#ifdef FEAT_HALT_CACHE
+    halt_cache_invalidate();
+#endif
     // TODO
     (void) start_address;
     (void) data;
@@ -23,6 +23,8 @@
 #include "probe_api/gdb_packets.h"
 #include "probe_api/result.h"
 #include "rp2040_flash_driver.h"
+#include "tick_budget.h"
+#include "time_critical.h"
 
 
 static bool flash_initialized;
@@ -40,11 +42,31 @@ static uint32_t write_address_offset; // number of bytes from a 0x00 address fro
 
 static flash_action_data_typ action_state;
 static flash_driver_data_typ cross_call_state;
+#ifdef FEAT_ERASE_SUSPEND
+static bool erase_suspended;
+static flash_action_data_typ read_action_state;
+#endif
+
+static Result add_erase_range_step(flash_driver_data_typ* const state, uint32_t start_address, uint32_t length);
+static Result write_step(flash_driver_data_typ* const state);
+static Result erase_finish_step(flash_driver_data_typ* const state);
+static Result write_finish_step(flash_driver_data_typ* const state);
+static Result enter_xip_mode_step(flash_driver_data_typ* const state);
+#ifdef FEAT_ERASE_SUSPEND
+static Result read_word_step(flash_driver_data_typ* const state, uint32_t address, uint32_t* value);
+static Result read_done_step(flash_driver_data_typ* const state);
+#endif
 
 void flash_driver_init(void)
 {
+#ifndef FEAT_EXECUTE_CODE_ON_TARGET
+    flash_actions_init();
+#endif
     flash_initialized = false;
     flash_erase_ongoing = false;
+#ifdef FEAT_ERASE_SUSPEND
+    erase_suspended = false;
+#endif
     action_state.first_call = true;
     erase_start_address = 0;
     erase_end_address = 0;
@@ -56,7 +78,141 @@ void flash_driver_init(void)
     write_address_offset = 0;
 }
 
+// true = a flash programming session is ongoing
+bool flash_driver_is_busy(void)
+{
+    if((true == flash_initialized) || (true == flash_erase_ongoing))
+    {
+        return true;
+    }
+    return false;
+}
+
+// The public functions run the phases of the state machine for as long as the
+// tick budget allows. The *_step() functions do one phase per call.
+
 Result flash_driver_add_erase_range(flash_driver_data_typ* const state, uint32_t start_address, uint32_t length)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = add_erase_range_step(state, start_address, length);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+Result flash_driver_write(flash_driver_data_typ* const state)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = write_step(state);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+Result flash_driver_erase_finish(flash_driver_data_typ* const state)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = erase_finish_step(state);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+Result flash_driver_write_finish(flash_driver_data_typ* const state)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = write_finish_step(state);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+Result flash_driver_enter_xip_mode(flash_driver_data_typ* const state)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = enter_xip_mode_step(state);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+#ifdef FEAT_ERASE_SUSPEND
+Result flash_driver_read_word(flash_driver_data_typ* const state, uint32_t address, uint32_t* value)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = read_word_step(state, address, value);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+
+Result flash_driver_read_done(flash_driver_data_typ* const state)
+{
+    Result res;
+    uint32_t phase_before;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    do
+    {
+        phase_before = state->phase;
+        res = read_done_step(state);
+    } while(true == tick_budget_continue(res, phase_before, state->phase));
+    return res;
+}
+#endif
+
+static Result add_erase_range_step(flash_driver_data_typ* const state, uint32_t start_address, uint32_t length)
 {
     if(NULL == state)
     {
@@ -257,7 +413,7 @@ Result flash_driver_add_erase_range(flash_driver_data_typ* const state, uint32_t
 }
 
 
-Result flash_driver_write(flash_driver_data_typ* const state)
+static Result TIME_CRITICAL(write_step)(flash_driver_data_typ* const state)
 {
     Result res;
 
@@ -355,7 +511,7 @@ Result flash_driver_write(flash_driver_data_typ* const state)
     return ERR_WRONG_STATE;
 }
 
-Result flash_driver_erase_finish(flash_driver_data_typ* const state)
+static Result erase_finish_step(flash_driver_data_typ* const state)
 {
     if(NULL == state)
     {
@@ -467,7 +623,7 @@ Result flash_driver_erase_finish(flash_driver_data_typ* const state)
     }
 }
 
-Result flash_driver_write_finish(flash_driver_data_typ* const state)
+static Result write_finish_step(flash_driver_data_typ* const state)
 {
     if(NULL == state)
     {
@@ -544,7 +700,7 @@ Result flash_driver_write_finish(flash_driver_data_typ* const state)
     }
 }
 
-Result flash_driver_enter_xip_mode(flash_driver_data_typ* const state)
+static Result enter_xip_mode_step(flash_driver_data_typ* const state)
 {
     if(NULL == state)
     {
@@ -572,3 +728,99 @@ Result flash_driver_enter_xip_mode(flash_driver_data_typ* const state)
 
     return RESULT_OK;
 }
+
+#ifdef FEAT_ERASE_SUSPEND
+// An erase (or page program) started by the pipelined flash programs might
+// still be running. The first read suspends it, read_done_step() resumes it.
+// Flash that can not suspend makes the read wait for the end of the erase.
+// The block that is being erased reads as undefined data while the erase is
+// suspended, so reads of that block return the erased value without
+// accessing the flash.
+static Result TIME_CRITICAL(read_word_step)(flash_driver_data_typ* const state, uint32_t address, uint32_t* value)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == value))
+    {
+        return ERR_ACTION_NULL;
+    }
+    if((true == state->first_call) && (true == flash_is_in_erased_block(address)))
+    {
+        *value = 0xffffffff;
+        return RESULT_OK;
+    }
+    if(true == state->first_call)
+    {
+        read_action_state.first_call = true;
+        state->first_call = false;
+        state->phase = 0;
+        if((true == erase_suspended) || (false == flash_can_suspend_erase()))
+        {
+            state->phase = 1;
+        }
+    }
+
+    if(0 == state->phase)
+    {
+        res = flash_erase_suspend(&read_action_state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            // Try again next time
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            debug_error("ERROR: erase suspend failed !");
+            return res;
+        }
+        erase_suspended = true;
+        read_action_state.first_call = true;
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == state->phase)
+    {
+        res = flash_read_word(&read_action_state, address, value);
+        if((RESULT_OK != res) && (ERR_NOT_COMPLETED != res))
+        {
+            debug_error("ERROR: flash read failed !");
+        }
+        return res;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+static Result read_done_step(flash_driver_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(true == state->first_call)
+    {
+        read_action_state.first_call = true;
+        state->first_call = false;
+        state->phase = 0;
+    }
+    if(false == erase_suspended)
+    {
+        return RESULT_OK;
+    }
+    res = flash_erase_resume(&read_action_state);
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    erase_suspended = false;
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: erase resume failed !");
+    }
+    return res;
+}
+#endif
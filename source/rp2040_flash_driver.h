@@ -29,10 +29,17 @@ typedef struct {
 
 
 void flash_driver_init(void);
+bool flash_driver_is_busy(void);
 Result flash_driver_add_erase_range(flash_driver_data_typ* const state, uint32_t start_address, uint32_t length);
 Result flash_driver_write(flash_driver_data_typ* const state);
 Result flash_driver_erase_finish(flash_driver_data_typ* const state);
 Result flash_driver_write_finish(flash_driver_data_typ* const state);
 Result flash_driver_enter_xip_mode(flash_driver_data_typ* const state);
+#ifdef FEAT_ERASE_SUSPEND
+// reads 4 bytes of the flash while the flash is not in XIP mode (a running erase gets suspended)
+Result flash_driver_read_word(flash_driver_data_typ* const state, uint32_t address, uint32_t* value);
+// end of the reads -> the erase continues
+Result flash_driver_read_done(flash_driver_data_typ* const state);
+#endif
 
 #endif /* SOURCE_RP2040_FLASH_DRIVER_H_ */
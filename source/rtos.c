@@ -0,0 +1,654 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include <string.h>
+#include "rtos.h"
+#include "probe_api/debug_log.h"
+#include "block_read.h"
+#include "text_util.h"
+
+#define LIST_NONE           0xffffffff
+// List_t: uxNumberOfItems, pxIndex, xListEnd (xItemValue, pxNext, pxPrevious)
+#define LIST_HEADER_WORDS   5
+#define LIST_SIZE           (LIST_HEADER_WORDS * 4)
+#define LIST_END_OFFSET     8
+// ListItem_t: xItemValue, pxNext, pxPrevious, pvOwner, pvContainer
+#define ITEM_WORDS          5
+#define ITEM_NEXT           1
+#define ITEM_OWNER          3
+// saved by PendSV (r4-r7, r8-r11) and by the exception entry (r0-r3, r12, lr, pc, xPSR)
+#define STACK_FRAME_WORDS   16
+#define XPSR_STACK_ALIGN    (1u << 9)
+
+#define PHASE_COUNTERS      0
+#define PHASE_LIST_HEADER   1
+#define PHASE_ITEM          2
+#define PHASE_NAMES         3
+#define PHASE_NAME_READ     4
+
+#define PHASE_TOP_OF_STACK  0
+#define PHASE_STACK_FRAME   1
+
+typedef struct {
+    uint32_t tcb;
+    uint32_t list;
+    bool has_name;
+    char name[RTOS_NAME_LENGTH + 1];
+} task_typ;
+
+typedef struct {
+    bool valid;
+    uint32_t num_items;
+    uint32_t first;
+    uint32_t last;
+} list_cache_typ;
+
+static const char* const symbol_names[RTOS_NUM_SYMBOLS] = {
+        "pxCurrentTCB",
+        "pxReadyTasksLists",
+        "xDelayedTaskList1",
+        "xDelayedTaskList2",
+        "xPendingReadyList",
+        "xSuspendedTaskList",
+        "xTasksWaitingTermination",
+        "uxCurrentNumberOfTasks",
+        "uxTaskNumber",
+};
+
+static uint32_t symbols[RTOS_NUM_SYMBOLS];
+static uint32_t next_symbol;
+static uint32_t max_priorities;
+static uint32_t name_offset;
+static task_typ tasks[RTOS_MAX_THREADS];
+static uint32_t num_tasks;
+static list_cache_typ lists[RTOS_MAX_LISTS];
+static bool counters_valid;
+static uint32_t number_of_tasks;
+static uint32_t task_number;
+static uint32_t current_tcb;
+static uint32_t num_updates;
+static uint32_t num_unchanged;
+static uint32_t num_list_walks;
+
+void rtos_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < RTOS_NUM_SYMBOLS; i++)
+    {
+        symbols[i] = 0;
+    }
+    next_symbol = RTOS_NUM_SYMBOLS;
+    max_priorities = RTOS_DEFAULT_MAX_PRIORITIES;
+    name_offset = RTOS_DEFAULT_NAME_OFFSET;
+    num_updates = 0;
+    num_unchanged = 0;
+    num_list_walks = 0;
+    rtos_forget();
+}
+
+void rtos_forget(void)
+{
+    uint32_t i;
+    for(i = 0; i < RTOS_MAX_LISTS; i++)
+    {
+        lists[i].valid = false;
+    }
+    num_tasks = 0;
+    counters_valid = false;
+    current_tcb = 0;
+}
+
+const char* rtos_get_symbol_name(uint32_t idx)
+{
+    if(RTOS_NUM_SYMBOLS <= idx)
+    {
+        return NULL;
+    }
+    return symbol_names[idx];
+}
+
+void rtos_set_symbol(uint32_t idx, uint32_t address)
+{
+    if(RTOS_NUM_SYMBOLS > idx)
+    {
+        symbols[idx] = address;
+        rtos_forget();
+    }
+}
+
+void rtos_set_max_priorities(uint32_t priorities)
+{
+    if((0 < priorities) && (RTOS_MAX_PRIORITIES >= priorities))
+    {
+        max_priorities = priorities;
+    }
+    rtos_forget();
+}
+
+void rtos_set_name_offset(uint32_t offset)
+{
+    name_offset = offset;
+    rtos_forget();
+}
+
+// GDB sends the symbol names hex encoded
+static bool is_hex_name(const char* hex, const char* name)
+{
+    uint8_t c;
+    while(0 != *name)
+    {
+        if((false == text_parse_hex_byte(hex, &c)) || ((uint8_t)*name != c))
+        {
+            return false;
+        }
+        hex = hex + 2;
+        name++;
+    }
+    return (0 == *hex);
+}
+
+uint32_t rtos_handle_qsymbol(const char* packet, char* buf, uint32_t size)
+{
+    const char* c = packet;
+    uint32_t address = 0;
+    uint32_t pos;
+    uint32_t i;
+
+    if((NULL == packet) || (NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    if(0 != strncmp(c, "qSymbol:", 8))
+    {
+        buf[0] = 0;
+        return 0;
+    }
+    c = c + 8;
+    if(0 == strcmp(c, ":"))
+    {
+        // GDB can look up symbols (again): ask for all of them
+        next_symbol = 0;
+    }
+    else
+    {
+        // "<address>:<name>", no address if GDB does not know the symbol
+        (void)text_parse_hex(&c, &address);
+        if(true == text_expect(&c, ':'))
+        {
+            for(i = 0; i < RTOS_NUM_SYMBOLS; i++)
+            {
+                if(true == is_hex_name(c, symbol_names[i]))
+                {
+                    rtos_set_symbol(i, address);
+                    break;
+                }
+            }
+        }
+    }
+    if(RTOS_NUM_SYMBOLS == next_symbol)
+    {
+        pos = text_add_string(buf, size, 0, "OK");
+    }
+    else
+    {
+        pos = text_add_string(buf, size, 0, "qSymbol:");
+        for(i = 0; 0 != symbol_names[next_symbol][i]; i++)
+        {
+            pos = text_add_hex_byte(buf, size, pos, (uint8_t)symbol_names[next_symbol][i]);
+        }
+        next_symbol++;
+    }
+    buf[pos] = 0;
+    return pos;
+}
+
+bool rtos_is_active(void)
+{
+    uint32_t i;
+    for(i = 0; i < RTOS_NUM_SYMBOLS; i++)
+    {
+        if(0 == symbols[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t get_num_lists(void)
+{
+    return max_priorities + (RTOS_MAX_LISTS - RTOS_MAX_PRIORITIES);
+}
+
+static uint32_t get_list_address(uint32_t list)
+{
+    if(list < max_priorities)
+    {
+        return symbols[RTOS_SYM_READY_LISTS] + list * LIST_SIZE;
+    }
+    return symbols[RTOS_SYM_DELAYED_LIST_1 + (list - max_priorities)];
+}
+
+static uint32_t find_task(uint32_t tcb)
+{
+    uint32_t i;
+    for(i = 0; i < num_tasks; i++)
+    {
+        if(tcb == tasks[i].tcb)
+        {
+            return i;
+        }
+    }
+    return RTOS_MAX_THREADS;
+}
+
+static bool add_task(uint32_t tcb, uint32_t list)
+{
+    uint32_t idx = find_task(tcb);
+    if(RTOS_MAX_THREADS != idx)
+    {
+        // the task moved to this list, the name is still known
+        tasks[idx].list = list;
+        return true;
+    }
+    if(RTOS_MAX_THREADS == num_tasks)
+    {
+        return false;
+    }
+    tasks[num_tasks].tcb = tcb;
+    tasks[num_tasks].list = list;
+    tasks[num_tasks].has_name = false;
+    num_tasks++;
+    return true;
+}
+
+static void remove_stale_tasks(void)
+{
+    uint32_t i;
+    uint32_t num = 0;
+    for(i = 0; i < num_tasks; i++)
+    {
+        if(LIST_NONE != tasks[i].list)
+        {
+            tasks[num] = tasks[i];
+            num++;
+        }
+    }
+    num_tasks = num;
+}
+
+static void next_list(rtos_data_typ* const state)
+{
+    state->list++;
+    if(get_num_lists() == state->list)
+    {
+        remove_stale_tasks();
+        state->task = 0;
+        state->phase = PHASE_NAMES;
+        return;
+    }
+    block_read_start(&(state->read), get_list_address(state->list), LIST_HEADER_WORDS);
+    state->phase = PHASE_LIST_HEADER;
+}
+
+Result rtos_update(rtos_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+    if(false == rtos_is_active())
+    {
+        return ERR_WRONG_STATE;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->addresses[0] = symbols[RTOS_SYM_NUMBER_OF_TASKS];
+        state->addresses[1] = symbols[RTOS_SYM_TASK_NUMBER];
+        state->addresses[2] = symbols[RTOS_SYM_CURRENT_TCB];
+        block_read_start_list(&(state->read), state->addresses, RTOS_NUM_COUNTERS);
+        state->phase = PHASE_COUNTERS;
+        num_updates++;
+    }
+
+    if(PHASE_COUNTERS == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        current_tcb = state->words[2];
+        if((true == counters_valid) && (number_of_tasks == state->words[0]) && (task_number == state->words[1]))
+        {
+            // no task was created or deleted
+            num_unchanged++;
+            return RESULT_OK;
+        }
+        number_of_tasks = state->words[0];
+        task_number = state->words[1];
+        counters_valid = false;
+        state->list = 0;
+        block_read_start(&(state->read), get_list_address(0), LIST_HEADER_WORDS);
+        state->phase = PHASE_LIST_HEADER;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_LIST_HEADER == state->phase)
+    {
+        list_cache_typ* list = &(lists[state->list]);
+        uint32_t i;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(   (true == list->valid) && (list->num_items == state->words[0])
+           && (list->first == state->words[3]) && (list->last == state->words[4]) )
+        {
+            next_list(state);
+            return ERR_NOT_COMPLETED;
+        }
+        // the tasks that are still in this list are found again
+        for(i = 0; i < num_tasks; i++)
+        {
+            if(state->list == tasks[i].list)
+            {
+                tasks[i].list = LIST_NONE;
+            }
+        }
+        list->valid = false;
+        list->num_items = state->words[0];
+        list->first = state->words[3];
+        list->last = state->words[4];
+        num_list_walks++;
+        if(0 == list->num_items)
+        {
+            list->valid = true;
+            next_list(state);
+            return ERR_NOT_COMPLETED;
+        }
+        if(RTOS_MAX_THREADS < list->num_items)
+        {
+            debug_error("RTOS: list %ld has %ld items !", state->list, list->num_items);
+            return ERR_WRONG_VALUE;
+        }
+        state->item = 0;
+        block_read_start(&(state->read), list->first, ITEM_WORDS);
+        state->phase = PHASE_ITEM;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_ITEM == state->phase)
+    {
+        list_cache_typ* list = &(lists[state->list]);
+        uint32_t next;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(false == add_task(state->words[ITEM_OWNER], state->list))
+        {
+            debug_error("RTOS: more than %d tasks !", RTOS_MAX_THREADS);
+            return ERR_WRONG_VALUE;
+        }
+        state->item++;
+        if(state->item == list->num_items)
+        {
+            list->valid = true;
+            next_list(state);
+            return ERR_NOT_COMPLETED;
+        }
+        next = state->words[ITEM_NEXT];
+        if((get_list_address(state->list) + LIST_END_OFFSET) == next)
+        {
+            // the list changed while we walked it (or the RAM is corrupted)
+            debug_error("RTOS: list %ld is shorter than %ld items !", state->list, list->num_items);
+            return ERR_WRONG_VALUE;
+        }
+        block_read_start(&(state->read), next, ITEM_WORDS);
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_NAMES == state->phase)
+    {
+        while((state->task < num_tasks) && (true == tasks[state->task].has_name))
+        {
+            state->task++;
+        }
+        if(num_tasks == state->task)
+        {
+            counters_valid = true;
+            return RESULT_OK;
+        }
+        block_read_start(&(state->read), tasks[state->task].tcb + name_offset, RTOS_NAME_LENGTH / 4);
+        state->phase = PHASE_NAME_READ;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_NAME_READ == state->phase)
+    {
+        task_typ* task = &(tasks[state->task]);
+        uint32_t i;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < RTOS_NAME_LENGTH; i++)
+        {
+            task->name[i] = (char)(state->words[i / 4] >> (8 * (i % 4)));
+        }
+        task->name[RTOS_NAME_LENGTH] = 0;
+        task->has_name = true;
+        state->task++;
+        state->phase = PHASE_NAMES;
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+uint32_t rtos_get_num_threads(void)
+{
+    return num_tasks;
+}
+
+uint32_t rtos_get_thread_id(uint32_t idx)
+{
+    if(num_tasks <= idx)
+    {
+        return 0;
+    }
+    return tasks[idx].tcb;
+}
+
+uint32_t rtos_get_current_thread(void)
+{
+    return current_tcb;
+}
+
+const char* rtos_get_thread_name(uint32_t thread_id)
+{
+    uint32_t idx = find_task(thread_id);
+    if((RTOS_MAX_THREADS == idx) || (false == tasks[idx].has_name))
+    {
+        return NULL;
+    }
+    return tasks[idx].name;
+}
+
+// task names may contain anything -> no XML special characters
+static uint32_t add_name(char* buf, uint32_t size, uint32_t pos, const char* name)
+{
+    while((0 != *name) && ((pos + 1) < size))
+    {
+        char c = *name;
+        if(('<' == c) || ('>' == c) || ('&' == c) || ('"' == c) || (' ' > c) || ('~' < c))
+        {
+            c = '_';
+        }
+        buf[pos] = c;
+        pos++;
+        name++;
+    }
+    return pos;
+}
+
+uint32_t rtos_get_stop_reply(char* buf, uint32_t size, uint32_t signal)
+{
+    uint32_t pos;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    pos = text_add_string(buf, size, 0, "T");
+    // the signal always has two digits
+    if(16 > signal)
+    {
+        pos = text_add_string(buf, size, pos, "0");
+    }
+    pos = text_add_hex(buf, size, pos, signal & 0xff);
+    pos = text_add_string(buf, size, pos, "thread:");
+    pos = text_add_hex(buf, size, pos, current_tcb);
+    pos = text_add_string(buf, size, pos, ";");
+    buf[pos] = 0;
+    return pos;
+}
+
+uint32_t rtos_get_threads_xml(char* buf, uint32_t size)
+{
+    uint32_t pos;
+    uint32_t i;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    pos = text_add_string(buf, size, 0, "<?xml version=\"1.0\"?>\r\n<threads>\r\n");
+    for(i = 0; i < num_tasks; i++)
+    {
+        pos = text_add_string(buf, size, pos, "<thread id=\"");
+        pos = text_add_hex(buf, size, pos, tasks[i].tcb);
+        pos = text_add_string(buf, size, pos, "\" name=\"");
+        if(true == tasks[i].has_name)
+        {
+            pos = add_name(buf, size, pos, tasks[i].name);
+        }
+        pos = text_add_string(buf, size, pos, "\"/>\r\n");
+    }
+    pos = text_add_string(buf, size, pos, "</threads>\r\n");
+    buf[pos] = 0;
+    return pos;
+}
+
+Result rtos_read_thread_registers(rtos_data_typ* const state, uint32_t thread_id, uint32_t* regs)
+{
+    Result res;
+    uint32_t i;
+
+    if((NULL == state) || (NULL == regs))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        if((current_tcb == thread_id) || (RTOS_MAX_THREADS == find_task(thread_id)))
+        {
+            // the running task has its registers in the core
+            return ERR_WRONG_VALUE;
+        }
+        state->first_call = false;
+        // pxTopOfStack
+        block_read_start(&(state->read), thread_id, 1);
+        state->phase = PHASE_TOP_OF_STACK;
+    }
+
+    if(PHASE_TOP_OF_STACK == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->item = state->words[0];
+        block_read_start(&(state->read), state->item, STACK_FRAME_WORDS);
+        state->phase = PHASE_STACK_FRAME;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_STACK_FRAME == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < 4; i++)
+        {
+            regs[4 + i] = state->words[i];       // r4 - r7
+            regs[8 + i] = state->words[4 + i];   // r8 - r11
+            regs[i] = state->words[8 + i];       // r0 - r3
+        }
+        regs[12] = state->words[12];
+        regs[14] = state->words[13];
+        regs[15] = state->words[14];
+        regs[16] = state->words[15];
+        // SP before the exception, the exception entry may have aligned it
+        regs[13] = state->item + STACK_FRAME_WORDS * 4;
+        if(0 != (regs[16] & XPSR_STACK_ALIGN))
+        {
+            regs[13] = regs[13] + 4;
+        }
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_CLI
+bool rtos_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        if(false == rtos_is_active())
+        {
+            cli_line("RTOS: symbols not known");
+            return true;
+        }
+        cli_line("RTOS: %ld tasks, %ld halts, %ld with the same tasks, %ld lists walked", num_tasks, num_updates,
+                 num_unchanged, num_list_walks);
+    }
+    if(loop < num_tasks)
+    {
+        cli_line("task 0x%08lx: %s%s", tasks[loop].tcb, (true == tasks[loop].has_name) ? tasks[loop].name : "",
+                 (current_tcb == tasks[loop].tcb) ? " (running)" : "");
+        return false;
+    }
+    return true;
+}
+#endif
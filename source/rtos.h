@@ -0,0 +1,111 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_RTOS_H_
+#define SOURCE_RTOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "block_read.h"
+
+// FreeRTOS awareness (FEAT_RTOS): the tasks are GDB threads.
+//
+// The addresses of the kernel variables come from GDB (qSymbol), the FreeRTOS
+// configuration (number of priorities, offset of the task name in the TCB)
+// from the [rtos] section (see target_config.h). The thread id of a task is the
+// address of its TCB. On each halt rtos_update() reads the number of tasks, the task
+// counter (incremented on each task creation) and pxCurrentTCB. If the
+// counters did not change the cached thread list is still correct. Otherwise
+// the headers of the task lists are read and only the lists whose header
+// changed are walked again. Names are read once per task.
+//
+// The registers of a task that does not run are read from its stack when GDB
+// asks for them (ARM_CM0 port: r4-r7, r8-r11, then the exception frame).
+
+#define RTOS_MAX_THREADS       32
+#define RTOS_MAX_PRIORITIES    32
+#define RTOS_NAME_LENGTH       16
+// ready lists + delayed 1 + delayed 2 + pending ready + suspended + waiting termination
+#define RTOS_MAX_LISTS         (RTOS_MAX_PRIORITIES + 5)
+#define RTOS_MAX_READ_WORDS    16
+// uxCurrentNumberOfTasks, uxTaskNumber, pxCurrentTCB
+#define RTOS_NUM_COUNTERS      3
+// number of registers of a task: r0-r15, xPSR
+#define RTOS_NUM_REGS          17
+
+// index into the symbol table
+#define RTOS_SYM_CURRENT_TCB           0
+#define RTOS_SYM_READY_LISTS           1
+#define RTOS_SYM_DELAYED_LIST_1        2
+#define RTOS_SYM_DELAYED_LIST_2        3
+#define RTOS_SYM_PENDING_READY_LIST    4
+#define RTOS_SYM_SUSPENDED_LIST        5
+#define RTOS_SYM_TERMINATION_LIST      6
+#define RTOS_SYM_NUMBER_OF_TASKS       7
+#define RTOS_SYM_TASK_NUMBER           8
+#define RTOS_NUM_SYMBOLS               9
+
+// TCB layout (FreeRTOS defaults, 32 bit): pxTopOfStack is the first member
+#define RTOS_DEFAULT_NAME_OFFSET       52
+#define RTOS_DEFAULT_MAX_PRIORITIES    5
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t list;
+    uint32_t item;
+    uint32_t num_items;
+    uint32_t task;
+    uint32_t addresses[RTOS_NUM_COUNTERS];
+    uint32_t words[RTOS_MAX_READ_WORDS];
+    block_read_typ read;
+} rtos_data_typ;
+
+void rtos_init(void);
+// new program or target reset: the thread list is read again on the next halt
+void rtos_forget(void);
+// names of the symbols (NULL after the last one)
+const char* rtos_get_symbol_name(uint32_t idx);
+void rtos_set_symbol(uint32_t idx, uint32_t address);
+// answers a qSymbol packet: asks GDB for the next symbol or replies "OK".
+// Returns the length of the reply (0 = not a qSymbol packet).
+uint32_t rtos_handle_qsymbol(const char* packet, char* buf, uint32_t size);
+// [rtos] max_priorities and name_offset
+void rtos_set_max_priorities(uint32_t priorities);
+void rtos_set_name_offset(uint32_t offset);
+// true if all symbols are known
+bool rtos_is_active(void);
+// the core halted: update the thread list
+Result rtos_update(rtos_data_typ* const state);
+uint32_t rtos_get_num_threads(void);
+// thread id (TCB address) of the thread with this index
+uint32_t rtos_get_thread_id(uint32_t idx);
+// thread id of the task that ran when the core halted
+uint32_t rtos_get_current_thread(void);
+const char* rtos_get_thread_name(uint32_t thread_id);
+// stop reply with the running task ("T05thread:20000480;"). Returns the length.
+uint32_t rtos_get_stop_reply(char* buf, uint32_t size, uint32_t signal);
+// qXfer:threads content. Returns the length.
+uint32_t rtos_get_threads_xml(char* buf, uint32_t size);
+// registers of a task that does not run (regs: RTOS_NUM_REGS values, GDB order)
+Result rtos_read_thread_registers(rtos_data_typ* const state, uint32_t thread_id, uint32_t* regs);
+#ifdef FEAT_CLI
+bool rtos_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_RTOS_H_ */
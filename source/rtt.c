@@ -0,0 +1,741 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "rtt.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "block_read.h"
+#include "time_us.h"
+
+// "SEGGER RTT" at the start of the control block
+#define ID_WORD_0           0x47474553
+#define ID_WORD_1           0x52205245
+#define ID_WORD_2           0x00005454
+#define NUM_ID_WORDS        3
+// control block: acID[16], MaxNumUpBuffers, MaxNumDownBuffers, aUp[], aDown[]
+#define CB_NUM_BUFFERS      16
+#define CB_BUFFERS          24
+#define CB_MAX_BUFFERS      32
+// buffer descriptor: sName, pBuffer, SizeOfBuffer, WrOff, RdOff, Flags
+#define DESC_SIZE           24
+#define DESC_BUFFER         4
+#define DESC_WR_OFF         12
+#define DESC_RD_OFF         16
+#define PROBE_BUFFER_MASK   (RTT_PROBE_BUFFER_SIZE - 1)
+
+#define PHASE_SCAN          0
+#define PHASE_HEADER        1
+#define PHASE_DESCRIPTORS   2
+#define PHASE_UP_OFFSETS    3
+#define PHASE_UP_DATA       4
+#define PHASE_UP_RD_OFF     5
+#define PHASE_DOWN_OFFSETS  6
+#define PHASE_DOWN_READ     7
+#define PHASE_DOWN_WRITE    8
+#define PHASE_DOWN_WR_OFF   9
+
+typedef struct {
+    uint32_t desc;    // address of the buffer descriptor in the target
+    uint32_t buffer;  // pBuffer
+    uint32_t size;    // SizeOfBuffer
+    uint8_t data[RTT_PROBE_BUFFER_SIZE];
+    uint32_t head;    // bytes put into data (free running)
+    uint32_t tail;    // bytes taken out of data (free running)
+    uint32_t num_bytes;
+} channel_typ;
+
+static const uint32_t id_words[NUM_ID_WORDS] = {ID_WORD_0, ID_WORD_1, ID_WORD_2};
+
+static bool enabled;
+static uint32_t tcp_port;
+static uint32_t configured_address;
+static uint32_t scan_start;
+static uint32_t scan_size;
+static uint32_t control_block;
+static bool channels_valid;
+static uint32_t target_num_up;
+static channel_typ up[RTT_MAX_UP];
+static channel_typ down[RTT_MAX_DOWN];
+static uint32_t num_up;
+static uint32_t num_down;
+static uint32_t interval;
+static uint32_t next_poll_time;
+static uint32_t num_polls;
+static uint32_t num_scans;
+static uint32_t num_failures;
+// scan progress, continues with the next poll
+static uint32_t scan_pos;
+static uint32_t scan_match;
+static uint32_t scan_interval;
+
+void rtt_init(void)
+{
+    enabled = false;
+    tcp_port = 0;
+    configured_address = 0;
+    scan_start = RTT_DEFAULT_SCAN_START;
+    scan_size = RTT_DEFAULT_SCAN_SIZE;
+    num_polls = 0;
+    num_scans = 0;
+    num_failures = 0;
+    rtt_forget();
+}
+
+static void forget_control_block(void)
+{
+    control_block = 0;
+    channels_valid = false;
+    num_up = 0;
+    num_down = 0;
+    interval = RTT_MIN_INTERVAL;
+    scan_pos = scan_start;
+    scan_match = 0;
+}
+
+void rtt_forget(void)
+{
+    forget_control_block();
+    scan_interval = RTT_SCAN_INTERVAL;
+    next_poll_time = time_us_now();
+}
+
+// failed scan or poll: wait longer each time
+static void back_off(void)
+{
+    next_poll_time = time_us_now() + scan_interval;
+    scan_interval = scan_interval * 2;
+    if(RTT_MAX_SCAN_INTERVAL < scan_interval)
+    {
+        scan_interval = RTT_MAX_SCAN_INTERVAL;
+    }
+}
+
+void rtt_set_enabled(bool value)
+{
+    enabled = value;
+}
+
+void rtt_set_tcp_port(uint32_t port)
+{
+    // the channels only go to TCP ports, no port = nothing to poll for
+    tcp_port = port;
+    enabled = (0 != port);
+}
+
+uint32_t rtt_get_tcp_port(void)
+{
+    return tcp_port;
+}
+
+void rtt_set_control_block(uint32_t address)
+{
+    configured_address = address & ~3u;
+    rtt_forget();
+}
+
+void rtt_set_scan_range(uint32_t start, uint32_t size)
+{
+    scan_start = start & ~3u;
+    scan_size = size & ~3u;
+    rtt_forget();
+}
+
+bool rtt_is_found(void)
+{
+    return channels_valid;
+}
+
+uint32_t rtt_get_num_up(void)
+{
+    return num_up;
+}
+
+uint32_t rtt_get_num_down(void)
+{
+    return num_down;
+}
+
+uint32_t rtt_get_poll_interval_us(void)
+{
+    return interval;
+}
+
+bool rtt_is_due(void)
+{
+    if(false == enabled)
+    {
+        return false;
+    }
+    return (0 <= (int32_t)(time_us_now() - next_poll_time));
+}
+
+uint32_t rtt_read_up(uint32_t channel, uint8_t* buf, uint32_t size)
+{
+    channel_typ* ch;
+    uint32_t i = 0;
+
+    if((num_up <= channel) || (NULL == buf))
+    {
+        return 0;
+    }
+    ch = &(up[channel]);
+    while((i < size) && (ch->tail != ch->head))
+    {
+        buf[i] = ch->data[ch->tail & PROBE_BUFFER_MASK];
+        ch->tail++;
+        i++;
+    }
+    return i;
+}
+
+uint32_t rtt_write_down(uint32_t channel, const uint8_t* data, uint32_t length)
+{
+    channel_typ* ch;
+    uint32_t i = 0;
+
+    if((num_down <= channel) || (NULL == data))
+    {
+        return 0;
+    }
+    ch = &(down[channel]);
+    while((i < length) && ((ch->head - ch->tail) < RTT_PROBE_BUFFER_SIZE))
+    {
+        ch->data[ch->head & PROBE_BUFFER_MASK] = data[i];
+        ch->head++;
+        i++;
+    }
+    return i;
+}
+
+static void start_block(rtt_data_typ* const state, uint32_t address, uint32_t num)
+{
+    state->address = address;
+    block_read_start(&(state->read), address, num);
+}
+
+static uint8_t get_byte(const uint32_t* words, uint32_t pos)
+{
+    return (uint8_t)(words[pos / 4] >> (8 * (pos % 4)));
+}
+
+static Result bad_control_block(const char* what)
+{
+    debug_error("RTT: control block at 0x%08lx has invalid %s !", control_block, what);
+    forget_control_block();
+    return ERR_WRONG_VALUE;
+}
+
+static Result poll_done(rtt_data_typ* const state)
+{
+    if(true == state->moved_data)
+    {
+        interval = interval / 2;
+        if(RTT_MIN_INTERVAL > interval)
+        {
+            interval = RTT_MIN_INTERVAL;
+        }
+    }
+    else
+    {
+        interval = interval * 2;
+        if(RTT_MAX_INTERVAL < interval)
+        {
+            interval = RTT_MAX_INTERVAL;
+        }
+    }
+    next_poll_time = time_us_now() + interval;
+    num_polls++;
+    return RESULT_OK;
+}
+
+static Result next_down_channel(rtt_data_typ* const state)
+{
+    while((state->channel < num_down) && (down[state->channel].head == down[state->channel].tail))
+    {
+        state->channel++;
+    }
+    if(num_down == state->channel)
+    {
+        return poll_done(state);
+    }
+    start_block(state, down[state->channel].desc + DESC_WR_OFF, 2);
+    state->phase = PHASE_DOWN_OFFSETS;
+    return ERR_NOT_COMPLETED;
+}
+
+static Result next_up_channel(rtt_data_typ* const state)
+{
+    if(num_up == state->channel)
+    {
+        state->channel = 0;
+        return next_down_channel(state);
+    }
+    start_block(state, up[state->channel].desc + DESC_WR_OFF, 2);
+    state->phase = PHASE_UP_OFFSETS;
+    return ERR_NOT_COMPLETED;
+}
+
+// reads the next part of the up buffer (state->rd up to state->wr or the end of the buffer)
+static Result start_up_chunk(rtt_data_typ* const state)
+{
+    channel_typ* ch = &(up[state->channel]);
+    uint32_t n;
+    uint32_t free_bytes = RTT_PROBE_BUFFER_SIZE - (ch->head - ch->tail);
+
+    if(state->wr > state->rd)
+    {
+        n = state->wr - state->rd;
+    }
+    else
+    {
+        n = ch->size - state->rd;
+    }
+    if(n > free_bytes)
+    {
+        n = free_bytes;
+    }
+    if(n > ((RTT_MAX_READ_WORDS - 1) * 4))
+    {
+        n = (RTT_MAX_READ_WORDS - 1) * 4;
+    }
+    if(0 == n)
+    {
+        // probe buffer full, the host is too slow
+        state->channel++;
+        return next_up_channel(state);
+    }
+    state->num_bytes = n;
+    state->pos = (ch->buffer + state->rd) & 3;
+    start_block(state, (ch->buffer + state->rd) & ~3u, (state->pos + n + 3) / 4);
+    state->phase = PHASE_UP_DATA;
+    return ERR_NOT_COMPLETED;
+}
+
+// writes the next word of down data, partial words are read first
+static Result start_down_word(rtt_data_typ* const state)
+{
+    channel_typ* ch = &(down[state->channel]);
+    uint32_t address = ch->buffer + state->wr;
+    uint32_t offset = address & 3;
+
+    state->pos = 4 - offset;
+    if(state->pos > state->num_bytes)
+    {
+        state->pos = state->num_bytes;
+    }
+    start_block(state, address & ~3u, 1);
+    if(4 == state->pos)
+    {
+        state->words[0] = 0;
+        state->phase = PHASE_DOWN_WRITE;
+    }
+    else
+    {
+        state->phase = PHASE_DOWN_READ;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static void merge_down_word(rtt_data_typ* const state)
+{
+    channel_typ* ch = &(down[state->channel]);
+    uint32_t offset = (ch->buffer + state->wr) & 3;
+    uint32_t i;
+
+    for(i = 0; i < state->pos; i++)
+    {
+        uint32_t shift = 8 * (offset + i);
+        uint32_t byte = ch->data[(ch->tail + i) & PROBE_BUFFER_MASK];
+        state->words[0] = (state->words[0] & ~(0xffu << shift)) | (byte << shift);
+    }
+}
+
+static Result poll_step(rtt_data_typ* const state)
+{
+    Result res;
+
+    if(true == state->first_call)
+    {
+        uint32_t n;
+
+        state->first_call = false;
+        state->channel = 0;
+        state->moved_data = false;
+        if(true == channels_valid)
+        {
+            return next_up_channel(state);
+        }
+        if(0 != configured_address)
+        {
+            control_block = configured_address;
+            start_block(state, control_block + CB_NUM_BUFFERS, 2);
+            state->phase = PHASE_HEADER;
+            return ERR_NOT_COMPLETED;
+        }
+        // the next part of the scan range
+        n = scan_start + scan_size - scan_pos;
+        if(RTT_SCAN_CHUNK < n)
+        {
+            n = RTT_SCAN_CHUNK;
+        }
+        start_block(state, scan_pos, n / 4);
+        state->match = scan_match;
+        state->phase = PHASE_SCAN;
+    }
+
+    if(PHASE_SCAN == state->phase)
+    {
+        uint32_t value;
+
+        res = block_read_next(&(state->read), &value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(NUM_ID_WORDS != state->match)
+        {
+            if(id_words[state->match] == value)
+            {
+                state->match++;
+            }
+            else if(ID_WORD_0 == value)
+            {
+                state->match = 1;
+            }
+            else
+            {
+                state->match = 0;
+            }
+            if(NUM_ID_WORDS == state->match)
+            {
+                // the id can start in the previous chunk
+                control_block = state->address + (state->read.done - NUM_ID_WORDS) * 4;
+                // only collect the reads that are still in flight
+                block_read_stop(&(state->read));
+            }
+        }
+        if(false == block_read_is_done(&(state->read)))
+        {
+            return ERR_NOT_COMPLETED;
+        }
+        if(NUM_ID_WORDS != state->match)
+        {
+            scan_pos = scan_pos + state->read.num_words * 4;
+            scan_match = state->match;
+            if((scan_start + scan_size) > scan_pos)
+            {
+                // continue with the next chunk soon
+                next_poll_time = time_us_now() + RTT_MIN_INTERVAL;
+                return RESULT_OK;
+            }
+            // no RTT in this program (yet)
+            num_scans++;
+            scan_pos = scan_start;
+            scan_match = 0;
+            back_off();
+            return RESULT_OK;
+        }
+        num_scans++;
+        scan_pos = scan_start;
+        scan_match = 0;
+        debug_line("RTT: control block at 0x%08lx", control_block);
+        start_block(state, control_block + CB_NUM_BUFFERS, 2);
+        state->phase = PHASE_HEADER;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_HEADER == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if((CB_MAX_BUFFERS < state->words[0]) || (CB_MAX_BUFFERS < state->words[1]))
+        {
+            return bad_control_block("number of buffers");
+        }
+        target_num_up = state->words[0];
+        num_up = (RTT_MAX_UP < state->words[0]) ? RTT_MAX_UP : state->words[0];
+        num_down = (RTT_MAX_DOWN < state->words[1]) ? RTT_MAX_DOWN : state->words[1];
+        state->channel = 0;
+        state->phase = PHASE_DESCRIPTORS;
+    }
+
+    if(PHASE_DESCRIPTORS == state->phase)
+    {
+        channel_typ* ch;
+
+        if(true == block_read_is_done(&(state->read)))
+        {
+            // the descriptor of the next channel
+            uint32_t desc;
+            if((num_up + num_down) == state->channel)
+            {
+                channels_valid = true;
+                scan_interval = RTT_SCAN_INTERVAL;
+                state->channel = 0;
+                return next_up_channel(state);
+            }
+            if(state->channel < num_up)
+            {
+                desc = control_block + CB_BUFFERS + state->channel * DESC_SIZE;
+            }
+            else
+            {
+                desc = control_block + CB_BUFFERS + (target_num_up + state->channel - num_up) * DESC_SIZE;
+            }
+            // pBuffer, SizeOfBuffer
+            start_block(state, desc + DESC_BUFFER, 2);
+        }
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(state->channel < num_up)
+        {
+            ch = &(up[state->channel]);
+        }
+        else
+        {
+            ch = &(down[state->channel - num_up]);
+        }
+        if(0 == state->words[1])
+        {
+            return bad_control_block("buffer size");
+        }
+        ch->desc = state->address - DESC_BUFFER;
+        ch->buffer = state->words[0];
+        ch->size = state->words[1];
+        ch->head = 0;
+        ch->tail = 0;
+        ch->num_bytes = 0;
+        state->channel++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_UP_OFFSETS == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->wr = state->words[0];
+        state->rd = state->words[1];
+        if((up[state->channel].size <= state->wr) || (up[state->channel].size <= state->rd))
+        {
+            return bad_control_block("up buffer offsets");
+        }
+        if(state->wr == state->rd)
+        {
+            state->channel++;
+            return next_up_channel(state);
+        }
+        return start_up_chunk(state);
+    }
+
+    if(PHASE_UP_DATA == state->phase)
+    {
+        channel_typ* ch = &(up[state->channel]);
+        uint32_t i;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < state->num_bytes; i++)
+        {
+            ch->data[ch->head & PROBE_BUFFER_MASK] = get_byte(state->words, state->pos + i);
+            ch->head++;
+        }
+        ch->num_bytes = ch->num_bytes + state->num_bytes;
+        state->rd = state->rd + state->num_bytes;
+        if(ch->size == state->rd)
+        {
+            state->rd = 0;
+        }
+        state->moved_data = true;
+        state->phase = PHASE_UP_RD_OFF;
+    }
+
+    if(PHASE_UP_RD_OFF == state->phase)
+    {
+        // the target can reuse the space now
+        res = step_write_ap((volatile uint32_t*)(up[state->channel].desc + DESC_RD_OFF), state->rd);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(state->rd != state->wr)
+        {
+            // wrapped around the end of the buffer or more than one chunk
+            return start_up_chunk(state);
+        }
+        state->channel++;
+        return next_up_channel(state);
+    }
+
+    if(PHASE_DOWN_OFFSETS == state->phase)
+    {
+        channel_typ* ch = &(down[state->channel]);
+        uint32_t n;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->wr = state->words[0];
+        state->rd = state->words[1];
+        if((ch->size <= state->wr) || (ch->size <= state->rd))
+        {
+            return bad_control_block("down buffer offsets");
+        }
+        // one byte stays free, otherwise a full buffer would look empty
+        if(state->rd > state->wr)
+        {
+            n = state->rd - state->wr - 1;
+        }
+        else
+        {
+            n = ch->size - state->wr;
+            if(0 == state->rd)
+            {
+                n--;
+            }
+        }
+        if(n > (ch->head - ch->tail))
+        {
+            n = ch->head - ch->tail;
+        }
+        if(0 == n)
+        {
+            // the target did not read the data yet
+            state->channel++;
+            return next_down_channel(state);
+        }
+        state->num_bytes = n;
+        return start_down_word(state);
+    }
+
+    if(PHASE_DOWN_READ == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_DOWN_WRITE;
+        merge_down_word(state);
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_DOWN_WRITE == state->phase)
+    {
+        channel_typ* ch = &(down[state->channel]);
+
+        if(4 == state->pos)
+        {
+            merge_down_word(state);
+        }
+        res = step_write_ap((volatile uint32_t*)state->address, state->words[0]);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        ch->tail = ch->tail + state->pos;
+        ch->num_bytes = ch->num_bytes + state->pos;
+        state->num_bytes = state->num_bytes - state->pos;
+        state->wr = state->wr + state->pos;
+        if(ch->size == state->wr)
+        {
+            state->wr = 0;
+        }
+        if(0 != state->num_bytes)
+        {
+            return start_down_word(state);
+        }
+        state->phase = PHASE_DOWN_WR_OFF;
+    }
+
+    if(PHASE_DOWN_WR_OFF == state->phase)
+    {
+        res = step_write_ap((volatile uint32_t*)(down[state->channel].desc + DESC_WR_OFF), state->wr);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->moved_data = true;
+        state->channel++;
+        return next_down_channel(state);
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+Result rtt_poll(rtt_data_typ* const state)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    res = poll_step(state);
+    if((RESULT_OK != res) && (ERR_NOT_COMPLETED != res))
+    {
+        // SWD error or broken control block, do not try again right away
+        num_failures++;
+        back_off();
+    }
+    return res;
+}
+
+#ifdef FEAT_CLI
+bool rtt_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        if(false == channels_valid)
+        {
+            cli_line("RTT: %s, no control block found (%ld scans, %ld failures)",
+                     (true == enabled) ? "enabled" : "disabled", num_scans, num_failures);
+            return true;
+        }
+        cli_line("RTT: control block at 0x%08lx, %ld polls, %ld failures, now every %ld us", control_block, num_polls,
+                 num_failures, interval);
+    }
+    if(loop < num_up)
+    {
+        cli_line("up %ld: %ld bytes buffer at 0x%08lx, %ld bytes received", loop, up[loop].size, up[loop].buffer,
+                 up[loop].num_bytes);
+        return false;
+    }
+    if(loop < (num_up + num_down))
+    {
+        channel_typ* ch = &(down[loop - num_up]);
+        cli_line("down %ld: %ld bytes buffer at 0x%08lx, %ld bytes sent", loop - num_up, ch->size, ch->buffer,
+                 ch->num_bytes);
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_RTT_H_
+#define SOURCE_RTT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+#include "block_read.h"
+
+// RTT channels (FEAT_RTT): SEGGER RTT compatible ring buffers in the target RAM.
+//
+// The control block is found by scanning the target RAM for the "SEGGER RTT"
+// id (RTT_SCAN_CHUNK bytes per poll, so that a poll never blocks the other
+// actions for long), or it is at the address given in the [rtt] section (see
+// target_config.h). target_tick() queues the RTT_POLL action when
+// rtt_is_due() says so. A poll reads the offsets of each up buffer, copies new
+// data into a buffer in the probe (pipelined word reads) and writes the new
+// read offset. Data for the down buffers is written the same way. The poll
+// interval halves while data comes in and doubles while the channels are idle.
+//
+// With a TCP port the probe firmware exposes each channel on its own port
+// (rtt_get_tcp_port() + channel number) and moves the data with rtt_read_up() /
+// rtt_write_down(). Without one, RTT is switched on with "monitor rtt on" and
+// target_tick() sends up channel 0 to the GDB console while GDB waits for the
+// stop reply.
+
+#define RTT_MAX_UP                3
+#define RTT_MAX_DOWN              3
+// data buffered in the probe for each channel, must be a power of two
+#define RTT_PROBE_BUFFER_SIZE     1024
+#define RTT_MAX_READ_WORDS        32
+#define RTT_MIN_INTERVAL          100
+#define RTT_MAX_INTERVAL          10000
+// bytes of target RAM searched for the control block in one poll
+#define RTT_SCAN_CHUNK            1024
+// time between two scans for the control block, doubles after each failed
+// scan or poll up to RTT_MAX_SCAN_INTERVAL
+#define RTT_SCAN_INTERVAL         1000000
+#define RTT_MAX_SCAN_INTERVAL     16000000
+// SRAM0 - SRAM5
+#define RTT_DEFAULT_SCAN_START    0x20000000
+#define RTT_DEFAULT_SCAN_SIZE     (264 * 1024)
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t channel;
+    uint32_t address;
+    uint32_t match;
+    uint32_t rd;
+    uint32_t wr;
+    uint32_t num_bytes;
+    uint32_t pos;
+    block_read_typ read;
+    bool moved_data;
+    uint32_t words[RTT_MAX_READ_WORDS];
+} rtt_data_typ;
+
+void rtt_init(void);
+// target reset or new program: search the control block again
+void rtt_forget(void);
+void rtt_set_enabled(bool enabled);
+// from the [rtt] section. Port 0 disables RTT.
+void rtt_set_tcp_port(uint32_t port);
+// port of channel 0
+uint32_t rtt_get_tcp_port(void);
+// 0 = scan for the control block
+void rtt_set_control_block(uint32_t address);
+void rtt_set_scan_range(uint32_t start, uint32_t size);
+bool rtt_is_found(void);
+uint32_t rtt_get_num_up(void);
+uint32_t rtt_get_num_down(void);
+uint32_t rtt_get_poll_interval_us(void);
+// true if RTT_POLL should run now
+bool rtt_is_due(void);
+// RTT_POLL action
+Result rtt_poll(rtt_data_typ* const state);
+// data that came from the target. Returns the number of bytes.
+uint32_t rtt_read_up(uint32_t channel, uint8_t* buf, uint32_t size);
+// data for the target. Returns the number of bytes that fit into the probe buffer.
+uint32_t rtt_write_down(uint32_t channel, const uint8_t* data, uint32_t length);
+#ifdef FEAT_CLI
+bool rtt_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_RTT_H_ */
@@ -0,0 +1,554 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "semihosting.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "block_read.h"
+
+#define RESULT_ERROR          0xffffffff
+#define OUTPUT_MASK           (SEMIHOST_OUTPUT_SIZE - 1)
+#define INPUT_MASK            (SEMIHOST_INPUT_SIZE - 1)
+// SYS_OPEN mode: 0-3 read, 4-7 write, 8-11 append
+#define OPEN_MODE_WRITE       4
+#define OPEN_MODE_APPEND      8
+#define OPEN_MODE_END         12
+#define CONSOLE_NAME          0x0074743a   // ":tt"
+#define CONSOLE_NAME_LENGTH   3
+
+#define PHASE_INSTRUCTION     0
+#define PHASE_R0              1
+#define PHASE_R1              2
+#define PHASE_ARGS            3
+#define PHASE_OPEN_NAME       4
+#define PHASE_COPY_OUT        5
+#define PHASE_COPY_IN         6
+#define PHASE_COPY_IN_READ    7
+#define PHASE_COPY_IN_WRITE   8
+#define PHASE_SET_R0          9
+#define PHASE_SET_PC          10
+#define PHASE_CLEAR_DFSR      11
+#define PHASE_RESUME          12
+
+static uint8_t output[SEMIHOST_OUTPUT_SIZE];
+static uint32_t output_head;
+static uint32_t output_tail;
+static uint8_t input[SEMIHOST_INPUT_SIZE];
+static uint32_t input_head;
+static uint32_t input_tail;
+static uint32_t num_calls;
+static uint32_t num_waits;
+static uint32_t num_bytes_out;
+static uint32_t num_bytes_in;
+static uint32_t tcp_port;
+
+void semihost_init(void)
+{
+    output_head = 0;
+    output_tail = 0;
+    input_head = 0;
+    input_tail = 0;
+    num_calls = 0;
+    num_waits = 0;
+    num_bytes_out = 0;
+    num_bytes_in = 0;
+    tcp_port = 0;
+}
+
+void semihost_set_tcp_port(uint32_t port)
+{
+    tcp_port = port;
+}
+
+uint32_t semihost_get_tcp_port(void)
+{
+    return tcp_port;
+}
+
+uint32_t semihost_read_output(uint8_t* buf, uint32_t size)
+{
+    uint32_t i = 0;
+
+    if(NULL == buf)
+    {
+        return 0;
+    }
+    while((i < size) && (output_tail != output_head))
+    {
+        buf[i] = output[output_tail & OUTPUT_MASK];
+        output_tail++;
+        i++;
+    }
+    return i;
+}
+
+uint32_t semihost_write_input(const uint8_t* data, uint32_t length)
+{
+    uint32_t i = 0;
+
+    if(NULL == data)
+    {
+        return 0;
+    }
+    while((i < length) && ((input_head - input_tail) < SEMIHOST_INPUT_SIZE))
+    {
+        input[input_head & INPUT_MASK] = data[i];
+        input_head++;
+        i++;
+    }
+    return i;
+}
+
+static bool is_console(uint32_t handle)
+{
+    return (SEMIHOST_HANDLE_STDIN <= handle) && (SEMIHOST_HANDLE_STDERR >= handle);
+}
+
+static bool is_output(uint32_t handle)
+{
+    return (SEMIHOST_HANDLE_STDOUT == handle) || (SEMIHOST_HANDLE_STDERR == handle);
+}
+
+static void start_block(semihost_data_typ* const state, uint32_t address, uint32_t num)
+{
+    state->address = address;
+    block_read_start(&(state->read), address, num);
+}
+
+static uint8_t get_byte(const uint32_t* words, uint32_t pos)
+{
+    return (uint8_t)(words[pos / 4] >> (8 * (pos % 4)));
+}
+
+static bool is_supported(uint32_t op)
+{
+    return (SYS_OPEN == op) || (SYS_CLOSE == op) || (SYS_WRITEC == op) || (SYS_WRITE0 == op)
+        || (SYS_WRITE == op) || (SYS_READ == op) || (SYS_ISTTY == op) || (SYS_ERRNO == op);
+}
+
+// the call is done: the result goes into r0
+static Result finish_call(semihost_data_typ* const state, uint32_t result)
+{
+    state->result = result;
+    state->reg_state.first_call = true;
+    if((SYS_WRITEC == state->op) || (SYS_WRITE0 == state->op))
+    {
+        // these calls have no result
+        state->phase = PHASE_SET_PC;
+    }
+    else
+    {
+        state->phase = PHASE_SET_R0;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result start_copy_out(semihost_data_typ* const state, uint32_t address, uint32_t length, uint32_t result)
+{
+    if(0 == length)
+    {
+        return finish_call(state, result);
+    }
+    state->result = result;
+    state->pos = address;
+    state->remaining = length;
+    // no chunk read yet
+    block_read_start(&(state->read), address, 0);
+    state->waiting = false;
+    state->phase = PHASE_COPY_OUT;
+    return ERR_NOT_COMPLETED;
+}
+
+static Result start_call(semihost_data_typ* const state)
+{
+    switch(state->op)
+    {
+    case SYS_WRITEC:
+        return start_copy_out(state, state->param, 1, 0);
+
+    case SYS_WRITE0:
+        // until the 0
+        return start_copy_out(state, state->param, 0xffffffff, 0);
+
+    case SYS_ERRNO:
+        return finish_call(state, 0);
+
+    case SYS_CLOSE:
+    case SYS_ISTTY:
+        start_block(state, state->param, 1);
+        break;
+
+    default:
+        start_block(state, state->param, 3);
+        break;
+    }
+    state->phase = PHASE_ARGS;
+    return ERR_NOT_COMPLETED;
+}
+
+static Result args_done(semihost_data_typ* const state)
+{
+    uint32_t handle = state->args[0];
+    uint32_t length = state->args[2];
+
+    switch(state->op)
+    {
+    case SYS_OPEN:
+        if(CONSOLE_NAME_LENGTH != length)
+        {
+            // files are not supported
+            return finish_call(state, RESULT_ERROR);
+        }
+        start_block(state, state->args[0], (0 == (state->args[0] & 3)) ? 1 : 2);
+        state->phase = PHASE_OPEN_NAME;
+        return ERR_NOT_COMPLETED;
+
+    case SYS_CLOSE:
+        return finish_call(state, (true == is_console(handle)) ? 0 : RESULT_ERROR);
+
+    case SYS_ISTTY:
+        return finish_call(state, (true == is_console(handle)) ? 1 : 0);
+
+    case SYS_WRITE:
+        if(false == is_output(handle))
+        {
+            // nothing written
+            return finish_call(state, length);
+        }
+        return start_copy_out(state, state->args[1], length, 0);
+
+    case SYS_READ:
+    {
+        uint32_t n = input_head - input_tail;
+        if(SEMIHOST_HANDLE_STDIN != handle)
+        {
+            return finish_call(state, length);
+        }
+        if(n > length)
+        {
+            n = length;
+        }
+        if(0 == n)
+        {
+            // nothing read = end of file
+            return finish_call(state, length);
+        }
+        state->result = length - n;
+        state->pos = state->args[1];
+        state->remaining = n;
+        state->phase = PHASE_COPY_IN;
+        return ERR_NOT_COMPLETED;
+    }
+
+    default:
+        return ERR_WRONG_STATE;
+    }
+}
+
+Result semihost_on_halt(semihost_data_typ* const state, uint32_t pc, bool* resumed)
+{
+    Result res;
+
+    if((NULL == state) || (NULL == resumed))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        *resumed = false;
+        state->pc = pc;
+        start_block(state, pc, 1);
+        state->phase = PHASE_INSTRUCTION;
+    }
+
+    if(PHASE_INSTRUCTION == state->phase)
+    {
+        uint32_t instruction;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        instruction = (state->words[0] >> (8 * (state->pc & 2))) & 0xffff;
+        if(SEMIHOST_BKPT_INSTRUCTION != instruction)
+        {
+            // a normal halt
+            return RESULT_OK;
+        }
+        state->reg_state.first_call = true;
+        state->phase = PHASE_R0;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_R0 == state->phase)
+    {
+        res = core_register_read(&(state->reg_state), 0, &(state->op));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(false == is_supported(state->op))
+        {
+            // GDB has to handle this
+            debug_line("semihosting: call 0x%02lx not handled by the probe", state->op);
+            return RESULT_OK;
+        }
+        state->reg_state.first_call = true;
+        state->phase = PHASE_R1;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_R1 == state->phase)
+    {
+        res = core_register_read(&(state->reg_state), 1, &(state->param));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        return start_call(state);
+    }
+
+    if(PHASE_ARGS == state->phase)
+    {
+        uint32_t i;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < state->read.num_words; i++)
+        {
+            state->args[i] = state->words[i];
+        }
+        return args_done(state);
+    }
+
+    if(PHASE_OPEN_NAME == state->phase)
+    {
+        uint32_t name = 0;
+        uint32_t mode = state->args[1];
+        uint32_t i;
+
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < CONSOLE_NAME_LENGTH; i++)
+        {
+            name = name | ((uint32_t)get_byte(state->words, (state->address & 3) + i) << (8 * i));
+        }
+        if(CONSOLE_NAME != name)
+        {
+            return finish_call(state, RESULT_ERROR);
+        }
+        if(OPEN_MODE_WRITE > mode)
+        {
+            return finish_call(state, SEMIHOST_HANDLE_STDIN);
+        }
+        if(OPEN_MODE_APPEND > mode)
+        {
+            return finish_call(state, SEMIHOST_HANDLE_STDOUT);
+        }
+        if(OPEN_MODE_END > mode)
+        {
+            return finish_call(state, SEMIHOST_HANDLE_STDERR);
+        }
+        return finish_call(state, RESULT_ERROR);
+    }
+
+    if(PHASE_COPY_OUT == state->phase)
+    {
+        uint32_t skip = state->pos & 3;
+        uint32_t i;
+
+        if(true == block_read_is_done(&(state->read)))
+        {
+            // next chunk
+            uint32_t n = SEMIHOST_OUTPUT_SIZE - (output_head - output_tail);
+            if(0 == n)
+            {
+                // the core stays halted until the output was sent
+                if(false == state->waiting)
+                {
+                    num_waits++;
+                    state->waiting = true;
+                }
+                return ERR_NOT_COMPLETED;
+            }
+            if(n > state->remaining)
+            {
+                n = state->remaining;
+            }
+            if(n > ((SEMIHOST_MAX_WORDS * 4) - skip))
+            {
+                n = (SEMIHOST_MAX_WORDS * 4) - skip;
+            }
+            state->num_bytes = n;
+            start_block(state, state->pos, (skip + n + 3) / 4);
+        }
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        for(i = 0; i < state->num_bytes; i++)
+        {
+            uint8_t c = get_byte(state->words, skip + i);
+            if((SYS_WRITE0 == state->op) && (0 == c))
+            {
+                state->remaining = i;
+                state->num_bytes = i;
+                break;
+            }
+            output[output_head & OUTPUT_MASK] = c;
+            output_head++;
+        }
+        num_bytes_out = num_bytes_out + state->num_bytes;
+        state->pos = state->pos + state->num_bytes;
+        state->remaining = state->remaining - state->num_bytes;
+        state->waiting = false;
+        if(0 == state->remaining)
+        {
+            return finish_call(state, state->result);
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_COPY_IN == state->phase)
+    {
+        // partial words are read first, so that the other bytes stay as they are
+        uint32_t offset = state->pos & 3;
+        state->num_bytes = 4 - offset;
+        if(state->num_bytes > state->remaining)
+        {
+            state->num_bytes = state->remaining;
+        }
+        start_block(state, state->pos, 1);
+        if(4 == state->num_bytes)
+        {
+            state->words[0] = 0;
+            state->phase = PHASE_COPY_IN_WRITE;
+        }
+        else
+        {
+            state->phase = PHASE_COPY_IN_READ;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_COPY_IN_READ == state->phase)
+    {
+        res = block_read_all(&(state->read), state->words);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_COPY_IN_WRITE;
+    }
+
+    if(PHASE_COPY_IN_WRITE == state->phase)
+    {
+        uint32_t offset = state->pos & 3;
+        uint32_t value = state->words[0];
+        uint32_t i;
+
+        for(i = 0; i < state->num_bytes; i++)
+        {
+            uint32_t shift = 8 * (offset + i);
+            value = (value & ~(0xffu << shift)) | ((uint32_t)input[(input_tail + i) & INPUT_MASK] << shift);
+        }
+        res = step_write_ap((volatile uint32_t*)(state->pos & ~3u), value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        input_tail = input_tail + state->num_bytes;
+        num_bytes_in = num_bytes_in + state->num_bytes;
+        state->pos = state->pos + state->num_bytes;
+        state->remaining = state->remaining - state->num_bytes;
+        if(0 == state->remaining)
+        {
+            return finish_call(state, state->result);
+        }
+        state->phase = PHASE_COPY_IN;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_SET_R0 == state->phase)
+    {
+        res = core_register_write(&(state->reg_state), 0, state->result);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->reg_state.first_call = true;
+        state->phase = PHASE_SET_PC;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_SET_PC == state->phase)
+    {
+        // continue after the BKPT
+        res = core_register_write(&(state->reg_state), REGSEL_PC, state->pc + 2);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CLEAR_DFSR;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CLEAR_DFSR == state->phase)
+    {
+        res = step_write_ap(DFSR_ADDRESS, DFSR_ALL);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_RESUME;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RESUME == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        num_calls++;
+        *resumed = true;
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_CLI
+bool semihost_cmd_info(uint32_t loop)
+{
+    (void)loop;
+    cli_line("semihosting: %ld calls, %ld bytes out, %ld bytes in, waited %ld times for the host", num_calls,
+             num_bytes_out, num_bytes_in, num_waits);
+    return true;
+}
+#endif
@@ -0,0 +1,95 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_SEMIHOSTING_H_
+#define SOURCE_SEMIHOSTING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+#include "block_read.h"
+#include "cortex_m_debug.h"
+
+// ARM semihosting on the probe (FEAT_SEMIHOSTING).
+//
+// When the core halts on "BKPT 0xAB" the probe does the call itself and lets
+// the core run again. GDB does not see these halts. The buffers are moved
+// with pipelined word reads (and word writes for SYS_READ), so a call takes a
+// few SWD transactions per 128 bytes instead of a round trip to the host.
+//
+// Only the console is supported (":tt" opens stdin, stdout or stderr). The
+// output goes into a buffer in the probe. target_tick() sends it to the GDB
+// console while GDB waits for the stop reply. With a TCP port in the
+// [semihosting] section the probe firmware serves that port with
+// semihost_read_output() instead. If the buffer is full the core stays
+// halted until there is space again. SYS_READ returns what
+// semihost_write_input() has delivered so far (nothing = end of file).
+// Other calls (SYS_EXIT, files, ...) are normal halts for GDB.
+
+#define SEMIHOST_BKPT_INSTRUCTION  0xbeab
+// operation in r0
+#define SYS_OPEN                   0x01
+#define SYS_CLOSE                  0x02
+#define SYS_WRITEC                 0x03
+#define SYS_WRITE0                 0x04
+#define SYS_WRITE                  0x05
+#define SYS_READ                   0x06
+#define SYS_ISTTY                  0x09
+#define SYS_ERRNO                  0x13
+
+#define SEMIHOST_HANDLE_STDIN      1
+#define SEMIHOST_HANDLE_STDOUT     2
+#define SEMIHOST_HANDLE_STDERR     3
+
+// must be a power of two
+#define SEMIHOST_OUTPUT_SIZE       4096
+#define SEMIHOST_INPUT_SIZE        256
+#define SEMIHOST_MAX_WORDS         32
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t pc;
+    uint32_t op;
+    uint32_t param;
+    uint32_t args[3];
+    uint32_t address;
+    uint32_t remaining;
+    uint32_t result;
+    uint32_t num_bytes;
+    uint32_t pos;
+    block_read_typ read;
+    bool waiting;
+    uint32_t words[SEMIHOST_MAX_WORDS];
+    core_register_data_typ reg_state;
+} semihost_data_typ;
+
+void semihost_init(void);
+// [semihosting] tcp_port (0 = output goes to the GDB console)
+void semihost_set_tcp_port(uint32_t port);
+uint32_t semihost_get_tcp_port(void);
+// the core halted at pc: *resumed = true if it was a semihosting call that
+// the probe handled and the core runs again.
+Result semihost_on_halt(semihost_data_typ* const state, uint32_t pc, bool* resumed);
+// output of the target. Returns the number of bytes.
+uint32_t semihost_read_output(uint8_t* buf, uint32_t size);
+// input for the target. Returns the number of bytes that fit.
+uint32_t semihost_write_input(const uint8_t* data, uint32_t length);
+#ifdef FEAT_CLI
+bool semihost_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_SEMIHOSTING_H_ */
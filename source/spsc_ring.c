@@ -0,0 +1,75 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "spsc_ring.h"
+#include "time_critical.h"
+
+// the slot content must be visible to the other core before the counter
+// changes (dmb on the Cortex-M0+)
+#define MEMORY_BARRIER()   __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static uint8_t* TIME_CRITICAL(get_slot)(spsc_ring_typ* const ring, uint32_t counter)
+{
+    uint32_t idx = counter & (ring->num_elements - 1);
+    return &(ring->buffer[idx * ring->element_size]);
+}
+
+void spsc_ring_init(spsc_ring_typ* const ring, void* buffer, uint32_t element_size, uint32_t num_elements)
+{
+    ring->buffer = (uint8_t*)buffer;
+    ring->element_size = element_size;
+    ring->num_elements = num_elements;
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+void* TIME_CRITICAL(spsc_ring_get_write_slot)(spsc_ring_typ* const ring)
+{
+    if((ring->head - ring->tail) >= ring->num_elements)
+    {
+        // full
+        return NULL;
+    }
+    return get_slot(ring, ring->head);
+}
+
+void TIME_CRITICAL(spsc_ring_commit)(spsc_ring_typ* const ring)
+{
+    MEMORY_BARRIER();
+    ring->head = ring->head + 1;
+}
+
+void* TIME_CRITICAL(spsc_ring_peek)(spsc_ring_typ* const ring)
+{
+    if(ring->head == ring->tail)
+    {
+        // empty
+        return NULL;
+    }
+    MEMORY_BARRIER();
+    return get_slot(ring, ring->tail);
+}
+
+void TIME_CRITICAL(spsc_ring_release)(spsc_ring_typ* const ring)
+{
+    MEMORY_BARRIER();
+    ring->tail = ring->tail + 1;
+}
+
+uint32_t spsc_ring_get_num_used(spsc_ring_typ* const ring)
+{
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,52 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_SPSC_RING_H_
+#define SOURCE_SPSC_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Lock free ring buffer for exactly one producer and one consumer. The
+// producer and the consumer can run on different cores.
+//
+// The ring holds fixed size elements in a buffer supplied by the user. The
+// producer gets a free slot, fills it and then commits it. The consumer peeks
+// at the oldest slot, uses it and then releases it. The slot stays valid
+// until it has been committed / released, so large elements do not need to
+// be copied.
+//
+// Only the producer writes "head" and only the consumer writes "tail". Both
+// are free running counters, the difference is the number of used slots.
+// num_elements must be a power of two.
+
+typedef struct {
+    uint8_t* buffer;
+    uint32_t element_size;
+    uint32_t num_elements;
+    volatile uint32_t head;  // number of committed elements (producer)
+    volatile uint32_t tail;  // number of released elements (consumer)
+} spsc_ring_typ;
+
+void spsc_ring_init(spsc_ring_typ* const ring, void* buffer, uint32_t element_size, uint32_t num_elements);
+// producer: NULL if the ring is full
+void* spsc_ring_get_write_slot(spsc_ring_typ* const ring);
+void spsc_ring_commit(spsc_ring_typ* const ring);
+// consumer: NULL if the ring is empty
+void* spsc_ring_peek(spsc_ring_typ* const ring);
+void spsc_ring_release(spsc_ring_typ* const ring);
+uint32_t spsc_ring_get_num_used(spsc_ring_typ* const ring);
+
+#endif /* SOURCE_SPSC_RING_H_ */
@@ -0,0 +1,764 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "stub_residency.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "hal/hw/DMA.h"
+#include "hal/hw/RESETS.h"
+
+#define REG_ALIAS_SET_BITS (0x2u << 12u)
+#define REG_ALIAS_CLR_BITS (0x3u << 12u)
+#define REG_ALIAS(reg, alias)  ((volatile uint32_t*)((volatile uint8_t*)(reg) + (alias)))
+
+#define CRC32_POLYNOMIAL   0x04c11db7
+#define CRC32_SEED         0xffffffff
+
+#define CHECK_SNIFF_CTRL   ( (1 << DMA_SNIFF_CTRL_EN_OFFSET)                                   \
+                           | (STUB_DMA_CHANNEL << DMA_SNIFF_CTRL_DMACH_OFFSET)                 \
+                           | (DMA_SNIFF_CTRL_CALC_CRC32 << DMA_SNIFF_CTRL_CALC_OFFSET) )
+
+// byte transfers: the CRC does not depend on how the sniffer orders the bytes of a word
+#define CHECK_DMA_CTRL     ( (1 << DMA_CH10_CTRL_TRIG_EN_OFFSET)                                        \
+                           | (DMA_CH10_CTRL_TRIG_DATA_SIZE_SIZE_BYTE << DMA_CH10_CTRL_TRIG_DATA_SIZE_OFFSET) \
+                           | (1 << DMA_CH10_CTRL_TRIG_INCR_READ_OFFSET)                                 \
+                           | (1 << DMA_CH10_CTRL_TRIG_SNIFF_EN_OFFSET)                                  \
+                           | (STUB_DMA_CHANNEL << DMA_CH10_CTRL_TRIG_CHAIN_TO_OFFSET)                   \
+                           | (DMA_CH10_CTRL_TRIG_TREQ_SEL_PERMANENT << DMA_CH10_CTRL_TRIG_TREQ_SEL_OFFSET) )
+
+#define NUM_CHECK_WRITES   7
+// everything but the read only and the write 1 to clear bits
+#define DMA_CTRL_WRITEABLE 0x00ffffff
+
+#define XPSR_THUMB         (1u << 24)
+
+#define PHASE_LOOKUP       0
+#define PHASE_WAIT_FREE    1
+#define PHASE_SAVE         2
+#define PHASE_SAVE_RESULT  3
+#define PHASE_CHECK        4
+#define PHASE_WAIT_DMA     5
+#define PHASE_READ_CRC     6
+#define PHASE_RESTORE      7
+#define PHASE_UPLOAD       8
+#define PHASE_CLEAR_BSS    9
+
+#define PHASE_CALL_HALT      0
+#define PHASE_CALL_HALTED    1
+#define PHASE_CALL_SAVE      2
+#define PHASE_CALL_SP        3
+#define PHASE_CALL_PC        4
+#define PHASE_CALL_XPSR      5
+#define PHASE_CALL_MASK      6
+#define PHASE_CALL_RUN       7
+#define PHASE_CALL_WAIT      8
+#define PHASE_CALL_STOP      9
+#define PHASE_CALL_STOPPED  10
+#define PHASE_CALL_UNMASK   11
+#define PHASE_CALL_RESTORE  12
+
+// registers changed by the check, in the order of state->saved
+#define SAVED_RESET        0
+#define SAVED_SNIFF_DATA   1
+#define SAVED_SNIFF_CTRL   2
+#define SAVED_READ_ADDR    3
+#define SAVED_WRITE_ADDR   4
+#define SAVED_TRANS_COUNT  5
+#define SAVED_CTRL         6
+
+static volatile uint32_t* const saved_regs[STUB_NUM_SAVED] = {
+    &(RESETS->RESET),
+    &(DMA->SNIFF_DATA),
+    &(DMA->SNIFF_CTRL),
+    &(DMA->CH10_READ_ADDR),
+    &(DMA->CH10_WRITE_ADDR),
+    &(DMA->CH10_TRANS_COUNT),
+    &(DMA->CH10_CTRL_TRIG),
+};
+
+// core registers of the application, written back in the reverse order
+// (SP is the active one of MSP and PSP, it gets its value again at the end)
+static const uint32_t saved_core_regs[STUB_NUM_CORE_REGS] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+    REGSEL_SP, REGSEL_LR, REGSEL_PC, REGSEL_XPSR,
+    REGSEL_MSP, REGSEL_PSP, REGSEL_CONTROL,
+};
+
+typedef struct {
+    uint32_t id;
+    uint32_t address;
+    uint32_t size;
+    uint32_t crc;
+    const uint8_t* code;
+    bool loaded;
+} stub_typ;
+
+static stub_typ stubs[STUB_MAX_STUBS];
+static uint32_t num_stubs;
+static uint32_t num_uploads;
+static uint32_t num_hits;
+
+void stub_residency_init(void)
+{
+    num_uploads = 0;
+    num_hits = 0;
+    stub_residency_forget_all();
+}
+
+void stub_residency_forget_all(void)
+{
+    num_stubs = 0;
+}
+
+uint32_t stub_residency_crc32(const uint8_t* data, uint32_t length)
+{
+    uint32_t crc = CRC32_SEED;
+    uint32_t i;
+    uint32_t bit;
+
+    for(i = 0; i < length; i++)
+    {
+        crc = crc ^ ((uint32_t)data[i] << 24);
+        for(bit = 0; bit < 8; bit++)
+        {
+            if(0 != (crc & 0x80000000))
+            {
+                crc = (crc << 1) ^ CRC32_POLYNOMIAL;
+            }
+            else
+            {
+                crc = crc << 1;
+            }
+        }
+    }
+    return crc;
+}
+
+uint32_t stub_residency_get_num_uploads(void)
+{
+    return num_uploads;
+}
+
+uint32_t stub_residency_get_num_hits(void)
+{
+    return num_hits;
+}
+
+// bytes of the target RAM that the stub and its check use
+static uint32_t get_footprint(const stub_typ* const stub)
+{
+    return ((stub->size + 3) & ~3u) + 4;
+}
+
+static uint32_t find_or_add(uint32_t id, const uint8_t* code, uint32_t size, uint32_t address)
+{
+    uint32_t i;
+
+    for(i = 0; i < num_stubs; i++)
+    {
+        if(id == stubs[i].id)
+        {
+            break;
+        }
+    }
+    if(i == num_stubs)
+    {
+        if(STUB_MAX_STUBS == num_stubs)
+        {
+            // the other stubs will be checked again when they are needed.
+            stub_residency_forget_all();
+            i = 0;
+        }
+        num_stubs++;
+    }
+    else if((address == stubs[i].address) && (size == stubs[i].size) && (code == stubs[i].code))
+    {
+        return i;
+    }
+    // new stub, different code or a different place
+    stubs[i].id = id;
+    stubs[i].address = address;
+    stubs[i].size = size;
+    stubs[i].crc = stub_residency_crc32(code, size);
+    stubs[i].code = code;
+    stubs[i].loaded = false;
+    return i;
+}
+
+// the upload of stub idx overwrites the stubs that share RAM with it
+static void forget_overlapping(uint32_t idx)
+{
+    uint32_t start = stubs[idx].address;
+    uint32_t end = start + get_footprint(&(stubs[idx]));
+    uint32_t i;
+
+    for(i = 0; i < num_stubs; i++)
+    {
+        if(  (i != idx)
+          && (stubs[i].address < end)
+          && ((stubs[i].address + get_footprint(&(stubs[i]))) > start) )
+        {
+            stubs[i].loaded = false;
+        }
+    }
+}
+
+static void get_check_write(const stub_typ* const stub, uint32_t pos, volatile uint32_t** reg, uint32_t* value)
+{
+    switch(pos)
+    {
+    case 0: *reg = REG_ALIAS(&(RESETS->RESET), REG_ALIAS_CLR_BITS); *value = RESETS_RESET_DMA_MASK; break;
+    case 1: *reg = &(DMA->SNIFF_DATA);     *value = CRC32_SEED;       break;
+    case 2: *reg = &(DMA->SNIFF_CTRL);     *value = CHECK_SNIFF_CTRL; break;
+    case 3: *reg = &(DMA->CH10_READ_ADDR); *value = stub->address;    break;
+    // the word behind the stub
+    case 4: *reg = &(DMA->CH10_WRITE_ADDR);*value = stub->address + get_footprint(stub) - 4; break;
+    case 5: *reg = &(DMA->CH10_TRANS_COUNT); *value = stub->size;     break;
+    default: *reg = &(DMA->CH10_CTRL_TRIG); *value = CHECK_DMA_CTRL;  break;
+    }
+}
+
+// number of writes that restore the saved registers
+static uint32_t get_num_restore_writes(const uint32_t* const saved)
+{
+    if(0 != (saved[SAVED_RESET] & RESETS_RESET_DMA_MASK))
+    {
+        // the DMA goes back into reset, that also resets the registers
+        return 1;
+    }
+    return STUB_NUM_SAVED - 1;
+}
+
+static void get_restore_write(const uint32_t* const saved, uint32_t pos, volatile uint32_t** reg, uint32_t* value)
+{
+    if(0 != (saved[SAVED_RESET] & RESETS_RESET_DMA_MASK))
+    {
+        *reg = REG_ALIAS(&(RESETS->RESET), REG_ALIAS_SET_BITS);
+        *value = RESETS_RESET_DMA_MASK;
+        return;
+    }
+    switch(pos)
+    {
+    case 0: *reg = &(DMA->SNIFF_DATA);       *value = saved[SAVED_SNIFF_DATA];  break;
+    case 1: *reg = &(DMA->SNIFF_CTRL);       *value = saved[SAVED_SNIFF_CTRL];  break;
+    case 2: *reg = &(DMA->CH10_READ_ADDR);   *value = saved[SAVED_READ_ADDR];   break;
+    case 3: *reg = &(DMA->CH10_WRITE_ADDR);  *value = saved[SAVED_WRITE_ADDR];  break;
+    case 4: *reg = &(DMA->CH10_TRANS_COUNT); *value = saved[SAVED_TRANS_COUNT]; break;
+    // alias 1: does not trigger the channel
+    default: *reg = &(DMA->CH10_AL1_CTRL);   *value = saved[SAVED_CTRL] & DMA_CTRL_WRITEABLE; break;
+    }
+}
+
+static uint32_t get_code_word(const stub_typ* const stub, uint32_t pos)
+{
+    uint32_t word = 0;
+    uint32_t i;
+    for(i = 0; i < 4; i++)
+    {
+        if((pos + i) < stub->size)
+        {
+            word = word | ((uint32_t)stub->code[pos + i] << (8 * i));
+        }
+    }
+    return word;
+}
+
+Result stub_residency_ensure(stub_residency_data_typ* const state, uint32_t id, const uint8_t* code, uint32_t size,
+                             uint32_t bss_size, uint32_t address)
+{
+    Result res;
+    stub_typ* stub;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_LOOKUP;
+        state->pos = 0;
+        state->num_polls = 0;
+        state->act_state.first_call = true;
+    }
+
+    if(PHASE_LOOKUP == state->phase)
+    {
+        if((NULL == code) || (0 == size) || (0 != (address & 3)))
+        {
+            return ERR_WRONG_VALUE;
+        }
+        state->idx = find_or_add(id, code, size, address);
+        if(true == stubs[state->idx].loaded)
+        {
+            state->pos = 0;
+            state->phase = PHASE_WAIT_FREE;
+        }
+        else
+        {
+            state->phase = PHASE_UPLOAD;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    stub = &(stubs[state->idx]);
+
+    if(PHASE_WAIT_FREE == state->phase)
+    {
+        // the application might still use the channel (the core is halted, the DMA is not)
+        res = act_read_register(&(state->act_state), &(DMA->CH10_CTRL_TRIG), &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == (state->value & DMA_CH10_CTRL_TRIG_BUSY_MASK))
+        {
+            state->num_polls = 0;
+            state->phase = PHASE_SAVE;
+            return ERR_NOT_COMPLETED;
+        }
+        state->num_polls++;
+        if(STUB_MAX_POLLS == state->num_polls)
+        {
+            // the upload does not need the DMA
+            debug_line("stub %ld: DMA channel %d is busy, no check", id, STUB_DMA_CHANNEL);
+            stub->loaded = false;
+            state->pos = 0;
+            state->phase = PHASE_UPLOAD;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_SAVE == state->phase)
+    {
+        res = step_read_ap(saved_regs[state->pos]);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(STUB_NUM_SAVED == state->pos)
+        {
+            state->pos = 0;
+            state->phase = PHASE_SAVE_RESULT;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_SAVE_RESULT == state->phase)
+    {
+        res = step_get_Result_data(&(state->saved[state->pos]));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(STUB_NUM_SAVED == state->pos)
+        {
+            state->pos = 0;
+            state->phase = PHASE_CHECK;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CHECK == state->phase)
+    {
+        // let the DMA sniffer calculate the CRC of the stub in the target RAM
+        volatile uint32_t* reg;
+        uint32_t value;
+        get_check_write(stub, state->pos, &reg, &value);
+        res = step_write_ap(reg, value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(NUM_CHECK_WRITES == state->pos)
+        {
+            state->phase = PHASE_WAIT_DMA;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_WAIT_DMA == state->phase)
+    {
+        res = act_read_register(&(state->act_state), &(DMA->CH10_CTRL_TRIG), &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 == (state->value & DMA_CH10_CTRL_TRIG_BUSY_MASK))
+        {
+            state->phase = PHASE_READ_CRC;
+            return ERR_NOT_COMPLETED;
+        }
+        state->num_polls++;
+        if(STUB_MAX_POLLS == state->num_polls)
+        {
+            debug_error("stub %ld: DMA timeout !", id);
+            return ERR_TARGET_ERROR;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_READ_CRC == state->phase)
+    {
+        res = act_read_register(&(state->act_state), &(DMA->SNIFF_DATA), &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos = 0;
+        state->phase = PHASE_RESTORE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_RESTORE == state->phase)
+    {
+        volatile uint32_t* reg;
+        uint32_t value;
+        get_restore_write(state->saved, state->pos, &reg, &value);
+        res = step_write_ap(reg, value);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(state->pos < get_num_restore_writes(state->saved))
+        {
+            return ERR_NOT_COMPLETED;
+        }
+        if(stub->crc == state->value)
+        {
+            num_hits++;
+            block_write_start_fill(&(state->write), address + ((size + 3) & ~3u), 0, (bss_size + 3) / 4);
+            state->phase = PHASE_CLEAR_BSS;
+            return ERR_NOT_COMPLETED;
+        }
+        debug_line("stub %ld at 0x%08lx was overwritten", id, stub->address);
+        stub->loaded = false;
+        state->pos = 0;
+        state->phase = PHASE_UPLOAD;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_UPLOAD == state->phase)
+    {
+        res = step_write_ap((volatile uint32_t*)(stub->address + state->pos), get_code_word(stub, state->pos));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos = state->pos + 4;
+        if(state->pos < stub->size)
+        {
+            return ERR_NOT_COMPLETED;
+        }
+        forget_overlapping(state->idx);
+        stub->loaded = true;
+        num_uploads++;
+        block_write_start_fill(&(state->write), address + ((size + 3) & ~3u), 0, (bss_size + 3) / 4);
+        state->phase = PHASE_CLEAR_BSS;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CLEAR_BSS == state->phase)
+    {
+        if(0 == bss_size)
+        {
+            return RESULT_OK;
+        }
+        return block_write_all(&(state->write));
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+// polls DHCSR until the core is halted
+static Result wait_for_halt(stub_call_data_typ* const state, uint32_t max_polls)
+{
+    Result res;
+
+    res = act_read_register(&(state->act_state), DHCSR_ADDRESS, &(state->value));
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->act_state.first_call = true;
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    if(0 != (state->value & DHCSR_S_HALT))
+    {
+        state->num_polls = 0;
+        return RESULT_OK;
+    }
+    state->num_polls++;
+    if(max_polls == state->num_polls)
+    {
+        state->num_polls = 0;
+        return ERR_TIMEOUT;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+// core_register_write() of a call parameter, goes to next_phase when done
+static Result write_parameter_done(stub_call_data_typ* const state, Result res, uint32_t next_phase)
+{
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->reg_state.first_call = true;
+    if(RESULT_OK != res)
+    {
+        return res;
+    }
+    state->phase = next_phase;
+    return ERR_NOT_COMPLETED;
+}
+
+Result stub_residency_call(stub_call_data_typ* const state, uint32_t entry_address, uint32_t stack_top)
+{
+    Result res;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_CALL_HALT;
+        state->num_polls = 0;
+        state->pos = 0;
+        state->stub_result = RESULT_OK;
+        state->reg_state.first_call = true;
+        state->act_state.first_call = true;
+    }
+
+    if(PHASE_CALL_HALT == state->phase)
+    {
+        // the core registers can only be accessed while the core is halted
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_HALTED;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_HALTED == state->phase)
+    {
+        res = wait_for_halt(state, CORE_MAX_POLLS);
+        if(ERR_TIMEOUT == res)
+        {
+            debug_error("stub at 0x%08lx: the core does not halt !", entry_address);
+            return ERR_TARGET_ERROR;
+        }
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_SAVE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_SAVE == state->phase)
+    {
+        // the application continues with these after the call
+        res = core_register_read(&(state->reg_state), saved_core_regs[state->pos], &(state->regs[state->pos]));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->reg_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(STUB_NUM_CORE_REGS == state->pos)
+        {
+            state->phase = PHASE_CALL_SP;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_SP == state->phase)
+    {
+        res = core_register_write(&(state->reg_state), REGSEL_SP, stack_top & ~7u);
+        return write_parameter_done(state, res, PHASE_CALL_PC);
+    }
+
+    if(PHASE_CALL_PC == state->phase)
+    {
+        res = core_register_write(&(state->reg_state), REGSEL_PC, entry_address & ~1u);
+        return write_parameter_done(state, res, PHASE_CALL_XPSR);
+    }
+
+    if(PHASE_CALL_XPSR == state->phase)
+    {
+        res = core_register_write(&(state->reg_state), REGSEL_XPSR, XPSR_THUMB);
+        return write_parameter_done(state, res, PHASE_CALL_MASK);
+    }
+
+    if(PHASE_CALL_MASK == state->phase)
+    {
+        // no interrupts of the application while the stub runs.
+        // C_MASKINTS must only change while the core is halted.
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT | DHCSR_C_MASKINTS);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_RUN;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_RUN == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_MASKINTS);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_WAIT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_WAIT == state->phase)
+    {
+        res = wait_for_halt(state, STUB_MAX_CALL_POLLS);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if(RESULT_OK == res)
+        {
+            // the stub hit its breakpoint
+            state->phase = PHASE_CALL_UNMASK;
+            return ERR_NOT_COMPLETED;
+        }
+        if(ERR_TIMEOUT == res)
+        {
+            debug_error("stub at 0x%08lx does not stop !", entry_address);
+            res = ERR_TARGET_ERROR;
+        }
+        // stop the stub, the application gets its registers back anyway
+        state->stub_result = res;
+        state->phase = PHASE_CALL_STOP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_STOP == state->phase)
+    {
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT | DHCSR_C_MASKINTS);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_STOPPED;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_STOPPED == state->phase)
+    {
+        res = wait_for_halt(state, CORE_MAX_POLLS);
+        if(ERR_TIMEOUT == res)
+        {
+            debug_error("stub at 0x%08lx: the core does not halt !", entry_address);
+            return ERR_TARGET_ERROR;
+        }
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = PHASE_CALL_UNMASK;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_UNMASK == state->phase)
+    {
+        // still halted
+        res = step_write_ap(DHCSR_ADDRESS, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos = STUB_NUM_CORE_REGS;
+        state->phase = PHASE_CALL_RESTORE;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_CALL_RESTORE == state->phase)
+    {
+        res = core_register_write(&(state->reg_state), saved_core_regs[state->pos - 1], state->regs[state->pos - 1]);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->reg_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos--;
+        if(0 == state->pos)
+        {
+            return state->stub_result;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+#ifdef FEAT_CLI
+bool stub_residency_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("stubs: %ld uploads, %ld times still resident", num_uploads, num_hits);
+    }
+    if(loop < num_stubs)
+    {
+        cli_line("stub %ld: 0x%08lx, %ld bytes%s", stubs[loop].id, stubs[loop].address, stubs[loop].size,
+                 (true == stubs[loop].loaded) ? "" : " (not loaded)");
+        return false;
+    }
+    return true;
+}
+#endif
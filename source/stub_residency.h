@@ -0,0 +1,107 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_STUB_RESIDENCY_H_
+#define SOURCE_STUB_RESIDENCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "cortex_m_debug.h"
+#include "block_write.h"
+
+// Keeps the programs that run on the target (stubs) in the target RAM.
+//
+// The caller decides where a stub lives: it reserves the RAM with the
+// ram_planner (code of the stub, its .bss, stack) and passes the start of the
+// reservation as load address. The .bss is cleared before every call. Later uses at the
+// same address only check that the stub is still there: the DMA sniffer of
+// the target calculates a CRC32 of the stub while one DMA channel reads it
+// and writes every byte to the first word behind the stub (.bss or stack). That takes a handful of
+// SWD transactions instead of one write per word. The stub is only uploaded
+// again if the CRC does not match (target reset, the application, the
+// ram_planner or the debugger overwrote the RAM).
+//
+// A stub can therefore only stay resident in RAM that the application does
+// not use ([scratch] region with "save = no"). In RAM that the ram_planner
+// saves and writes back after the call the stub is gone after every call.
+//
+// The check needs the DMA channel STUB_DMA_CHANNEL and the DMA sniffer of the
+// target. The check waits until the application does not use the channel,
+// their registers (and the reset state of the DMA) are read before the check
+// and written back after it, so the application does not notice.
+//
+// stub_residency_call() starts an entry point of a stub at the address where
+// it is resident, with SP at the top of the given stack. The entry point stops
+// the core with a breakpoint when done (see target_src/inc.h). The core
+// registers of the application are saved before and written back after the
+// call, interrupts are masked while the stub runs.
+
+#define STUB_DMA_CHANNEL       10
+#define STUB_MAX_STUBS         4
+// number of status reads while waiting for the DMA
+#define STUB_MAX_POLLS         100
+// number of DHCSR reads while waiting for the end of a stub
+#define STUB_MAX_CALL_POLLS    10000
+// DMA registers that are saved before the check
+#define STUB_NUM_SAVED         7
+// core registers that are saved before a call (r0 - r12, sp, lr, pc, xPSR, msp, psp, control)
+#define STUB_NUM_CORE_REGS     20
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t idx;
+    uint32_t pos;
+    uint32_t num_polls;
+    uint32_t value;
+    uint32_t saved[STUB_NUM_SAVED];
+    block_write_typ write;
+    activity_data_typ act_state;
+} stub_residency_data_typ;
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t num_polls;
+    uint32_t value;
+    uint32_t pos;
+    uint32_t regs[STUB_NUM_CORE_REGS];
+    Result stub_result;
+    core_register_data_typ reg_state;
+    activity_data_typ act_state;
+} stub_call_data_typ;
+
+void stub_residency_init(void);
+// forget all stubs (other target connected)
+void stub_residency_forget_all(void);
+// makes sure that the stub "id" (code, size) is in the target RAM at address
+// and clears its .bss (bss_size bytes behind the code, rounded up to a word).
+// The word behind the stub gets overwritten by the check.
+Result stub_residency_ensure(stub_residency_data_typ* const state, uint32_t id, const uint8_t* code, uint32_t size,
+                             uint32_t bss_size, uint32_t address);
+// runs the stub from entry_address (load address + offset of the entry point)
+// until it stops on its breakpoint. stack_top is the initial SP.
+Result stub_residency_call(stub_call_data_typ* const state, uint32_t entry_address, uint32_t stack_top);
+// CRC32 as calculated by the DMA sniffer (polynomial 0x04c11db7, MSB first, no final inversion)
+uint32_t stub_residency_crc32(const uint8_t* data, uint32_t length);
+uint32_t stub_residency_get_num_uploads(void);
+uint32_t stub_residency_get_num_hits(void);
+#ifdef FEAT_CLI
+bool stub_residency_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_STUB_RESIDENCY_H_ */
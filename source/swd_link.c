@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "swd_link.h"
+#include "target.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+static bool connect_pending = false;
+static uint32_t connected_core = 0;
+
+Result swd_switch_core(uint32_t core_num)
+{
+    Result res;
+
+    if(false == connect_pending)
+    {
+        res = step_connect(target_is_SWDv2(), target_get_SWD_core_id(core_num), target_get_SWD_APSel(core_num));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        connect_pending = true;
+        return ERR_NOT_COMPLETED;
+    }
+    res = step_get_Result_OK();
+    if(ERR_NOT_COMPLETED == res)
+    {
+        // Try again next time
+        return res;
+    }
+    connect_pending = false;
+    if(RESULT_OK != res)
+    {
+        debug_error("ERROR: SWD connect to core %ld failed !", core_num);
+        return res;
+    }
+    connected_core = core_num;
+    return RESULT_OK;
+}
+
+uint32_t swd_get_connected_core(void)
+{
+    return connected_core;
+}
+
+Result swd_link_recover(void)
+{
+    return swd_switch_core(connected_core);
+}
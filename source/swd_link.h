@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_SWD_LINK_H_
+#define SOURCE_SWD_LINK_H_
+
+#include <stdint.h>
+#include "probe_api/result.h"
+
+// SWD link functions of the probe (RP2040 board).
+//
+// A switch to another core is a new connect of the SWD engine: line reset,
+// TARGETSEL (SWDv2 multi drop), DPIDR read, ABORT write that clears the
+// sticky errors, debug power up and the MEM-AP setup. The same connect also
+// gets the link going again after a FAULT ACK or a parity error.
+
+// Provided by the probe firmware (nomagic_probe): its SWD engine owns the PIO
+// state machine, the PIO program and the clock they run from.
+// Changes the SWCLK frequency (0 = default of the probe). The engine uses the
+// fastest frequency it can do that is not faster than requested.
+void swd_set_clock_khz(uint32_t khz);
+
+// connects to the DP of the core (TARGETSEL). Returns ERR_NOT_COMPLETED until done.
+// Steps that are still queued for the old core must be finished before.
+Result swd_switch_core(uint32_t core_num);
+// core of the last successful connect
+uint32_t swd_get_connected_core(void);
+// after a FAULT ACK or a parity error: connects again to the last core, which
+// clears the sticky errors. Returns ERR_NOT_COMPLETED until done.
+Result swd_link_recover(void);
+
+#endif /* SOURCE_SWD_LINK_H_ */
@@ -0,0 +1,248 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include "swd_tuning.h"
+#include "text_util.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+
+// known values:
+// SYSINFO CHIP_ID: bit 31-28 revision, bit 27-12 part (0x0002), bit 11-0 manufacturer (0x927)
+#define CHIP_ID_ADDRESS         0x40000000
+#define CHIP_ID_MASK            0x0fffffff
+#define CHIP_ID_VALUE           0x00002927
+// boot ROM: 'M', 'u', 0x01, version
+#define ROM_MAGIC_ADDRESS       0x00000010
+#define ROM_MAGIC_MASK          0x00ffffff
+#define ROM_MAGIC_VALUE         0x0001754d
+
+#define NO_STEP                 0xffffffff
+
+// SWCLK frequencies that are tested, slowest first
+static const uint32_t clock_steps_khz[] = {
+        1000, 2000, 4000, 6000, 8000, 10000, 12500, 15000, 20000, 25000
+};
+#define NUM_CLOCK_STEPS  (sizeof(clock_steps_khz)/sizeof(clock_steps_khz[0]))
+
+static uint32_t configured_khz;
+static uint32_t tuned_khz;
+
+void swd_tuning_init(void)
+{
+    configured_khz = SWD_TUNING_DEFAULT_KHZ;
+    tuned_khz = SWD_TUNING_DEFAULT_KHZ;
+}
+
+void swd_tuning_set_configured_khz(uint32_t khz)
+{
+    configured_khz = khz;
+    swd_set_clock_khz(swd_tuning_get_khz());
+}
+
+uint32_t swd_tuning_get_khz(void)
+{
+    if(SWD_TUNING_DEFAULT_KHZ != tuned_khz)
+    {
+        return tuned_khz;
+    }
+    return configured_khz;
+}
+
+bool swd_tuning_has_result(void)
+{
+    return (SWD_TUNING_DEFAULT_KHZ != tuned_khz);
+}
+
+static void set_step(swd_tuning_data_typ* const state, uint32_t step)
+{
+    state->step = step;
+    state->num_reads = 0;
+    state->recovering = false;
+    state->act_state.first_call = true;
+    swd_set_clock_khz(clock_steps_khz[step]);
+}
+
+// reads the known values. Returns RESULT_OK after SWD_TUNING_NUM_READS good
+// reads, ERR_TARGET_ERROR if one read failed.
+static Result check_reads(swd_tuning_data_typ* const state)
+{
+    Result res;
+    uint32_t expected;
+
+    if(true == state->recovering)
+    {
+        res = swd_link_recover();
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->recovering = false;
+        if(RESULT_OK != res)
+        {
+            debug_error("SWD: reconnect failed !");
+        }
+        return ERR_TARGET_ERROR;
+    }
+
+    if(0 == (state->num_reads & 1))
+    {
+        res = act_read_register(&(state->act_state), (volatile uint32_t*)CHIP_ID_ADDRESS, &(state->value));
+        state->value = state->value & CHIP_ID_MASK;
+        expected = CHIP_ID_VALUE;
+    }
+    else
+    {
+        res = act_read_register(&(state->act_state), (volatile uint32_t*)ROM_MAGIC_ADDRESS, &(state->value));
+        state->value = state->value & ROM_MAGIC_MASK;
+        expected = ROM_MAGIC_VALUE;
+    }
+    if(ERR_NOT_COMPLETED == res)
+    {
+        return res;
+    }
+    state->act_state.first_call = true;
+    if(RESULT_OK != res)
+    {
+        // ACK or parity error -> the DP has sticky errors set. The reconnect
+        // clears them. It uses the slowest clock, as this one did not work.
+        swd_set_clock_khz(clock_steps_khz[0]);
+        state->recovering = true;
+        return ERR_NOT_COMPLETED;
+    }
+    if(expected != state->value)
+    {
+        // the data got corrupted
+        return ERR_TARGET_ERROR;
+    }
+    state->num_reads++;
+    if(SWD_TUNING_NUM_READS == state->num_reads)
+    {
+        return RESULT_OK;
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+Result swd_tuning_run(swd_tuning_data_typ* const state)
+{
+    Result res;
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = 0;
+        state->best_step = NO_STEP;
+        state->old_khz = swd_tuning_get_khz();
+        set_step(state, 0);
+    }
+
+    if(0 == state->phase)
+    {
+        // search the fastest clock that works
+        res = check_reads(state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if(RESULT_OK == res)
+        {
+            state->best_step = state->step;
+            if((state->step + 1) < NUM_CLOCK_STEPS)
+            {
+                set_step(state, state->step + 1);
+                return ERR_NOT_COMPLETED;
+            }
+        }
+        // else this step failed -> the step before was the fastest one
+
+        if(NO_STEP == state->best_step)
+        {
+            debug_error("SWD: no clock worked !");
+            swd_set_clock_khz(state->old_khz);
+            return ERR_TARGET_ERROR;
+        }
+        if(SWD_TUNING_MARGIN_STEPS < state->best_step)
+        {
+            set_step(state, state->best_step - SWD_TUNING_MARGIN_STEPS);
+        }
+        else
+        {
+            set_step(state, 0);
+        }
+        state->phase++;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(1 == state->phase)
+    {
+        // verify the selected clock
+        res = check_reads(state);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            if(0 == state->step)
+            {
+                debug_error("SWD: verification failed !");
+                swd_set_clock_khz(state->old_khz);
+                return ERR_TARGET_ERROR;
+            }
+            set_step(state, state->step - 1);
+            return ERR_NOT_COMPLETED;
+        }
+        tuned_khz = clock_steps_khz[state->step];
+        debug_line("SWD: %ld kHz worked, using %ld kHz", clock_steps_khz[state->best_step], tuned_khz);
+        return RESULT_OK;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+uint32_t swd_tuning_get_ini_section(char* buf, uint32_t size)
+{
+    uint32_t pos;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    pos = text_add_string(buf, size, 0, "[swd]\r\nswclk_khz = ");
+    pos = text_add_decimal(buf, size, pos, swd_tuning_get_khz());
+    pos = text_add_string(buf, size, pos, "\r\n");
+    buf[pos] = 0;
+    return pos;
+}
+
+#ifdef FEAT_CLI
+bool swd_tuning_cmd_info(uint32_t loop)
+{
+    (void)loop;
+    if(SWD_TUNING_DEFAULT_KHZ == swd_tuning_get_khz())
+    {
+        cli_line("SWCLK: default");
+    }
+    else if(SWD_TUNING_DEFAULT_KHZ != tuned_khz)
+    {
+        cli_line("SWCLK: %ld kHz (tuned, [swd] swclk_khz = %ld)", tuned_khz, tuned_khz);
+    }
+    else
+    {
+        cli_line("SWCLK: %ld kHz (nomagic.ini)", configured_khz);
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_SWD_TUNING_H_
+#define SOURCE_SWD_TUNING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "swd_link.h"
+
+// SWCLK auto tuning (FEAT_SWD_TUNING).
+//
+// The SWD clock is increased step by step. On each step known values are read
+// from the target (SYSINFO CHIP_ID and the boot ROM magic). A read that fails
+// (wrong ACK, parity error) or returns a wrong value ends the search. After a
+// failed read the SWD engine connects again (swd_link_recover()) on the slowest
+// clock, which clears the sticky errors of the DP. The
+// result is the highest step that worked, minus SWD_TUNING_MARGIN_STEPS steps
+// as safety margin. The result is verified once more before it is used.
+//
+// "monitor swd_tune" prints the result as [swd] section for nomagic.ini:
+//     [swd]
+//     swclk_khz = 8000
+// The probe does not write nomagic.ini, the user copies the section into it.
+// It only takes effect once the probe firmware passes it to target_config_set().
+// 0 (or no [swd] section) means the default clock of the probe is used.
+
+#define SWD_TUNING_DEFAULT_KHZ   0
+// number of reads on each clock step
+#define SWD_TUNING_NUM_READS     32
+// the result is this many steps slower than the fastest working step
+#define SWD_TUNING_MARGIN_STEPS  1
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t step;
+    uint32_t best_step;
+    uint32_t num_reads;
+    bool recovering;
+    uint32_t old_khz;
+    uint32_t value;
+    activity_data_typ act_state;
+} swd_tuning_data_typ;
+
+void swd_tuning_init(void);
+// value of "swclk_khz" from the [swd] section of nomagic.ini (used at once)
+void swd_tuning_set_configured_khz(uint32_t khz);
+// SWCLK in kHz that should be used (0 = default of the probe)
+uint32_t swd_tuning_get_khz(void);
+// true after a successful swd_tuning_run() (the result is not in nomagic.ini yet)
+bool swd_tuning_has_result(void);
+Result swd_tuning_run(swd_tuning_data_typ* const state);
+// writes the [swd] section for nomagic.ini into buf. Returns the length.
+uint32_t swd_tuning_get_ini_section(char* buf, uint32_t size);
+#ifdef FEAT_CLI
+bool swd_tuning_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_SWD_TUNING_H_ */
@@ -28,6 +28,9 @@
 #define MON_CMD_IDX_RESET                   2
 #define MON_CMD_IDX_HALT                    3
 #define MON_CMD_IDX_REG                     4
+#ifdef FEAT_SWD_TUNING
+#define MON_CMD_IDX_SWD_TUNE                5
+#endif
 
 
 static const mon_cmd_typ mon_commands[] = {
@@ -38,6 +41,9 @@ static const mon_cmd_typ mon_commands[] = {
 /* 2 */ {"reset",                      "reset target"},
 /* 3 */ {"halt",                       "halt target"},
 /* 4 */ {"reg",                        "show register content"},
+#ifdef FEAT_SWD_TUNING
+/* 5 */ {"swd_tune",                   "find the fastest reliable SWD clock"},
+#endif
 };
 
 #define TARGET_RAM_START   0x20000000
@@ -51,6 +57,11 @@ uint32_t target_get_SWD_core_id(uint32_t core_num); // only required for SWDv2 (
 uint32_t target_get_SWD_APSel(uint32_t core_num);
 
 void target_send_file(char* filename, uint32_t offset, uint32_t len);
+// The gdb server of the probe firmware hands every packet (without "$" and
+// checksum, NUL terminated) to this function before it handles the packet
+// itself. Returns true if the packet has been taken care of here (reply sent
+// or action queued). A packet can be looked at and still return false.
+bool target_handle_gdb_packet(const char* packet);
 Result target_write(uint32_t start_address, uint8_t* data, uint32_t length);
 
 bool target_command_halt_cpu(void);
@@ -0,0 +1,199 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "target_config.h"
+#include "probe_api/debug_log.h"
+#include "dual_core.h"
+#include "live_watch.h"
+#include "ram_planner.h"
+#include "region_cache.h"
+#include "rtos.h"
+#include "rtt.h"
+#include "semihosting.h"
+#include "swd_tuning.h"
+#include "text_util.h"
+
+typedef void (*config_setter)(uint32_t value);
+
+typedef struct {
+    const char* section;
+    const char* key;
+    config_setter set;
+} config_entry_typ;
+
+#ifdef FEAT_EXECUTE_CODE_ON_TARGET
+// the [scratch] keys come one by one, the region is set again after each of them
+static uint32_t scratch_start = 0;
+static uint32_t scratch_size = 0;
+static uint32_t scratch_save = 1;
+
+static void set_scratch_region(void)
+{
+    ram_planner_set_user_region(scratch_start, scratch_size, (0 != scratch_save));
+}
+
+static void set_scratch_start(uint32_t value)
+{
+    scratch_start = value;
+    set_scratch_region();
+}
+
+static void set_scratch_size(uint32_t value)
+{
+    scratch_size = value;
+    set_scratch_region();
+}
+
+static void set_scratch_save(uint32_t value)
+{
+    scratch_save = value;
+    set_scratch_region();
+}
+#endif
+
+#ifdef FEAT_DUAL_CORE
+static void set_halt_together(uint32_t value)
+{
+    dual_core_set_halt_together(0 != value);
+}
+#endif
+
+#ifdef FEAT_LIVE_WATCH
+static void set_live_watch_interval(uint32_t value)
+{
+    if(RESULT_OK != live_watch_set_interval_us(value))
+    {
+        debug_error("ERROR: [live_watch] interval_us = %ld is too short !", value);
+    }
+}
+#endif
+
+static const config_entry_typ entries[] = {
+#ifdef FEAT_SWD_TUNING
+    {"swd", "swclk_khz", swd_tuning_set_configured_khz},
+#endif
+#ifdef FEAT_EXECUTE_CODE_ON_TARGET
+    {"scratch", "start", set_scratch_start},
+    {"scratch", "size", set_scratch_size},
+    {"scratch", "save", set_scratch_save},
+    {"scratch", "save_budget", ram_planner_set_save_budget},
+#endif
+#ifdef FEAT_REGION_CACHE
+    {"cache", "budget", region_cache_set_budget},
+#endif
+#ifdef FEAT_DUAL_CORE
+    {"cores", "halt_together", set_halt_together},
+#endif
+#ifdef FEAT_RTOS
+    {"rtos", "max_priorities", rtos_set_max_priorities},
+    {"rtos", "name_offset", rtos_set_name_offset},
+#endif
+#ifdef FEAT_LIVE_WATCH
+    {"live_watch", "interval_us", set_live_watch_interval},
+#endif
+#ifdef FEAT_RTT
+    {"rtt", "tcp_port", rtt_set_tcp_port},
+    {"rtt", "control_block", rtt_set_control_block},
+#endif
+#ifdef FEAT_SEMIHOSTING
+    {"semihosting", "tcp_port", semihost_set_tcp_port},
+#endif
+    {NULL, NULL, NULL}
+};
+
+static bool parse_value(const char* value, uint32_t* result)
+{
+    uint32_t val = 0;
+
+    if(0 == strcmp(value, "yes"))
+    {
+        *result = 1;
+        return true;
+    }
+    if(0 == strcmp(value, "no"))
+    {
+        *result = 0;
+        return true;
+    }
+    if(('0' == value[0]) && (('x' == value[1]) || ('X' == value[1])))
+    {
+        value = value + 2;
+        if(false == text_parse_hex(&value, &val))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if(0 == *value)
+        {
+            return false;
+        }
+        while(('0' <= *value) && ('9' >= *value))
+        {
+            val = (val * 10) + (uint32_t)(*value - '0');
+            value++;
+        }
+    }
+    if(0 != *value)
+    {
+        return false;
+    }
+    *result = val;
+    return true;
+}
+
+bool target_config_set(const char* section, const char* key, const char* value)
+{
+    uint32_t i;
+    uint32_t val;
+
+    if((NULL == section) || (NULL == key) || (NULL == value))
+    {
+        return false;
+    }
+    for(i = 0; NULL != entries[i].section; i++)
+    {
+        if((0 == strcmp(section, entries[i].section)) && (0 == strcmp(key, entries[i].key)))
+        {
+            if(false == parse_value(value, &val))
+            {
+                debug_error("ERROR: [%s] %s = %s is not a valid value !", section, key, value);
+                return false;
+            }
+            entries[i].set(val);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t target_config_get_changed(char* buf, uint32_t size)
+{
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    buf[0] = 0;
+#ifdef FEAT_SWD_TUNING
+    if(true == swd_tuning_has_result())
+    {
+        return swd_tuning_get_ini_section(buf, size);
+    }
+#endif
+    return 0;
+}
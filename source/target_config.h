@@ -0,0 +1,46 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_TARGET_CONFIG_H_
+#define SOURCE_TARGET_CONFIG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// settings of the target specific features in nomagic.ini.
+//
+// The ini parser of the probe firmware (nomagic_probe) has to hand every line
+// of the sections it does not know itself to target_config_set(). It does not
+// do that yet. Until it does these settings keep their defaults, so the
+// nomagic.ini of this repository does not contain them. The value can be
+// decimal, hex (0x...), "yes" (1) or "no" (0).
+//
+// sections and keys:
+//     [swd]         swclk_khz
+//     [scratch]     start, size, save, save_budget
+//     [cache]       budget
+//     [cores]       halt_together
+//     [rtos]        max_priorities, name_offset
+//     [live_watch]  interval_us
+//     [rtt]         tcp_port, control_block
+//     [semihosting] tcp_port
+
+// returns false if the section / key is not known or the value is invalid
+bool target_config_set(const char* section, const char* key, const char* value);
+// writes the sections that changed on the probe (e.g. the tuned SWD clock) in
+// nomagic.ini format into buf. Returns the length.
+uint32_t target_config_get_changed(char* buf, uint32_t size);
+
+#endif /* SOURCE_TARGET_CONFIG_H_ */
@@ -0,0 +1,133 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "text_util.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+int32_t text_hex_digit(char c)
+{
+    if(('0' <= c) && ('9' >= c))
+    {
+        return c - '0';
+    }
+    if(('a' <= c) && ('f' >= c))
+    {
+        return c - 'a' + 10;
+    }
+    if(('A' <= c) && ('F' >= c))
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool text_parse_hex(const char** c, uint32_t* value)
+{
+    const char* start = *c;
+    *value = 0;
+    while(0 <= text_hex_digit(**c))
+    {
+        *value = (*value << 4) | (uint32_t)text_hex_digit(**c);
+        (*c)++;
+    }
+    return (start != *c);
+}
+
+bool text_parse_hex_byte(const char* c, uint8_t* value)
+{
+    int32_t high = text_hex_digit(c[0]);
+    int32_t low;
+
+    if(0 > high)
+    {
+        return false;
+    }
+    low = text_hex_digit(c[1]);
+    if(0 > low)
+    {
+        return false;
+    }
+    *value = (uint8_t)((high << 4) | low);
+    return true;
+}
+
+bool text_expect(const char** c, char expected)
+{
+    if(expected != **c)
+    {
+        return false;
+    }
+    (*c)++;
+    return true;
+}
+
+uint32_t text_add_string(char* buf, uint32_t size, uint32_t pos, const char* str)
+{
+    while((0 != *str) && ((pos + 1) < size))
+    {
+        buf[pos] = *str;
+        pos++;
+        str++;
+    }
+    return pos;
+}
+
+uint32_t text_add_hex(char* buf, uint32_t size, uint32_t pos, uint32_t value)
+{
+    int32_t shift = 28;
+
+    while((0 < shift) && (0 == (value >> shift)))
+    {
+        shift = shift - 4;
+    }
+    while((0 <= shift) && ((pos + 1) < size))
+    {
+        buf[pos] = hex_digits[(value >> shift) & 0xf];
+        pos++;
+        shift = shift - 4;
+    }
+    return pos;
+}
+
+uint32_t text_add_hex_byte(char* buf, uint32_t size, uint32_t pos, uint32_t value)
+{
+    if((pos + 2) < size)
+    {
+        buf[pos] = hex_digits[(value >> 4) & 0xf];
+        buf[pos + 1] = hex_digits[value & 0xf];
+        pos = pos + 2;
+    }
+    return pos;
+}
+
+uint32_t text_add_decimal(char* buf, uint32_t size, uint32_t pos, uint32_t value)
+{
+    char digits[10];
+    uint32_t num_digits = 0;
+
+    do {
+        digits[num_digits] = (char)('0' + (value % 10));
+        num_digits++;
+        value = value / 10;
+    } while(0 != value);
+    while((0 < num_digits) && ((pos + 1) < size))
+    {
+        num_digits--;
+        buf[pos] = digits[num_digits];
+        pos++;
+    }
+    return pos;
+}
@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_TEXT_UTIL_H_
+#define SOURCE_TEXT_UTIL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Text helpers for GDB packets and nomagic.ini lines.
+//
+// The text_add_*() functions write at buf[pos] and return the new end. They
+// stop one character before size, so the caller can always terminate the
+// string with buf[pos] = 0. Hex digits are lower case, as GDB sends them.
+
+// returns the value of the hex digit or -1 if c is not a hex digit
+int32_t text_hex_digit(char c);
+// reads a hex number and moves *c behind it. Returns false if there is no hex digit.
+bool text_parse_hex(const char** c, uint32_t* value);
+// reads the two hex digits of a byte. Returns false if one of them is not a hex digit.
+bool text_parse_hex_byte(const char* c, uint8_t* value);
+// moves *c behind the expected character. Returns false if *c is a different character.
+bool text_expect(const char** c, char expected);
+
+uint32_t text_add_string(char* buf, uint32_t size, uint32_t pos, const char* str);
+// hex number without leading zeros
+uint32_t text_add_hex(char* buf, uint32_t size, uint32_t pos, uint32_t value);
+// always two hex digits (or nothing if they do not fit)
+uint32_t text_add_hex_byte(char* buf, uint32_t size, uint32_t pos, uint32_t value);
+uint32_t text_add_decimal(char* buf, uint32_t size, uint32_t pos, uint32_t value);
+
+#endif /* SOURCE_TEXT_UTIL_H_ */
@@ -0,0 +1,52 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "tick_budget.h"
+#include "time_critical.h"
+#include "time_us.h"
+
+static uint32_t phases_left;
+static uint32_t start_time;
+
+void tick_budget_start(void)
+{
+    phases_left = TICK_BUDGET_PHASES;
+    start_time = time_us_now();
+}
+
+bool TIME_CRITICAL(tick_budget_continue)(Result res, uint32_t phase_before, uint32_t phase_after)
+{
+    if(ERR_NOT_COMPLETED != res)
+    {
+        // done or failed
+        return false;
+    }
+    if(phase_before == phase_after)
+    {
+        // waiting for a SWD transaction or polling a register -> let the others run
+        return false;
+    }
+    if(0 == phases_left)
+    {
+        return false;
+    }
+    phases_left--;
+    if((time_us_now() - start_time) >= TICK_BUDGET_US)
+    {
+        phases_left = 0;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_TICK_BUDGET_H_
+#define SOURCE_TICK_BUDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/result.h"
+
+// Each call of a flash state machine does one phase and returns. If the phase
+// could advance (the step was queued or the result was already available) the
+// state machine can run the next phase immediately. The tick budget limits
+// how many phases run in one target_tick() so that USB and the network stay
+// responsive.
+//
+// The budget is the number of phases and the time since tick_budget_start().
+// Both limits can be set from the Makefile. Without a call to
+// tick_budget_start() there is no budget (one phase per call).
+
+#ifndef TICK_BUDGET_PHASES
+// every phase queues at most one SWD transaction -> the step queue of the probe needs room for that many
+#define TICK_BUDGET_PHASES     8
+#endif
+
+#ifndef TICK_BUDGET_US
+#define TICK_BUDGET_US       100
+#endif
+
+void tick_budget_start(void);
+// true = the state machine should run the next phase now.
+bool tick_budget_continue(Result res, uint32_t phase_before, uint32_t phase_after);
+
+#endif /* SOURCE_TICK_BUDGET_H_ */
@@ -0,0 +1,37 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdint.h>
+#include "time_critical.h"
+
+// defined in time_critical.ld
+extern uint32_t __time_critical_start[];
+extern uint32_t __time_critical_end[];
+extern uint32_t __time_critical_load[];
+
+// must be called before any time critical function is used.
+void time_critical_init(void)
+{
+#ifndef UNIT_TEST
+    uint32_t* src = __time_critical_load;
+    uint32_t* dst = __time_critical_start;
+    while(dst < __time_critical_end)
+    {
+        *dst = *src;
+        dst++;
+        src++;
+    }
+#endif
+}
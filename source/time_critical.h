@@ -0,0 +1,41 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_TIME_CRITICAL_H_
+#define SOURCE_TIME_CRITICAL_H_
+
+// Functions and tables that are used while talking to the target over SWD
+// can be placed into SRAM. There they do not depend on the XIP cache of the
+// probe. time_critical.ld collects them into the .time_critical section and
+// time_critical_init() copies them from flash into SRAM.
+//
+// usage:
+//   Result TIME_CRITICAL(function_name)(parameters)
+//   static const type TIME_CRITICAL_DATA(table_name)[] = { ... };
+//
+// "make ram_report" lists the functions and tables and shows the SRAM usage.
+
+#ifdef UNIT_TEST
+// the tests run on the host
+#define TIME_CRITICAL(func_name)     func_name
+#define TIME_CRITICAL_DATA(name)     name
+#else
+#define TIME_CRITICAL(func_name)     __attribute__((section(".time_critical." #func_name), noinline)) func_name
+#define TIME_CRITICAL_DATA(name)     __attribute__((section(".time_critical.data." #name))) name
+#endif
+
+void time_critical_init(void);
+
+#endif /* SOURCE_TIME_CRITICAL_H_ */
@@ -0,0 +1,24 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "time_us.h"
+#include "time_critical.h"
+#include "hal/hw/TIMER.h"
+
+uint32_t TIME_CRITICAL(time_us_now)(void)
+{
+    // the timer of the probe counts in micro seconds (clk_ref tick = 1MHz)
+    return TIMER->TIMERAWL;
+}
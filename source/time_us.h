@@ -0,0 +1,26 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef SOURCE_TIME_US_H_
+#define SOURCE_TIME_US_H_
+
+#include <stdint.h>
+
+// free running microsecond counter of the probe (wraps after about 71 minutes).
+// Differences of two values are correct across the wrap as long as they are
+// computed with uint32_t arithmetic.
+uint32_t time_us_now(void);
+
+#endif /* SOURCE_TIME_US_H_ */
@@ -0,0 +1,890 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stddef.h>
+#include "tracepoint.h"
+#include "probe_api/debug_log.h"
+#include "probe_api/steps.h"
+#include "block_read.h"
+#include "text_util.h"
+
+#define BUFFER_WORDS        (TRACE_BUFFER_BYTES / 4)
+// registers that can be collected (bit n = GDB register n)
+#define SUPPORTED_REGS      (0x0000ffffu | (1u << GDB_REG_XPSR))
+#define NO_BASE_REG         -1
+
+// frame: header, pc, register mask, the collected registers, then for each
+// memory range: word aligned address, number of words, the words.
+#define FRAME_HEADER(number, num_words)  (((number) << 16) | (num_words))
+#define FRAME_NUMBER(header)             ((header) >> 16)
+#define FRAME_NUM_WORDS(header)          ((header) & 0xffff)
+#define FRAME_PC            1
+#define FRAME_REG_MASK      2
+#define FRAME_REGS          3
+
+#define STOP_NOT_RUN        0
+#define STOP_QTSTOP         1
+#define STOP_FULL           2
+#define STOP_PASSCOUNT      3
+#define STOP_ERROR          4
+
+#define PHASE_LOOKUP        0
+#define PHASE_CONDITION     1
+#define PHASE_REGISTERS     2
+#define PHASE_BASE_REG      3
+#define PHASE_MEMORY        4
+#define PHASE_STEP_OVER     5
+
+#define ARM_PHASE_ENABLE_FPB    0
+#define ARM_PHASE_READ_COMP     1
+#define ARM_PHASE_WRITE_COMP    2
+#define ARM_PHASE_NEXT          3
+
+typedef struct {
+    int32_t basereg;
+    uint32_t offset;
+    uint32_t length;
+} range_typ;
+
+typedef struct {
+    bool used;
+    bool enabled;
+    uint32_t number;
+    uint32_t address;
+    uint32_t pass_count;
+    uint32_t hits;
+    uint32_t reg_mask;
+    uint32_t num_ranges;
+    range_typ ranges[TRACE_MAX_RANGES];
+    uint32_t cond_length;
+    uint8_t condition[TRACE_MAX_COND_BYTES];
+} tracepoint_typ;
+
+static tracepoint_typ tracepoints[TRACE_MAX_TRACEPOINTS];
+// comparator TRACE_FIRST_COMP + i was written by trace_arm()
+static bool comp_owned[TRACE_MAX_TRACEPOINTS];
+static uint32_t buffer[BUFFER_WORDS];
+static uint32_t used_words;
+static uint32_t num_frames;
+static bool running;
+static uint32_t stop_reason;
+static uint32_t stop_tracepoint;
+static int32_t selected_frame;
+static uint32_t selected_offset;
+
+void trace_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+    {
+        comp_owned[i] = false;
+    }
+    trace_clear();
+}
+
+void trace_clear(void)
+{
+    uint32_t i;
+    for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+    {
+        tracepoints[i].used = false;
+    }
+    used_words = 0;
+    num_frames = 0;
+    running = false;
+    stop_reason = STOP_NOT_RUN;
+    stop_tracepoint = 0;
+    selected_frame = TRACE_NO_FRAME;
+}
+
+static tracepoint_typ* find_number(uint32_t number, uint32_t address)
+{
+    uint32_t i;
+    for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+    {
+        if((true == tracepoints[i].used) && (number == tracepoints[i].number) && (address == tracepoints[i].address))
+        {
+            return &(tracepoints[i]);
+        }
+    }
+    return NULL;
+}
+
+static uint32_t find_address(uint32_t address)
+{
+    uint32_t i;
+    for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+    {
+        if(   (true == tracepoints[i].used) && (true == tracepoints[i].enabled)
+           && ((address & ~1u) == (tracepoints[i].address & ~1u)) )
+        {
+            return i;
+        }
+    }
+    return TRACE_MAX_TRACEPOINTS;
+}
+
+static Result define_tracepoint(const char* c)
+{
+    uint32_t number;
+    uint32_t address;
+    uint32_t step;
+    uint32_t pass;
+    uint32_t i;
+    bool enabled;
+    tracepoint_typ* tp;
+
+    if(   (false == text_parse_hex(&c, &number)) || (false == text_expect(&c, ':'))
+       || (false == text_parse_hex(&c, &address)) || (false == text_expect(&c, ':')) )
+    {
+        return ERR_WRONG_VALUE;
+    }
+    enabled = ('E' == *c);
+    if(   ((false == text_expect(&c, 'E')) && (false == text_expect(&c, 'D'))) || (false == text_expect(&c, ':'))
+       || (false == text_parse_hex(&c, &step)) || (false == text_expect(&c, ':'))
+       || (false == text_parse_hex(&c, &pass)) )
+    {
+        return ERR_WRONG_VALUE;
+    }
+    if(0 != step)
+    {
+        debug_error("tracepoint %ld: while-stepping is not supported !", number);
+        return ERR_WRONG_VALUE;
+    }
+
+    tp = find_number(number, address);
+    if(NULL == tp)
+    {
+        for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+        {
+            if(false == tracepoints[i].used)
+            {
+                tp = &(tracepoints[i]);
+                break;
+            }
+        }
+    }
+    if(NULL == tp)
+    {
+        debug_error("tracepoint %ld: no free FPB comparator !", number);
+        return ERR_WRONG_VALUE;
+    }
+    tp->used = false;
+    tp->enabled = enabled;
+    tp->number = number;
+    tp->address = address;
+    tp->pass_count = pass;
+    tp->hits = 0;
+    tp->reg_mask = 0;
+    tp->num_ranges = 0;
+    tp->cond_length = 0;
+
+    while(true == text_expect(&c, ':'))
+    {
+        if(true == text_expect(&c, 'F'))
+        {
+            // fast tracepoint: we always stop the core, so it is a normal one
+            (void)text_parse_hex(&c, &step);
+        }
+        else if(true == text_expect(&c, 'X'))
+        {
+            uint32_t len;
+            if(   (false == text_parse_hex(&c, &len)) || (false == text_expect(&c, ','))
+               || (0 == len) || (TRACE_MAX_COND_BYTES < len) )
+            {
+                debug_error("tracepoint %ld: invalid condition !", number);
+                return ERR_WRONG_VALUE;
+            }
+            for(i = 0; i < len; i++)
+            {
+                if(false == text_parse_hex_byte(c, &(tp->condition[i])))
+                {
+                    debug_error("tracepoint %ld: invalid condition !", number);
+                    return ERR_WRONG_VALUE;
+                }
+                c = c + 2;
+            }
+            tp->cond_length = len;
+        }
+        else
+        {
+            debug_error("tracepoint %ld: unsupported option %c !", number, *c);
+            return ERR_WRONG_VALUE;
+        }
+    }
+    if((0 != *c) && ('-' != *c))
+    {
+        return ERR_WRONG_VALUE;
+    }
+    tp->used = true;
+    return RESULT_OK;
+}
+
+static Result add_actions(const char* c)
+{
+    uint32_t number;
+    uint32_t address;
+    uint32_t value;
+    tracepoint_typ* tp;
+
+    if(   (false == text_parse_hex(&c, &number)) || (false == text_expect(&c, ':'))
+       || (false == text_parse_hex(&c, &address)) || (false == text_expect(&c, ':')) )
+    {
+        return ERR_WRONG_VALUE;
+    }
+    tp = find_number(number, address);
+    if(NULL == tp)
+    {
+        debug_error("tracepoint %ld: action for an unknown tracepoint !", number);
+        return ERR_WRONG_VALUE;
+    }
+
+    while((0 != *c) && ('-' != *c))
+    {
+        if(true == text_expect(&c, 'R'))
+        {
+            if(false == text_parse_hex(&c, &value))
+            {
+                return ERR_WRONG_VALUE;
+            }
+            tp->reg_mask = tp->reg_mask | (value & SUPPORTED_REGS);
+        }
+        else if(true == text_expect(&c, 'M'))
+        {
+            range_typ* range;
+            bool negative = text_expect(&c, '-');
+            if(TRACE_MAX_RANGES == tp->num_ranges)
+            {
+                debug_error("tracepoint %ld: too many memory ranges !", number);
+                return ERR_WRONG_VALUE;
+            }
+            range = &(tp->ranges[tp->num_ranges]);
+            if(false == text_parse_hex(&c, &value))
+            {
+                return ERR_WRONG_VALUE;
+            }
+            // absolute addresses have base register -1 ("-1" or "FFFFFFFF")
+            if(((true == negative) && (1 == value)) || (0xffffffff == value))
+            {
+                range->basereg = NO_BASE_REG;
+            }
+            else if((false == negative) && (16 > value))
+            {
+                range->basereg = (int32_t)value;
+            }
+            else
+            {
+                debug_error("tracepoint %ld: invalid base register !", number);
+                return ERR_WRONG_VALUE;
+            }
+            if(   (false == text_expect(&c, ',')) || (false == text_parse_hex(&c, &(range->offset)))
+               || (false == text_expect(&c, ',')) || (false == text_parse_hex(&c, &(range->length))) )
+            {
+                return ERR_WRONG_VALUE;
+            }
+            if((0 == range->length) || (TRACE_MAX_RANGE_BYTES < range->length))
+            {
+                debug_error("tracepoint %ld: memory range of %ld bytes not supported !", number, range->length);
+                return ERR_WRONG_VALUE;
+            }
+            tp->num_ranges++;
+        }
+        else
+        {
+            // "X" (collect expression) and "S" (while-stepping)
+            debug_error("tracepoint %ld: unsupported action %c !", number, *c);
+            return ERR_WRONG_VALUE;
+        }
+    }
+    return RESULT_OK;
+}
+
+Result trace_define(const char* packet)
+{
+    if(NULL == packet)
+    {
+        return ERR_WRONG_VALUE;
+    }
+    if(true == running)
+    {
+        return ERR_WRONG_STATE;
+    }
+    if('-' == packet[0])
+    {
+        return add_actions(&packet[1]);
+    }
+    return define_tracepoint(packet);
+}
+
+Result trace_start(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < TRACE_MAX_TRACEPOINTS; i++)
+    {
+        tracepoints[i].hits = 0;
+    }
+    used_words = 0;
+    num_frames = 0;
+    selected_frame = TRACE_NO_FRAME;
+    stop_reason = STOP_NOT_RUN;
+    running = true;
+    return RESULT_OK;
+}
+
+void trace_stop(void)
+{
+    if(true == running)
+    {
+        stop_reason = STOP_QTSTOP;
+    }
+    running = false;
+}
+
+bool trace_is_running(void)
+{
+    return running;
+}
+
+bool trace_is_tracepoint(uint32_t address)
+{
+    return (TRACE_MAX_TRACEPOINTS != find_address(address));
+}
+
+bool trace_is_comparator_in_use(uint32_t comp)
+{
+    if((TRACE_FIRST_COMP > comp) || (FP_NUM_COMP <= comp))
+    {
+        return false;
+    }
+    return comp_owned[comp - TRACE_FIRST_COMP];
+}
+
+Result trace_arm(trace_arm_data_typ* const state, bool enable)
+{
+    Result res;
+    bool wanted;
+    tracepoint_typ* tp;
+
+    if(NULL == state)
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->idx = 0;
+        state->act_state.first_call = true;
+        // the FPB is only switched on, never off: the breakpoints of GDB use it too.
+        state->phase = (true == enable) ? ARM_PHASE_ENABLE_FPB : ARM_PHASE_READ_COMP;
+    }
+
+    if(ARM_PHASE_ENABLE_FPB == state->phase)
+    {
+        res = step_write_ap(FP_CTRL_ADDRESS, FP_CTRL_KEY | FP_CTRL_ENABLE);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->phase = ARM_PHASE_READ_COMP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    tp = &(tracepoints[state->idx]);
+    wanted = (true == enable) && (true == tp->used) && (true == tp->enabled);
+
+    if(ARM_PHASE_READ_COMP == state->phase)
+    {
+        if(true == comp_owned[state->idx])
+        {
+            // ours -> update or remove it
+            state->phase = ARM_PHASE_WRITE_COMP;
+            return ERR_NOT_COMPLETED;
+        }
+        if(false == wanted)
+        {
+            // not ours and not needed -> leave it alone
+            state->phase = ARM_PHASE_NEXT;
+            return ERR_NOT_COMPLETED;
+        }
+        res = act_read_register(&(state->act_state), FP_COMP0_ADDRESS + TRACE_FIRST_COMP + state->idx, &(state->value));
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        state->act_state.first_call = true;
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(0 != (state->value & FP_COMP_ENABLE))
+        {
+            debug_error("tracepoint %ld: FPB comparator %ld is used by a breakpoint !",
+                        tp->number, TRACE_FIRST_COMP + state->idx);
+            return ERR_WRONG_STATE;
+        }
+        state->phase = ARM_PHASE_WRITE_COMP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(ARM_PHASE_WRITE_COMP == state->phase)
+    {
+        res = step_write_ap(FP_COMP0_ADDRESS + TRACE_FIRST_COMP + state->idx,
+                            (true == wanted) ? FP_COMP_VALUE(tp->address) : 0);
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        comp_owned[state->idx] = wanted;
+        state->phase = ARM_PHASE_NEXT;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(ARM_PHASE_NEXT == state->phase)
+    {
+        state->idx++;
+        if(TRACE_MAX_TRACEPOINTS == state->idx)
+        {
+            return RESULT_OK;
+        }
+        state->phase = ARM_PHASE_READ_COMP;
+        return ERR_NOT_COMPLETED;
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+static uint32_t get_regsel(uint32_t regnum)
+{
+    if(GDB_REG_XPSR == regnum)
+    {
+        return REGSEL_XPSR;
+    }
+    return regnum;
+}
+
+static void stop_tracing(trace_data_typ* const state, uint32_t reason)
+{
+    running = false;
+    stop_reason = reason;
+    stop_tracepoint = tracepoints[state->idx].number;
+    state->phase = PHASE_STEP_OVER;
+}
+
+static bool frame_add(trace_data_typ* const state, uint32_t value)
+{
+    if(BUFFER_WORDS == state->pos)
+    {
+        stop_tracing(state, STOP_FULL);
+        return false;
+    }
+    buffer[state->pos] = value;
+    state->pos++;
+    return true;
+}
+
+static void start_frame(trace_data_typ* const state, uint32_t pc)
+{
+    tracepoint_typ* tp = &(tracepoints[state->idx]);
+
+    state->frame_start = used_words;
+    state->pos = used_words;
+    if(   (false == frame_add(state, 0))
+       || (false == frame_add(state, pc))
+       || (false == frame_add(state, tp->reg_mask)) )
+    {
+        return;
+    }
+    state->reg = 0;
+    state->reg_state.first_call = true;
+    state->phase = PHASE_REGISTERS;
+}
+
+static void end_frame(trace_data_typ* const state)
+{
+    tracepoint_typ* tp = &(tracepoints[state->idx]);
+
+    buffer[state->frame_start] = FRAME_HEADER(tp->number, state->pos - state->frame_start);
+    used_words = state->pos;
+    num_frames++;
+    tp->hits++;
+    state->phase = PHASE_STEP_OVER;
+    if((0 != tp->pass_count) && (tp->pass_count <= tp->hits))
+    {
+        stop_tracing(state, STOP_PASSCOUNT);
+    }
+}
+
+Result trace_on_halt(trace_data_typ* const state, uint32_t pc, bool* resume)
+{
+    Result res;
+    tracepoint_typ* tp;
+
+    if((NULL == state) || (NULL == resume))
+    {
+        return ERR_ACTION_NULL;
+    }
+
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        state->phase = PHASE_LOOKUP;
+        *resume = false;
+    }
+
+    if(PHASE_LOOKUP == state->phase)
+    {
+        state->idx = find_address(pc);
+        if(TRACE_MAX_TRACEPOINTS == state->idx)
+        {
+            // not a tracepoint
+            return RESULT_OK;
+        }
+        state->step_state.first_call = true;
+        if(false == running)
+        {
+            // tracing has stopped, but the tracepoint is still armed
+            state->phase = PHASE_STEP_OVER;
+        }
+        else if(0 != tracepoints[state->idx].cond_length)
+        {
+            state->expr_state.first_call = true;
+            state->phase = PHASE_CONDITION;
+        }
+        else
+        {
+            start_frame(state, pc);
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    tp = &(tracepoints[state->idx]);
+
+    if(PHASE_CONDITION == state->phase)
+    {
+        res = agent_expr_run(&(state->expr_state), &(tp->condition[0]), tp->cond_length);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            stop_tracing(state, STOP_ERROR);
+        }
+        else if(0 == state->expr_state.result)
+        {
+            state->phase = PHASE_STEP_OVER;
+        }
+        else
+        {
+            start_frame(state, pc);
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_REGISTERS == state->phase)
+    {
+        uint32_t value;
+        while((32 > state->reg) && (0 == (tp->reg_mask & (1u << state->reg))))
+        {
+            state->reg++;
+        }
+        if(32 == state->reg)
+        {
+            state->range = 0;
+            state->reg_state.first_call = true;
+            state->phase = PHASE_BASE_REG;
+            return ERR_NOT_COMPLETED;
+        }
+        res = core_register_read(&(state->reg_state), get_regsel(state->reg), &value);
+        if(ERR_NOT_COMPLETED == res)
+        {
+            return res;
+        }
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        if(true == frame_add(state, value))
+        {
+            state->reg++;
+            state->reg_state.first_call = true;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_BASE_REG == state->phase)
+    {
+        range_typ* range;
+        uint32_t address;
+        uint32_t end;
+
+        if(tp->num_ranges == state->range)
+        {
+            end_frame(state);
+            return ERR_NOT_COMPLETED;
+        }
+        range = &(tp->ranges[state->range]);
+        address = range->offset;
+        if(NO_BASE_REG != range->basereg)
+        {
+            uint32_t value;
+            res = core_register_read(&(state->reg_state), (uint32_t)range->basereg, &value);
+            if(ERR_NOT_COMPLETED == res)
+            {
+                return res;
+            }
+            if(RESULT_OK != res)
+            {
+                return res;
+            }
+            state->reg_state.first_call = true;
+            address = address + value;
+        }
+        end = (address + range->length + 3) & ~3u;
+        state->address = address & ~3u;
+        state->num_words = (end - state->address) / 4;
+        if(   (false == frame_add(state, state->address))
+           || (false == frame_add(state, state->num_words)) )
+        {
+            return ERR_NOT_COMPLETED;
+        }
+        if(BUFFER_WORDS < (state->pos + state->num_words))
+        {
+            stop_tracing(state, STOP_FULL);
+            return ERR_NOT_COMPLETED;
+        }
+        block_read_start(&(state->read), state->address, state->num_words);
+        state->phase = PHASE_MEMORY;
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_MEMORY == state->phase)
+    {
+        res = block_read_next(&(state->read), &(buffer[state->pos]));
+        if(RESULT_OK != res)
+        {
+            return res;
+        }
+        state->pos++;
+        if(true == block_read_is_done(&(state->read)))
+        {
+            state->range++;
+            state->phase = PHASE_BASE_REG;
+        }
+        return ERR_NOT_COMPLETED;
+    }
+
+    if(PHASE_STEP_OVER == state->phase)
+    {
+        return core_step_over_breakpoint(&(state->step_state), pc, resume);
+    }
+
+    return ERR_WRONG_STATE;
+}
+
+uint32_t trace_get_status(char* buf, uint32_t size)
+{
+    uint32_t pos;
+
+    if((NULL == buf) || (0 == size))
+    {
+        return 0;
+    }
+    if(true == running)
+    {
+        pos = text_add_string(buf, size, 0, "T1");
+    }
+    else
+    {
+        pos = text_add_string(buf, size, 0, "T0;");
+        if(STOP_NOT_RUN == stop_reason)
+        {
+            pos = text_add_string(buf, size, pos, "tnotrun:0");
+        }
+        else if(STOP_QTSTOP == stop_reason)
+        {
+            pos = text_add_string(buf, size, pos, "tstop:0");
+        }
+        else if(STOP_FULL == stop_reason)
+        {
+            pos = text_add_string(buf, size, pos, "tfull:0");
+        }
+        else if(STOP_PASSCOUNT == stop_reason)
+        {
+            pos = text_add_string(buf, size, pos, "tpasscount:");
+            pos = text_add_hex(buf, size, pos, stop_tracepoint);
+        }
+        else
+        {
+            pos = text_add_string(buf, size, pos, "terror::");
+            pos = text_add_hex(buf, size, pos, stop_tracepoint);
+        }
+    }
+    pos = text_add_string(buf, size, pos, ";tframes:");
+    pos = text_add_hex(buf, size, pos, num_frames);
+    pos = text_add_string(buf, size, pos, ";tcreated:");
+    pos = text_add_hex(buf, size, pos, num_frames);
+    pos = text_add_string(buf, size, pos, ";tfree:");
+    pos = text_add_hex(buf, size, pos, (BUFFER_WORDS - used_words) * 4);
+    pos = text_add_string(buf, size, pos, ";tsize:");
+    pos = text_add_hex(buf, size, pos, TRACE_BUFFER_BYTES);
+    pos = text_add_string(buf, size, pos, ";circular:0;disconn:0");
+    buf[pos] = 0;
+    return pos;
+}
+
+uint32_t trace_get_num_frames(void)
+{
+    return num_frames;
+}
+
+static uint32_t get_frame_offset(uint32_t frame)
+{
+    uint32_t offset = 0;
+    uint32_t i;
+    for(i = 0; i < frame; i++)
+    {
+        offset = offset + FRAME_NUM_WORDS(buffer[offset]);
+    }
+    return offset;
+}
+
+Result trace_select_frame(int32_t frame, uint32_t* tracepoint)
+{
+    if(TRACE_NO_FRAME == frame)
+    {
+        selected_frame = TRACE_NO_FRAME;
+        return RESULT_OK;
+    }
+    if((0 > frame) || (num_frames <= (uint32_t)frame))
+    {
+        return ERR_WRONG_VALUE;
+    }
+    selected_frame = frame;
+    selected_offset = get_frame_offset((uint32_t)frame);
+    if(NULL != tracepoint)
+    {
+        *tracepoint = FRAME_NUMBER(buffer[selected_offset]);
+    }
+    return RESULT_OK;
+}
+
+int32_t trace_find_frame(uint32_t pc, int32_t after)
+{
+    uint32_t offset = 0;
+    uint32_t i;
+    for(i = 0; i < num_frames; i++)
+    {
+        if(((int32_t)i > after) && ((pc & ~1u) == (buffer[offset + FRAME_PC] & ~1u)))
+        {
+            return (int32_t)i;
+        }
+        offset = offset + FRAME_NUM_WORDS(buffer[offset]);
+    }
+    return TRACE_NO_FRAME;
+}
+
+int32_t trace_get_selected_frame(void)
+{
+    return selected_frame;
+}
+
+static uint32_t count_bits(uint32_t mask)
+{
+    uint32_t num = 0;
+    while(0 != mask)
+    {
+        mask = mask & (mask - 1);
+        num++;
+    }
+    return num;
+}
+
+bool trace_frame_get_register(uint32_t regnum, uint32_t* value)
+{
+    uint32_t mask;
+
+    if((TRACE_NO_FRAME == selected_frame) || (NULL == value) || (32 <= regnum))
+    {
+        return false;
+    }
+    mask = buffer[selected_offset + FRAME_REG_MASK];
+    if(0 != (mask & (1u << regnum)))
+    {
+        *value = buffer[selected_offset + FRAME_REGS + count_bits(mask & ((1u << regnum) - 1))];
+        return true;
+    }
+    if(REGSEL_PC == regnum)
+    {
+        // GDB needs the PC of each frame
+        *value = buffer[selected_offset + FRAME_PC];
+        return true;
+    }
+    return false;
+}
+
+uint32_t trace_frame_read_memory(uint32_t address, uint8_t* buf, uint32_t length)
+{
+    uint32_t end;
+    uint32_t w;
+    uint32_t i;
+
+    if((TRACE_NO_FRAME == selected_frame) || (NULL == buf))
+    {
+        return 0;
+    }
+    end = selected_offset + FRAME_NUM_WORDS(buffer[selected_offset]);
+    w = selected_offset + FRAME_REGS + count_bits(buffer[selected_offset + FRAME_REG_MASK]);
+    while(w < end)
+    {
+        uint32_t start = buffer[w];
+        uint32_t num_bytes = buffer[w + 1] * 4;
+        if((address >= start) && ((address - start) < num_bytes))
+        {
+            for(i = 0; (i < length) && ((address - start + i) < num_bytes); i++)
+            {
+                uint32_t pos = address - start + i;
+                buf[i] = (uint8_t)(buffer[w + 2 + pos / 4] >> (8 * (pos % 4)));
+            }
+            return i;
+        }
+        w = w + 2 + buffer[w + 1];
+    }
+    return 0;
+}
+
+#ifdef FEAT_CLI
+bool trace_cmd_info(uint32_t loop)
+{
+    if(0 == loop)
+    {
+        cli_line("tracing: %s, %ld frames, %ld of %d bytes used", (true == running) ? "running" : "stopped",
+                 num_frames, used_words * 4, TRACE_BUFFER_BYTES);
+    }
+    if(loop < TRACE_MAX_TRACEPOINTS)
+    {
+        if(true == tracepoints[loop].used)
+        {
+            cli_line("tracepoint %ld at 0x%08lx: %ld hits, %ld ranges", tracepoints[loop].number,
+                     tracepoints[loop].address, tracepoints[loop].hits, tracepoints[loop].num_ranges);
+        }
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,114 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#ifndef SOURCE_TRACEPOINT_H_
+#define SOURCE_TRACEPOINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "agent_expr.h"
+#include "cortex_m_debug.h"
+#include "block_read.h"
+
+// GDB tracepoints collected on the probe (FEAT_TRACEPOINTS).
+//
+// GDB defines the tracepoints with QTDP packets: the address, an optional
+// condition (agent expression), a pass count and the actions ("R" registers,
+// "M" memory ranges). On QTStart the tracepoints get the upper FPB
+// comparators (the lower ones stay for the breakpoints of GDB). The
+// comparators are read first: QTStart fails if a breakpoint already uses one
+// of them. The breakpoint code of the probe must skip the comparators for
+// which trace_is_comparator_in_use() is true. When the core
+// halts on a tracepoint the probe reads the registers and memory ranges into
+// a trace frame in the probe RAM, steps over the tracepoint and lets the core
+// run again. GDB downloads the frames later (QTFrame, then the usual register
+// and memory reads).
+//
+// Tracing stops when the buffer is full or the pass count of a tracepoint is
+// reached. The tracepoints stay armed until QTStop, but are only stepped over.
+// While-stepping actions and collections by expression ("X") are not supported.
+
+#define TRACE_MAX_TRACEPOINTS  2
+#define TRACE_FIRST_COMP       (FP_NUM_COMP - TRACE_MAX_TRACEPOINTS)
+#define TRACE_MAX_RANGES       4
+#define TRACE_MAX_RANGE_BYTES  512
+#define TRACE_MAX_COND_BYTES   64
+#ifndef TRACE_BUFFER_BYTES
+#define TRACE_BUFFER_BYTES     8192
+#endif
+// no frame selected
+#define TRACE_NO_FRAME         -1
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t idx;
+    uint32_t reg;
+    uint32_t range;
+    uint32_t address;
+    uint32_t num_words;
+    block_read_typ read;
+    uint32_t frame_start;
+    uint32_t pos;
+    agent_expr_data_typ expr_state;
+    core_register_data_typ reg_state;
+    core_step_over_data_typ step_state;
+} trace_data_typ;
+
+typedef struct {
+    bool first_call;
+    uint32_t phase;
+    uint32_t idx;
+    uint32_t value;
+    activity_data_typ act_state;
+} trace_arm_data_typ;
+
+void trace_init(void);
+// QTinit: removes all tracepoints and frames
+void trace_clear(void);
+// QTDP: packet is the part after "QTDP:"
+Result trace_define(const char* packet);
+// QTStart (after the tracepoints are armed) and QTStop
+Result trace_start(void);
+void trace_stop(void);
+bool trace_is_running(void);
+bool trace_is_tracepoint(uint32_t address);
+// writes the FPB comparators of the tracepoints (enable = false: removes them).
+// ERR_WRONG_STATE if a comparator that a tracepoint needs is used by a breakpoint.
+Result trace_arm(trace_arm_data_typ* const state, bool enable);
+// true if a tracepoint uses the FPB comparator (0 to FP_NUM_COMP - 1)
+bool trace_is_comparator_in_use(uint32_t comp);
+// the core halted at pc. *resume = true: pc was a tracepoint and the core runs again.
+Result trace_on_halt(trace_data_typ* const state, uint32_t pc, bool* resume);
+// qTStatus reply. Returns the length.
+uint32_t trace_get_status(char* buf, uint32_t size);
+uint32_t trace_get_num_frames(void);
+// QTFrame:n (TRACE_NO_FRAME: back to the live target). *tracepoint = number of the tracepoint that created the frame.
+Result trace_select_frame(int32_t frame, uint32_t* tracepoint);
+// QTFrame:pc:addr: first frame after "after" created at pc. Returns TRACE_NO_FRAME if there is none.
+int32_t trace_find_frame(uint32_t pc, int32_t after);
+int32_t trace_get_selected_frame(void);
+// register of the selected frame (GDB register number). false = not collected.
+bool trace_frame_get_register(uint32_t regnum, uint32_t* value);
+// memory of the selected frame. Returns the number of bytes that were collected from address on.
+uint32_t trace_frame_read_memory(uint32_t address, uint8_t* buf, uint32_t length);
+#ifdef FEAT_CLI
+bool trace_cmd_info(uint32_t loop);
+#endif
+
+#endif /* SOURCE_TRACEPOINT_H_ */
@@ -1,23 +1,119 @@
 #!/usr/bin/python3
 # -*- coding: utf-8 -*-
 
+# creates target_progs.c and target_progs.h from the programs that run on the
+# target. For each program (blink.bin) the files blink.elf (linked with
+# target.ld) and blink.su (gcc -fstack-usage) are also read.
+
 import sys
 import os
+import struct
 from pathlib import Path
 import datetime
 
+ENTRY_PREFIX = 'entry_'
+PARAMETER_BLOCK_SYMBOL = 'target_params'
+
+SHT_SYMTAB = 2
+STT_OBJECT = 1
+STT_FUNC = 2
+
+
+def crc32(data):
+    # same CRC as the DMA sniffer of the RP2040 (polynomial 0x04c11db7, MSB first, no final inversion)
+    crc = 0xffffffff
+    for b in data:
+        crc = crc ^ (b << 24)
+        for i in range(8):
+            if 0 != (crc & 0x80000000):
+                crc = ((crc << 1) ^ 0x04c11db7) & 0xffffffff
+            else:
+                crc = (crc << 1) & 0xffffffff
+    return crc
+
+
+def read_elf(fileName):
+    # returns the sections (name -> size) and symbols (name -> (value, size, type))
+    with open(fileName, mode='rb') as file:
+        elf = file.read()
+    if (elf[0:4] != b'\x7fELF') or (1 != elf[4]) or (1 != elf[5]):
+        print('ERROR: ' + fileName + ' is not a 32bit little endian elf file !')
+        sys.exit(1)
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+    headers = []
+    for i in range(shnum):
+        headers.append(struct.unpack_from('<IIIIIIIIII', elf, shoff + i * shentsize))
+
+    def get_string(table, offset):
+        start = headers[table][4] + offset
+        end = elf.index(b'\x00', start)
+        return elf[start:end].decode('ascii')
+
+    sections = {}
+    symbols = {}
+    for h in headers:
+        sections[get_string(shstrndx, h[0])] = h[5]
+        if SHT_SYMTAB == h[1]:
+            strtab = h[6]
+            for pos in range(h[4], h[4] + h[5], 16):
+                name, value, size, info, other, shndx = struct.unpack_from('<IIIBBH', elf, pos)
+                if (0 == name) or (0 == shndx):
+                    continue
+                symbols[get_string(strtab, name)] = (value, size, info & 0xf)
+    return sections, symbols
+
+
+def read_stack_usage(fileName):
+    # sum of the stack usage of all functions. That is more than really needed,
+    # but safe as long as the program does not use recursion.
+    res = 0
+    if not os.path.isfile(fileName):
+        return 0
+    with open(fileName, mode='r') as file:
+        for line in file:
+            parts = line.split('\t')
+            if 2 > len(parts):
+                continue
+            res = res + int(parts[1])
+    return (res + 7) & ~7
+
+
 def read_prog(fileName):
     res = {}
     res['name'] = fileName
-    res['size'] = os.path.getsize(fileName)
     with open(fileName, mode='rb') as file:
         fileContent = file.read()
-        code = ''
-        for i in range(len(fileContent)):
-            code = code + hex(fileContent[i]) + ', '
-        res['data'] = code
+    res['size'] = len(fileContent)
+    lines = []
+    for i in range(0, len(fileContent), 16):
+        lines.append(', '.join('0x%02x' % b for b in fileContent[i:i + 16]))
+    res['data'] = ',\n'.join(lines)
+    res['crc'] = crc32(fileContent)
+
+    sections, symbols = read_elf(str(Path(fileName).with_suffix('.elf')))
+    res['bss_size'] = sections.get('.bss', 0)
+    res['stack_size'] = read_stack_usage(str(Path(fileName).with_suffix('.su')))
+    entries = []
+    for name in sorted(symbols.keys()):
+        value, size, typ = symbols[name]
+        if (STT_FUNC == typ) and name.startswith(ENTRY_PREFIX):
+            # thumb bit removed
+            entries.append((name[len(ENTRY_PREFIX):], value & ~1))
+    if 0 == len(entries):
+        print('ERROR: ' + fileName + ' has no entry point !')
+        sys.exit(1)
+    res['entries'] = entries
+    if PARAMETER_BLOCK_SYMBOL in symbols:
+        value, size, typ = symbols[PARAMETER_BLOCK_SYMBOL]
+        res['param_offset'] = value
+        res['param_size'] = size
+    else:
+        res['param_offset'] = 0
+        res['param_size'] = 0
     return res
 
+
 def create_header_file(progs):
     f = open('target_src/target_progs.h', 'w')
     f.write('// automatically created ' + datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S') + '\n')
@@ -30,15 +126,44 @@ def create_header_file(progs):
     f.write('typedef enum {\n')
     for k in progs.keys():
         f.write('    ' + k + ',\n')
-    f.write('}progs_typ;\n');
+    f.write('}progs_typ;\n')
+    f.write('\n')
+    f.write('#define TARGET_PROGS_NO_ENTRY 0xffffffff\n')
+    f.write('\n')
+    f.write('// index into target_prog_descriptor_typ.entries\n')
+    for k in progs.keys():
+        for i, entry in enumerate(progs[k]['entries']):
+            f.write('#define ' + k + '_ENTRY_' + entry[0].upper() + ' ' + str(i) + '\n')
+    f.write('\n')
+    f.write('typedef struct {\n')
+    f.write('    const char* name;\n')
+    f.write('    uint32_t offset;  // from the start of the code (without thumb bit)\n')
+    f.write('} target_entry_typ;\n')
+    f.write('\n')
+    f.write('typedef struct {\n')
+    f.write('    const uint8_t* code;\n')
+    f.write('    uint32_t code_size;\n')
+    f.write('    uint32_t bss_size;  // after the code, must be cleared\n')
+    f.write('    uint32_t stack_size;\n')
+    f.write('    uint32_t param_offset;  // parameter and result block\n')
+    f.write('    uint32_t param_size;\n')
+    f.write('    uint32_t crc;  // CRC32 of the code as calculated by the DMA sniffer\n')
+    f.write('    uint32_t num_entries;\n')
+    f.write('    const target_entry_typ* entries;\n')
+    f.write('} target_prog_descriptor_typ;\n')
     f.write('\n')
     f.write('uint32_t target_progs_get_size(progs_typ prog);\n')
     f.write('uint8_t* target_progs_get_code(progs_typ prog);\n')
+    f.write('const target_prog_descriptor_typ* target_progs_get_descriptor(progs_typ prog);\n')
+    f.write('// offset of the entry point (<PROG>_ENTRY_<NAME>) from the start of the code.\n')
+    f.write('// TARGET_PROGS_NO_ENTRY if the program does not have that entry point.\n')
+    f.write('uint32_t target_progs_get_entry_offset(progs_typ prog, uint32_t entry);\n')
     f.write('\n')
     f.write('#endif /* TARGET_SRC_TARGET_PROGS_H_ */\n')
     f.write('\n')
     f.close()
 
+
 def create_c_file(progs):
     f = open('target_src/target_progs.c', 'w')
     f.write('// automatically created ' + datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S') + '\n')
@@ -46,8 +171,26 @@ def create_c_file(progs):
     f.write('#include "target_progs.h"\n')
     f.write('\n')
     for k in progs.keys():
+        p = progs[k]
         f.write('static uint8_t ' + k + '_code[] = {\n')
-        f.write(str(progs[k]['data']) + '\n')
+        f.write(p['data'] + '\n')
+        f.write('};\n')
+        f.write('\n')
+        f.write('static const target_entry_typ ' + k + '_entries[] = {\n')
+        for entry in p['entries']:
+            f.write('    {"' + entry[0] + '", ' + str(entry[1]) + '},\n')
+        f.write('};\n')
+        f.write('\n')
+        f.write('static const target_prog_descriptor_typ ' + k + '_descriptor = {\n')
+        f.write('    &' + k + '_code[0],\n')
+        f.write('    ' + str(p['size']) + ',\n')
+        f.write('    ' + str(p['bss_size']) + ',\n')
+        f.write('    ' + str(p['stack_size']) + ',\n')
+        f.write('    ' + str(p['param_offset']) + ',\n')
+        f.write('    ' + str(p['param_size']) + ',\n')
+        f.write('    0x%08x,\n' % p['crc'])
+        f.write('    ' + str(len(p['entries'])) + ',\n')
+        f.write('    &' + k + '_entries[0],\n')
         f.write('};\n')
         f.write('\n')
     f.write('uint32_t target_progs_get_size(progs_typ prog)\n')
@@ -70,6 +213,26 @@ def create_c_file(progs):
     f.write('    }\n')
     f.write('}\n')
     f.write('\n')
+    f.write('const target_prog_descriptor_typ* target_progs_get_descriptor(progs_typ prog)\n')
+    f.write('{\n')
+    f.write('    switch(prog)\n')
+    f.write('    {\n')
+    for k in progs.keys():
+        f.write('    case ' + k + ': return &' + k + '_descriptor;\n')
+    f.write('    default: return NULL;\n')
+    f.write('    }\n')
+    f.write('}\n')
+    f.write('\n')
+    f.write('uint32_t target_progs_get_entry_offset(progs_typ prog, uint32_t entry)\n')
+    f.write('{\n')
+    f.write('    const target_prog_descriptor_typ* desc = target_progs_get_descriptor(prog);\n')
+    f.write('    if((NULL == desc) || (entry >= desc->num_entries))\n')
+    f.write('    {\n')
+    f.write('        return TARGET_PROGS_NO_ENTRY;\n')
+    f.write('    }\n')
+    f.write('    return desc->entries[entry].offset;\n')
+    f.write('}\n')
+    f.write('\n')
     f.close()
 
 
@@ -84,4 +247,3 @@ if __name__ == '__main__':
     create_header_file(progs)
     create_c_file(progs)
 
-
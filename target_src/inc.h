@@ -18,16 +18,29 @@
 
 #include <stdint.h>
 
-#define STACK_POINTER 0x20042000
+// Entry points:
+// ENTRY(erase) creates the entry point "entry_erase". The entry point calls
+// erase() and stops the core with a breakpoint. The probe sets SP to a stack
+// in the scratch RAM (ram_planner) before it starts the entry point.
+// create_api.py finds all entry points in the elf file. A program can have
+// more than one entry point.
+#define ENTRY(name)                                                      \
+void __attribute__((naked, used, section(".text.entry"))) entry_##name() \
+{                                                                        \
+    __asm__("bl " #name "\n"                                             \
+            "bkpt #1\n");                                                \
+}                                                                        \
+                                                                         \
+static void __attribute__((used, noinline)) name (void)
 
-#define FUNC void __attribute__((naked, used)) target_function() \
-{                                                                \
-    __asm__("ldr r4, =#STACK_POINTER\n"                          \
-            "mov sp, r4\n"                                       \
-            "bl exec_func\n"                                     \
-            "bkpt #1\n");                                        \
-}                                                                \
-                                                                 \
-static void __attribute__((used)) exec_func (void)
+// programs with only one entry point
+#define FUNC ENTRY(exec_func)
+
+// parameter and result block:
+// PARAMETER_BLOCK(flash_params_typ); creates "target_params". The probe
+// writes the parameters before it starts an entry point and reads the results
+// after the breakpoint was hit.
+#define PARAMETER_BLOCK(type)  \
+    volatile type __attribute__((section(".params"), used)) target_params
 
 #endif /* TARGET_SOURCE_INC_H_ */
@@ -2,27 +2,43 @@
 # the necessary files are:
 # target_progs.h
 # target_progs.c
+#
+# each program is compiled (.o + stack usage in .su), linked to address 0 with
+# target.ld (.elf) and converted to a binary image (.bin). create_api.py takes
+# the image and reads the entry points, the parameter block and the size of
+# .bss from the elf file.
+#
+# The programs run where they get uploaded, without relocation. With -fPIE and
+# hidden symbols all addresses of code and data are PC relative, so no GOT
+# entries are needed (target.ld fails the link if there are any).
 
 TARGET_SOURCE_FOLDER = target_src/
 ELF2BIN = arm-none-eabi-objcopy  -O binary -S
 
 PROGS = blink.c
 TARGET_CC = $(CC)
-TARGET_CFLAGS = -c -mthumb -nostartfiles -nodefaultlibs -nostdlib -ffreestanding -mcpu=cortex-m0plus -Os -fPIC
+TARGET_CFLAGS = -c -mthumb -nostartfiles -nodefaultlibs -nostdlib -ffreestanding -mcpu=cortex-m0plus -Os -fPIE -fvisibility=hidden -fstack-usage
+TARGET_LD = $(CC)
+TARGET_LFLAGS = -mthumb -mcpu=cortex-m0plus -nostartfiles -nodefaultlibs -nostdlib -T $(TARGET_SOURCE_FOLDER)target.ld
 TARGET_DDEFS = 
 TARGET_INCDIR =
 
-CLEAN_RM += target_src/*.bin target_src/*.d target_src/*.elf target_src/target_progs.c target_src/target_progs.h
+CLEAN_RM += target_src/*.bin target_src/*.d target_src/*.o target_src/*.su target_src/*.elf target_src/target_progs.c target_src/target_progs.h
 
 BIN_PROGS = $(patsubst %,$(TARGET_SOURCE_FOLDER)%, $(PROGS:.c=.bin))
 
-.PRECIOUS: $(TARGET_SOURCE_FOLDER)%.elf
+.PRECIOUS: $(TARGET_SOURCE_FOLDER)%.o $(TARGET_SOURCE_FOLDER)%.elf
 
-$(TARGET_SOURCE_FOLDER)%.elf : $(TARGET_SOURCE_FOLDER)%.c
+$(TARGET_SOURCE_FOLDER)%.o : $(TARGET_SOURCE_FOLDER)%.c
 	@echo ""
 	@echo "=== compiling $@"
 	$(TARGET_CC) $(TARGET_CFLAGS) $(TARGET_DDEFS) $(TARGET_INCDIR) $< -o $@
 
+$(TARGET_SOURCE_FOLDER)%.elf : $(TARGET_SOURCE_FOLDER)%.o $(TARGET_SOURCE_FOLDER)target.ld
+	@echo ""
+	@echo "=== linking $@"
+	$(TARGET_LD) $(TARGET_LFLAGS) $< -o $@
+
 
 $(TARGET_SOURCE_FOLDER)%.bin : $(TARGET_SOURCE_FOLDER)%.elf
 	@echo ""
@@ -31,7 +47,7 @@ $(TARGET_SOURCE_FOLDER)%.bin : $(TARGET_SOURCE_FOLDER)%.elf
 	$(ELF2BIN) $< $@
 
 
-$(TARGET_SOURCE_FOLDER)target_progs.c: $(BIN_PROGS)
+$(TARGET_SOURCE_FOLDER)target_progs.c: $(BIN_PROGS) $(TARGET_SOURCE_FOLDER)create_api.py
 	@echo ""
 	@echo "create target_progs.c + target_progs.h"
 	@echo "======================================"
@@ -0,0 +1,155 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "agent_expr.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS  10000
+
+static agent_expr_data_typ state;
+
+void setUp(void)
+{
+    mock_core_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result run(const uint8_t* code, uint32_t length)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = agent_expr_run(&state, code, length);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_agent_expr_arithmetic(void)
+{
+    // Objective: (3 + 4) * 6 - 2
+    const uint8_t code[] = {0x22, 3, 0x22, 4, 0x02, 0x22, 6, 0x04, 0x22, 2, 0x03, 0x27};
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code, sizeof(code)));
+    TEST_ASSERT_EQUAL_INT64(40, state.result);
+}
+
+void test_agent_expr_register(void)
+{
+    // Objective: r0 == 5, the register is read from the core
+    const uint8_t code[] = {0x26, 0x00, 0x00, 0x22, 0x05, 0x13, 0x27};
+    mock_core_set_register(0, 5);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code, sizeof(code)));
+    TEST_ASSERT_EQUAL_INT64(1, state.result);
+    mock_core_set_register(0, 4);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code, sizeof(code)));
+    TEST_ASSERT_EQUAL_INT64(0, state.result);
+}
+
+void test_agent_expr_memory(void)
+{
+    // Objective: ref32 reads a word, ref16 across a word boundary reads both words
+    const uint8_t code32[] = {0x24, 0x20, 0x00, 0x00, 0x04, 0x19, 0x27};
+    const uint8_t code16[] = {0x24, 0x20, 0x00, 0x00, 0x03, 0x18, 0x27};
+    mock_core_set_ram_word(0x20000000, 0x44332211);
+    mock_core_set_ram_word(0x20000004, 0x88776655);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code32, sizeof(code32)));
+    TEST_ASSERT_EQUAL_INT64(0x88776655, state.result);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code16, sizeof(code16)));
+    TEST_ASSERT_EQUAL_INT64(0x5544, state.result);
+}
+
+void test_agent_expr_sign_extension(void)
+{
+    // Objective: ext 8 makes 0xff a -1, zero_ext 4 keeps the low bits
+    const uint8_t code_ext[] = {0x22, 0xff, 0x16, 8, 0x27};
+    const uint8_t code_zero[] = {0x22, 0xff, 0x2a, 4, 0x27};
+    const uint8_t code_less[] = {0x22, 0xff, 0x16, 8, 0x22, 1, 0x14, 0x27};
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code_ext, sizeof(code_ext)));
+    TEST_ASSERT_EQUAL_INT64(-1, state.result);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code_zero, sizeof(code_zero)));
+    TEST_ASSERT_EQUAL_INT64(0x0f, state.result);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code_less, sizeof(code_less)));
+    TEST_ASSERT_EQUAL_INT64(1, state.result);
+}
+
+void test_agent_expr_if_goto(void)
+{
+    // Objective: if_goto jumps on non zero values only
+    //                         0     1  2     3  4     5     6     7  8     9
+    const uint8_t code[] = {0x22, 1, 0x20, 0x00, 0x08, 0x22, 7, 0x27, 0x22, 9, 0x27};
+    TEST_ASSERT_EQUAL(RESULT_OK, run(code, sizeof(code)));
+    TEST_ASSERT_EQUAL_INT64(9, state.result);
+}
+
+void test_agent_expr_pick_rot(void)
+{
+    // Objective: pick 1 copies the second item, rot moves the top item below the next two
+    const uint8_t pick[] = {0x22, 5, 0x22, 7, 0x32, 1, 0x03, 0x27};
+    const uint8_t rot_top[] = {0x22, 1, 0x22, 2, 0x22, 3, 0x33, 0x27};
+    const uint8_t rot_third[] = {0x22, 1, 0x22, 2, 0x22, 3, 0x33, 0x29, 0x29, 0x27};
+    const uint8_t pick_deep[] = {0x22, 5, 0x32, 1, 0x27};
+    const uint8_t rot_short[] = {0x22, 1, 0x22, 2, 0x33, 0x27};
+    const uint8_t invalid[] = {0x22, 1, 0x31, 0x27};
+    TEST_ASSERT_EQUAL(RESULT_OK, run(pick, sizeof(pick)));
+    TEST_ASSERT_EQUAL_INT64(2, state.result);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(rot_top, sizeof(rot_top)));
+    TEST_ASSERT_EQUAL_INT64(2, state.result);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(rot_third, sizeof(rot_third)));
+    TEST_ASSERT_EQUAL_INT64(3, state.result);
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(pick_deep, sizeof(pick_deep)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(rot_short, sizeof(rot_short)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(invalid, sizeof(invalid)));
+}
+
+void test_agent_expr_errors(void)
+{
+    // Objective: broken expressions fail instead of returning a value
+    const uint8_t div_zero[] = {0x22, 1, 0x22, 0, 0x05, 0x27};
+    const uint8_t no_end[] = {0x22, 1};
+    const uint8_t underflow[] = {0x02, 0x27};
+    const uint8_t endless[] = {0x21, 0x00, 0x00};
+    const uint8_t trace[] = {0x0c, 0x27};
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(div_zero, sizeof(div_zero)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(no_end, sizeof(no_end)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(underflow, sizeof(underflow)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(endless, sizeof(endless)));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, run(trace, sizeof(trace)));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_agent_expr_arithmetic);
+    RUN_TEST(test_agent_expr_register);
+    RUN_TEST(test_agent_expr_memory);
+    RUN_TEST(test_agent_expr_sign_extension);
+    RUN_TEST(test_agent_expr_if_goto);
+    RUN_TEST(test_agent_expr_pick_rot);
+    RUN_TEST(test_agent_expr_errors);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "cond_breakpoint.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS  10000
+#define BP_ADDRESS 0x10000100
+
+// r0 == 5
+#define COND_R0_IS_5  ";X7,26000022051327"
+// r1 == 1
+#define COND_R1_IS_1  ";X7,26000122011327"
+
+static cond_bp_data_typ state;
+static bool resume;
+
+void setUp(void)
+{
+    const uint32_t pcs[] = {BP_ADDRESS, BP_ADDRESS + 2, BP_ADDRESS + 4};
+    mock_core_init();
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    mock_core_set_breakpoint(BP_ADDRESS);
+    cond_bp_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result run(uint32_t pc)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    resume = false;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = cond_bp_on_halt(&state, pc, &resume);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_cond_bp_false_resumes(void)
+{
+    // Objective: a false condition steps over the breakpoint and lets the core run
+    uint32_t comp = mock_core_get_fp_comp(0);
+    TEST_ASSERT_EQUAL(RESULT_OK, cond_bp_set(BP_ADDRESS, COND_R0_IS_5));
+    mock_core_set_register(0, 4);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS));
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_FALSE(mock_core_is_halted());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_core_get_num_steps());
+    TEST_ASSERT_EQUAL_HEX32(BP_ADDRESS + 2, mock_core_get_register(15));
+    TEST_ASSERT_EQUAL_HEX32(comp, mock_core_get_fp_comp(0));
+}
+
+void test_cond_bp_true_stops(void)
+{
+    // Objective: a true condition reports the halt to GDB
+    TEST_ASSERT_EQUAL(RESULT_OK, cond_bp_set(BP_ADDRESS, COND_R0_IS_5));
+    mock_core_set_register(0, 5);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS));
+    TEST_ASSERT_FALSE(resume);
+    TEST_ASSERT_TRUE(mock_core_is_halted());
+    TEST_ASSERT_EQUAL_UINT32(0, mock_core_get_num_steps());
+}
+
+void test_cond_bp_any_condition(void)
+{
+    // Objective: the halt is reported if one of the conditions is true
+    TEST_ASSERT_EQUAL(RESULT_OK, cond_bp_set(BP_ADDRESS, COND_R0_IS_5 COND_R1_IS_1));
+    mock_core_set_register(0, 4);
+    mock_core_set_register(1, 1);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS));
+    TEST_ASSERT_FALSE(resume);
+    mock_core_set_register(1, 0);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS));
+    TEST_ASSERT_TRUE(resume);
+}
+
+void test_cond_bp_no_condition(void)
+{
+    // Objective: halts on other addresses and unconditional breakpoints are reported
+    TEST_ASSERT_EQUAL(RESULT_OK, cond_bp_set(BP_ADDRESS, COND_R0_IS_5));
+    TEST_ASSERT_TRUE(cond_bp_has_condition(BP_ADDRESS));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS + 2));
+    TEST_ASSERT_FALSE(resume);
+    TEST_ASSERT_EQUAL(RESULT_OK, cond_bp_set(BP_ADDRESS, ""));
+    TEST_ASSERT_FALSE(cond_bp_has_condition(BP_ADDRESS));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(BP_ADDRESS));
+    TEST_ASSERT_FALSE(resume);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_core_get_num_steps());
+}
+
+void test_cond_bp_parse_errors(void)
+{
+    // Objective: broken conditions are rejected
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, cond_bp_set(BP_ADDRESS, ";X3,22zz27"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, cond_bp_set(BP_ADDRESS, ";X4,220127"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, cond_bp_set(BP_ADDRESS, ";X81,22"));
+    TEST_ASSERT_FALSE(cond_bp_has_condition(BP_ADDRESS));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cond_bp_false_resumes);
+    RUN_TEST(test_cond_bp_true_stops);
+    RUN_TEST(test_cond_bp_any_condition);
+    RUN_TEST(test_cond_bp_no_condition);
+    RUN_TEST(test_cond_bp_parse_errors);
+    return UNITY_END();
+}
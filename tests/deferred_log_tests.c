@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "deferred_log.h"
+#include "mock/lib/printf_mock.h"
+
+// aligned like the format strings created by the dlog_x() macros
+static const char fmt_a[] __attribute__((aligned(4))) = "value %ld";
+static const char fmt_b[] __attribute__((aligned(4))) = "values %ld %ld %ld";
+
+void setUp(void)
+{
+    dlog_init();
+    init_printf_mock();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_dlog_empty(void)
+{
+    // Objective: nothing to flush after init
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_waiting_words());
+    TEST_ASSERT_FALSE(dlog_flush_one());
+}
+
+void test_dlog_record_sizes(void)
+{
+    // Objective: a record uses one word for the header plus one word per argument
+    dlog_record(fmt_a, 1, 42, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, dlog_get_num_waiting_words());
+    dlog_record(fmt_b, 3, 1, 2, 3);
+    TEST_ASSERT_EQUAL_UINT32(6, dlog_get_num_waiting_words());
+    dlog_record(fmt_a, 0, 0, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(7, dlog_get_num_waiting_words());
+}
+
+void test_dlog_flush(void)
+{
+    // Objective: each flush removes exactly one record
+    dlog_record(fmt_a, 1, 42, 0, 0);
+    dlog_record(fmt_b, 3, 1, 2, 3);
+    TEST_ASSERT_TRUE(dlog_flush_one());
+    TEST_ASSERT_EQUAL_UINT32(4, dlog_get_num_waiting_words());
+    TEST_ASSERT_TRUE(0 < printf_mock_get_write_idx());
+    TEST_ASSERT_TRUE(dlog_flush_one());
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_waiting_words());
+    TEST_ASSERT_FALSE(dlog_flush_one());
+}
+
+void test_dlog_full(void)
+{
+    // Objective: records that do not fit are dropped and counted
+    uint32_t i;
+    for(i = 0; i < 1000; i++)
+    {
+        dlog_record(fmt_b, 3, i, i, i);
+    }
+    TEST_ASSERT_TRUE(0 < dlog_get_num_dropped());
+    TEST_ASSERT_TRUE(1000 * 4 > dlog_get_num_waiting_words());
+    // flush everything, the last line reports the dropped records
+    while(true == dlog_flush_one())
+    {
+        ;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_waiting_words());
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_dropped());
+}
+
+void test_dlog_wrap_around(void)
+{
+    // Objective: records survive the wrap around at the end of the buffer
+    uint32_t i;
+    for(i = 0; i < 2000; i++)
+    {
+        dlog_record(fmt_b, 3, i, i, i);
+        TEST_ASSERT_TRUE(dlog_flush_one());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_waiting_words());
+    TEST_ASSERT_EQUAL_UINT32(0, dlog_get_num_dropped());
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dlog_empty);
+    RUN_TEST(test_dlog_record_sizes);
+    RUN_TEST(test_dlog_flush);
+    RUN_TEST(test_dlog_full);
+    RUN_TEST(test_dlog_wrap_around);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "dual_core.h"
+#include "mock/mock_dual_core_target.h"
+
+#define MAX_CALLS  1000
+
+static dual_core_data_typ state;
+static bool stopped;
+
+void setUp(void)
+{
+    mock_dual_core_init();
+    dual_core_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result select_core(uint32_t core)
+{
+    Result res;
+    uint32_t i;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = dual_core_select(core);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result poll(void)
+{
+    Result res;
+    uint32_t i;
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = dual_core_poll(&state, &stopped);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result set_run_state(bool halt)
+{
+    Result res;
+    uint32_t i;
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = dual_core_set_run_state(&state, halt);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_dual_core_select_is_cached(void)
+{
+    // Objective: selecting the selected core needs no SWD traffic
+    TEST_ASSERT_EQUAL(RESULT_OK, select_core(1));
+    TEST_ASSERT_EQUAL(RESULT_OK, select_core(1));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_dual_core_get_selected());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_dual_core_get_num_switches());
+    TEST_ASSERT_EQUAL(RESULT_OK, select_core(0));
+    TEST_ASSERT_EQUAL(RESULT_OK, select_core(1));
+    TEST_ASSERT_EQUAL_UINT32(3, mock_dual_core_get_num_switches());
+    dual_core_forget();
+    TEST_ASSERT_EQUAL(RESULT_OK, select_core(1));
+    TEST_ASSERT_EQUAL_UINT32(4, mock_dual_core_get_num_switches());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, select_core(2));
+}
+
+void test_dual_core_threads(void)
+{
+    // Objective: thread 1 is core 0, thread 2 is core 1
+    TEST_ASSERT_EQUAL_UINT32(1, dual_core_get_thread());
+    TEST_ASSERT_EQUAL(RESULT_OK, dual_core_set_thread(2));
+    TEST_ASSERT_EQUAL_UINT32(2, dual_core_get_thread());
+    TEST_ASSERT_EQUAL(RESULT_OK, dual_core_set_thread(0));
+    TEST_ASSERT_EQUAL_UINT32(2, dual_core_get_thread());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, dual_core_set_thread(3));
+    TEST_ASSERT_EQUAL_UINT32(2, dual_core_get_thread());
+}
+
+void test_dual_core_poll(void)
+{
+    // Objective: the core that halted becomes the current thread, the other core keeps running
+    char reply[20];
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_FALSE(stopped);
+    mock_dual_core_set_halted(1, true);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_TRUE(stopped);
+    TEST_ASSERT_EQUAL_UINT32(2, dual_core_get_thread());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_dual_core_get_selected());
+    TEST_ASSERT_TRUE(dual_core_is_halted(1));
+    TEST_ASSERT_FALSE(dual_core_is_halted(0));
+    TEST_ASSERT_FALSE(mock_dual_core_is_halted(0));
+    dual_core_get_stop_reply(reply, sizeof(reply), 5);
+    TEST_ASSERT_EQUAL_STRING("T05thread:02;", reply);
+    // no new halt
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_FALSE(stopped);
+}
+
+void test_dual_core_halt_together(void)
+{
+    // Objective: with halt_together a halt of one core also halts the other one
+    dual_core_set_halt_together(true);
+    mock_dual_core_set_halted(0, true);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_TRUE(stopped);
+    TEST_ASSERT_TRUE(mock_dual_core_is_halted(1));
+    TEST_ASSERT_TRUE(dual_core_is_halted(1));
+    TEST_ASSERT_EQUAL_UINT32(1, dual_core_get_thread());
+    TEST_ASSERT_EQUAL_UINT32(0, mock_dual_core_get_selected());
+}
+
+void test_dual_core_run_state(void)
+{
+    // Objective: both cores are halted and resumed, the current thread stays selected.
+    // The DHCSR write of one core must reach that core before the switch to the other core.
+    TEST_ASSERT_EQUAL(RESULT_OK, dual_core_set_thread(2));
+    TEST_ASSERT_EQUAL(RESULT_OK, set_run_state(true));
+    TEST_ASSERT_TRUE(mock_dual_core_is_halted(0));
+    TEST_ASSERT_TRUE(mock_dual_core_is_halted(1));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_dual_core_get_selected());
+    TEST_ASSERT_EQUAL(RESULT_OK, set_run_state(false));
+    TEST_ASSERT_FALSE(mock_dual_core_is_halted(0));
+    TEST_ASSERT_FALSE(mock_dual_core_is_halted(1));
+    TEST_ASSERT_FALSE(dual_core_is_halted(1));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dual_core_select_is_cached);
+    RUN_TEST(test_dual_core_threads);
+    RUN_TEST(test_dual_core_poll);
+    RUN_TEST(test_dual_core_halt_together);
+    RUN_TEST(test_dual_core_run_state);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "halt_cache.h"
+#include "mock/mock_stub_target.h"
+
+#define MAX_CALLS  100000
+#define DHCSR_HALTED  0x00030003
+#define RAM           0x20040000
+
+void setUp(void)
+{
+    uint32_t i;
+    mock_stub_init();
+    halt_cache_init();
+    for(i = 0; i < 0x2000; i++)
+    {
+        mock_stub_set_ram_byte(RAM + i, (uint8_t)(i * 13));
+    }
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result read_word(uint32_t address, uint32_t* value)
+{
+    halt_cache_data_typ state;
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = halt_cache_read(&state, address, value);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static uint32_t ram_word(uint32_t address)
+{
+    return (uint32_t)mock_stub_get_ram_byte(address)
+         | ((uint32_t)mock_stub_get_ram_byte(address + 1) << 8)
+         | ((uint32_t)mock_stub_get_ram_byte(address + 2) << 16)
+         | ((uint32_t)mock_stub_get_ram_byte(address + 3) << 24);
+}
+
+void test_halt_cache_running(void)
+{
+    // Objective: nothing is cached while the core is running
+    uint32_t value;
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, read_word(RAM, &value));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_num_reads());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, read_word(0x40000000, &value));
+}
+
+void test_halt_cache_block_read_ahead(void)
+{
+    // Objective: a miss reads the whole block, the other words of the block are hits
+    uint32_t value = 0;
+    uint32_t i;
+    mock_stub_set_dhcsr(DHCSR_HALTED);
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM + 8, &value));
+    TEST_ASSERT_EQUAL_HEX32(ram_word(RAM + 8), value);
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_BLOCK_BYTES / 4, mock_stub_get_num_reads());
+    TEST_ASSERT_TRUE(1 < mock_stub_get_max_reads_in_flight());
+    TEST_ASSERT_TRUE(BLOCK_READ_IN_FLIGHT >= mock_stub_get_max_reads_in_flight());
+    for(i = 0; i < HALT_CACHE_BLOCK_BYTES; i = i + 4)
+    {
+        TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM + i, &value));
+        TEST_ASSERT_EQUAL_HEX32(ram_word(RAM + i), value);
+    }
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_BLOCK_BYTES / 4, mock_stub_get_num_reads());
+    TEST_ASSERT_EQUAL_UINT32(1, halt_cache_get_num_misses());
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_BLOCK_BYTES / 4, halt_cache_get_num_hits());
+}
+
+void test_halt_cache_new_epoch(void)
+{
+    // Objective: after invalidate the RAM is read again
+    uint32_t value = 0;
+    mock_stub_set_dhcsr(DHCSR_HALTED);
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM, &value));
+    mock_stub_set_ram_byte(RAM, 0xa5);
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM, &value));
+    TEST_ASSERT_NOT_EQUAL(0xa5, value & 0xff);
+    halt_cache_invalidate();
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM, &value));
+    TEST_ASSERT_EQUAL_HEX32(ram_word(RAM), value);
+    TEST_ASSERT_EQUAL_UINT32(0xa5, value & 0xff);
+}
+
+void test_halt_cache_replacement(void)
+{
+    // Objective: with all blocks in use the oldest block is replaced
+    uint32_t value = 0;
+    uint32_t i;
+    mock_stub_set_dhcsr(DHCSR_HALTED);
+    for(i = 0; i <= HALT_CACHE_NUM_BLOCKS; i++)
+    {
+        TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM + i * HALT_CACHE_BLOCK_BYTES, &value));
+    }
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_NUM_BLOCKS + 1, halt_cache_get_num_misses());
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM + HALT_CACHE_BLOCK_BYTES, &value));
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_NUM_BLOCKS + 1, halt_cache_get_num_misses());
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM, &value));
+    TEST_ASSERT_EQUAL_UINT32(HALT_CACHE_NUM_BLOCKS + 2, halt_cache_get_num_misses());
+    TEST_ASSERT_EQUAL_HEX32(ram_word(RAM), value);
+}
+
+void test_halt_cache_other_core_running(void)
+{
+    // Objective: the RAM is only cached if both cores are halted
+    uint32_t value = 0;
+    mock_stub_set_core_dhcsr(0, DHCSR_HALTED);
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, read_word(RAM, &value));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_num_reads());
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_connected_core());
+    TEST_ASSERT_EQUAL_UINT32(2, mock_stub_get_num_switches());
+
+    mock_stub_set_core_dhcsr(1, DHCSR_HALTED);
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM, &value));
+    TEST_ASSERT_EQUAL_HEX32(ram_word(RAM), value);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_connected_core());
+    TEST_ASSERT_EQUAL_UINT32(4, mock_stub_get_num_switches());
+    // same epoch -> no switch
+    TEST_ASSERT_EQUAL(RESULT_OK, read_word(RAM + 4, &value));
+    TEST_ASSERT_EQUAL_UINT32(4, mock_stub_get_num_switches());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_halt_cache_running);
+    RUN_TEST(test_halt_cache_block_read_ahead);
+    RUN_TEST(test_halt_cache_new_epoch);
+    RUN_TEST(test_halt_cache_replacement);
+    RUN_TEST(test_halt_cache_other_core_running);
+    return UNITY_END();
+}
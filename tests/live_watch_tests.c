@@ -0,0 +1,156 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "live_watch.h"
+#include "mock/mock_core_target.h"
+#include "mock/mock_time_us.h"
+
+#define MAX_CALLS  1000
+
+static live_watch_data_typ state;
+
+void setUp(void)
+{
+    mock_core_init();
+    mock_core_set_halted(false);
+    set_time_us(1000);
+    live_watch_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result sample(void)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = live_watch_sample(&state);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_live_watch_add(void)
+{
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, live_watch_start());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, live_watch_add(0x20000101, 2));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, live_watch_add(0x20000102, 4));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, live_watch_add(0x20000100, 3));
+    for(i = 0; i < LIVE_WATCH_MAX_VARS; i++)
+    {
+        TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000100 + i, 1));
+    }
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, live_watch_add(0x20000200, 4));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_start());
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, live_watch_add(0x20000200, 4));
+    live_watch_clear();
+    TEST_ASSERT_FALSE(live_watch_is_running());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, live_watch_set_interval_us(LIVE_WATCH_MIN_INTERVAL - 1));
+}
+
+void test_live_watch_sample_line(void)
+{
+    char buf[80];
+    uint32_t reads;
+
+    mock_core_set_ram_word(0x20000100, 0x12340011);
+    mock_core_set_ram_word(0x20000200, 0x12345678);
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000100, 1));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000102, 2));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000200, 4));
+    live_watch_get_header(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("time_us,0x20000100,0x20000102,0x20000200\r\n", buf);
+
+    TEST_ASSERT_EQUAL(0, live_watch_get_line(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_start());
+    reads = mock_core_get_num_ram_reads();
+    TEST_ASSERT_EQUAL(RESULT_OK, sample());
+    // the first two variables are in the same word
+    TEST_ASSERT_EQUAL(2, mock_core_get_num_ram_reads() - reads);
+    // the core still runs
+    TEST_ASSERT_FALSE(mock_core_is_halted());
+
+    TEST_ASSERT_EQUAL(strlen("1000,17,4660,305419896\r\n"), live_watch_get_line(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("1000,17,4660,305419896\r\n", buf);
+    TEST_ASSERT_EQUAL(0, live_watch_get_line(buf, sizeof(buf)));
+}
+
+void test_live_watch_due(void)
+{
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000100, 4));
+    TEST_ASSERT_FALSE(live_watch_is_due());
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_set_interval_us(500));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_start());
+    TEST_ASSERT_TRUE(live_watch_is_due());
+    TEST_ASSERT_EQUAL(RESULT_OK, sample());
+    advance_time_us(499);
+    TEST_ASSERT_FALSE(live_watch_is_due());
+    advance_time_us(1);
+    TEST_ASSERT_TRUE(live_watch_is_due());
+    // the sample is late, the next one is still on the 500us grid
+    advance_time_us(100);
+    TEST_ASSERT_EQUAL(RESULT_OK, sample());
+    advance_time_us(399);
+    TEST_ASSERT_FALSE(live_watch_is_due());
+    advance_time_us(1);
+    TEST_ASSERT_TRUE(live_watch_is_due());
+    live_watch_stop();
+    TEST_ASSERT_FALSE(live_watch_is_due());
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, sample());
+}
+
+void test_live_watch_dropped(void)
+{
+    char buf[40];
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_add(0x20000100, 4));
+    TEST_ASSERT_EQUAL(RESULT_OK, live_watch_start());
+    for(i = 0; i < LIVE_WATCH_NUM_SAMPLES + 3; i++)
+    {
+        mock_core_set_ram_word(0x20000100, i);
+        TEST_ASSERT_EQUAL(RESULT_OK, sample());
+    }
+    TEST_ASSERT_EQUAL(3, live_watch_get_num_dropped());
+    // the oldest samples are kept
+    live_watch_get_line(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("1000,0\r\n", buf);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_live_watch_add);
+    RUN_TEST(test_live_watch_sample_line);
+    RUN_TEST(test_live_watch_due);
+    RUN_TEST(test_live_watch_dropped);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "loop_monitor.h"
+#include "mock/mock_time_us.h"
+
+void setUp(void)
+{
+    set_time_us(0);
+    loop_monitor_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_loop_monitor_first_tick(void)
+{
+    // Objective: the first tick only starts the measurement
+    loop_monitor_tick_start();
+    TEST_ASSERT_EQUAL_UINT32(0, loop_monitor_get_max_iteration_us());
+    TEST_ASSERT_EQUAL_UINT32(0, loop_monitor_get_subsystem(LM_OTHER)->calls);
+}
+
+void test_loop_monitor_histogram(void)
+{
+    // Objective: iterations are sorted into power of two buckets
+    loop_monitor_tick_start();
+    loop_monitor_tick_start();  // 0us
+    advance_time_us(1);
+    loop_monitor_tick_start();  // 1us
+    advance_time_us(3);
+    loop_monitor_tick_start();  // 3us
+    advance_time_us(4);
+    loop_monitor_tick_start();  // 4us
+    advance_time_us(1000000);
+    loop_monitor_tick_start();  // 1s
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_bucket(0));
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_bucket(1));
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_bucket(2));
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_bucket(3));
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_bucket(LM_NUM_BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT32(1000000, loop_monitor_get_max_iteration_us());
+}
+
+void test_loop_monitor_exclusive_sections(void)
+{
+    // Objective: the clock of the open section stops while the flash section runs
+    loop_monitor_tick_start();
+    advance_time_us(10);                // main loop
+    loop_monitor_enter(LM_SWD);
+    advance_time_us(5);
+    loop_monitor_enter(LM_FLASH);
+    advance_time_us(100);
+    loop_monitor_leave(LM_FLASH);
+    advance_time_us(7);
+    loop_monitor_leave(LM_SWD);
+    advance_time_us(20);                // main loop
+    loop_monitor_tick_start();
+
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_subsystem(LM_FLASH)->calls);
+    TEST_ASSERT_EQUAL_UINT32(100, loop_monitor_get_subsystem(LM_FLASH)->max_us);
+    TEST_ASSERT_EQUAL_UINT32(12, loop_monitor_get_subsystem(LM_SWD)->total_us);
+    TEST_ASSERT_EQUAL_UINT32(30, loop_monitor_get_subsystem(LM_OTHER)->total_us);
+    TEST_ASSERT_EQUAL_UINT32(142, loop_monitor_get_max_iteration_us());
+}
+
+void test_loop_monitor_probe_sections(void)
+{
+    // Objective: the USB and GDB sections of the probe main loop are not counted as other
+    loop_monitor_tick_start();
+    loop_monitor_enter(LM_USB);
+    advance_time_us(40);
+    loop_monitor_leave(LM_USB);
+    advance_time_us(3);                 // main loop
+    loop_monitor_enter(LM_GDB);
+    advance_time_us(25);
+    loop_monitor_leave(LM_GDB);
+    loop_monitor_enter(LM_SWD);
+    advance_time_us(8);
+    loop_monitor_leave(LM_SWD);
+    loop_monitor_tick_start();
+
+    TEST_ASSERT_EQUAL_UINT32(40, loop_monitor_get_subsystem(LM_USB)->max_us);
+    TEST_ASSERT_EQUAL_UINT32(25, loop_monitor_get_subsystem(LM_GDB)->max_us);
+    TEST_ASSERT_EQUAL_UINT32(8, loop_monitor_get_subsystem(LM_SWD)->total_us);
+    TEST_ASSERT_EQUAL_UINT32(3, loop_monitor_get_subsystem(LM_OTHER)->total_us);
+}
+
+void test_loop_monitor_flash_throughput(void)
+{
+    // Objective: ticks and time of a flash operation are counted
+    uint32_t i;
+    loop_monitor_tick_start();
+    loop_monitor_tick_end(false);
+    for(i = 0; i < 5; i++)
+    {
+        advance_time_us(50);
+        loop_monitor_tick_start();
+        advance_time_us(50);
+        loop_monitor_tick_end(true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, loop_monitor_get_flash_ticks());
+    TEST_ASSERT_EQUAL_UINT32(450, loop_monitor_get_flash_time_us());
+    // end of the flash operation -> values stay
+    advance_time_us(50);
+    loop_monitor_tick_start();
+    loop_monitor_tick_end(false);
+    TEST_ASSERT_EQUAL_UINT32(5, loop_monitor_get_flash_ticks());
+    // the next flash operation starts from zero
+    loop_monitor_tick_start();
+    loop_monitor_tick_end(true);
+    TEST_ASSERT_EQUAL_UINT32(1, loop_monitor_get_flash_ticks());
+}
+
+void test_loop_monitor_timer_wrap(void)
+{
+    // Objective: the wrap around of the timer does not create long iterations
+    set_time_us(0xfffffff0);
+    loop_monitor_tick_start();
+    advance_time_us(0x20);
+    loop_monitor_tick_start();
+    TEST_ASSERT_EQUAL_UINT32(0x20, loop_monitor_get_max_iteration_us());
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_loop_monitor_first_tick);
+    RUN_TEST(test_loop_monitor_histogram);
+    RUN_TEST(test_loop_monitor_exclusive_sections);
+    RUN_TEST(test_loop_monitor_probe_sections);
+    RUN_TEST(test_loop_monitor_flash_throughput);
+    RUN_TEST(test_loop_monitor_timer_wrap);
+    return UNITY_END();
+}
@@ -40,6 +40,11 @@ uint8_t* flash_write_page_received_data_ptr = NULL;
 
 uint8_t buffer[256];
 
+void flash_actions_init(void)
+{
+
+}
+
 Result flash_erase_32kb(flash_action_data_typ* const state, uint32_t start_address)
 {
     if(NULL == state)
@@ -0,0 +1,280 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "mock_core_target.h"
+#include "mock_read_fifo.h"
+
+#define DFSR_ADDRESS     0xe000ed30
+#define DHCSR_ADDRESS    0xe000edf0
+#define DCRSR_ADDRESS    0xe000edf4
+#define DCRDR_ADDRESS    0xe000edf8
+#define FP_COMP0_ADDRESS 0xe0002008
+#define FP_NUM_COMP      4
+#define FP_COMP_ENABLE   (1u << 0)
+#define FP_COMP_MASK     0x1ffffffc
+
+#define DHCSR_C_HALT     (1u << 1)
+#define DHCSR_C_STEP     (1u << 2)
+#define DHCSR_S_REGRDY   (1u << 16)
+#define DHCSR_S_HALT     (1u << 17)
+#define DFSR_HALTED      (1u << 0)
+#define DFSR_BKPT        (1u << 1)
+#define DCRSR_REGWNR     (1u << 16)
+#define MAX_PROGRAM      64
+
+static uint32_t ram[MOCK_CORE_RAM_SIZE / 4];
+static uint32_t regs[MOCK_CORE_NUM_REGS];
+static uint32_t program[MAX_PROGRAM];
+static uint32_t program_length;
+static uint32_t program_idx;
+static uint32_t fp_comp[FP_NUM_COMP];
+static bool halted;
+static uint32_t dfsr;
+static uint32_t dcrdr;
+static uint32_t num_steps;
+static uint32_t num_ram_reads;
+
+void mock_core_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < (MOCK_CORE_RAM_SIZE / 4); i++)
+    {
+        ram[i] = 0;
+    }
+    for(i = 0; i < MOCK_CORE_NUM_REGS; i++)
+    {
+        regs[i] = 0;
+    }
+    program_length = 0;
+    program_idx = 0;
+    for(i = 0; i < FP_NUM_COMP; i++)
+    {
+        fp_comp[i] = 0;
+    }
+    halted = true;
+    dfsr = 0;
+    dcrdr = 0;
+    num_steps = 0;
+    num_ram_reads = 0;
+    mock_read_fifo_init();
+}
+
+void mock_core_set_program(const uint32_t* pcs, uint32_t num)
+{
+    uint32_t i;
+    for(i = 0; (i < num) && (i < MAX_PROGRAM); i++)
+    {
+        program[i] = pcs[i];
+    }
+    program_length = i;
+    program_idx = 0;
+    regs[15] = program[0];
+}
+
+void mock_core_set_breakpoint(uint32_t address)
+{
+    // REPLACE = 01 (lower half word)
+    fp_comp[0] = 0x40000000 | (address & FP_COMP_MASK) | FP_COMP_ENABLE;
+}
+
+void mock_core_set_fp_comp(uint32_t idx, uint32_t value)
+{
+    fp_comp[idx] = value;
+}
+
+uint32_t mock_core_get_fp_comp(uint32_t idx)
+{
+    return fp_comp[idx];
+}
+
+void mock_core_set_halted(bool value)
+{
+    halted = value;
+}
+
+bool mock_core_is_halted(void)
+{
+    return halted;
+}
+
+void mock_core_set_register(uint32_t idx, uint32_t value)
+{
+    regs[idx] = value;
+}
+
+uint32_t mock_core_get_register(uint32_t idx)
+{
+    return regs[idx];
+}
+
+void mock_core_set_ram_word(uint32_t address, uint32_t value)
+{
+    ram[(address - MOCK_CORE_RAM_START) / 4] = value;
+}
+
+uint32_t mock_core_get_ram_word(uint32_t address)
+{
+    return ram[(address - MOCK_CORE_RAM_START) / 4];
+}
+
+uint32_t mock_core_get_num_ram_reads(void)
+{
+    return num_ram_reads;
+}
+
+uint32_t mock_core_get_num_steps(void)
+{
+    return num_steps;
+}
+
+static bool is_ram(uint32_t addr)
+{
+    return (addr >= MOCK_CORE_RAM_START) && (addr < (MOCK_CORE_RAM_START + MOCK_CORE_RAM_SIZE));
+}
+
+static bool is_breakpoint(uint32_t pc)
+{
+    uint32_t i;
+    for(i = 0; i < FP_NUM_COMP; i++)
+    {
+        if((0 != (fp_comp[i] & FP_COMP_ENABLE)) && ((fp_comp[i] & FP_COMP_MASK) == (pc & FP_COMP_MASK)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void step(void)
+{
+    num_steps++;
+    if(true == is_breakpoint(regs[15]))
+    {
+        // the breakpoint hits before the instruction is executed
+        dfsr = dfsr | DFSR_BKPT;
+        return;
+    }
+    if((program_idx + 1) < program_length)
+    {
+        program_idx++;
+        regs[15] = program[program_idx];
+    }
+    dfsr = dfsr | DFSR_HALTED;
+}
+
+static uint32_t read_word(uint32_t addr)
+{
+    if(DHCSR_ADDRESS == addr)
+    {
+        return DHCSR_S_REGRDY | ((true == halted) ? DHCSR_S_HALT : 0);
+    }
+    if(DFSR_ADDRESS == addr)
+    {
+        return dfsr;
+    }
+    if(DCRDR_ADDRESS == addr)
+    {
+        return dcrdr;
+    }
+    if((FP_COMP0_ADDRESS <= addr) && ((FP_COMP0_ADDRESS + 4 * FP_NUM_COMP) > addr))
+    {
+        return fp_comp[(addr - FP_COMP0_ADDRESS) / 4];
+    }
+    if(true == is_ram(addr))
+    {
+        num_ram_reads++;
+        return ram[(addr - MOCK_CORE_RAM_START) / 4];
+    }
+    return 0;
+}
+
+Result step_write_ap(volatile uint32_t* address, uint32_t data)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)address;
+    if(DHCSR_ADDRESS == addr)
+    {
+        if(0 != (data & DHCSR_C_HALT))
+        {
+            halted = true;
+        }
+        else if(0 != (data & DHCSR_C_STEP))
+        {
+            step();
+            halted = true;
+        }
+        else
+        {
+            halted = false;
+        }
+    }
+    else if(DFSR_ADDRESS == addr)
+    {
+        dfsr = dfsr & ~data;
+    }
+    else if(DCRSR_ADDRESS == addr)
+    {
+        uint32_t sel = data & 0x1f;
+        if(sel < MOCK_CORE_NUM_REGS)
+        {
+            if(0 != (data & DCRSR_REGWNR))
+            {
+                regs[sel] = dcrdr;
+            }
+            else
+            {
+                dcrdr = regs[sel];
+            }
+        }
+    }
+    else if(DCRDR_ADDRESS == addr)
+    {
+        dcrdr = data;
+    }
+    else if((FP_COMP0_ADDRESS <= addr) && ((FP_COMP0_ADDRESS + 4 * FP_NUM_COMP) > addr))
+    {
+        fp_comp[(addr - FP_COMP0_ADDRESS) / 4] = data;
+    }
+    else if(true == is_ram(addr))
+    {
+        ram[(addr - MOCK_CORE_RAM_START) / 4] = data;
+    }
+    return RESULT_OK;
+}
+
+Result act_read_register(activity_data_typ* state, volatile uint32_t* address, uint32_t* value)
+{
+    if(true == state->first_call)
+    {
+        // the SWD transaction takes some time
+        state->first_call = false;
+        return ERR_NOT_COMPLETED;
+    }
+    *value = read_word((uint32_t)(uintptr_t)address);
+    return RESULT_OK;
+}
+
+Result step_read_ap(volatile uint32_t* address)
+{
+    return mock_read_fifo_push(read_word((uint32_t)(uintptr_t)address));
+}
+
+Result step_get_Result_data(uint32_t* data)
+{
+    return mock_read_fifo_pop(data);
+}
@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_CORE_TARGET_H_
+#define MOCK_MOCK_CORE_TARGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MOCK_CORE_RAM_START   0x20000000
+#define MOCK_CORE_RAM_SIZE    (4 * 1024)
+#define MOCK_CORE_NUM_REGS    17
+
+// simulates the debug registers of a Cortex-M0+ core (DHCSR, DCRSR, DCRDR,
+// DFSR), its registers and some RAM.
+void mock_core_init(void);
+// PC values: pcs[0] is the PC now, each step moves to the next value.
+void mock_core_set_program(const uint32_t* pcs, uint32_t num);
+// sets FPB comparator 0: a step from this address hits the breakpoint
+void mock_core_set_breakpoint(uint32_t address);
+void mock_core_set_fp_comp(uint32_t idx, uint32_t value);
+uint32_t mock_core_get_fp_comp(uint32_t idx);
+void mock_core_set_halted(bool halted);
+bool mock_core_is_halted(void);
+void mock_core_set_register(uint32_t idx, uint32_t value);
+uint32_t mock_core_get_register(uint32_t idx);
+void mock_core_set_ram_word(uint32_t address, uint32_t value);
+uint32_t mock_core_get_ram_word(uint32_t address);
+uint32_t mock_core_get_num_steps(void);
+uint32_t mock_core_get_num_ram_reads(void);
+
+#endif /* MOCK_MOCK_CORE_TARGET_H_ */
@@ -0,0 +1,145 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "mock_dual_core_target.h"
+
+#define DHCSR_ADDRESS    0xe000edf0
+#define DHCSR_C_HALT     (1u << 1)
+#define DHCSR_S_HALT     (1u << 17)
+#define NUM_CORES        2
+#define NO_CORE          0xffffffff
+#define NUM_QUEUED       4
+
+static bool halted[NUM_CORES];
+static uint32_t selected;
+static uint32_t num_switches;
+static bool switch_pending;
+// written DHCSR values that are still in the step queue
+static uint32_t queued_writes[NUM_QUEUED];
+static uint32_t num_queued;
+
+void mock_dual_core_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < NUM_CORES; i++)
+    {
+        halted[i] = false;
+    }
+    selected = NO_CORE;
+    num_switches = 0;
+    switch_pending = false;
+    num_queued = 0;
+}
+
+static void execute_queued(void)
+{
+    uint32_t i;
+    // the steps go to the core that is selected when they run
+    for(i = 0; i < num_queued; i++)
+    {
+        if(NO_CORE != selected)
+        {
+            halted[selected] = (0 != (queued_writes[i] & DHCSR_C_HALT));
+        }
+    }
+    num_queued = 0;
+}
+
+void mock_dual_core_set_halted(uint32_t core, bool halt)
+{
+    halted[core] = halt;
+}
+
+bool mock_dual_core_is_halted(uint32_t core)
+{
+    // the queued steps run sooner or later
+    execute_queued();
+    return halted[core];
+}
+
+uint32_t mock_dual_core_get_selected(void)
+{
+    return selected;
+}
+
+uint32_t mock_dual_core_get_num_switches(void)
+{
+    return num_switches;
+}
+
+Result step_get_Result_OK(void)
+{
+    if(0 != num_queued)
+    {
+        execute_queued();
+        return ERR_NOT_COMPLETED;
+    }
+    return RESULT_OK;
+}
+
+Result swd_switch_core(uint32_t core_num)
+{
+    if(false == switch_pending)
+    {
+        // line reset, TARGETSEL and DPIDR read take some time
+        switch_pending = true;
+        return ERR_NOT_COMPLETED;
+    }
+    switch_pending = false;
+    if(NUM_CORES <= core_num)
+    {
+        return ERR_TARGET_ERROR;
+    }
+    selected = core_num;
+    num_switches++;
+    // steps that were still queued now go to the new core
+    execute_queued();
+    return RESULT_OK;
+}
+
+Result step_write_ap(volatile uint32_t* address, uint32_t data)
+{
+    if((NO_CORE == selected) || (DHCSR_ADDRESS != (uint32_t)(uintptr_t)address))
+    {
+        return ERR_TARGET_ERROR;
+    }
+    if(NUM_QUEUED == num_queued)
+    {
+        return ERR_NOT_COMPLETED;
+    }
+    queued_writes[num_queued] = data;
+    num_queued++;
+    return RESULT_OK;
+}
+
+Result act_read_register(activity_data_typ* state, volatile uint32_t* address, uint32_t* value)
+{
+    if(true == state->first_call)
+    {
+        state->first_call = false;
+        execute_queued();
+        return ERR_NOT_COMPLETED;
+    }
+    if((NO_CORE == selected) || (DHCSR_ADDRESS != (uint32_t)(uintptr_t)address))
+    {
+        return ERR_TARGET_ERROR;
+    }
+    *value = (true == halted[selected]) ? DHCSR_S_HALT : 0;
+    return RESULT_OK;
+}
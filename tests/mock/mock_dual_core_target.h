@@ -0,0 +1,32 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_DUAL_CORE_TARGET_H_
+#define MOCK_MOCK_DUAL_CORE_TARGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// simulates the two DPs of a RP2040 (TARGETSEL) and the DHCSR of both cores.
+// DHCSR writes stay in the step queue until step_get_Result_OK() or a read;
+// a switch runs them on the new core.
+void mock_dual_core_init(void);
+void mock_dual_core_set_halted(uint32_t core, bool halted);
+bool mock_dual_core_is_halted(uint32_t core);
+// core of the DP that is selected (0xffffffff: none)
+uint32_t mock_dual_core_get_selected(void);
+uint32_t mock_dual_core_get_num_switches(void);
+
+#endif /* MOCK_MOCK_DUAL_CORE_TARGET_H_ */
@@ -23,6 +23,11 @@ void flash_driver_init(void)
 
 }
 
+bool flash_driver_is_busy(void)
+{
+    return false;
+}
+
 Result flash_driver_add_erase_range(flash_driver_data_typ* const state, uint32_t start_address, uint32_t length)
 {
     (void)state;
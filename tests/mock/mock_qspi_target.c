@@ -0,0 +1,381 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "hal/hw/IO_QSPI.h"
+#include "hal/hw/XIP_SSI.h"
+#include "hal/qspi_flash.h"
+#include "mock_qspi_target.h"
+
+#define CMD_BUFFER_SIZE  300
+#define MAX_REGISTERS     8
+#define MAX_COMMANDS     64
+#define SFDP_SIZE       128
+
+static volatile uint32_t* write_address[MOCK_QSPI_MAX_WRITES];
+static uint32_t write_value[MOCK_QSPI_MAX_WRITES];
+static uint32_t num_writes;
+static uint32_t register_value;
+static volatile uint32_t* reg_address[MAX_REGISTERS];
+static uint32_t reg_value[MAX_REGISTERS];
+static uint32_t num_regs;
+
+static uint8_t cmd_bytes[CMD_BUFFER_SIZE];
+static uint32_t num_cmd_bytes;
+static uint8_t commands[MAX_COMMANDS];
+static uint32_t num_commands;
+
+static uint8_t sfdp[SFDP_SIZE];
+static uint32_t sfdp_length;
+
+static uint8_t status_values[10];
+static uint32_t num_status;
+static uint32_t status_idx;
+
+static uint32_t jedec_id;
+static uint32_t jedec_min_sckdv;
+static uint32_t jedec_rsd_ok_mask;
+static uint32_t quad_min_sckdv;
+static uint32_t ssi_sckdv;
+static uint32_t ssi_rsd;
+static bool rx_only;
+static uint32_t num_rx_frames;
+
+static uint8_t rx_fifo[64];
+static uint32_t rx_level;
+static uint32_t max_rx_level;
+
+void mock_qspi_init(void)
+{
+    num_writes = 0;
+    register_value = 0;
+    num_regs = 0;
+    num_cmd_bytes = 0;
+    num_commands = 0;
+    sfdp_length = 0;
+    num_status = 0;
+    status_idx = 0;
+    jedec_id = 0;
+    jedec_min_sckdv = 0;
+    jedec_rsd_ok_mask = 0xffffffff;
+    quad_min_sckdv = 0;
+    ssi_sckdv = 0;
+    ssi_rsd = 0;
+    rx_only = false;
+    num_rx_frames = 0;
+    rx_level = 0;
+    max_rx_level = 0;
+}
+
+void mock_qspi_set_status(const uint8_t* status, uint32_t num)
+{
+    uint32_t i;
+    for(i = 0; (i < num) && (i < sizeof(status_values)); i++)
+    {
+        status_values[i] = status[i];
+    }
+    num_status = i;
+    status_idx = 0;
+}
+
+void mock_qspi_set_jedec_id(uint32_t id, uint32_t min_sckdv, uint32_t rsd_ok_mask)
+{
+    jedec_id = id;
+    jedec_min_sckdv = min_sckdv;
+    jedec_rsd_ok_mask = rsd_ok_mask;
+}
+
+void mock_qspi_set_quad_min_sckdv(uint32_t min_sckdv)
+{
+    quad_min_sckdv = min_sckdv;
+}
+
+void mock_qspi_set_register_value(uint32_t val)
+{
+    register_value = val;
+}
+
+void mock_qspi_set_register(volatile uint32_t* reg, uint32_t val)
+{
+    if(num_regs < MAX_REGISTERS)
+    {
+        reg_address[num_regs] = reg;
+        reg_value[num_regs] = val;
+        num_regs++;
+    }
+}
+
+uint32_t mock_qspi_get_last_write_to(volatile uint32_t* reg)
+{
+    uint32_t i;
+    for(i = num_writes; i > 0; i--)
+    {
+        if(reg == write_address[i - 1])
+        {
+            return i - 1;
+        }
+    }
+    return MOCK_QSPI_MAX_WRITES;
+}
+
+uint32_t mock_qspi_get_num_writes(void)
+{
+    return num_writes;
+}
+
+volatile uint32_t* mock_qspi_get_write_address(uint32_t idx)
+{
+    return write_address[idx];
+}
+
+uint32_t mock_qspi_get_write_value(uint32_t idx)
+{
+    return write_value[idx];
+}
+
+uint32_t mock_qspi_get_num_command_bytes(void)
+{
+    return num_cmd_bytes;
+}
+
+uint8_t mock_qspi_get_command_byte(uint32_t idx)
+{
+    return cmd_bytes[idx];
+}
+
+void mock_qspi_set_sfdp(const uint8_t* table, uint32_t length)
+{
+    uint32_t i;
+    for(i = 0; (i < length) && (i < SFDP_SIZE); i++)
+    {
+        sfdp[i] = table[i];
+    }
+    sfdp_length = i;
+}
+
+uint8_t mock_qspi_get_flash_byte(uint32_t address)
+{
+    return (uint8_t)((address * 7) + 3);
+}
+
+uint32_t mock_qspi_get_num_commands(void)
+{
+    return num_commands;
+}
+
+uint8_t mock_qspi_get_command(uint32_t idx)
+{
+    return commands[idx];
+}
+
+uint32_t mock_qspi_get_max_rx_fifo_level(void)
+{
+    return max_rx_level;
+}
+
+uint32_t mock_qspi_get_rx_fifo_level(void)
+{
+    return rx_level;
+}
+
+static uint32_t get_command_address(void)
+{
+    return ((uint32_t)cmd_bytes[1] << 16) | ((uint32_t)cmd_bytes[2] << 8) | cmd_bytes[3];
+}
+
+static bool too_fast(uint32_t min_sckdv)
+{
+    // with slow clocks the sample delay does not matter
+    return (ssi_sckdv < min_sckdv)
+        || ((ssi_sckdv < 16) && (0 == (jedec_rsd_ok_mask & (1u << ssi_rsd))));
+}
+
+static void push_rx_byte(uint8_t data)
+{
+    if(rx_level < sizeof(rx_fifo))
+    {
+        rx_fifo[rx_level] = data;
+        rx_level++;
+        if(rx_level > max_rx_level)
+        {
+            max_rx_level = rx_level;
+        }
+    }
+}
+
+// RX only mode: the command and the address word do not create received
+// bytes, after the address word the SSI reads CTRLR1 + 1 data frames.
+static void quad_read(uint32_t address_word)
+{
+    uint32_t i;
+    uint32_t address = address_word >> 8;
+    for(i = 0; i <= num_rx_frames; i++)
+    {
+        uint8_t data = mock_qspi_get_flash_byte(address + i);
+        if(true == too_fast((jedec_min_sckdv > quad_min_sckdv) ? jedec_min_sckdv : quad_min_sckdv))
+        {
+            data = data ^ 0x55;
+        }
+        push_rx_byte(data);
+    }
+}
+
+static uint8_t get_miso_byte(void)
+{
+    if((1 < num_cmd_bytes) && (FLASHCMD_READ_STATUS == cmd_bytes[0]))
+    {
+        uint8_t res = 0xff;
+        if(0 < num_status)
+        {
+            res = status_values[status_idx];
+            if(status_idx < (num_status - 1))
+            {
+                status_idx++;
+            }
+        }
+        return res;
+    }
+    if((1 < num_cmd_bytes) && (4 >= num_cmd_bytes) && (0x9f == cmd_bytes[0]))
+    {
+        uint8_t res = (uint8_t)(jedec_id >> (8 * (4 - num_cmd_bytes)));
+        if(true == too_fast(jedec_min_sckdv))
+        {
+            res = res ^ 0x55;
+        }
+        return res;
+    }
+    if((4 < num_cmd_bytes) && (FLASHCMD_READ_DATA == cmd_bytes[0]))
+    {
+        // command, 3 address bytes, data
+        return mock_qspi_get_flash_byte(get_command_address() + num_cmd_bytes - 5);
+    }
+    if((5 < num_cmd_bytes) && (0x5a == cmd_bytes[0]))
+    {
+        // command, 3 address bytes, dummy byte, data
+        uint32_t address = get_command_address() + num_cmd_bytes - 6;
+        if(address < sfdp_length)
+        {
+            return sfdp[address];
+        }
+        return 0xff;
+    }
+    return 0;
+}
+
+Result step_write_ap(volatile uint32_t* address, uint32_t data)
+{
+    if(num_writes < MOCK_QSPI_MAX_WRITES)
+    {
+        write_address[num_writes] = address;
+        write_value[num_writes] = data;
+        num_writes++;
+    }
+    if(&(IO_QSPI->GPIO_QSPI_SS_CTRL) == address)
+    {
+        if((2 << IO_QSPI_GPIO_QSPI_SS_CTRL_OUTOVER_OFFSET) == data)
+        {
+            // /CS low -> new command
+            num_cmd_bytes = 0;
+        }
+    }
+    if(&(XIP_SSI->BAUDR) == address)
+    {
+        ssi_sckdv = data;
+    }
+    if(&(XIP_SSI->RX_SAMPLE_DLY) == address)
+    {
+        ssi_rsd = data;
+    }
+    if(&(XIP_SSI->CTRLR[0]) == address)
+    {
+        rx_only = (XIP_SSI_CTRLR0_TMOD_RX_ONLY == ((data & XIP_SSI_CTRLR0_TMOD_MASK) >> XIP_SSI_CTRLR0_TMOD_OFFSET));
+    }
+    if(&(XIP_SSI->CTRLR[1]) == address)
+    {
+        num_rx_frames = data;
+    }
+    if(&(XIP_SSI->DR0) == address)
+    {
+        if(num_cmd_bytes < CMD_BUFFER_SIZE)
+        {
+            cmd_bytes[num_cmd_bytes] = (uint8_t)data;
+            num_cmd_bytes++;
+        }
+        if((1 == num_cmd_bytes) && (num_commands < MAX_COMMANDS))
+        {
+            commands[num_commands] = (uint8_t)data;
+            num_commands++;
+        }
+        if(false == rx_only)
+        {
+            push_rx_byte(get_miso_byte());
+        }
+        else if(2 == num_cmd_bytes)
+        {
+            quad_read(data);
+        }
+    }
+    return RESULT_OK;
+}
+
+Result act_read_register(activity_data_typ* state, volatile uint32_t* address, uint32_t* value)
+{
+    uint32_t i;
+    if(true == state->first_call)
+    {
+        // the SWD transaction takes some time
+        state->first_call = false;
+        return ERR_NOT_COMPLETED;
+    }
+    if(&(XIP_SSI->SR) == address)
+    {
+        *value = XIP_SSI_SR_TFE_MASK;  // TX FIFO empty and not busy
+    }
+    else if(&(XIP_SSI->RXFLR) == address)
+    {
+        *value = rx_level;
+    }
+    else if(&(XIP_SSI->DR0) == address)
+    {
+        if(0 == rx_level)
+        {
+            *value = 0;
+        }
+        else
+        {
+            *value = rx_fifo[0];
+            for(i = 1; i < rx_level; i++)
+            {
+                rx_fifo[i - 1] = rx_fifo[i];
+            }
+            rx_level--;
+        }
+    }
+    else
+    {
+        *value = register_value;
+        for(i = 0; i < num_regs; i++)
+        {
+            if(reg_address[i] == address)
+            {
+                *value = reg_value[i];
+            }
+        }
+    }
+    return RESULT_OK;
+}
@@ -0,0 +1,55 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_QSPI_TARGET_H_
+#define MOCK_MOCK_QSPI_TARGET_H_
+
+#include <stdint.h>
+
+// simulates the SSI of the target and a flash chip connected to it.
+#define MOCK_QSPI_MAX_WRITES  1000
+
+void mock_qspi_init(void);
+// the values returned by the status register (one per read status command, the last one repeats)
+void mock_qspi_set_status(const uint8_t* status, uint32_t num);
+// JEDEC ID of the flash. It is only read correctly with a clock divider of at
+// least min_sckdv and a sample delay that has its bit set in rsd_ok_mask.
+// (The sample delay is ignored for clock dividers of 16 and more.)
+void mock_qspi_set_jedec_id(uint32_t id, uint32_t min_sckdv, uint32_t rsd_ok_mask);
+// quad reads (0xeb) need at least this clock divider (and the limits of the JEDEC ID read)
+void mock_qspi_set_quad_min_sckdv(uint32_t min_sckdv);
+// value returned when reading registers other than the SSI
+void mock_qspi_set_register_value(uint32_t val);
+// value returned when reading this register (overrides mock_qspi_set_register_value())
+void mock_qspi_set_register(volatile uint32_t* reg, uint32_t val);
+// index of the last write to the register, MOCK_QSPI_MAX_WRITES if it was not written
+uint32_t mock_qspi_get_last_write_to(volatile uint32_t* reg);
+uint32_t mock_qspi_get_num_writes(void);
+volatile uint32_t* mock_qspi_get_write_address(uint32_t idx);
+uint32_t mock_qspi_get_write_value(uint32_t idx);
+// number of bytes sent to DR0 after /CS went low
+uint32_t mock_qspi_get_num_command_bytes(void);
+uint8_t mock_qspi_get_command_byte(uint32_t idx);
+// first bytes of the commands sent since mock_qspi_init()
+uint32_t mock_qspi_get_num_commands(void);
+uint8_t mock_qspi_get_command(uint32_t idx);
+// SFDP table of the flash (none after mock_qspi_init())
+void mock_qspi_set_sfdp(const uint8_t* table, uint32_t length);
+// content of the flash (a pattern)
+uint8_t mock_qspi_get_flash_byte(uint32_t address);
+uint32_t mock_qspi_get_max_rx_fifo_level(void);
+uint32_t mock_qspi_get_rx_fifo_level(void);
+
+#endif /* MOCK_MOCK_QSPI_TARGET_H_ */
@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "mock_read_fifo.h"
+
+static uint32_t fifo[MOCK_READ_FIFO_SIZE];
+static uint32_t level;
+static uint32_t max_level;
+
+void mock_read_fifo_init(void)
+{
+    level = 0;
+    max_level = 0;
+}
+
+Result mock_read_fifo_push(uint32_t value)
+{
+    if(MOCK_READ_FIFO_SIZE == level)
+    {
+        // queue full
+        return ERR_NOT_COMPLETED;
+    }
+    fifo[level] = value;
+    level++;
+    if(level > max_level)
+    {
+        max_level = level;
+    }
+    return RESULT_OK;
+}
+
+Result mock_read_fifo_pop(uint32_t* value)
+{
+    uint32_t i;
+    if(0 == level)
+    {
+        return ERR_WRONG_STATE;
+    }
+    *value = fifo[0];
+    for(i = 1; i < level; i++)
+    {
+        fifo[i - 1] = fifo[i];
+    }
+    level--;
+    return RESULT_OK;
+}
+
+uint32_t mock_read_fifo_get_max_level(void)
+{
+    return max_level;
+}
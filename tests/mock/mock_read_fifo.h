@@ -0,0 +1,34 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_READ_FIFO_H_
+#define MOCK_MOCK_READ_FIFO_H_
+
+#include <stdint.h>
+#include "probe_api/result.h"
+
+// results of the queued step_read_ap() calls of the target mocks
+
+#define MOCK_READ_FIFO_SIZE  8
+
+void mock_read_fifo_init(void);
+// ERR_NOT_COMPLETED if the queue is full
+Result mock_read_fifo_push(uint32_t value);
+// ERR_WRONG_STATE if no read was queued
+Result mock_read_fifo_pop(uint32_t* value);
+// highest number of reads that were queued at the same time
+uint32_t mock_read_fifo_get_max_level(void);
+
+#endif /* MOCK_MOCK_READ_FIFO_H_ */
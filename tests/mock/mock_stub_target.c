@@ -0,0 +1,458 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "hal/hw/DMA.h"
+#include "hal/hw/RESETS.h"
+#include "mock_stub_target.h"
+#include "mock_read_fifo.h"
+
+#define RAM_START  0x20040000
+#define RAM_SIZE   (8 * 1024)
+#define DHCSR_ADDRESS  ((volatile uint32_t*)0xe000edf0)
+#define DCRSR_ADDRESS  ((volatile uint32_t*)0xe000edf4)
+#define DCRDR_ADDRESS  ((volatile uint32_t*)0xe000edf8)
+#define DHCSR_C_HALT   (1u << 1)
+#define DHCSR_C_MASKINTS (1u << 3)
+#define DHCSR_S_HALT   (1u << 17)
+// S_REGRDY, S_HALT, C_HALT, C_DEBUGEN
+#define DHCSR_HALTED   0x00030003
+#define DCRSR_REGWNR   (1u << 16)
+#define REGSEL_PC      15
+#define NUM_CORE_REGS  21
+#define NUM_CORES      2
+#define RESETS_RESET_SET_ADDRESS  ((volatile uint32_t*)((volatile uint8_t*)&(RESETS->RESET) + 0x2000))
+#define RESETS_RESET_CLR_ADDRESS  ((volatile uint32_t*)((volatile uint8_t*)&(RESETS->RESET) + 0x3000))
+
+static uint8_t ram[RAM_SIZE];
+static uint32_t num_writes;
+static bool dma_in_reset;
+static uint32_t sniff_data;
+static uint32_t sniff_ctrl;
+static uint32_t read_addr;
+static uint32_t write_addr;
+static uint32_t trans_count;
+static uint32_t dma_ctrl;
+static uint32_t busy_reads;
+static uint32_t num_reads;
+static uint32_t dhcsr[NUM_CORES];
+static uint32_t connected_core;
+static bool switch_pending;
+static uint32_t num_switches;
+static uint32_t dcrdr;
+static uint32_t core_regs[NUM_CORE_REGS];
+static uint32_t call_regs[NUM_CORE_REGS];
+static uint32_t num_calls;
+static bool maskints;
+static bool call_masked;
+static bool maskints_error;
+
+void mock_stub_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < RAM_SIZE; i++)
+    {
+        ram[i] = 0x55;
+    }
+    num_writes = 0;
+    dma_in_reset = true;
+    sniff_data = 0;
+    sniff_ctrl = 0;
+    read_addr = 0;
+    write_addr = 0;
+    trans_count = 0;
+    dma_ctrl = 0;
+    busy_reads = 0;
+    mock_read_fifo_init();
+    num_reads = 0;
+    dhcsr[0] = 0;
+    dhcsr[1] = 0;
+    connected_core = 0;
+    switch_pending = false;
+    num_switches = 0;
+    dcrdr = 0;
+    for(i = 0; i < NUM_CORE_REGS; i++)
+    {
+        core_regs[i] = 0;
+        call_regs[i] = 0;
+    }
+    num_calls = 0;
+    maskints = false;
+    call_masked = false;
+    maskints_error = false;
+}
+
+uint8_t mock_stub_get_ram_byte(uint32_t address)
+{
+    return ram[address - RAM_START];
+}
+
+void mock_stub_set_ram_byte(uint32_t address, uint8_t value)
+{
+    ram[address - RAM_START] = value;
+}
+
+uint32_t mock_stub_get_num_writes(void)
+{
+    return num_writes;
+}
+
+uint32_t mock_stub_get_num_reads(void)
+{
+    return num_reads;
+}
+
+void mock_stub_set_dhcsr(uint32_t value)
+{
+    dhcsr[0] = value;
+    dhcsr[1] = value;
+}
+
+void mock_stub_set_core_dhcsr(uint32_t core, uint32_t value)
+{
+    dhcsr[core] = value;
+}
+
+uint32_t mock_stub_get_connected_core(void)
+{
+    return connected_core;
+}
+
+uint32_t mock_stub_get_num_switches(void)
+{
+    return num_switches;
+}
+
+void mock_stub_set_dma_channel(uint32_t read, uint32_t write, uint32_t count, uint32_t ctrl)
+{
+    dma_in_reset = false;
+    read_addr = read;
+    write_addr = write;
+    trans_count = count;
+    dma_ctrl = ctrl;
+}
+
+bool mock_stub_is_dma_in_reset(void)
+{
+    return dma_in_reset;
+}
+
+void mock_stub_get_dma_channel(uint32_t* read, uint32_t* write, uint32_t* count, uint32_t* ctrl)
+{
+    *read = read_addr;
+    *write = write_addr;
+    *count = trans_count;
+    *ctrl = dma_ctrl;
+}
+
+uint32_t mock_stub_get_sniff_ctrl(void)
+{
+    return sniff_ctrl;
+}
+
+uint32_t mock_stub_get_num_calls(void)
+{
+    return num_calls;
+}
+
+uint32_t mock_stub_get_core_register(uint32_t regsel)
+{
+    return core_regs[regsel];
+}
+
+uint32_t mock_stub_get_call_register(uint32_t regsel)
+{
+    return call_regs[regsel];
+}
+
+void mock_stub_set_core_register(uint32_t regsel, uint32_t value)
+{
+    core_regs[regsel] = value;
+}
+
+bool mock_stub_call_was_masked(void)
+{
+    return call_masked;
+}
+
+bool mock_stub_is_maskints(void)
+{
+    return maskints;
+}
+
+bool mock_stub_get_maskints_error(void)
+{
+    return maskints_error;
+}
+
+void mock_stub_set_dma_busy(uint32_t reads)
+{
+    busy_reads = reads;
+}
+
+uint32_t mock_stub_get_max_reads_in_flight(void)
+{
+    return mock_read_fifo_get_max_level();
+}
+
+static uint32_t read_ram_word(uint32_t addr)
+{
+    if((addr >= RAM_START) && (addr < (RAM_START + RAM_SIZE)))
+    {
+        return (uint32_t)ram[addr - RAM_START]
+             | ((uint32_t)ram[addr - RAM_START + 1] << 8)
+             | ((uint32_t)ram[addr - RAM_START + 2] << 16)
+             | ((uint32_t)ram[addr - RAM_START + 3] << 24);
+    }
+    return 0;
+}
+
+static void run_dma(void)
+{
+    uint32_t i;
+    uint32_t crc = sniff_data;
+    uint32_t bit;
+
+    if((true == dma_in_reset) || (0 == (sniff_ctrl & DMA_SNIFF_CTRL_EN_MASK)))
+    {
+        return;
+    }
+    for(i = 0; i < trans_count; i++)
+    {
+        crc = crc ^ ((uint32_t)ram[read_addr + i - RAM_START] << 24);
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (0 != (crc & 0x80000000)) ? ((crc << 1) ^ 0x04c11db7) : (crc << 1);
+        }
+    }
+    sniff_data = crc;
+    // the byte transfers need some time
+    busy_reads = 2;
+}
+
+Result step_write_ap(volatile uint32_t* address, uint32_t data)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)address;
+    num_writes++;
+    if((addr >= RAM_START) && (addr < (RAM_START + RAM_SIZE)))
+    {
+        ram[addr - RAM_START] = (uint8_t)(data & 0xff);
+        ram[addr - RAM_START + 1] = (uint8_t)((data >> 8) & 0xff);
+        ram[addr - RAM_START + 2] = (uint8_t)((data >> 16) & 0xff);
+        ram[addr - RAM_START + 3] = (uint8_t)((data >> 24) & 0xff);
+    }
+    else if(RESETS_RESET_CLR_ADDRESS == address)
+    {
+        if(0 != (data & RESETS_RESET_DMA_MASK))
+        {
+            dma_in_reset = false;
+        }
+    }
+    else if(RESETS_RESET_SET_ADDRESS == address)
+    {
+        if(0 != (data & RESETS_RESET_DMA_MASK))
+        {
+            dma_in_reset = true;
+            sniff_data = 0;
+            sniff_ctrl = 0;
+            read_addr = 0;
+            write_addr = 0;
+            trans_count = 0;
+            dma_ctrl = 0;
+        }
+    }
+    else if(DHCSR_ADDRESS == address)
+    {
+        if((0 != (data & DHCSR_C_MASKINTS)) != maskints)
+        {
+            // C_MASKINTS must only change while the core is halted
+            if(0 == (dhcsr[connected_core] & DHCSR_S_HALT))
+            {
+                maskints_error = true;
+            }
+            maskints = (0 != (data & DHCSR_C_MASKINTS));
+        }
+        if(0 == (data & DHCSR_C_HALT))
+        {
+            // the stub runs until its breakpoint and uses some registers
+            uint32_t i;
+            num_calls++;
+            call_masked = maskints;
+            for(i = 0; i < NUM_CORE_REGS; i++)
+            {
+                call_regs[i] = core_regs[i];
+            }
+            for(i = 0; i < 13; i++)
+            {
+                core_regs[i] = 0xdead0000 + i;
+            }
+            core_regs[REGSEL_PC] = core_regs[REGSEL_PC] + 0x20;
+        }
+        dhcsr[connected_core] = DHCSR_HALTED;
+    }
+    else if(DCRDR_ADDRESS == address)
+    {
+        dcrdr = data;
+    }
+    else if(DCRSR_ADDRESS == address)
+    {
+        if((data & 0x1f) < NUM_CORE_REGS)
+        {
+            if(0 != (data & DCRSR_REGWNR))
+            {
+                core_regs[data & 0x1f] = dcrdr;
+            }
+            else
+            {
+                dcrdr = core_regs[data & 0x1f];
+            }
+        }
+    }
+    else if(&(DMA->SNIFF_DATA) == address)
+    {
+        sniff_data = data;
+    }
+    else if(&(DMA->SNIFF_CTRL) == address)
+    {
+        sniff_ctrl = data;
+    }
+    else if(&(DMA->CH10_READ_ADDR) == address)
+    {
+        read_addr = data;
+    }
+    else if(&(DMA->CH10_WRITE_ADDR) == address)
+    {
+        write_addr = data;
+    }
+    else if(&(DMA->CH10_TRANS_COUNT) == address)
+    {
+        trans_count = data;
+    }
+    else if(&(DMA->CH10_AL1_CTRL) == address)
+    {
+        dma_ctrl = data;
+    }
+    else if(&(DMA->CH10_CTRL_TRIG) == address)
+    {
+        dma_ctrl = data;
+        if(0 != (data & DMA_CH10_CTRL_TRIG_EN_MASK))
+        {
+            run_dma();
+        }
+    }
+    return RESULT_OK;
+}
+
+static uint32_t read_word(volatile uint32_t* address)
+{
+    uint32_t value;
+    if(&(DMA->CH10_CTRL_TRIG) == address)
+    {
+        value = dma_ctrl & ~DMA_CH10_CTRL_TRIG_BUSY_MASK;
+        if(0 < busy_reads)
+        {
+            busy_reads--;
+            value = value | DMA_CH10_CTRL_TRIG_BUSY_MASK;
+        }
+        return value;
+    }
+    if(&(DMA->SNIFF_DATA) == address)
+    {
+        return (true == dma_in_reset) ? 0 : sniff_data;
+    }
+    if(&(DMA->SNIFF_CTRL) == address)
+    {
+        return sniff_ctrl;
+    }
+    if(&(DMA->CH10_READ_ADDR) == address)
+    {
+        return read_addr;
+    }
+    if(&(DMA->CH10_WRITE_ADDR) == address)
+    {
+        return write_addr;
+    }
+    if(&(DMA->CH10_TRANS_COUNT) == address)
+    {
+        return trans_count;
+    }
+    if(&(RESETS->RESET) == address)
+    {
+        return (true == dma_in_reset) ? RESETS_RESET_DMA_MASK : 0;
+    }
+    if(DHCSR_ADDRESS == address)
+    {
+        return dhcsr[connected_core];
+    }
+    if(DCRDR_ADDRESS == address)
+    {
+        return dcrdr;
+    }
+    return read_ram_word((uint32_t)(uintptr_t)address);
+}
+
+Result act_read_register(activity_data_typ* state, volatile uint32_t* address, uint32_t* value)
+{
+    if(true == state->first_call)
+    {
+        // the SWD transaction takes some time
+        state->first_call = false;
+        return ERR_NOT_COMPLETED;
+    }
+    *value = read_word(address);
+    return RESULT_OK;
+}
+
+Result step_read_ap(volatile uint32_t* address)
+{
+    Result res = mock_read_fifo_push(read_word(address));
+    if(RESULT_OK == res)
+    {
+        num_reads++;
+    }
+    return res;
+}
+
+Result step_get_Result_data(uint32_t* data)
+{
+    return mock_read_fifo_pop(data);
+}
+
+Result step_get_Result_OK(void)
+{
+    return RESULT_OK;
+}
+
+Result swd_switch_core(uint32_t core_num)
+{
+    if(false == switch_pending)
+    {
+        // the connect takes some time
+        switch_pending = true;
+        return ERR_NOT_COMPLETED;
+    }
+    switch_pending = false;
+    connected_core = core_num;
+    num_switches++;
+    return RESULT_OK;
+}
+
+uint32_t swd_get_connected_core(void)
+{
+    return connected_core;
+}
@@ -0,0 +1,55 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_STUB_TARGET_H_
+#define MOCK_MOCK_STUB_TARGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// simulates the RAM of a RP2040 (SRAM4 and SRAM5), DMA channel 10 with the
+// sniffer and the core registers (a stub stops on its breakpoint at once).
+// DHCSR is per core, swd_switch_core() selects the core.
+void mock_stub_init(void);
+uint8_t mock_stub_get_ram_byte(uint32_t address);
+void mock_stub_set_ram_byte(uint32_t address, uint8_t value);
+uint32_t mock_stub_get_num_writes(void);
+uint32_t mock_stub_get_num_reads(void);
+uint32_t mock_stub_get_max_reads_in_flight(void);
+// value read from DHCSR of both cores (0 = core is running)
+void mock_stub_set_dhcsr(uint32_t value);
+void mock_stub_set_core_dhcsr(uint32_t core, uint32_t value);
+uint32_t mock_stub_get_connected_core(void);
+uint32_t mock_stub_get_num_switches(void);
+// the application uses DMA channel 10 (takes the DMA out of reset)
+void mock_stub_set_dma_channel(uint32_t read, uint32_t write, uint32_t count, uint32_t ctrl);
+void mock_stub_get_dma_channel(uint32_t* read, uint32_t* write, uint32_t* count, uint32_t* ctrl);
+bool mock_stub_is_dma_in_reset(void);
+uint32_t mock_stub_get_sniff_ctrl(void);
+// number of times the core was started
+uint32_t mock_stub_get_num_calls(void);
+uint32_t mock_stub_get_core_register(uint32_t regsel);
+void mock_stub_set_core_register(uint32_t regsel, uint32_t value);
+// value of the core register when the core was started the last time
+uint32_t mock_stub_get_call_register(uint32_t regsel);
+// C_MASKINTS was set when the core was started
+bool mock_stub_call_was_masked(void);
+bool mock_stub_is_maskints(void);
+// C_MASKINTS changed while the core was running
+bool mock_stub_get_maskints_error(void);
+// the application keeps DMA channel 10 busy for the next reads of its CTRL register
+void mock_stub_set_dma_busy(uint32_t reads);
+
+#endif /* MOCK_MOCK_STUB_TARGET_H_ */
@@ -0,0 +1,133 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "probe_api/activity.h"
+#include "probe_api/result.h"
+#include "mock_swd_target.h"
+
+static uint32_t clock_khz;
+static uint32_t max_error_free_khz;
+static uint32_t max_correct_data_khz;
+static uint32_t failing_read;
+static uint32_t num_reads;
+static bool sticky_error;
+static uint32_t num_recoveries;
+static bool recover_pending;
+
+void mock_swd_init(void)
+{
+    clock_khz = 0;
+    max_error_free_khz = 100000;
+    max_correct_data_khz = 100000;
+    failing_read = 0;
+    num_reads = 0;
+    sticky_error = false;
+    num_recoveries = 0;
+    recover_pending = false;
+}
+
+void mock_swd_set_max_error_free_khz(uint32_t khz)
+{
+    max_error_free_khz = khz;
+}
+
+void mock_swd_set_max_correct_data_khz(uint32_t khz)
+{
+    max_correct_data_khz = khz;
+}
+
+void mock_swd_set_failing_read(uint32_t num)
+{
+    failing_read = num;
+}
+
+uint32_t mock_swd_get_clock_khz(void)
+{
+    return clock_khz;
+}
+
+uint32_t mock_swd_get_num_reads(void)
+{
+    return num_reads;
+}
+
+uint32_t mock_swd_get_num_recoveries(void)
+{
+    return num_recoveries;
+}
+
+void swd_set_clock_khz(uint32_t khz)
+{
+    clock_khz = khz;
+}
+
+Result swd_link_recover(void)
+{
+    if(false == recover_pending)
+    {
+        // the connect takes some time
+        recover_pending = true;
+        return ERR_NOT_COMPLETED;
+    }
+    recover_pending = false;
+    if(clock_khz > max_error_free_khz)
+    {
+        return ERR_TARGET_ERROR;
+    }
+    sticky_error = false;
+    num_recoveries++;
+    return RESULT_OK;
+}
+
+Result act_read_register(activity_data_typ* state, volatile uint32_t* address, uint32_t* value)
+{
+    if(true == state->first_call)
+    {
+        // the SWD transaction takes some time
+        state->first_call = false;
+        return ERR_NOT_COMPLETED;
+    }
+    num_reads++;
+    if(true == sticky_error)
+    {
+        // FAULT until the sticky error gets cleared
+        return ERR_TARGET_ERROR;
+    }
+    if((clock_khz > max_error_free_khz) || (failing_read == num_reads))
+    {
+        // parity error
+        sticky_error = true;
+        return ERR_TARGET_ERROR;
+    }
+    if((volatile uint32_t*)0x40000000 == address)
+    {
+        *value = 0x20002927;  // CHIP_ID (B2)
+    }
+    else if((volatile uint32_t*)0x00000010 == address)
+    {
+        *value = 0x0301754d;  // ROM magic + version 3
+    }
+    else
+    {
+        *value = 0;
+    }
+    if(clock_khz > max_correct_data_khz)
+    {
+        *value = *value ^ 0x00000100;
+    }
+    return RESULT_OK;
+}
@@ -0,0 +1,35 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef MOCK_MOCK_SWD_TARGET_H_
+#define MOCK_MOCK_SWD_TARGET_H_
+
+#include <stdint.h>
+
+// simulates a RP2040 connected with a cable that only works up to a maximum SWCLK.
+// After a failed read all reads fail until swd_link_recover() connected again on a
+// clock that works.
+void mock_swd_init(void);
+// reads above this clock fail with an error (0 = all reads fail)
+void mock_swd_set_max_error_free_khz(uint32_t khz);
+// reads above this clock return corrupted data (0 = all reads are corrupted)
+void mock_swd_set_max_correct_data_khz(uint32_t khz);
+// the read with this number fails, independent of the clock (0 = no failing read)
+void mock_swd_set_failing_read(uint32_t num);
+uint32_t mock_swd_get_clock_khz(void);
+uint32_t mock_swd_get_num_reads(void);
+uint32_t mock_swd_get_num_recoveries(void);
+
+#endif /* MOCK_MOCK_SWD_TARGET_H_ */
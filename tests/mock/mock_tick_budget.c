@@ -0,0 +1,31 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "tick_budget.h"
+
+// no budget -> the state machines do one phase per call
+
+void tick_budget_start(void)
+{
+
+}
+
+bool tick_budget_continue(Result res, uint32_t phase_before, uint32_t phase_after)
+{
+    (void)res;
+    (void)phase_before;
+    (void)phase_after;
+    return false;
+}
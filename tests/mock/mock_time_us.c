@@ -0,0 +1,35 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdint.h>
+#include "time_us.h"
+#include "mock_time_us.h"
+
+static uint32_t now;
+
+void set_time_us(uint32_t val)
+{
+    now = val;
+}
+
+void advance_time_us(uint32_t val)
+{
+    now = now + val;
+}
+
+uint32_t time_us_now(void)
+{
+    return now;
+}
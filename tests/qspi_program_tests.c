@@ -0,0 +1,766 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "unity.h"
+#include "qspi_program.h"
+#include "flash_actions.h"
+#include "hal/hw/CLOCKS.h"
+#include "hal/hw/DMA.h"
+#include "hal/hw/RESETS.h"
+#include "hal/hw/XIP_CTRL.h"
+#include "hal/hw/XIP_SSI.h"
+#include "hal/hw/XOSC.h"
+#include "hal/qspi_flash.h"
+#include "mock/mock_qspi_target.h"
+
+#define MAX_CALLS  10000
+
+static qspi_program_typ prog;
+static uint32_t reg_a;
+static uint32_t reg_b;
+
+static Result run_until_done(qspi_program_typ* p)
+{
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = qspi_program_run(p);
+    }
+    return res;
+}
+
+static Result run_erase(uint32_t address)
+{
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_erase_4kb(&state, address);
+    }
+    return res;
+}
+
+static Result run_initialize(void)
+{
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    // all polls of the clock boost succeed, except for the reset
+    mock_qspi_set_register_value(0xffffffff);
+    mock_qspi_set_register(&(RESETS->RESET), 0);
+    mock_qspi_set_register(&(DMA->CH11_CTRL_TRIG), 0);
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_initialize(&state);
+    }
+    return res;
+}
+
+static uint32_t get_last_value_of(volatile uint32_t* reg)
+{
+    uint32_t idx = mock_qspi_get_last_write_to(reg);
+    TEST_ASSERT_TRUE(MOCK_QSPI_MAX_WRITES > idx);
+    return mock_qspi_get_write_value(idx);
+}
+
+void setUp(void)
+{
+    mock_qspi_init();
+    flash_actions_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_program_end(void)
+{
+    // Objective: an empty program finishes at once
+    static const qspi_op_typ program[] = {
+        {QOP_END, NULL, 0, 0},
+    };
+    qspi_program_start(&prog, program);
+    TEST_ASSERT_EQUAL(RESULT_OK, qspi_program_step(&prog));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_num_writes());
+}
+
+void test_program_write(void)
+{
+    // Objective: writes are done in order, one per step
+    static const qspi_op_typ program[] = {
+        {QOP_WRITE, (volatile uint32_t*)&reg_a, 0x12, 0},
+        {QOP_WRITE, (volatile uint32_t*)&reg_b, 0x34, 0},
+        {QOP_END, NULL, 0, 0},
+    };
+    qspi_program_start(&prog, program);
+    TEST_ASSERT_EQUAL(ERR_NOT_COMPLETED, qspi_program_step(&prog));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    TEST_ASSERT_EQUAL_UINT32(2, mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_PTR(&reg_a, mock_qspi_get_write_address(0));
+    TEST_ASSERT_EQUAL_UINT32(0x12, mock_qspi_get_write_value(0));
+    TEST_ASSERT_EQUAL_PTR(&reg_b, mock_qspi_get_write_address(1));
+    TEST_ASSERT_EQUAL_UINT32(0x34, mock_qspi_get_write_value(1));
+}
+
+void test_program_accumulator(void)
+{
+    // Objective: read modify write sequences use the read value
+    static const qspi_op_typ program[] = {
+        {QOP_READ_ACC, (volatile uint32_t*)&reg_a, 0, 0},
+        {QOP_WRITE_ACC_SET, (volatile uint32_t*)&reg_a, 0, 0x0f},
+        {QOP_WRITE_ACC_CLR, (volatile uint32_t*)&reg_a, 0, 0x03},
+        {QOP_END, NULL, 0, 0},
+    };
+    mock_qspi_set_register_value(0x100);
+    qspi_program_start(&prog, program);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    TEST_ASSERT_EQUAL_UINT32(2, mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_UINT32(0x10f, mock_qspi_get_write_value(0));
+    TEST_ASSERT_EQUAL_UINT32(0x10c, mock_qspi_get_write_value(1));
+}
+
+void test_program_poll(void)
+{
+    // Objective: poll reads until the masked value matches
+    static const qspi_op_typ program[] = {
+        {QOP_POLL, (volatile uint32_t*)&reg_a, 0x02, 0x03},
+        {QOP_END, NULL, 0, 0},
+    };
+    uint32_t i;
+    mock_qspi_set_register_value(0x01);
+    qspi_program_start(&prog, program);
+    for(i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL(ERR_NOT_COMPLETED, qspi_program_run(&prog));
+    }
+    mock_qspi_set_register_value(0x06);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+}
+
+void test_program_send_and_drain(void)
+{
+    // Objective: all bytes sent are also read from the RX FIFO
+    static const qspi_op_typ program[] = {
+        {QOP_SEND, NULL, 0x9f, 0},
+        {QOP_SEND_PARAM, NULL, 1, 8},
+        {QOP_SEND_PARAM, NULL, 1, 0},
+        {QOP_DRAIN_RX, NULL, 0, 0},
+        {QOP_END, NULL, 0, 0},
+    };
+    qspi_program_start(&prog, program);
+    prog.param[1] = 0x1234;
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    TEST_ASSERT_EQUAL_UINT32(3, mock_qspi_get_num_command_bytes());
+    TEST_ASSERT_EQUAL_HEX8(0x9f, mock_qspi_get_command_byte(0));
+    TEST_ASSERT_EQUAL_HEX8(0x12, mock_qspi_get_command_byte(1));
+    TEST_ASSERT_EQUAL_HEX8(0x34, mock_qspi_get_command_byte(2));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_rx_fifo_level());
+}
+
+void test_program_poll_timeout(void)
+{
+    // Objective: a register that never gets the expected value is an error
+    static const qspi_op_typ program[] = {
+        {QOP_POLL, (volatile uint32_t*)&reg_a, 0x02, 0x03},
+        {QOP_END, NULL, 0, 0},
+    };
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    mock_qspi_set_register_value(0x01);
+    qspi_program_start(&prog, program);
+    for(i = 0; (i < 4 * QSPI_POLL_LIMIT) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = qspi_program_run(&prog);
+    }
+    TEST_ASSERT_EQUAL(ERR_TARGET_ERROR, res);
+}
+
+void test_program_busy_timeout(void)
+{
+    // Objective: a flash that stays busy is a timeout
+    static const qspi_op_typ program[] = {
+        {QOP_LOOP_WHILE_BUSY, NULL, 0, 0},
+        {QOP_END, NULL, 0, 0},
+    };
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    qspi_program_start(&prog, program);
+    prog.last_rx = STATUS_REGISTER_BUSY;
+    for(i = 0; (i < 4 * QSPI_BUSY_LIMIT) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = qspi_program_run(&prog);
+    }
+    TEST_ASSERT_EQUAL(ERR_TIMEOUT, res);
+}
+
+void test_program_save_restore(void)
+{
+    // Objective: saved values survive the start of the next program
+    static const qspi_op_typ save[] = {
+        {QOP_SAVE, (volatile uint32_t*)&reg_a, 3, 0},
+        {QOP_END, NULL, 0, 0},
+    };
+    static const qspi_op_typ restore[] = {
+        {QOP_WRITE, (volatile uint32_t*)&reg_a, 0, 0},
+        {QOP_RESTORE, (volatile uint32_t*)&reg_a, 3, 0xffffffff},
+        {QOP_RESTORE, (volatile uint32_t*)&reg_b, 3, 0x0f},
+        {QOP_END, NULL, 0, 0},
+    };
+    mock_qspi_set_register_value(0x1234);
+    qspi_program_start(&prog, save);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    mock_qspi_set_register_value(0);
+    qspi_program_start(&prog, restore);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    TEST_ASSERT_EQUAL_UINT32(3, mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_UINT32(0x1234, mock_qspi_get_write_value(1));
+    TEST_ASSERT_EQUAL_PTR(&reg_b, mock_qspi_get_write_address(2));
+    TEST_ASSERT_EQUAL_UINT32(0x4, mock_qspi_get_write_value(2));
+}
+
+void test_program_skip_if_saved(void)
+{
+    // Objective: the operation after a skip only runs if the saved bits are clear
+    static const qspi_op_typ program[] = {
+        {QOP_SAVE, (volatile uint32_t*)&reg_a, 2, 0},
+        {QOP_SKIP_IF_SAVED, NULL, 2, 0x01},
+        {QOP_WRITE, (volatile uint32_t*)&reg_a, 0x12, 0},
+        {QOP_SKIP_IF_SAVED, NULL, 2, 0x02},
+        {QOP_WRITE, (volatile uint32_t*)&reg_b, 0x34, 0},
+        {QOP_END, NULL, 0, 0},
+    };
+    mock_qspi_set_register_value(0x01);
+    qspi_program_start(&prog, program);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_until_done(&prog));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_PTR(&reg_b, mock_qspi_get_write_address(0));
+}
+
+void test_flash_clock_boost_and_restore(void)
+{
+    // Objective: initialize switches the target to the PLL, enter XIP restores the original clocks
+    const uint8_t status[] = {0};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    uint32_t idx;
+
+    // all polls succeed, except for the reset
+    mock_qspi_set_register_value(0xffffffff);
+    mock_qspi_set_register(&(RESETS->RESET), 0);
+    mock_qspi_set_register(&(DMA->CH11_CTRL_TRIG), 0);
+    mock_qspi_set_register(&(XOSC->CTRL), XOSC_CTRL_FREQ_RANGE_1_15MHZ);
+    mock_qspi_set_register(&(CLOCKS->CLK_SYS_CTRL), 0);
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_initialize(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    // clk_sys now runs from the PLL
+    idx = mock_qspi_get_last_write_to(&(CLOCKS->CLK_SYS_CTRL));
+    TEST_ASSERT_TRUE(MOCK_QSPI_MAX_WRITES > idx);
+    TEST_ASSERT_EQUAL_UINT32(CLOCKS_CLK_SYS_CTRL_SRC_clksrc_clk_sys_aux, mock_qspi_get_write_value(idx) & CLOCKS_CLK_SYS_CTRL_SRC_MASK);
+    // the SSI was configured after the clock change
+    TEST_ASSERT_TRUE(idx < mock_qspi_get_last_write_to(&(XIP_SSI->BAUDR)));
+
+    res = ERR_NOT_COMPLETED;
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_enter_XIP(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    // the saved values are back
+    idx = mock_qspi_get_last_write_to(&(XOSC->CTRL));
+    TEST_ASSERT_EQUAL_UINT32(XOSC_CTRL_FREQ_RANGE_1_15MHZ, mock_qspi_get_write_value(idx));
+    idx = mock_qspi_get_last_write_to(&(CLOCKS->CLK_SYS_CTRL));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_write_value(idx));
+    // the clocks are restored after the XIP setup
+    TEST_ASSERT_TRUE(idx > mock_qspi_get_last_write_to(&(XIP_SSI->SPI_CTRLR0)));
+}
+
+void test_flash_clock_boost_after_re_init(void)
+{
+    // Objective: after a re init (target reset) the clocks are boosted again
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    flash_actions_init();
+    mock_qspi_init();
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_TRUE(MOCK_QSPI_MAX_WRITES > mock_qspi_get_last_write_to(&(CLOCKS->CLK_SYS_CTRL)));
+}
+
+void test_flash_ssi_calibration(void)
+{
+    // Objective: the fastest clock divider with a working sample delay window is used
+    mock_qspi_set_jedec_id(0xef4015, 4, 0x06);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(4, get_last_value_of(&(XIP_SSI->BAUDR)));
+    TEST_ASSERT_EQUAL_UINT32(1, get_last_value_of(&(XIP_SSI->RX_SAMPLE_DLY)));
+}
+
+void test_flash_ssi_calibration_needs_margin(void)
+{
+    // Objective: a single working sample delay is not enough
+    mock_qspi_set_jedec_id(0xef4015, 2, 0x08);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(8, get_last_value_of(&(XIP_SSI->BAUDR)));
+    TEST_ASSERT_EQUAL_UINT32(1, get_last_value_of(&(XIP_SSI->RX_SAMPLE_DLY)));
+}
+
+void test_flash_ssi_calibration_no_id(void)
+{
+    // Objective: without a JEDEC ID the default setting is used
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(8, get_last_value_of(&(XIP_SSI->BAUDR)));
+}
+
+void test_flash_ssi_calibration_cached(void)
+{
+    // Objective: the second initialize uses the result of the first one
+    uint32_t writes;
+    mock_qspi_set_jedec_id(0xef4015, 2, 0x03);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    writes = mock_qspi_get_num_writes();
+    TEST_ASSERT_EQUAL_UINT32(2, get_last_value_of(&(XIP_SSI->BAUDR)));
+    TEST_ASSERT_EQUAL_UINT32(0, get_last_value_of(&(XIP_SSI->RX_SAMPLE_DLY)));
+    mock_qspi_init();
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_TRUE(writes > mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_UINT32(2, get_last_value_of(&(XIP_SSI->BAUDR)));
+}
+
+void test_flash_ssi_calibration_quad_read(void)
+{
+    // Objective: a setting that reads the ID but fails the quad read is not used
+    mock_qspi_set_jedec_id(0xef4015, 2, 0x03);
+    mock_qspi_set_quad_min_sckdv(4);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(8, get_last_value_of(&(XIP_SSI->BAUDR)));
+    TEST_ASSERT_EQUAL_UINT32(1, get_last_value_of(&(XIP_SSI->RX_SAMPLE_DLY)));
+}
+
+void test_flash_ssi_calibration_clock_changed(void)
+{
+    // Objective: the cached setting is not used if clk_sys runs from a different configuration
+    uint32_t writes;
+    mock_qspi_set_jedec_id(0xef4015, 2, 0x03);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    writes = mock_qspi_get_num_writes();
+    mock_qspi_init();
+    mock_qspi_set_jedec_id(0xef4015, 4, 0x03);
+    mock_qspi_set_register(&(CLOCKS->CLK_SYS_DIV), 2 << CLOCKS_CLK_SYS_DIV_INT_OFFSET);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_TRUE(writes <= mock_qspi_get_num_writes());
+    TEST_ASSERT_EQUAL_UINT32(4, get_last_value_of(&(XIP_SSI->BAUDR)));
+}
+
+#ifdef FEAT_PIPELINED_FLASH
+void test_flash_erase(void)
+{
+    // Objective: erase waits for the previous operation, sends write enable and the erase command
+    const uint8_t status[] = {STATUS_REGISTER_BUSY, STATUS_REGISTER_BUSY, 0};
+    mock_qspi_set_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL(RESULT_OK, run_erase(0x10123000));
+    // last command was the erase, the flash is still busy with it
+    TEST_ASSERT_EQUAL_HEX8(FLASHCMD_SECTOR_ERASE, mock_qspi_get_command_byte(0));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_rx_fifo_level());
+}
+#else
+void test_flash_erase(void)
+{
+    // Objective: erase sends write enable, the erase command and waits for the flash
+    const uint8_t status[] = {STATUS_REGISTER_BUSY, STATUS_REGISTER_BUSY, 0};
+    mock_qspi_set_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL(RESULT_OK, run_erase(0x10123000));
+    // last command was the read status
+    TEST_ASSERT_EQUAL_HEX8(FLASHCMD_READ_STATUS, mock_qspi_get_command_byte(0));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_rx_fifo_level());
+}
+#endif
+
+void test_flash_erase_no_flash(void)
+{
+    // Objective: a status of 0xff is reported as error
+    const uint8_t status[] = {0xff};
+    mock_qspi_set_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL(ERR_TARGET_ERROR, run_erase(0x10000000));
+}
+
+#ifdef FEAT_XIP_CACHE_STAGING
+void test_flash_write_page(void)
+{
+    // Objective: the data is uploaded to the XIP cache SRAM and the target DMA sends it
+    const uint8_t status[] = {STATUS_REGISTER_BUSY, 0};
+    flash_action_data_typ state;
+    uint8_t data[254];
+    uint32_t i;
+    uint32_t idx;
+    Result res = ERR_NOT_COMPLETED;
+
+    for(i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 3);
+    }
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_write_page(&state, 0x10004500, data, sizeof(data));
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    // the data words are the first writes
+    for(i = 0; i < (sizeof(data) + 3)/4; i++)
+    {
+        uint32_t expected = data[4*i] | ((uint32_t)data[4*i + 1] << 8);
+        if((4*i + 2) < sizeof(data))
+        {
+            expected = expected | ((uint32_t)data[4*i + 2] << 16) | ((uint32_t)data[4*i + 3] << 24);
+        }
+        TEST_ASSERT_EQUAL_PTR((volatile uint32_t*)0x15000000 + i, mock_qspi_get_write_address(i));
+        TEST_ASSERT_EQUAL_UINT32(expected, mock_qspi_get_write_value(i));
+    }
+    // the DMA got started with the length of the data
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), get_last_value_of(&(DMA->CH11_TRANS_COUNT)));
+    TEST_ASSERT_EQUAL_UINT32(0x15000000, get_last_value_of(&(DMA->CH11_READ_ADDR)));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&(XIP_SSI->DR0), get_last_value_of(&(DMA->CH11_WRITE_ADDR)));
+    idx = mock_qspi_get_last_write_to(&(DMA->CH11_CTRL_TRIG));
+    TEST_ASSERT_TRUE(MOCK_QSPI_MAX_WRITES > idx);
+    TEST_ASSERT_TRUE(idx > mock_qspi_get_last_write_to(&(DMA->CH11_TRANS_COUNT)));
+    // the SSI is back in TX and RX mode without DMA
+    TEST_ASSERT_EQUAL_UINT32(0, get_last_value_of(&(XIP_SSI->DMACR)));
+    TEST_ASSERT_EQUAL_UINT32(XIP_SSI_CTRLR0_TMOD_TX_AND_RX, (get_last_value_of(&(XIP_SSI->CTRLR[0])) & XIP_SSI_CTRLR0_TMOD_MASK) >> XIP_SSI_CTRLR0_TMOD_OFFSET);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_qspi_get_rx_fifo_level());
+}
+#else
+void test_flash_write_page(void)
+{
+    // Objective: all data bytes are sent without overflowing the RX FIFO
+    const uint8_t status[] = {STATUS_REGISTER_BUSY, 0};
+    flash_action_data_typ state;
+    uint8_t data[256];
+    uint32_t i;
+    uint32_t first_data_write = 0;
+    Result res = ERR_NOT_COMPLETED;
+
+    for(i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 3);
+    }
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_write_page(&state, 0x10004500, data, sizeof(data));
+        if((0 == first_data_write) && (4 == mock_qspi_get_num_command_bytes()) && (FLASHCMD_PAGE_PROGRAM == mock_qspi_get_command_byte(0)))
+        {
+            first_data_write = mock_qspi_get_num_writes();
+        }
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_TRUE(16 >= mock_qspi_get_max_rx_fifo_level());
+    TEST_ASSERT_TRUE(0 != first_data_write);
+    // the page program command with the data
+    for(i = 0; i < sizeof(data); i++)
+    {
+        TEST_ASSERT_EQUAL_PTR(&(XIP_SSI->DR0), mock_qspi_get_write_address(first_data_write + i));
+        TEST_ASSERT_EQUAL_UINT32(data[i], mock_qspi_get_write_value(first_data_write + i));
+    }
+}
+
+#endif
+
+#if defined(FEAT_PIPELINED_FLASH) && defined(FEAT_XIP_CACHE_STAGING)
+void test_flash_upload_while_busy(void)
+{
+    // Objective: the page is uploaded before the probe waits for the erase to finish
+    const uint8_t status_idle[] = {0};
+    const uint8_t status_busy[] = {STATUS_REGISTER_BUSY, STATUS_REGISTER_BUSY, 0};
+    flash_action_data_typ state;
+    uint8_t data[256];
+    uint32_t i;
+    uint32_t first_status_read = MOCK_QSPI_MAX_WRITES;
+    Result res = ERR_NOT_COMPLETED;
+
+    for(i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+    mock_qspi_set_status(status_idle, sizeof(status_idle));
+    TEST_ASSERT_EQUAL(RESULT_OK, run_erase(0x10004000));
+    // the flash is now busy erasing
+    mock_qspi_init();
+    mock_qspi_set_status(status_busy, sizeof(status_busy));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_write_page(&state, 0x10004000, data, sizeof(data));
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    for(i = 0; i < mock_qspi_get_num_writes(); i++)
+    {
+        if((&(XIP_SSI->DR0) == mock_qspi_get_write_address(i)) && (FLASHCMD_READ_STATUS == mock_qspi_get_write_value(i)))
+        {
+            first_status_read = i;
+            break;
+        }
+    }
+    // 64 words uploaded, /CS low, then polling the status, then the page program
+    TEST_ASSERT_EQUAL_UINT32(65, first_status_read);
+    TEST_ASSERT_TRUE(first_status_read < mock_qspi_get_last_write_to(&(DMA->CH11_CTRL_TRIG)));
+    TEST_ASSERT_EQUAL_HEX8(FLASHCMD_PAGE_PROGRAM, mock_qspi_get_command_byte(0));
+}
+#endif
+
+void test_flash_xip_ctrl_restored(void)
+{
+    // Objective: XIP_CTRL is disabled while programming and restored in XIP mode
+    const uint8_t status[] = {0};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    uint32_t idx;
+
+    mock_qspi_set_register(&(XIP_CTRL->CTRL), XIP_CTRL_CTRL_ERR_BADWRITE_MASK | XIP_CTRL_CTRL_EN_MASK);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(0, get_last_value_of(&(XIP_CTRL->CTRL)));
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_enter_XIP(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    idx = mock_qspi_get_last_write_to(&(XIP_CTRL->CTRL));
+    TEST_ASSERT_EQUAL_UINT32(XIP_CTRL_CTRL_ERR_BADWRITE_MASK | XIP_CTRL_CTRL_EN_MASK, mock_qspi_get_write_value(idx));
+    // restored after the cache flush
+    TEST_ASSERT_TRUE(idx > mock_qspi_get_last_write_to(&(XIP_CTRL->FLUSH)));
+}
+
+void test_flash_dma_and_ssi_restored(void)
+{
+    // Objective: enter XIP gives the SSI DMA settings, DMA channel 11 and the DMA reset back
+    const uint8_t status[] = {0};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+
+    mock_qspi_set_register(&(XIP_SSI->DMACR), XIP_SSI_DMACR_RDMAE_MASK);
+    mock_qspi_set_register(&(XIP_SSI->DMATDLR), 4);
+    mock_qspi_set_register(&(DMA->CH11_READ_ADDR), 0x20001000);
+    mock_qspi_set_register(&(DMA->CH11_AL1_CTRL), DMA_CH11_CTRL_TRIG_EN_MASK);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_EQUAL_UINT32(0, get_last_value_of(&(XIP_SSI->DMACR)));
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_enter_XIP(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_EQUAL_UINT32(XIP_SSI_DMACR_RDMAE_MASK, get_last_value_of(&(XIP_SSI->DMACR)));
+    TEST_ASSERT_EQUAL_UINT32(4, get_last_value_of(&(XIP_SSI->DMATDLR)));
+#ifdef FEAT_XIP_CACHE_STAGING
+    TEST_ASSERT_EQUAL_UINT32(0x20001000, get_last_value_of(&(DMA->CH11_READ_ADDR)));
+    TEST_ASSERT_EQUAL_UINT32(DMA_CH11_CTRL_TRIG_EN_MASK, get_last_value_of(&(DMA->CH11_AL1_CTRL)));
+    // the DMA was not in reset (RESETS->RESET reads 0)
+    TEST_ASSERT_EQUAL_UINT32(0, get_last_value_of((volatile uint32_t*)((volatile uint8_t*)&(RESETS->RESET) + 0x2000)));
+#endif
+}
+
+#ifdef FEAT_ERASE_SUSPEND
+// SFDP header, one parameter header (BFPT with 16 DWORDs at 0x30) and the BFPT
+static void set_sfdp(bool can_suspend)
+{
+    uint8_t table[0x70];
+    uint32_t i;
+    for(i = 0; i < sizeof(table); i++)
+    {
+        table[i] = 0xff;
+    }
+    table[0] = 'S';
+    table[1] = 'F';
+    table[2] = 'D';
+    table[3] = 'P';
+    table[8] = 0;      // JEDEC BFPT
+    table[11] = 16;    // DWORDs
+    table[12] = 0x30;  // pointer
+    table[13] = 0;
+    table[14] = 0;
+    // DWORD 12: bit 31 = 1 -> not supported
+    table[0x30 + 44 + 3] = (true == can_suspend) ? 0x7f : 0xff;
+    // DWORD 13: suspend 0xb0, resume 0x30
+    table[0x30 + 48 + 2] = 0x30;
+    table[0x30 + 48 + 3] = 0xb0;
+    mock_qspi_set_sfdp(table, sizeof(table));
+}
+
+static bool command_was_sent(uint8_t cmd)
+{
+    uint32_t i;
+    for(i = 0; i < mock_qspi_get_num_commands(); i++)
+    {
+        if(cmd == mock_qspi_get_command(i))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_flash_suspend_from_sfdp(void)
+{
+    // Objective: the suspend and resume commands come from the SFDP table
+    const uint8_t status[] = {0};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+
+    set_sfdp(true);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_TRUE(flash_can_suspend_erase());
+    mock_qspi_init();
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_erase_suspend(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_EQUAL_HEX8(0xb0, mock_qspi_get_command(0));
+    res = ERR_NOT_COMPLETED;
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_erase_resume(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_EQUAL_HEX8(0x30, mock_qspi_get_command(mock_qspi_get_num_commands() - 1));
+}
+
+void test_flash_suspend_not_supported(void)
+{
+    // Objective: no suspend without SFDP table or if the BFPT says so
+    flash_action_data_typ state;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_FALSE(flash_can_suspend_erase());
+    // checked only once
+    mock_qspi_init();
+    flash_actions_init();
+    set_sfdp(false);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_initialize());
+    TEST_ASSERT_TRUE(command_was_sent(0x5a));
+    TEST_ASSERT_FALSE(flash_can_suspend_erase());
+    state.first_call = true;
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, flash_erase_suspend(&state));
+}
+
+void test_flash_read_word(void)
+{
+    // Objective: the read waits for the flash and returns the bytes in little endian order
+    const uint8_t status[] = {STATUS_REGISTER_BUSY, 0};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t value = 0;
+    uint32_t expected;
+    uint32_t i;
+
+    mock_qspi_set_status(status, sizeof(status));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_read_word(&state, 0x10012340, &value);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_TRUE(command_was_sent(FLASHCMD_READ_STATUS));
+    expected = mock_qspi_get_flash_byte(0x12340)
+             | ((uint32_t)mock_qspi_get_flash_byte(0x12341) << 8)
+             | ((uint32_t)mock_qspi_get_flash_byte(0x12342) << 16)
+             | ((uint32_t)mock_qspi_get_flash_byte(0x12343) << 24);
+    TEST_ASSERT_EQUAL_HEX32(expected, value);
+}
+
+void test_flash_erased_block(void)
+{
+    // Objective: the block of the last erase is known until a page gets written
+    const uint8_t status[] = {0};
+    uint8_t data[4] = {1, 2, 3, 4};
+    flash_action_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+
+    mock_qspi_set_status(status, sizeof(status));
+    TEST_ASSERT_FALSE(flash_is_in_erased_block(0x10004000));
+    TEST_ASSERT_EQUAL(RESULT_OK, run_erase(0x10004000));
+    TEST_ASSERT_FALSE(flash_is_in_erased_block(0x10003ffc));
+    TEST_ASSERT_TRUE(flash_is_in_erased_block(0x10004000));
+    TEST_ASSERT_TRUE(flash_is_in_erased_block(0x10004ffc));
+    TEST_ASSERT_FALSE(flash_is_in_erased_block(0x10005000));
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = flash_write_page(&state, 0x10004000, data, sizeof(data));
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_FALSE(flash_is_in_erased_block(0x10004000));
+}
+#endif
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_program_end);
+    RUN_TEST(test_program_write);
+    RUN_TEST(test_program_accumulator);
+    RUN_TEST(test_program_poll);
+    RUN_TEST(test_program_send_and_drain);
+    RUN_TEST(test_program_poll_timeout);
+    RUN_TEST(test_program_busy_timeout);
+    RUN_TEST(test_program_save_restore);
+    RUN_TEST(test_program_skip_if_saved);
+    RUN_TEST(test_flash_clock_boost_and_restore);
+    RUN_TEST(test_flash_clock_boost_after_re_init);
+    RUN_TEST(test_flash_ssi_calibration);
+    RUN_TEST(test_flash_ssi_calibration_needs_margin);
+    RUN_TEST(test_flash_ssi_calibration_no_id);
+    RUN_TEST(test_flash_ssi_calibration_cached);
+    RUN_TEST(test_flash_ssi_calibration_quad_read);
+    RUN_TEST(test_flash_ssi_calibration_clock_changed);
+    RUN_TEST(test_flash_erase);
+    RUN_TEST(test_flash_erase_no_flash);
+    RUN_TEST(test_flash_write_page);
+#if defined(FEAT_PIPELINED_FLASH) && defined(FEAT_XIP_CACHE_STAGING)
+    RUN_TEST(test_flash_upload_while_busy);
+#endif
+    RUN_TEST(test_flash_xip_ctrl_restored);
+    RUN_TEST(test_flash_dma_and_ssi_restored);
+#ifdef FEAT_ERASE_SUSPEND
+    RUN_TEST(test_flash_suspend_from_sfdp);
+    RUN_TEST(test_flash_suspend_not_supported);
+    RUN_TEST(test_flash_read_word);
+    RUN_TEST(test_flash_erased_block);
+#endif
+    return UNITY_END();
+}
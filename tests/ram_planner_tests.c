@@ -0,0 +1,157 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "ram_planner.h"
+#include "mock/mock_stub_target.h"
+
+#define MAX_CALLS  100000
+
+void setUp(void)
+{
+    uint32_t i;
+    mock_stub_init();
+    ram_planner_init();
+    for(i = 0; i < (RAM_PLANNER_DEFAULT_END - RAM_PLANNER_DEFAULT_START); i++)
+    {
+        mock_stub_set_ram_byte(RAM_PLANNER_DEFAULT_START + i, (uint8_t)(i * 13));
+    }
+}
+
+void tearDown(void)
+{
+
+}
+
+static uint32_t num_calls;
+
+static Result run(Result (*func)(ram_planner_data_typ* const state))
+{
+    ram_planner_data_typ state;
+    Result res;
+
+    state.first_call = true;
+    for(num_calls = 1; num_calls <= MAX_CALLS; num_calls++)
+    {
+        res = func(&state);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_ram_planner_default_region(void)
+{
+    // Objective: without a [scratch] section SRAM4 and SRAM5 are used
+    uint32_t start = 0;
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(1000, &start));
+    TEST_ASSERT_EQUAL_HEX32(RAM_PLANNER_DEFAULT_START, start);
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, ram_planner_reserve(4, &start));
+    ram_planner_release();
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(4, &start));
+}
+
+void test_ram_planner_save_and_restore(void)
+{
+    // Objective: RAM that the helper overwrites has its old content afterwards
+    uint32_t start = 0;
+    uint32_t i;
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(256, &start));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(ram_planner_save));
+    TEST_ASSERT_EQUAL_UINT32(64, mock_stub_get_num_reads());
+    // reads are pipelined
+    TEST_ASSERT_EQUAL_UINT32(BLOCK_READ_IN_FLIGHT, mock_stub_get_max_reads_in_flight());
+    for(i = 0; i < 256; i++)
+    {
+        mock_stub_set_ram_byte(start + i, 0xff);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, run(ram_planner_restore));
+    TEST_ASSERT_EQUAL_UINT32(64, mock_stub_get_num_writes());
+    // writes are pipelined
+    TEST_ASSERT_EQUAL_UINT32(64 / BLOCK_WRITE_PER_CALL, num_calls);
+    for(i = 0; i < 256; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)(i * 13), mock_stub_get_ram_byte(start + i));
+    }
+    ram_planner_release();
+}
+
+void test_ram_planner_budget(void)
+{
+    // Objective: no reservation that needs more probe RAM than the budget allows
+    uint32_t start = 0;
+    ram_planner_set_save_budget(1024);
+    TEST_ASSERT_EQUAL_UINT32(1024, ram_planner_get_save_budget());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, ram_planner_reserve(1028, &start));
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(1024, &start));
+    ram_planner_release();
+    ram_planner_set_save_budget(RAM_PLANNER_MAX_SAVE_BYTES * 2);
+    TEST_ASSERT_EQUAL_UINT32(RAM_PLANNER_MAX_SAVE_BYTES, ram_planner_get_save_budget());
+}
+
+void test_ram_planner_user_region_without_save(void)
+{
+    // Objective: a region the application does not use is neither read nor written back
+    uint32_t start = 0;
+    ram_planner_set_user_region(0x20030000, 0x4000, false);
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(0x3000, &start));
+    TEST_ASSERT_EQUAL_HEX32(0x20030000, start);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(ram_planner_save));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(ram_planner_restore));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_num_reads());
+    TEST_ASSERT_EQUAL_UINT32(0, mock_stub_get_num_writes());
+    ram_planner_release();
+}
+
+void test_ram_planner_user_region_too_small(void)
+{
+    // Objective: if the user region is too small SRAM4 and SRAM5 are used
+    uint32_t start = 0;
+    ram_planner_set_user_region(0x20030000, 0x100, true);
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(0x100, &start));
+    TEST_ASSERT_EQUAL_HEX32(0x20030000, start);
+    ram_planner_release();
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(0x200, &start));
+    TEST_ASSERT_EQUAL_HEX32(RAM_PLANNER_DEFAULT_START, start);
+    ram_planner_release();
+}
+
+void test_ram_planner_default_region_is_saved(void)
+{
+    // Objective: the default region holds the stacks of the cores, it is saved even
+    // if the region of the application would not need to be
+    uint32_t start = 0;
+    ram_planner_set_user_region(0x20030000, 0x100, false);
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(0x200, &start));
+    TEST_ASSERT_EQUAL_HEX32(RAM_PLANNER_DEFAULT_START, start);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(ram_planner_save));
+    TEST_ASSERT_EQUAL_UINT32(0x200 / 4, mock_stub_get_num_reads());
+    ram_planner_release();
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ram_planner_default_region);
+    RUN_TEST(test_ram_planner_save_and_restore);
+    RUN_TEST(test_ram_planner_budget);
+    RUN_TEST(test_ram_planner_user_region_without_save);
+    RUN_TEST(test_ram_planner_user_region_too_small);
+    RUN_TEST(test_ram_planner_default_region_is_saved);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "range_step.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS  (20 * RANGE_STEP_MAX_STEPS)
+
+static range_step_data_typ state;
+
+void setUp(void)
+{
+    mock_core_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result run(uint32_t start, uint32_t end)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = range_step_run(&state, start, end);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_range_step_until_outside(void)
+{
+    // Objective: stepping continues until the PC leaves the range
+    const uint32_t pcs[] = {0x10000100, 0x10000102, 0x10000104, 0x10000106, 0x10000108, 0x10000200};
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(0x10000100, 0x10000110));
+    TEST_ASSERT_EQUAL(RANGE_STEP_LEFT_RANGE, state.reason);
+    TEST_ASSERT_EQUAL_HEX32(0x10000200, state.pc);
+    TEST_ASSERT_EQUAL_UINT32(5, mock_core_get_num_steps());
+    TEST_ASSERT_TRUE(mock_core_is_halted());
+}
+
+void test_range_step_end_is_exclusive(void)
+{
+    // Objective: a PC equal to the end of the range is outside
+    const uint32_t pcs[] = {0x10000100, 0x10000102, 0x10000104};
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(0x10000100, 0x10000104));
+    TEST_ASSERT_EQUAL_HEX32(0x10000104, state.pc);
+    TEST_ASSERT_EQUAL_UINT32(2, mock_core_get_num_steps());
+}
+
+void test_range_step_breakpoint(void)
+{
+    // Objective: a breakpoint inside the range ends the stepping
+    const uint32_t pcs[] = {0x10000100, 0x10000102, 0x10000104, 0x10000106, 0x10000200};
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    mock_core_set_breakpoint(0x10000104);
+    TEST_ASSERT_EQUAL(RESULT_OK, run(0x10000100, 0x10000110));
+    TEST_ASSERT_EQUAL(RANGE_STEP_DEBUG_EVENT, state.reason);
+    TEST_ASSERT_EQUAL_HEX32(0x10000104, state.pc);
+}
+
+void test_range_step_loop_in_range(void)
+{
+    // Objective: code that never leaves the range stops after the step limit
+    const uint32_t pcs[] = {0x10000100};
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    TEST_ASSERT_EQUAL(RESULT_OK, run(0x10000100, 0x10000110));
+    TEST_ASSERT_EQUAL(RANGE_STEP_STEP_LIMIT, state.reason);
+    TEST_ASSERT_EQUAL_UINT32(RANGE_STEP_MAX_STEPS, mock_core_get_num_steps());
+}
+
+void test_range_step_parse_vcont(void)
+{
+    // Objective: the range comes from the vCont packet, thread and other actions are ignored
+    uint32_t start = 0;
+    uint32_t end = 0;
+    TEST_ASSERT_TRUE(range_step_parse_vcont("vCont;r10000100,10000110", &start, &end));
+    TEST_ASSERT_EQUAL_HEX32(0x10000100, start);
+    TEST_ASSERT_EQUAL_HEX32(0x10000110, end);
+    TEST_ASSERT_TRUE(range_step_parse_vcont("vCont;r2000,2008:1;c", &start, &end));
+    TEST_ASSERT_EQUAL_HEX32(0x2000, start);
+    TEST_ASSERT_EQUAL_HEX32(0x2008, end);
+    TEST_ASSERT_FALSE(range_step_parse_vcont("vCont;s:1", &start, &end));
+    TEST_ASSERT_FALSE(range_step_parse_vcont("vCont;r2000", &start, &end));
+    TEST_ASSERT_FALSE(range_step_parse_vcont("vCont;r2000,2000", &start, &end));
+    TEST_ASSERT_FALSE(range_step_parse_vcont("vCont;r2000,20x0", &start, &end));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_range_step_until_outside);
+    RUN_TEST(test_range_step_end_is_exclusive);
+    RUN_TEST(test_range_step_breakpoint);
+    RUN_TEST(test_range_step_loop_in_range);
+    RUN_TEST(test_range_step_parse_vcont);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include "unity.h"
+#include "region_cache.h"
+
+void setUp(void)
+{
+    region_cache_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_region_cache_miss_then_hit(void)
+{
+    // Objective: a word is served from the cache after it has been read once
+    uint32_t value = 0;
+    TEST_ASSERT_FALSE(region_cache_read(0x10000100, &value));
+    region_cache_store(0x10000100, 0x12345678);
+    TEST_ASSERT_TRUE(region_cache_read(0x10000100, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, value);
+    // other words of the same line have not been read
+    TEST_ASSERT_FALSE(region_cache_read(0x10000104, &value));
+    TEST_ASSERT_EQUAL_UINT32(1, region_cache_get_num_hits());
+    TEST_ASSERT_EQUAL_UINT32(2, region_cache_get_num_misses());
+}
+
+void test_region_cache_only_rom_and_flash(void)
+{
+    // Objective: RAM, peripherals and unaligned addresses are not cached
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(region_cache_is_cacheable(0x00000010));
+    TEST_ASSERT_TRUE(region_cache_is_cacheable(0x10fffffc));
+    TEST_ASSERT_FALSE(region_cache_is_cacheable(0x00004000));
+    TEST_ASSERT_FALSE(region_cache_is_cacheable(0x20000000));
+    TEST_ASSERT_FALSE(region_cache_is_cacheable(0x40000000));
+    TEST_ASSERT_FALSE(region_cache_is_cacheable(0x10000002));
+    region_cache_store(0x20000000, 1);
+    TEST_ASSERT_FALSE(region_cache_read(0x20000000, &value));
+}
+
+void test_region_cache_flash_invalidate(void)
+{
+    // Objective: programming the flash removes the flash lines, the ROM lines stay
+    uint32_t value = 0;
+    region_cache_store(0x00000010, 0x0001754d);
+    region_cache_store(0x10000040, 0xcafe);
+    region_cache_invalidate_flash();
+    TEST_ASSERT_FALSE(region_cache_read(0x10000040, &value));
+    TEST_ASSERT_TRUE(region_cache_read(0x00000010, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x0001754d, value);
+    region_cache_invalidate_all();
+    TEST_ASSERT_FALSE(region_cache_read(0x00000010, &value));
+}
+
+void test_region_cache_eviction(void)
+{
+    // Objective: a line that maps to the same place replaces the old one
+    uint32_t value = 0;
+    region_cache_store(0x10000000, 1);
+    region_cache_store(0x10000000 + REGION_CACHE_MAX_BYTES, 2);
+    TEST_ASSERT_FALSE(region_cache_read(0x10000000, &value));
+    TEST_ASSERT_TRUE(region_cache_read(0x10000000 + REGION_CACHE_MAX_BYTES, &value));
+    TEST_ASSERT_EQUAL_UINT32(2, value);
+}
+
+void test_region_cache_budget(void)
+{
+    // Objective: the budget limits the number of lines, 0 disables the cache
+    uint32_t value = 0;
+    region_cache_set_budget(2 * REGION_CACHE_LINE_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(2 * REGION_CACHE_LINE_BYTES, region_cache_get_budget());
+    region_cache_store(0x10000000, 1);
+    region_cache_store(0x10000000 + 2 * REGION_CACHE_LINE_BYTES, 2);
+    TEST_ASSERT_FALSE(region_cache_read(0x10000000, &value));
+    region_cache_set_budget(10 * REGION_CACHE_MAX_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(REGION_CACHE_MAX_BYTES, region_cache_get_budget());
+    region_cache_set_budget(0);
+    region_cache_store(0x10000000, 1);
+    TEST_ASSERT_FALSE(region_cache_read(0x10000000, &value));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_region_cache_miss_then_hit);
+    RUN_TEST(test_region_cache_only_rom_and_flash);
+    RUN_TEST(test_region_cache_flash_invalidate);
+    RUN_TEST(test_region_cache_eviction);
+    RUN_TEST(test_region_cache_budget);
+    return UNITY_END();
+}
@@ -0,0 +1,311 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "rtos.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS          100000
+#define CURRENT_TCB        0x20000000
+#define NUMBER_OF_TASKS    0x20000004
+#define TASK_NUMBER        0x20000008
+#define READY_LISTS        0x20000100
+#define DELAYED_LIST_1     0x20000180
+#define DELAYED_LIST_2     0x200001a0
+#define PENDING_READY_LIST 0x200001c0
+#define SUSPENDED_LIST     0x200001e0
+#define TERMINATION_LIST   0x20000200
+#define TCB(n)             (0x20000400 + (n) * 0x80)
+#define STACK              0x20000c00
+// 10 list headers with 5 words each
+#define HEADER_READS       50
+
+static rtos_data_typ state;
+static uint32_t num_tasks;
+
+static void init_list(uint32_t list)
+{
+    mock_core_set_ram_word(list, 0);
+    mock_core_set_ram_word(list + 4, list + 8);
+    mock_core_set_ram_word(list + 8, 0xffffffff);
+    mock_core_set_ram_word(list + 12, list + 8);
+    mock_core_set_ram_word(list + 16, list + 8);
+}
+
+// vListInsertEnd() of the state list item of the TCB
+static void add_to_list(uint32_t list, uint32_t tcb)
+{
+    uint32_t item = tcb + 4;
+    uint32_t last = mock_core_get_ram_word(list + 16);
+    mock_core_set_ram_word(item + 4, list + 8);
+    mock_core_set_ram_word(item + 8, last);
+    mock_core_set_ram_word(item + 12, tcb);
+    mock_core_set_ram_word(item + 16, list);
+    mock_core_set_ram_word(last + 4, item);
+    mock_core_set_ram_word(list + 16, item);
+    mock_core_set_ram_word(list, mock_core_get_ram_word(list) + 1);
+}
+
+static void create_task(uint32_t n, const char* name, uint32_t list)
+{
+    uint32_t word = 0;
+    uint32_t i;
+    for(i = 0; i < RTOS_NAME_LENGTH; i++)
+    {
+        uint32_t c = (i < strlen(name)) ? (uint8_t)name[i] : 0;
+        word = word | (c << (8 * (i % 4)));
+        if(3 == (i % 4))
+        {
+            mock_core_set_ram_word(TCB(n) + RTOS_DEFAULT_NAME_OFFSET + i - 3, word);
+            word = 0;
+        }
+    }
+    add_to_list(list, TCB(n));
+    num_tasks++;
+    mock_core_set_ram_word(NUMBER_OF_TASKS, num_tasks);
+    mock_core_set_ram_word(TASK_NUMBER, mock_core_get_ram_word(TASK_NUMBER) + 1);
+}
+
+void setUp(void)
+{
+    uint32_t i;
+
+    mock_core_init();
+    for(i = 0; i < RTOS_DEFAULT_MAX_PRIORITIES; i++)
+    {
+        init_list(READY_LISTS + i * 20);
+    }
+    init_list(DELAYED_LIST_1);
+    init_list(DELAYED_LIST_2);
+    init_list(PENDING_READY_LIST);
+    init_list(SUSPENDED_LIST);
+    init_list(TERMINATION_LIST);
+    num_tasks = 0;
+    create_task(0, "IDLE", READY_LISTS);
+    create_task(1, "main", READY_LISTS + 2 * 20);
+    create_task(2, "blink", DELAYED_LIST_1);
+    mock_core_set_ram_word(CURRENT_TCB, TCB(1));
+
+    rtos_init();
+    rtos_set_symbol(RTOS_SYM_CURRENT_TCB, CURRENT_TCB);
+    rtos_set_symbol(RTOS_SYM_READY_LISTS, READY_LISTS);
+    rtos_set_symbol(RTOS_SYM_DELAYED_LIST_1, DELAYED_LIST_1);
+    rtos_set_symbol(RTOS_SYM_DELAYED_LIST_2, DELAYED_LIST_2);
+    rtos_set_symbol(RTOS_SYM_PENDING_READY_LIST, PENDING_READY_LIST);
+    rtos_set_symbol(RTOS_SYM_SUSPENDED_LIST, SUSPENDED_LIST);
+    rtos_set_symbol(RTOS_SYM_TERMINATION_LIST, TERMINATION_LIST);
+    rtos_set_symbol(RTOS_SYM_NUMBER_OF_TASKS, NUMBER_OF_TASKS);
+    rtos_set_symbol(RTOS_SYM_TASK_NUMBER, TASK_NUMBER);
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result update(void)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = rtos_update(&state);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result read_registers(uint32_t thread_id, uint32_t* regs)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = rtos_read_thread_registers(&state, thread_id, regs);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_rtos_symbols_missing(void)
+{
+    TEST_ASSERT_TRUE(rtos_is_active());
+    TEST_ASSERT_EQUAL_STRING("pxCurrentTCB", rtos_get_symbol_name(RTOS_SYM_CURRENT_TCB));
+    TEST_ASSERT_NULL(rtos_get_symbol_name(RTOS_NUM_SYMBOLS));
+    rtos_set_symbol(RTOS_SYM_TASK_NUMBER, 0);
+    TEST_ASSERT_FALSE(rtos_is_active());
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, update());
+    TEST_ASSERT_EQUAL(0, rtos_get_num_threads());
+}
+
+void test_rtos_walk_finds_tasks(void)
+{
+    char buf[30];
+
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    TEST_ASSERT_EQUAL(3, rtos_get_num_threads());
+    TEST_ASSERT_EQUAL_HEX32(TCB(0), rtos_get_thread_id(0));
+    TEST_ASSERT_EQUAL_HEX32(TCB(1), rtos_get_thread_id(1));
+    TEST_ASSERT_EQUAL_HEX32(TCB(2), rtos_get_thread_id(2));
+    TEST_ASSERT_EQUAL_HEX32(TCB(1), rtos_get_current_thread());
+    TEST_ASSERT_EQUAL_STRING("IDLE", rtos_get_thread_name(TCB(0)));
+    TEST_ASSERT_EQUAL_STRING("main", rtos_get_thread_name(TCB(1)));
+    TEST_ASSERT_EQUAL_STRING("blink", rtos_get_thread_name(TCB(2)));
+    TEST_ASSERT_NULL(rtos_get_thread_name(TCB(3)));
+    rtos_get_stop_reply(buf, sizeof(buf), 5);
+    TEST_ASSERT_EQUAL_STRING("T05thread:20000480;", buf);
+}
+
+void test_rtos_unchanged_counters(void)
+{
+    uint32_t reads;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    // the tasks run, another task is current now
+    mock_core_set_ram_word(CURRENT_TCB, TCB(2));
+    reads = mock_core_get_num_ram_reads();
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    // only the counters and pxCurrentTCB
+    TEST_ASSERT_EQUAL(3, mock_core_get_num_ram_reads() - reads);
+    TEST_ASSERT_EQUAL(3, rtos_get_num_threads());
+    TEST_ASSERT_EQUAL_HEX32(TCB(2), rtos_get_current_thread());
+}
+
+void test_rtos_only_changed_list_walked(void)
+{
+    uint32_t reads;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    create_task(3, "uart", SUSPENDED_LIST);
+    reads = mock_core_get_num_ram_reads();
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    // counters, all list headers, the one item of the suspended list and the new name
+    TEST_ASSERT_EQUAL(3 + HEADER_READS + 5 + RTOS_NAME_LENGTH / 4, mock_core_get_num_ram_reads() - reads);
+    TEST_ASSERT_EQUAL(4, rtos_get_num_threads());
+    TEST_ASSERT_EQUAL_STRING("uart", rtos_get_thread_name(TCB(3)));
+    TEST_ASSERT_EQUAL_STRING("blink", rtos_get_thread_name(TCB(2)));
+
+    // a task was deleted
+    init_list(DELAYED_LIST_1);
+    num_tasks--;
+    mock_core_set_ram_word(NUMBER_OF_TASKS, num_tasks);
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    TEST_ASSERT_EQUAL(3, rtos_get_num_threads());
+    TEST_ASSERT_NULL(rtos_get_thread_name(TCB(2)));
+    TEST_ASSERT_EQUAL_STRING("uart", rtos_get_thread_name(TCB(3)));
+}
+
+void test_rtos_thread_registers(void)
+{
+    uint32_t regs[RTOS_NUM_REGS];
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    // stack of "blink" as left by PendSV
+    mock_core_set_ram_word(TCB(2), STACK);
+    for(i = 0; i < 16; i++)
+    {
+        mock_core_set_ram_word(STACK + i * 4, 0x100 + i);
+    }
+    mock_core_set_ram_word(STACK + 15 * 4, 0x01000200);
+    TEST_ASSERT_EQUAL(RESULT_OK, read_registers(TCB(2), regs));
+    TEST_ASSERT_EQUAL_HEX32(0x108, regs[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x10b, regs[3]);
+    TEST_ASSERT_EQUAL_HEX32(0x100, regs[4]);
+    TEST_ASSERT_EQUAL_HEX32(0x107, regs[11]);
+    TEST_ASSERT_EQUAL_HEX32(0x10c, regs[12]);
+    // aligned by the exception entry
+    TEST_ASSERT_EQUAL_HEX32(STACK + 64 + 4, regs[13]);
+    TEST_ASSERT_EQUAL_HEX32(0x10d, regs[14]);
+    TEST_ASSERT_EQUAL_HEX32(0x10e, regs[15]);
+    TEST_ASSERT_EQUAL_HEX32(0x01000200, regs[16]);
+
+    // the registers of the running task are in the core
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, read_registers(TCB(1), regs));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, read_registers(TCB(5), regs));
+}
+
+void test_rtos_threads_xml(void)
+{
+    char buf[300];
+    uint32_t len;
+
+    TEST_ASSERT_EQUAL(RESULT_OK, update());
+    len = rtos_get_threads_xml(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("<?xml version=\"1.0\"?>\r\n<threads>\r\n"
+                             "<thread id=\"20000400\" name=\"IDLE\"/>\r\n"
+                             "<thread id=\"20000480\" name=\"main\"/>\r\n"
+                             "<thread id=\"20000500\" name=\"blink\"/>\r\n"
+                             "</threads>\r\n", buf);
+    TEST_ASSERT_EQUAL(strlen(buf), len);
+    // too small: cut, but terminated
+    len = rtos_get_threads_xml(buf, 20);
+    TEST_ASSERT_EQUAL(19, len);
+    TEST_ASSERT_EQUAL(19, strlen(buf));
+}
+
+void test_rtos_qsymbol(void)
+{
+    // Objective: the symbols are asked for one by one, unknown symbols have no address
+    char buf[64];
+    char packet[64];
+    uint32_t i;
+
+    rtos_init();
+    TEST_ASSERT_EQUAL_UINT32(0, rtos_handle_qsymbol("qC", buf, sizeof(buf)));
+    rtos_handle_qsymbol("qSymbol::", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("qSymbol:707843757272656e74544342", buf);
+    rtos_handle_qsymbol("qSymbol:20000000:707843757272656e74544342", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("qSymbol:707852656164795461736b734c69737473", buf);
+    for(i = 1; i < RTOS_NUM_SYMBOLS; i++)
+    {
+        // GDB answers with the name it was asked for
+        strcpy(packet, "qSymbol:20000100:");
+        strcat(packet, &(buf[8]));
+        rtos_handle_qsymbol(packet, buf, sizeof(buf));
+    }
+    TEST_ASSERT_EQUAL_STRING("OK", buf);
+    TEST_ASSERT_TRUE(rtos_is_active());
+    rtos_handle_qsymbol("qSymbol::", buf, sizeof(buf));
+    rtos_handle_qsymbol("qSymbol::707843757272656e74544342", buf, sizeof(buf));
+    TEST_ASSERT_FALSE(rtos_is_active());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rtos_symbols_missing);
+    RUN_TEST(test_rtos_walk_finds_tasks);
+    RUN_TEST(test_rtos_unchanged_counters);
+    RUN_TEST(test_rtos_only_changed_list_walked);
+    RUN_TEST(test_rtos_thread_registers);
+    RUN_TEST(test_rtos_threads_xml);
+    RUN_TEST(test_rtos_qsymbol);
+    return UNITY_END();
+}
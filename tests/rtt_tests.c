@@ -0,0 +1,305 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "rtt.h"
+#include "mock/mock_core_target.h"
+#include "mock/mock_time_us.h"
+
+#define MAX_CALLS       100000
+#define CONTROL_BLOCK   0x20000400
+#define UP_0            (CONTROL_BLOCK + 24)
+#define UP_1            (UP_0 + 24)
+#define DOWN_0          (UP_1 + 24)
+#define UP_0_BUFFER     0x20000800
+#define UP_0_SIZE       64
+#define UP_1_BUFFER     0x20000880
+#define DOWN_0_BUFFER   0x20000900
+#define DOWN_0_SIZE     16
+
+static rtt_data_typ state;
+
+static void set_byte(uint32_t address, uint8_t value)
+{
+    uint32_t word = mock_core_get_ram_word(address & ~3u);
+    uint32_t shift = 8 * (address & 3);
+    mock_core_set_ram_word(address & ~3u, (word & ~(0xffu << shift)) | ((uint32_t)value << shift));
+}
+
+static uint8_t get_byte(uint32_t address)
+{
+    return (uint8_t)(mock_core_get_ram_word(address & ~3u) >> (8 * (address & 3)));
+}
+
+static void set_descriptor(uint32_t desc, uint32_t buffer, uint32_t size)
+{
+    mock_core_set_ram_word(desc, 0);
+    mock_core_set_ram_word(desc + 4, buffer);
+    mock_core_set_ram_word(desc + 8, size);
+    mock_core_set_ram_word(desc + 12, 0);
+    mock_core_set_ram_word(desc + 16, 0);
+    mock_core_set_ram_word(desc + 20, 0);
+}
+
+static void create_control_block(void)
+{
+    mock_core_set_ram_word(CONTROL_BLOCK, 0x47474553);
+    mock_core_set_ram_word(CONTROL_BLOCK + 4, 0x52205245);
+    mock_core_set_ram_word(CONTROL_BLOCK + 8, 0x00005454);
+    mock_core_set_ram_word(CONTROL_BLOCK + 12, 0);
+    mock_core_set_ram_word(CONTROL_BLOCK + 16, 2);
+    mock_core_set_ram_word(CONTROL_BLOCK + 20, 1);
+    set_descriptor(UP_0, UP_0_BUFFER, UP_0_SIZE);
+    set_descriptor(UP_1, UP_1_BUFFER, 16);
+    set_descriptor(DOWN_0, DOWN_0_BUFFER, DOWN_0_SIZE);
+}
+
+void setUp(void)
+{
+    mock_core_init();
+    mock_core_set_halted(false);
+    set_time_us(1000);
+    rtt_init();
+    rtt_set_enabled(true);
+    rtt_set_scan_range(MOCK_CORE_RAM_START, MOCK_CORE_RAM_SIZE);
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result poll(void)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = rtt_poll(&state);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+// polls until the control block is found or a whole scan is done
+static Result scan(void)
+{
+    Result res;
+    uint32_t i;
+
+    for(i = 0; i < (MOCK_CORE_RAM_SIZE / RTT_SCAN_CHUNK); i++)
+    {
+        res = poll();
+        if((RESULT_OK != res) || (true == rtt_is_found()))
+        {
+            return res;
+        }
+        advance_time_us(RTT_MIN_INTERVAL);
+        if(false == rtt_is_due())
+        {
+            // scan finished
+            return res;
+        }
+    }
+    return res;
+}
+
+void test_rtt_scan(void)
+{
+    uint32_t reads;
+
+    // partial id
+    mock_core_set_ram_word(0x20000100, 0x47474553);
+    mock_core_set_ram_word(0x20000104, 0x52205245);
+    TEST_ASSERT_TRUE(rtt_is_due());
+    // one poll only searches a part of the RAM
+    reads = mock_core_get_num_ram_reads();
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(RTT_SCAN_CHUNK / 4, mock_core_get_num_ram_reads() - reads);
+    advance_time_us(RTT_MIN_INTERVAL);
+    TEST_ASSERT_TRUE(rtt_is_due());
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_FALSE(rtt_is_found());
+    // no new scan right away
+    TEST_ASSERT_FALSE(rtt_is_due());
+    advance_time_us(RTT_SCAN_INTERVAL);
+    TEST_ASSERT_TRUE(rtt_is_due());
+
+    // the scan after a failed scan waits twice as long
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_FALSE(rtt_is_found());
+    advance_time_us(RTT_SCAN_INTERVAL);
+    TEST_ASSERT_FALSE(rtt_is_due());
+    advance_time_us(RTT_SCAN_INTERVAL);
+    TEST_ASSERT_TRUE(rtt_is_due());
+
+    create_control_block();
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_TRUE(rtt_is_found());
+    TEST_ASSERT_EQUAL(2, rtt_get_num_up());
+    TEST_ASSERT_EQUAL(1, rtt_get_num_down());
+
+    // the id across two chunks
+    rtt_forget();
+    mock_core_set_ram_word(CONTROL_BLOCK - 8, 0x47474553);
+    mock_core_set_ram_word(CONTROL_BLOCK - 4, 0x52205245);
+    mock_core_set_ram_word(CONTROL_BLOCK, 0x00005454);
+    mock_core_set_ram_word(CONTROL_BLOCK + 8, 1);
+    mock_core_set_ram_word(CONTROL_BLOCK + 12, 0);
+    set_descriptor(CONTROL_BLOCK + 16, UP_0_BUFFER, UP_0_SIZE);
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_TRUE(rtt_is_found());
+    TEST_ASSERT_EQUAL(1, rtt_get_num_up());
+    TEST_ASSERT_EQUAL(0, rtt_get_num_down());
+    create_control_block();
+
+    // the configured address needs no scan
+    rtt_set_control_block(CONTROL_BLOCK);
+    reads = mock_core_get_num_ram_reads();
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_TRUE(rtt_is_found());
+    TEST_ASSERT_TRUE(30 > (mock_core_get_num_ram_reads() - reads));
+
+    // a broken control block is searched again, but not right away
+    mock_core_set_ram_word(UP_0 + 12, UP_0_SIZE);
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, poll());
+    TEST_ASSERT_FALSE(rtt_is_found());
+    TEST_ASSERT_FALSE(rtt_is_due());
+    advance_time_us(RTT_SCAN_INTERVAL);
+    TEST_ASSERT_TRUE(rtt_is_due());
+}
+
+void test_rtt_up(void)
+{
+    uint8_t buf[80];
+    uint32_t i;
+
+    create_control_block();
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_EQUAL(0, rtt_read_up(0, buf, sizeof(buf)));
+
+    for(i = 0; i < 5; i++)
+    {
+        set_byte(UP_0_BUFFER + 1 + i, (uint8_t)"Hello"[i]);
+    }
+    mock_core_set_ram_word(UP_0 + 16, 1);
+    mock_core_set_ram_word(UP_0 + 12, 6);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(5, rtt_read_up(0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_MEMORY("Hello", buf, 5);
+    TEST_ASSERT_EQUAL(6, mock_core_get_ram_word(UP_0 + 16));
+
+    // wraps around the end of the buffer
+    for(i = 0; i < 7; i++)
+    {
+        set_byte(UP_0_BUFFER + ((61 + i) % UP_0_SIZE), (uint8_t)"0123456"[i]);
+    }
+    mock_core_set_ram_word(UP_0 + 16, 61);
+    mock_core_set_ram_word(UP_0 + 12, 4);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(7, rtt_read_up(0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_MEMORY("0123456", buf, 7);
+    TEST_ASSERT_EQUAL(4, mock_core_get_ram_word(UP_0 + 16));
+    TEST_ASSERT_EQUAL(0, rtt_read_up(1, buf, sizeof(buf)));
+}
+
+void test_rtt_down(void)
+{
+    create_control_block();
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    TEST_ASSERT_EQUAL(0, rtt_write_down(1, (const uint8_t*)"x", 1));
+    TEST_ASSERT_EQUAL(6, rtt_write_down(0, (const uint8_t*)"abcdef", 6));
+
+    set_byte(DOWN_0_BUFFER + 13, 0x55);
+    mock_core_set_ram_word(DOWN_0 + 12, 14);
+    mock_core_set_ram_word(DOWN_0 + 16, 3);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    // up to the end of the buffer
+    TEST_ASSERT_EQUAL(0, mock_core_get_ram_word(DOWN_0 + 12));
+    TEST_ASSERT_EQUAL('a', get_byte(DOWN_0_BUFFER + 14));
+    TEST_ASSERT_EQUAL('b', get_byte(DOWN_0_BUFFER + 15));
+    TEST_ASSERT_EQUAL(0x55, get_byte(DOWN_0_BUFFER + 13));
+
+    // one byte stays free
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(2, mock_core_get_ram_word(DOWN_0 + 12));
+    TEST_ASSERT_EQUAL('c', get_byte(DOWN_0_BUFFER));
+    TEST_ASSERT_EQUAL('d', get_byte(DOWN_0_BUFFER + 1));
+    TEST_ASSERT_EQUAL(0, get_byte(DOWN_0_BUFFER + 2));
+
+    // the target read the data
+    mock_core_set_ram_word(DOWN_0 + 16, 2);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(4, mock_core_get_ram_word(DOWN_0 + 12));
+    TEST_ASSERT_EQUAL('e', get_byte(DOWN_0_BUFFER + 2));
+    TEST_ASSERT_EQUAL('f', get_byte(DOWN_0_BUFFER + 3));
+}
+
+void test_rtt_interval(void)
+{
+    uint32_t i;
+
+    create_control_block();
+    TEST_ASSERT_EQUAL(RESULT_OK, scan());
+    for(i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    }
+    TEST_ASSERT_EQUAL(RTT_MAX_INTERVAL, rtt_get_poll_interval_us());
+    TEST_ASSERT_FALSE(rtt_is_due());
+    advance_time_us(RTT_MAX_INTERVAL);
+    TEST_ASSERT_TRUE(rtt_is_due());
+
+    set_byte(UP_0_BUFFER, 'x');
+    mock_core_set_ram_word(UP_0 + 12, 1);
+    TEST_ASSERT_EQUAL(RESULT_OK, poll());
+    TEST_ASSERT_EQUAL(RTT_MAX_INTERVAL / 2, rtt_get_poll_interval_us());
+
+    rtt_set_enabled(false);
+    advance_time_us(RTT_MAX_INTERVAL);
+    TEST_ASSERT_FALSE(rtt_is_due());
+}
+
+void test_rtt_tcp_port(void)
+{
+    // Objective: without a TCP port for the channels RTT is off
+    rtt_init();
+    TEST_ASSERT_FALSE(rtt_is_due());
+    rtt_set_tcp_port(19021);
+    TEST_ASSERT_EQUAL_UINT32(19021, rtt_get_tcp_port());
+    TEST_ASSERT_TRUE(rtt_is_due());
+    rtt_set_tcp_port(0);
+    TEST_ASSERT_FALSE(rtt_is_due());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rtt_scan);
+    RUN_TEST(test_rtt_up);
+    RUN_TEST(test_rtt_down);
+    RUN_TEST(test_rtt_interval);
+    RUN_TEST(test_rtt_tcp_port);
+    return UNITY_END();
+}
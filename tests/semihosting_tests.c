@@ -0,0 +1,243 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "semihosting.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS   100000
+#define BKPT_PC     0x20000102
+#define PARAMS      0x20000180
+#define STRING      0x20000203
+#define BUFFER      0x20000400
+
+static semihost_data_typ state;
+static bool resumed;
+
+static void set_byte(uint32_t address, uint8_t value)
+{
+    uint32_t word = mock_core_get_ram_word(address & ~3u);
+    uint32_t shift = 8 * (address & 3);
+    mock_core_set_ram_word(address & ~3u, (word & ~(0xffu << shift)) | ((uint32_t)value << shift));
+}
+
+static uint8_t get_byte(uint32_t address)
+{
+    return (uint8_t)(mock_core_get_ram_word(address & ~3u) >> (8 * (address & 3)));
+}
+
+static void set_string(uint32_t address, const char* str)
+{
+    uint32_t i;
+    for(i = 0; i <= strlen(str); i++)
+    {
+        set_byte(address + i, (uint8_t)str[i]);
+    }
+}
+
+static void set_call(uint32_t op, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    mock_core_set_register(0, op);
+    mock_core_set_register(1, PARAMS);
+    mock_core_set_register(15, BKPT_PC);
+    mock_core_set_ram_word(PARAMS, arg0);
+    mock_core_set_ram_word(PARAMS + 4, arg1);
+    mock_core_set_ram_word(PARAMS + 8, arg2);
+    mock_core_set_halted(true);
+}
+
+void setUp(void)
+{
+    mock_core_init();
+    // movs r0, r0 ; bkpt 0xab
+    mock_core_set_ram_word(BKPT_PC & ~3u, 0xbeab0000);
+    semihost_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result on_halt(uint32_t max_calls)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < max_calls; i++)
+    {
+        res = semihost_on_halt(&state, BKPT_PC, &resumed);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result go_on(void)
+{
+    Result res;
+    uint32_t i;
+
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = semihost_on_halt(&state, BKPT_PC, &resumed);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_semihost_normal_halt(void)
+{
+    // bkpt 0x00
+    mock_core_set_ram_word(BKPT_PC & ~3u, 0xbe000000);
+    set_call(SYS_WRITE0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_FALSE(resumed);
+    TEST_ASSERT_TRUE(mock_core_is_halted());
+
+    // SYS_EXIT is for GDB
+    mock_core_set_ram_word(BKPT_PC & ~3u, 0xbeab0000);
+    set_call(0x18, 0, 0, 0);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_FALSE(resumed);
+    TEST_ASSERT_EQUAL_HEX32(BKPT_PC, mock_core_get_register(15));
+}
+
+void test_semihost_write0(void)
+{
+    uint8_t buf[40];
+
+    set_string(STRING, "Hello, world\n");
+    set_call(SYS_WRITE0, 0, 0, 0);
+    mock_core_set_register(1, STRING);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_TRUE(resumed);
+    TEST_ASSERT_FALSE(mock_core_is_halted());
+    TEST_ASSERT_EQUAL_HEX32(BKPT_PC + 2, mock_core_get_register(15));
+    TEST_ASSERT_EQUAL(13, semihost_read_output(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_MEMORY("Hello, world\n", buf, 13);
+    TEST_ASSERT_EQUAL(0, semihost_read_output(buf, sizeof(buf)));
+}
+
+void test_semihost_open(void)
+{
+    set_string(STRING, ":tt");
+    set_call(SYS_OPEN, STRING, 4, 3);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_TRUE(resumed);
+    TEST_ASSERT_EQUAL(SEMIHOST_HANDLE_STDOUT, mock_core_get_register(0));
+
+    set_call(SYS_OPEN, STRING, 0, 3);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL(SEMIHOST_HANDLE_STDIN, mock_core_get_register(0));
+
+    set_call(SYS_OPEN, STRING, 8, 3);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL(SEMIHOST_HANDLE_STDERR, mock_core_get_register(0));
+
+    set_string(STRING, "log.txt");
+    set_call(SYS_OPEN, STRING, 4, 7);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL_HEX32(0xffffffff, mock_core_get_register(0));
+
+    set_call(SYS_ISTTY, SEMIHOST_HANDLE_STDOUT, 0, 0);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL(1, mock_core_get_register(0));
+}
+
+void test_semihost_write(void)
+{
+    uint8_t buf[400];
+    uint32_t i;
+
+    for(i = 0; i < 300; i++)
+    {
+        set_byte(BUFFER + 1 + i, (uint8_t)i);
+    }
+    set_call(SYS_WRITE, SEMIHOST_HANDLE_STDOUT, BUFFER + 1, 300);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_TRUE(resumed);
+    TEST_ASSERT_EQUAL(0, mock_core_get_register(0));
+    TEST_ASSERT_EQUAL(300, semihost_read_output(buf, sizeof(buf)));
+    for(i = 0; i < 300; i++)
+    {
+        TEST_ASSERT_EQUAL((uint8_t)i, buf[i]);
+    }
+
+    // stdin can not be written
+    set_call(SYS_WRITE, SEMIHOST_HANDLE_STDIN, BUFFER, 10);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL(10, mock_core_get_register(0));
+}
+
+void test_semihost_output_full(void)
+{
+    static uint8_t buf[SEMIHOST_OUTPUT_SIZE];
+
+    set_call(SYS_WRITE, SEMIHOST_HANDLE_STDOUT, BUFFER, 3000);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    set_call(SYS_WRITE, SEMIHOST_HANDLE_STDOUT, BUFFER, 2000);
+    // the core waits for the host
+    TEST_ASSERT_EQUAL(ERR_NOT_COMPLETED, on_halt(MAX_CALLS));
+    TEST_ASSERT_TRUE(mock_core_is_halted());
+    TEST_ASSERT_EQUAL(SEMIHOST_OUTPUT_SIZE, semihost_read_output(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(RESULT_OK, go_on());
+    TEST_ASSERT_TRUE(resumed);
+    TEST_ASSERT_EQUAL(3000 + 2000 - SEMIHOST_OUTPUT_SIZE, semihost_read_output(buf, sizeof(buf)));
+}
+
+void test_semihost_read(void)
+{
+    set_byte(BUFFER, 0x55);
+    set_byte(BUFFER + 4, 0x66);
+    set_call(SYS_READ, SEMIHOST_HANDLE_STDIN, BUFFER + 1, 8);
+    // no input = end of file
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_EQUAL(8, mock_core_get_register(0));
+
+    TEST_ASSERT_EQUAL(3, semihost_write_input((const uint8_t*)"abc", 3));
+    set_call(SYS_READ, SEMIHOST_HANDLE_STDIN, BUFFER + 1, 8);
+    TEST_ASSERT_EQUAL(RESULT_OK, on_halt(MAX_CALLS));
+    TEST_ASSERT_TRUE(resumed);
+    // 5 bytes not read
+    TEST_ASSERT_EQUAL(5, mock_core_get_register(0));
+    TEST_ASSERT_EQUAL(0x55, get_byte(BUFFER));
+    TEST_ASSERT_EQUAL('a', get_byte(BUFFER + 1));
+    TEST_ASSERT_EQUAL('b', get_byte(BUFFER + 2));
+    TEST_ASSERT_EQUAL('c', get_byte(BUFFER + 3));
+    TEST_ASSERT_EQUAL(0x66, get_byte(BUFFER + 4));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_semihost_normal_halt);
+    RUN_TEST(test_semihost_write0);
+    RUN_TEST(test_semihost_open);
+    RUN_TEST(test_semihost_write);
+    RUN_TEST(test_semihost_output_full);
+    RUN_TEST(test_semihost_read);
+    return UNITY_END();
+}
@@ -0,0 +1,125 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "unity.h"
+#include "spsc_ring.h"
+
+#define NUM_ELEMENTS  4
+
+static spsc_ring_typ ring;
+static uint32_t buffer[NUM_ELEMENTS];
+
+void setUp(void)
+{
+    spsc_ring_init(&ring, buffer, sizeof(uint32_t), NUM_ELEMENTS);
+}
+
+void tearDown(void)
+{
+
+}
+
+static void push(uint32_t value)
+{
+    uint32_t* slot = spsc_ring_get_write_slot(&ring);
+    TEST_ASSERT_NOT_NULL(slot);
+    *slot = value;
+    spsc_ring_commit(&ring);
+}
+
+static uint32_t pop(void)
+{
+    uint32_t value;
+    uint32_t* slot = spsc_ring_peek(&ring);
+    TEST_ASSERT_NOT_NULL(slot);
+    value = *slot;
+    spsc_ring_release(&ring);
+    return value;
+}
+
+void test_spsc_ring_empty(void)
+{
+    // Objective: nothing to read after init
+    TEST_ASSERT_NULL(spsc_ring_peek(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_get_num_used(&ring));
+}
+
+void test_spsc_ring_slot_not_visible_before_commit(void)
+{
+    // Objective: the consumer only sees committed slots
+    uint32_t* slot = spsc_ring_get_write_slot(&ring);
+    TEST_ASSERT_NOT_NULL(slot);
+    *slot = 42;
+    TEST_ASSERT_NULL(spsc_ring_peek(&ring));
+    spsc_ring_commit(&ring);
+    TEST_ASSERT_EQUAL_UINT32(42, pop());
+}
+
+void test_spsc_ring_full(void)
+{
+    // Objective: no write slot if all elements are used
+    uint32_t i;
+    for(i = 0; i < NUM_ELEMENTS; i++)
+    {
+        push(i);
+    }
+    TEST_ASSERT_NULL(spsc_ring_get_write_slot(&ring));
+    TEST_ASSERT_EQUAL_UINT32(NUM_ELEMENTS, spsc_ring_get_num_used(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, pop());
+    TEST_ASSERT_NOT_NULL(spsc_ring_get_write_slot(&ring));
+}
+
+void test_spsc_ring_order_and_wrap_around(void)
+{
+    // Objective: elements come out in order, also after many wrap arounds
+    uint32_t i;
+    for(i = 0; i < 100; i++)
+    {
+        push(i);
+        push(i + 1000);
+        TEST_ASSERT_EQUAL_UINT32(i, pop());
+        TEST_ASSERT_EQUAL_UINT32(i + 1000, pop());
+    }
+    TEST_ASSERT_NULL(spsc_ring_peek(&ring));
+}
+
+void test_spsc_ring_counter_overflow(void)
+{
+    // Objective: the free running counters can overflow
+    ring.head = 0xfffffffe;
+    ring.tail = 0xfffffffe;
+    push(1);
+    push(2);
+    push(3);
+    TEST_ASSERT_EQUAL_UINT32(3, spsc_ring_get_num_used(&ring));
+    TEST_ASSERT_EQUAL_UINT32(1, pop());
+    TEST_ASSERT_EQUAL_UINT32(2, pop());
+    TEST_ASSERT_EQUAL_UINT32(3, pop());
+    TEST_ASSERT_NULL(spsc_ring_peek(&ring));
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spsc_ring_empty);
+    RUN_TEST(test_spsc_ring_slot_not_visible_before_commit);
+    RUN_TEST(test_spsc_ring_full);
+    RUN_TEST(test_spsc_ring_order_and_wrap_around);
+    RUN_TEST(test_spsc_ring_counter_overflow);
+    return UNITY_END();
+}
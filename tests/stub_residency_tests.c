@@ -0,0 +1,289 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "stub_residency.h"
+#include "mock/mock_stub_target.h"
+
+#define MAX_CALLS  10000
+// load addresses in the RAM of the mock
+#define ADDRESS_A  0x20040000
+#define ADDRESS_B  0x20041000
+
+static uint8_t stub_a[100];
+static uint8_t stub_b[30];
+
+void setUp(void)
+{
+    uint32_t i;
+    mock_stub_init();
+    stub_residency_init();
+    for(i = 0; i < sizeof(stub_a); i++)
+    {
+        stub_a[i] = (uint8_t)(i * 7 + 1);
+    }
+    for(i = 0; i < sizeof(stub_b); i++)
+    {
+        stub_b[i] = (uint8_t)(0xa0 + i);
+    }
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result ensure(uint32_t id, const uint8_t* code, uint32_t size, uint32_t address)
+{
+    stub_residency_data_typ state;
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = stub_residency_ensure(&state, id, code, size, 0, address);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+void test_stub_crc32(void)
+{
+    // Objective: same CRC as the DMA sniffer (CRC-32/MPEG-2)
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT_EQUAL_HEX32(0x0376e6e7, stub_residency_crc32(check, sizeof(check)));
+}
+
+void test_stub_first_use_uploads(void)
+{
+    // Objective: the first use uploads the stub to the given address
+    uint32_t i;
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_uploads());
+    for(i = 0; i < sizeof(stub_a); i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8(stub_a[i], mock_stub_get_ram_byte(ADDRESS_A + i));
+    }
+}
+
+void test_stub_resident_is_not_uploaded_again(void)
+{
+    // Objective: a resident stub is only checked, that needs only a few writes
+    // (7 for the check, 1 that puts the DMA back into reset)
+    uint32_t writes;
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    writes = mock_stub_get_num_writes();
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_hits());
+    TEST_ASSERT_EQUAL_UINT32(writes + 2 * 8, mock_stub_get_num_writes());
+    TEST_ASSERT_TRUE(mock_stub_is_dma_in_reset());
+}
+
+void test_stub_overwritten_is_uploaded_again(void)
+{
+    // Objective: a changed byte in the stub causes a new upload
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    mock_stub_set_ram_byte(ADDRESS_A + 42, 0);
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL_HEX8(stub_a[42], mock_stub_get_ram_byte(ADDRESS_A + 42));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_uploads());
+}
+
+void test_stub_two_stubs(void)
+{
+    // Objective: two stubs at different places stay resident both
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(2, stub_b, sizeof(stub_b), ADDRESS_B));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(2, stub_b, sizeof(stub_b), ADDRESS_B));
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_hits());
+}
+
+void test_stub_same_place(void)
+{
+    // Objective: a stub uploaded on top of another one replaces it
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(2, stub_b, sizeof(stub_b), ADDRESS_A + 0x20));
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    // no check of the overwritten stub
+    TEST_ASSERT_EQUAL_UINT32(3, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL_UINT32(0, stub_residency_get_num_hits());
+    // a different place is a new upload
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_B));
+    TEST_ASSERT_EQUAL_UINT32(4, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, ensure(1, stub_a, sizeof(stub_a), ADDRESS_B + 2));
+}
+
+void test_stub_forget_all(void)
+{
+    // Objective: after forget_all the stub gets uploaded again
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    stub_residency_forget_all();
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_uploads());
+}
+
+void test_stub_check_restores_dma(void)
+{
+    // Objective: the check does not change the DMA channel and the sniffer of the application
+    uint32_t read;
+    uint32_t write;
+    uint32_t count;
+    uint32_t ctrl;
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    mock_stub_set_dma_channel(0x20001000, 0x50000000, 17, 0x00208011);
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_hits());
+    TEST_ASSERT_FALSE(mock_stub_is_dma_in_reset());
+    mock_stub_get_dma_channel(&read, &write, &count, &ctrl);
+    TEST_ASSERT_EQUAL_HEX32(0x20001000, read);
+    TEST_ASSERT_EQUAL_HEX32(0x50000000, write);
+    TEST_ASSERT_EQUAL_UINT32(17, count);
+    TEST_ASSERT_EQUAL_HEX32(0x00208011, ctrl);
+    TEST_ASSERT_EQUAL_HEX32(0, mock_stub_get_sniff_ctrl());
+}
+
+void test_stub_check_waits_for_dma(void)
+{
+    // Objective: the check does not take the DMA channel while the application uses it
+    uint32_t read;
+    uint32_t write;
+    uint32_t count;
+    uint32_t ctrl;
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    mock_stub_set_dma_channel(0x20001000, 0x50000000, 17, 0x00208011);
+    mock_stub_set_dma_busy(5);
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_hits());
+    mock_stub_get_dma_channel(&read, &write, &count, &ctrl);
+    TEST_ASSERT_EQUAL_HEX32(0x20001000, read);
+    TEST_ASSERT_EQUAL_UINT32(17, count);
+    // busy all the time -> no check, upload
+    mock_stub_set_dma_busy(STUB_MAX_POLLS);
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_hits());
+    TEST_ASSERT_EQUAL_UINT32(2, stub_residency_get_num_uploads());
+    mock_stub_get_dma_channel(&read, &write, &count, &ctrl);
+    TEST_ASSERT_EQUAL_HEX32(0x20001000, read);
+}
+
+void test_stub_bss_is_cleared(void)
+{
+    // Objective: the .bss behind the code is zero before each call, resident or not
+    stub_residency_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    uint32_t round;
+
+    for(round = 0; round < 2; round++)
+    {
+        for(i = 0; i < 40; i++)
+        {
+            mock_stub_set_ram_byte(ADDRESS_A + sizeof(stub_a) + i, 0xaa);
+        }
+        state.first_call = true;
+        res = ERR_NOT_COMPLETED;
+        for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+        {
+            res = stub_residency_ensure(&state, 1, stub_a, sizeof(stub_a), 36, ADDRESS_A);
+        }
+        TEST_ASSERT_EQUAL(RESULT_OK, res);
+        for(i = 0; i < 36; i++)
+        {
+            TEST_ASSERT_EQUAL_HEX8(0, mock_stub_get_ram_byte(ADDRESS_A + sizeof(stub_a) + i));
+        }
+        TEST_ASSERT_EQUAL_HEX8(0xaa, mock_stub_get_ram_byte(ADDRESS_A + sizeof(stub_a) + 36));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_uploads());
+    TEST_ASSERT_EQUAL_UINT32(1, stub_residency_get_num_hits());
+}
+
+static Result call(uint32_t entry_address, uint32_t stack_top)
+{
+    stub_call_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = stub_residency_call(&state, entry_address, stack_top);
+    }
+    return res;
+}
+
+void test_stub_call(void)
+{
+    // Objective: the stub runs from the address where it is resident, on the given stack, without interrupts
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, call(ADDRESS_A + 0x11, 0x20041f04));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_stub_get_num_calls());
+    TEST_ASSERT_EQUAL_HEX32(ADDRESS_A + 0x10, mock_stub_get_call_register(REGSEL_PC));
+    TEST_ASSERT_EQUAL_HEX32(0x01000000, mock_stub_get_call_register(REGSEL_XPSR));
+    // the stack must be 8 byte aligned
+    TEST_ASSERT_EQUAL_HEX32(0x20041f00, mock_stub_get_call_register(REGSEL_SP));
+    TEST_ASSERT_TRUE(mock_stub_call_was_masked());
+    TEST_ASSERT_FALSE(mock_stub_get_maskints_error());
+    // interrupts of the application are not masked after the call
+    TEST_ASSERT_FALSE(mock_stub_is_maskints());
+}
+
+void test_stub_call_restores_registers(void)
+{
+    // Objective: the application continues with its registers after the call
+    uint32_t i;
+    for(i = 0; i < 21; i++)
+    {
+        mock_stub_set_core_register(i, 0x1000 + i);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, ensure(1, stub_a, sizeof(stub_a), ADDRESS_A));
+    TEST_ASSERT_EQUAL(RESULT_OK, call(ADDRESS_A + 0x10, 0x20041f04));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_stub_get_num_calls());
+    for(i = 0; i < 21; i++)
+    {
+        if(19 != i)
+        {
+            TEST_ASSERT_EQUAL_HEX32(0x1000 + i, mock_stub_get_core_register(i));
+        }
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stub_crc32);
+    RUN_TEST(test_stub_first_use_uploads);
+    RUN_TEST(test_stub_resident_is_not_uploaded_again);
+    RUN_TEST(test_stub_overwritten_is_uploaded_again);
+    RUN_TEST(test_stub_two_stubs);
+    RUN_TEST(test_stub_same_place);
+    RUN_TEST(test_stub_forget_all);
+    RUN_TEST(test_stub_check_restores_dma);
+    RUN_TEST(test_stub_check_waits_for_dma);
+    RUN_TEST(test_stub_bss_is_cleared);
+    RUN_TEST(test_stub_call);
+    RUN_TEST(test_stub_call_restores_registers);
+    return UNITY_END();
+}
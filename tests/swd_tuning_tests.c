@@ -0,0 +1,132 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "swd_tuning.h"
+#include "mock/mock_swd_target.h"
+
+#define MAX_CALLS  10000
+
+static Result run_tuning(void)
+{
+    swd_tuning_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = swd_tuning_run(&state);
+    }
+    return res;
+}
+
+void setUp(void)
+{
+    mock_swd_init();
+    swd_tuning_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_swd_tuning_default(void)
+{
+    // Objective: without tuning and configuration the default clock is used
+    TEST_ASSERT_EQUAL_UINT32(SWD_TUNING_DEFAULT_KHZ, swd_tuning_get_khz());
+    swd_tuning_set_configured_khz(4000);
+    TEST_ASSERT_EQUAL_UINT32(4000, swd_tuning_get_khz());
+    // the configured clock is used at once
+    TEST_ASSERT_EQUAL_UINT32(4000, mock_swd_get_clock_khz());
+}
+
+void test_swd_tuning_margin(void)
+{
+    // Objective: the result is one step below the fastest working clock
+    mock_swd_set_max_error_free_khz(12500);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_tuning());
+    TEST_ASSERT_EQUAL_UINT32(10000, swd_tuning_get_khz());
+    TEST_ASSERT_EQUAL_UINT32(10000, mock_swd_get_clock_khz());
+}
+
+void test_swd_tuning_corrupted_data(void)
+{
+    // Objective: reads without error but with wrong values also end the search
+    mock_swd_set_max_correct_data_khz(4000);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_tuning());
+    TEST_ASSERT_EQUAL_UINT32(2000, swd_tuning_get_khz());
+}
+
+void test_swd_tuning_all_clocks_work(void)
+{
+    // Objective: the margin also applies if the fastest clock works
+    TEST_ASSERT_EQUAL(RESULT_OK, run_tuning());
+    TEST_ASSERT_EQUAL_UINT32(20000, swd_tuning_get_khz());
+}
+
+void test_swd_tuning_no_clock_works(void)
+{
+    // Objective: if nothing works the old clock is restored
+    swd_tuning_set_configured_khz(6000);
+    mock_swd_set_max_error_free_khz(0);
+    TEST_ASSERT_EQUAL(ERR_TARGET_ERROR, run_tuning());
+    TEST_ASSERT_EQUAL_UINT32(6000, swd_tuning_get_khz());
+    TEST_ASSERT_EQUAL_UINT32(6000, mock_swd_get_clock_khz());
+}
+
+void test_swd_tuning_verification_fails(void)
+{
+    // Objective: if the verification fails the next slower clock is used
+    // 7 steps with 32 good reads, then the first read at 15000 kHz fails.
+    // The verification at 10000kHz starts with read 226.
+    mock_swd_set_max_error_free_khz(12500);
+    mock_swd_set_failing_read(230);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_tuning());
+    TEST_ASSERT_EQUAL_UINT32(8000, swd_tuning_get_khz());
+    TEST_ASSERT_EQUAL_UINT32(8000, mock_swd_get_clock_khz());
+    // the errors of the search step and of the verification were cleared
+    TEST_ASSERT_EQUAL_UINT32(2, mock_swd_get_num_recoveries());
+}
+
+void test_swd_tuning_ini_section(void)
+{
+    // Objective: the [swd] section contains the clock, too small buffers are handled
+    char buf[40];
+    uint32_t len;
+    mock_swd_set_max_error_free_khz(10000);
+    TEST_ASSERT_EQUAL(RESULT_OK, run_tuning());
+    len = swd_tuning_get_ini_section(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("[swd]\r\nswclk_khz = 8000\r\n", buf);
+    TEST_ASSERT_EQUAL_UINT32(25, len);
+    len = swd_tuning_get_ini_section(buf, 10);
+    TEST_ASSERT_EQUAL_STRING("[swd]\r\nsw", buf);
+    TEST_ASSERT_EQUAL_UINT32(9, len);
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_swd_tuning_default);
+    RUN_TEST(test_swd_tuning_margin);
+    RUN_TEST(test_swd_tuning_corrupted_data);
+    RUN_TEST(test_swd_tuning_all_clocks_work);
+    RUN_TEST(test_swd_tuning_no_clock_works);
+    RUN_TEST(test_swd_tuning_verification_fails);
+    RUN_TEST(test_swd_tuning_ini_section);
+    return UNITY_END();
+}
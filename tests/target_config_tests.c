@@ -0,0 +1,127 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "target_config.h"
+#include "ram_planner.h"
+#include "region_cache.h"
+#include "rtos.h"
+#include "swd_tuning.h"
+#include "mock/mock_swd_target.h"
+
+#define MAX_CALLS  10000
+
+void setUp(void)
+{
+    mock_swd_init();
+    swd_tuning_init();
+    ram_planner_init();
+    region_cache_init();
+    rtos_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_target_config_swd(void)
+{
+    // Objective: [swd] swclk_khz sets the SWD clock
+    TEST_ASSERT_TRUE(target_config_set("swd", "swclk_khz", "8000"));
+    TEST_ASSERT_EQUAL_UINT32(8000, swd_tuning_get_khz());
+    TEST_ASSERT_EQUAL_UINT32(8000, mock_swd_get_clock_khz());
+    TEST_ASSERT_TRUE(target_config_set("swd", "swclk_khz", "0xfa0"));
+    TEST_ASSERT_EQUAL_UINT32(4000, mock_swd_get_clock_khz());
+}
+
+void test_target_config_cache(void)
+{
+    // Objective: [cache] budget limits the region cache
+    TEST_ASSERT_TRUE(target_config_set("cache", "budget", "1024"));
+    TEST_ASSERT_EQUAL_UINT32(1024, region_cache_get_budget());
+    TEST_ASSERT_TRUE(target_config_set("cache", "budget", "0"));
+    TEST_ASSERT_EQUAL_UINT32(0, region_cache_get_budget());
+}
+
+void test_target_config_scratch(void)
+{
+    // Objective: the [scratch] keys set the region of the RAM planner
+    uint32_t start = 0;
+    TEST_ASSERT_TRUE(target_config_set("scratch", "start", "0x20030000"));
+    TEST_ASSERT_TRUE(target_config_set("scratch", "size", "4096"));
+    TEST_ASSERT_TRUE(target_config_set("scratch", "save", "no"));
+    TEST_ASSERT_TRUE(target_config_set("scratch", "save_budget", "1024"));
+    TEST_ASSERT_EQUAL_UINT32(1024, ram_planner_get_save_budget());
+    // larger than the save budget, but nothing needs to be saved
+    TEST_ASSERT_EQUAL(RESULT_OK, ram_planner_reserve(2048, &start));
+    TEST_ASSERT_EQUAL_HEX32(0x20030000, start);
+    ram_planner_release();
+}
+
+void test_target_config_rtos(void)
+{
+    // Objective: the [rtos] keys are known
+    TEST_ASSERT_TRUE(target_config_set("rtos", "max_priorities", "7"));
+    TEST_ASSERT_TRUE(target_config_set("rtos", "name_offset", "0x34"));
+}
+
+void test_target_config_invalid(void)
+{
+    // Objective: unknown keys and invalid values are rejected
+    TEST_ASSERT_FALSE(target_config_set("swd", "clock", "8000"));
+    TEST_ASSERT_FALSE(target_config_set("network", "swclk_khz", "8000"));
+    TEST_ASSERT_FALSE(target_config_set("swd", "swclk_khz", "8MHz"));
+    TEST_ASSERT_FALSE(target_config_set("swd", "swclk_khz", ""));
+    TEST_ASSERT_FALSE(target_config_set("swd", "swclk_khz", "0x"));
+    TEST_ASSERT_FALSE(target_config_set(NULL, "swclk_khz", "8000"));
+    TEST_ASSERT_EQUAL_UINT32(SWD_TUNING_DEFAULT_KHZ, swd_tuning_get_khz());
+}
+
+void test_target_config_changed(void)
+{
+    // Objective: the tuned SWD clock is reported as changed setting
+    char buf[40];
+    swd_tuning_data_typ state;
+    Result res = ERR_NOT_COMPLETED;
+    uint32_t i;
+
+    TEST_ASSERT_TRUE(target_config_set("swd", "swclk_khz", "4000"));
+    TEST_ASSERT_EQUAL_UINT32(0, target_config_get_changed(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("", buf);
+    mock_swd_set_max_error_free_khz(10000);
+    state.first_call = true;
+    for(i = 0; (i < MAX_CALLS) && (ERR_NOT_COMPLETED == res); i++)
+    {
+        res = swd_tuning_run(&state);
+    }
+    TEST_ASSERT_EQUAL(RESULT_OK, res);
+    TEST_ASSERT_EQUAL_UINT32(25, target_config_get_changed(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("[swd]\r\nswclk_khz = 8000\r\n", buf);
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_target_config_swd);
+    RUN_TEST(test_target_config_cache);
+    RUN_TEST(test_target_config_scratch);
+    RUN_TEST(test_target_config_rtos);
+    RUN_TEST(test_target_config_invalid);
+    RUN_TEST(test_target_config_changed);
+    return UNITY_END();
+}
@@ -21,11 +21,13 @@ TEST_EXECUTEABLES = $(TEST_BIN_FOLDER)rp2040
 RP2040_OBJS =                                                          \
  $(TEST_BIN_FOLDER)rp2040_tests.o                                      \
  $(TEST_BIN_FOLDER)source/rp2040.o                                     \
+ $(TEST_BIN_FOLDER)source/time_critical.o                              \
  $(TEST_BIN_FOLDER)mock/mock_flash_driver.o                            \
  $(TEST_BIN_FOLDER)mock/mock_flash_write_buffer.o                      \
  $(TEST_BIN_FOLDER)mock/mock_hex.o                                     \
  $(TEST_BIN_FOLDER)mock/mock_steps.o                                   \
  $(TEST_BIN_FOLDER)mock/mock_cortex-m_actions.o                        \
+ $(TEST_BIN_FOLDER)mock/mock_tick_budget.o                             \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/gdbserver/gdbserver_mock.o \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
  $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
@@ -39,12 +41,262 @@ RP2040_FLASH_DRIVER_OBJS =                                             \
  $(TEST_BIN_FOLDER)source/rp2040_flash_driver.o                        \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
  $(TEST_BIN_FOLDER)mock/flash_actions_mock.o                           \
+ $(TEST_BIN_FOLDER)mock/mock_tick_budget.o                             \
  $(TEST_BIN_FOLDER)mock/mock_flash_write_buffer.o                      \
  $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o      \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/gdbserver/gdbserver_mock.o \
  $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/target/common_mock.o
 
+# deferred_log
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)deferred_log
+DEFERRED_LOG_OBJS =                                                    \
+ $(TEST_BIN_FOLDER)deferred_log_tests.o                                \
+ $(TEST_BIN_FOLDER)source/deferred_log.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# loop_monitor
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)loop_monitor
+LOOP_MONITOR_OBJS =                                                    \
+ $(TEST_BIN_FOLDER)loop_monitor_tests.o                                \
+ $(TEST_BIN_FOLDER)source/loop_monitor.o                               \
+ $(TEST_BIN_FOLDER)mock/mock_time_us.o                                 \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+# the loop monitor is only compiled in with LOOP_MONITOR
+$(TEST_BIN_FOLDER)loop_monitor_tests.o $(TEST_BIN_FOLDER)source/loop_monitor.o: TST_DDEFS += -DLOOP_MONITOR=1
+
+# tick_budget
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)tick_budget
+TICK_BUDGET_OBJS =                                                     \
+ $(TEST_BIN_FOLDER)tick_budget_tests.o                                 \
+ $(TEST_BIN_FOLDER)source/tick_budget.o                                \
+ $(TEST_BIN_FOLDER)mock/mock_time_us.o
+
+# qspi_program
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)qspi_program
+QSPI_PROGRAM_OBJS =                                                    \
+ $(TEST_BIN_FOLDER)qspi_program_tests.o                                \
+ $(TEST_BIN_FOLDER)source/qspi_program.o                               \
+ $(TEST_BIN_FOLDER)source/flash_actions.o                              \
+ $(TEST_BIN_FOLDER)mock/mock_qspi_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_tick_budget.o                             \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+# test the clock boost, XIP cache staging and pipelined programs
+$(TEST_BIN_FOLDER)qspi_program_tests.o $(TEST_BIN_FOLDER)source/flash_actions.o: TST_DDEFS += -DFEAT_TARGET_CLOCK_BOOST -DFEAT_XIP_CACHE_STAGING -DFEAT_PIPELINED_FLASH -DFEAT_ERASE_SUSPEND
+
+# spsc_ring
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)spsc_ring
+SPSC_RING_OBJS =                                                       \
+ $(TEST_BIN_FOLDER)spsc_ring_tests.o                                   \
+ $(TEST_BIN_FOLDER)source/spsc_ring.o
+
+# swd_tuning
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)swd_tuning
+SWD_TUNING_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)swd_tuning_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/swd_tuning.o                                 \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)mock/mock_swd_target.o                              \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# text_util
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)text_util
+TEXT_UTIL_OBJS =                                                       \
+ $(TEST_BIN_FOLDER)text_util_tests.o                                   \
+ $(TEST_BIN_FOLDER)source/text_util.o
+
+# target_config
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)target_config
+TARGET_CONFIG_OBJS =                                                   \
+ $(TEST_BIN_FOLDER)target_config_tests.o                               \
+ $(TEST_BIN_FOLDER)source/target_config.o                              \
+ $(TEST_BIN_FOLDER)source/swd_tuning.o                                 \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)source/region_cache.o                               \
+ $(TEST_BIN_FOLDER)source/ram_planner.o                                \
+ $(TEST_BIN_FOLDER)source/rtos.o                                       \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)source/block_write.o                                \
+ $(TEST_BIN_FOLDER)mock/mock_steps.o                                   \
+ $(TEST_BIN_FOLDER)mock/mock_swd_target.o                              \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+$(TEST_BIN_FOLDER)target_config_tests.o $(TEST_BIN_FOLDER)source/target_config.o: TST_DDEFS += -DFEAT_SWD_TUNING -DFEAT_REGION_CACHE -DFEAT_RTOS -DFEAT_EXECUTE_CODE_ON_TARGET
+
+# stub_residency
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)stub_residency
+STUB_RESIDENCY_OBJS =                                                  \
+ $(TEST_BIN_FOLDER)stub_residency_tests.o                              \
+ $(TEST_BIN_FOLDER)source/stub_residency.o                             \
+ $(TEST_BIN_FOLDER)source/block_write.o                                \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_stub_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# ram_planner
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)ram_planner
+RAM_PLANNER_OBJS =                                                     \
+ $(TEST_BIN_FOLDER)ram_planner_tests.o                                 \
+ $(TEST_BIN_FOLDER)source/ram_planner.o                                \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)source/block_write.o                                \
+ $(TEST_BIN_FOLDER)mock/mock_stub_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# region_cache
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)region_cache
+REGION_CACHE_OBJS =                                                    \
+ $(TEST_BIN_FOLDER)region_cache_tests.o                                \
+ $(TEST_BIN_FOLDER)source/region_cache.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# halt_cache
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)halt_cache
+HALT_CACHE_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)halt_cache_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/halt_cache.o                                 \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)mock/mock_stub_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# range_step
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)range_step
+RANGE_STEP_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)range_step_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/range_step.o                                 \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# agent_expr
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)agent_expr
+AGENT_EXPR_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)agent_expr_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/agent_expr.o                                 \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# cond_breakpoint
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)cond_breakpoint
+COND_BREAKPOINT_OBJS =                                                 \
+ $(TEST_BIN_FOLDER)cond_breakpoint_tests.o                             \
+ $(TEST_BIN_FOLDER)source/cond_breakpoint.o                            \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)source/agent_expr.o                                 \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# tracepoint
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)tracepoint
+TRACEPOINT_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)tracepoint_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/tracepoint.o                                 \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)source/agent_expr.o                                 \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# dual_core
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)dual_core
+DUAL_CORE_OBJS =                                                       \
+ $(TEST_BIN_FOLDER)dual_core_tests.o                                   \
+ $(TEST_BIN_FOLDER)source/dual_core.o                                  \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)mock/mock_dual_core_target.o                        \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# rtos
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)rtos
+RTOS_OBJS =                                                            \
+ $(TEST_BIN_FOLDER)rtos_tests.o                                        \
+ $(TEST_BIN_FOLDER)source/rtos.o                                       \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# live_watch
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)live_watch
+LIVE_WATCH_OBJS =                                                      \
+ $(TEST_BIN_FOLDER)live_watch_tests.o                                  \
+ $(TEST_BIN_FOLDER)source/live_watch.o                                 \
+ $(TEST_BIN_FOLDER)source/spsc_ring.o                                  \
+ $(TEST_BIN_FOLDER)source/text_util.o                                  \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)mock/mock_time_us.o                                 \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# rtt
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)rtt
+RTT_OBJS =                                                             \
+ $(TEST_BIN_FOLDER)rtt_tests.o                                         \
+ $(TEST_BIN_FOLDER)source/rtt.o                                        \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)mock/mock_time_us.o                                 \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
+# semihosting
+TEST_EXECUTEABLES += $(TEST_BIN_FOLDER)semihosting
+SEMIHOSTING_OBJS =                                                     \
+ $(TEST_BIN_FOLDER)semihosting_tests.o                                 \
+ $(TEST_BIN_FOLDER)source/semihosting.o                                \
+ $(TEST_BIN_FOLDER)source/block_read.o                                 \
+ $(TEST_BIN_FOLDER)source/cortex_m_debug.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_core_target.o                             \
+ $(TEST_BIN_FOLDER)mock/mock_read_fifo.o                               \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/lib/printf_mock.o          \
+ $(TEST_BIN_FOLDER)nomagic_probe/src/lib/printf.o                      \
+ $(TEST_BIN_FOLDER)nomagic_probe/tests/mock/hal/hw_divider_mock.o
+
 
 TEST_LOGS = $(patsubst %,%.txt, $(TEST_EXECUTEABLES))
 
@@ -107,6 +359,132 @@ $(TEST_BIN_FOLDER)rp2040_flash_driver: $(RP2040_FLASH_DRIVER_OBJS) $(FRAMEWORK_O
 	@echo "============================"
 	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)rp2040_flash_driver $(RP2040_FLASH_DRIVER_OBJS) $(FRAMEWORK_OBJS)
 
+$(TEST_BIN_FOLDER)deferred_log: $(DEFERRED_LOG_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: deferred_log"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)deferred_log $(DEFERRED_LOG_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)loop_monitor: $(LOOP_MONITOR_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: loop_monitor"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)loop_monitor $(LOOP_MONITOR_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)tick_budget: $(TICK_BUDGET_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: tick_budget"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)tick_budget $(TICK_BUDGET_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)qspi_program: $(QSPI_PROGRAM_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: qspi_program"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)qspi_program $(QSPI_PROGRAM_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)spsc_ring: $(SPSC_RING_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: spsc_ring"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)spsc_ring $(SPSC_RING_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)swd_tuning: $(SWD_TUNING_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: swd_tuning"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)swd_tuning $(SWD_TUNING_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)text_util: $(TEXT_UTIL_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: text_util"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)text_util $(TEXT_UTIL_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)target_config: $(TARGET_CONFIG_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: target_config"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)target_config $(TARGET_CONFIG_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)stub_residency: $(STUB_RESIDENCY_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: stub_residency"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)stub_residency $(STUB_RESIDENCY_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)ram_planner: $(RAM_PLANNER_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: ram_planner"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)ram_planner $(RAM_PLANNER_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)region_cache: $(REGION_CACHE_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: region_cache"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)region_cache $(REGION_CACHE_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)halt_cache: $(HALT_CACHE_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: halt_cache"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)halt_cache $(HALT_CACHE_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)range_step: $(RANGE_STEP_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: range_step"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)range_step $(RANGE_STEP_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)agent_expr: $(AGENT_EXPR_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: agent_expr"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)agent_expr $(AGENT_EXPR_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)cond_breakpoint: $(COND_BREAKPOINT_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: cond_breakpoint"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)cond_breakpoint $(COND_BREAKPOINT_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)tracepoint: $(TRACEPOINT_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: tracepoint"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)tracepoint $(TRACEPOINT_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)dual_core: $(DUAL_CORE_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: dual_core"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)dual_core $(DUAL_CORE_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)rtos: $(RTOS_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: rtos"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)rtos $(RTOS_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)live_watch: $(LIVE_WATCH_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: live_watch"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)live_watch $(LIVE_WATCH_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)rtt: $(RTT_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: rtt"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)rtt $(RTT_OBJS) $(FRAMEWORK_OBJS)
+
+$(TEST_BIN_FOLDER)semihosting: $(SEMIHOSTING_OBJS) $(FRAMEWORK_OBJS)
+	@echo ""
+	@echo "linking test: semihosting"
+	@echo "============================"
+	$(TST_LD) $(TST_LFLAGS) -o $(TEST_BIN_FOLDER)semihosting $(SEMIHOSTING_OBJS) $(FRAMEWORK_OBJS)
+
 
 
 
@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "text_util.h"
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_text_parse_hex(void)
+{
+    // Objective: hex numbers are read up to the first other character
+    const char* c = "1aF0,x";
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(text_parse_hex(&c, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x1af0, value);
+    TEST_ASSERT_TRUE(text_expect(&c, ','));
+    TEST_ASSERT_FALSE(text_expect(&c, ','));
+    TEST_ASSERT_FALSE(text_parse_hex(&c, &value));
+    TEST_ASSERT_EQUAL_CHAR('x', *c);
+}
+
+void test_text_parse_hex_byte(void)
+{
+    // Objective: a byte needs two hex digits
+    uint8_t value = 0;
+    TEST_ASSERT_TRUE(text_parse_hex_byte("a5", &value));
+    TEST_ASSERT_EQUAL_HEX8(0xa5, value);
+    TEST_ASSERT_FALSE(text_parse_hex_byte("5", &value));
+    TEST_ASSERT_FALSE(text_parse_hex_byte("g0", &value));
+}
+
+void test_text_add(void)
+{
+    // Objective: numbers are formatted like GDB expects them
+    char buf[32];
+    uint32_t pos;
+    pos = text_add_string(buf, sizeof(buf), 0, "T");
+    pos = text_add_hex_byte(buf, sizeof(buf), pos, 5);
+    pos = text_add_string(buf, sizeof(buf), pos, ";");
+    pos = text_add_hex(buf, sizeof(buf), pos, 0x2000);
+    pos = text_add_string(buf, sizeof(buf), pos, ";");
+    pos = text_add_hex(buf, sizeof(buf), pos, 0);
+    pos = text_add_string(buf, sizeof(buf), pos, ";");
+    pos = text_add_decimal(buf, sizeof(buf), pos, 4000000000u);
+    buf[pos] = 0;
+    TEST_ASSERT_EQUAL_STRING("T05;2000;0;4000000000", buf);
+}
+
+void test_text_add_truncates(void)
+{
+    // Objective: there is always room for the terminating 0
+    char buf[6];
+    uint32_t pos;
+    pos = text_add_string(buf, sizeof(buf), 0, "abcd");
+    pos = text_add_hex_byte(buf, sizeof(buf), pos, 0x12);
+    TEST_ASSERT_EQUAL_UINT32(4, pos);
+    pos = text_add_hex(buf, sizeof(buf), pos, 0x12345678);
+    TEST_ASSERT_EQUAL_UINT32(5, pos);
+    buf[pos] = 0;
+    TEST_ASSERT_EQUAL_STRING("abcd1", buf);
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_parse_hex);
+    RUN_TEST(test_text_parse_hex_byte);
+    RUN_TEST(test_text_add);
+    RUN_TEST(test_text_add_truncates);
+    return UNITY_END();
+}
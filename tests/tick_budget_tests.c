@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include <stdbool.h>
+#include "unity.h"
+#include "tick_budget.h"
+#include "mock/mock_time_us.h"
+
+void setUp(void)
+{
+    set_time_us(0);
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_tick_budget_not_started(void)
+{
+    // Objective: without tick_budget_start() the state machines do one phase per call
+    uint32_t i;
+    // use up any budget left over from a previous test
+    for(i = 0; i < 2 * TICK_BUDGET_PHASES; i++)
+    {
+        tick_budget_continue(ERR_NOT_COMPLETED, 0, 1);
+    }
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_NOT_COMPLETED, 0, 1));
+}
+
+void test_tick_budget_result(void)
+{
+    // Objective: finished or failed state machines stop
+    tick_budget_start();
+    TEST_ASSERT_FALSE(tick_budget_continue(RESULT_OK, 0, 1));
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_WRONG_STATE, 0, 1));
+    TEST_ASSERT_TRUE(tick_budget_continue(ERR_NOT_COMPLETED, 0, 1));
+}
+
+void test_tick_budget_no_progress(void)
+{
+    // Objective: a state machine that waits (phase did not change) yields
+    tick_budget_start();
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_NOT_COMPLETED, 3, 3));
+}
+
+void test_tick_budget_phases(void)
+{
+    // Objective: only TICK_BUDGET_PHASES phases run in one tick
+    uint32_t i;
+    tick_budget_start();
+    for(i = 0; i < TICK_BUDGET_PHASES; i++)
+    {
+        TEST_ASSERT_TRUE(tick_budget_continue(ERR_NOT_COMPLETED, i, i + 1));
+    }
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_NOT_COMPLETED, i, i + 1));
+    // next tick
+    tick_budget_start();
+    TEST_ASSERT_TRUE(tick_budget_continue(ERR_NOT_COMPLETED, 0, 1));
+}
+
+void test_tick_budget_time(void)
+{
+    // Objective: the budget ends when the time is up
+    tick_budget_start();
+    TEST_ASSERT_TRUE(tick_budget_continue(ERR_NOT_COMPLETED, 0, 1));
+    advance_time_us(TICK_BUDGET_US);
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_NOT_COMPLETED, 1, 2));
+    TEST_ASSERT_FALSE(tick_budget_continue(ERR_NOT_COMPLETED, 2, 3));
+}
+
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tick_budget_not_started);
+    RUN_TEST(test_tick_budget_result);
+    RUN_TEST(test_tick_budget_no_progress);
+    RUN_TEST(test_tick_budget_phases);
+    RUN_TEST(test_tick_budget_time);
+    return UNITY_END();
+}
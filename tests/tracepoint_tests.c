@@ -0,0 +1,239 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "tracepoint.h"
+#include "mock/mock_core_target.h"
+
+#define MAX_CALLS  100000
+#define TP_ADDRESS 0x10000100
+
+static trace_data_typ state;
+static trace_arm_data_typ arm_state;
+static bool resume;
+
+void setUp(void)
+{
+    const uint32_t pcs[] = {TP_ADDRESS, TP_ADDRESS + 2, TP_ADDRESS + 4, TP_ADDRESS + 6, TP_ADDRESS + 8, TP_ADDRESS + 10};
+    mock_core_init();
+    mock_core_set_program(pcs, sizeof(pcs)/sizeof(pcs[0]));
+    trace_init();
+}
+
+void tearDown(void)
+{
+
+}
+
+static Result arm(bool enable)
+{
+    Result res;
+    uint32_t i;
+
+    arm_state.first_call = true;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = trace_arm(&arm_state, enable);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static Result hit(void)
+{
+    Result res;
+    uint32_t i;
+
+    state.first_call = true;
+    resume = false;
+    for(i = 0; i < MAX_CALLS; i++)
+    {
+        res = trace_on_halt(&state, TP_ADDRESS, &resume);
+        if(ERR_NOT_COMPLETED != res)
+        {
+            // the core runs to the tracepoint again
+            mock_core_set_register(15, TP_ADDRESS);
+            mock_core_set_halted(true);
+            return res;
+        }
+    }
+    return ERR_NOT_COMPLETED;
+}
+
+static void start(void)
+{
+    TEST_ASSERT_EQUAL(RESULT_OK, arm(true));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_start());
+}
+
+void test_trace_collect(void)
+{
+    // Objective: registers and memory are collected into a frame and the core runs again
+    uint32_t tracepoint = 0;
+    uint32_t value = 0;
+    uint8_t buf[8];
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("1:10000100:E:0:0-"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("-1:10000100:R2000003M-1,20000012,6"));
+    mock_core_set_register(0, 0x11);
+    mock_core_set_register(1, 0x22);
+    mock_core_set_register(16, 0x61000000);
+    mock_core_set_ram_word(0x20000010, 0x44332211);
+    mock_core_set_ram_word(0x20000014, 0x88776655);
+    mock_core_set_ram_word(0x20000018, 0xccbbaa99);
+    start();
+    TEST_ASSERT_EQUAL_HEX32(FP_COMP_VALUE(TP_ADDRESS), mock_core_get_fp_comp(TRACE_FIRST_COMP));
+
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_core_get_num_steps());
+    TEST_ASSERT_EQUAL_HEX32(FP_COMP_VALUE(TP_ADDRESS), mock_core_get_fp_comp(TRACE_FIRST_COMP));
+    TEST_ASSERT_EQUAL_UINT32(1, trace_get_num_frames());
+
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_select_frame(0, &tracepoint));
+    TEST_ASSERT_EQUAL_UINT32(1, tracepoint);
+    TEST_ASSERT_TRUE(trace_frame_get_register(1, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x22, value);
+    TEST_ASSERT_TRUE(trace_frame_get_register(25, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x61000000, value);
+    TEST_ASSERT_TRUE(trace_frame_get_register(15, &value));
+    TEST_ASSERT_EQUAL_HEX32(TP_ADDRESS, value);
+    TEST_ASSERT_FALSE(trace_frame_get_register(2, &value));
+    TEST_ASSERT_EQUAL_UINT32(6, trace_frame_read_memory(0x20000012, buf, 6));
+    TEST_ASSERT_EQUAL_HEX8(0x33, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x88, buf[5]);
+    TEST_ASSERT_EQUAL_UINT32(0, trace_frame_read_memory(0x20000020, buf, 4));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_select_frame(1, &tracepoint));
+
+    TEST_ASSERT_EQUAL(RESULT_OK, arm(false));
+    TEST_ASSERT_EQUAL_HEX32(0, mock_core_get_fp_comp(TRACE_FIRST_COMP));
+}
+
+void test_trace_condition(void)
+{
+    // Objective: frames are only created when the condition is true
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("1:10000100:E:0:0:X7,26000022051327-"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("-1:10000100:R1"));
+    start();
+    mock_core_set_register(0, 4);
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_EQUAL_UINT32(0, trace_get_num_frames());
+    mock_core_set_register(0, 5);
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_EQUAL_UINT32(1, trace_get_num_frames());
+    TEST_ASSERT_EQUAL_INT32(0, trace_find_frame(TP_ADDRESS, TRACE_NO_FRAME));
+    TEST_ASSERT_EQUAL_INT32(TRACE_NO_FRAME, trace_find_frame(TP_ADDRESS, 0));
+}
+
+void test_trace_pass_count(void)
+{
+    // Objective: tracing stops after "pass" hits, later hits are only stepped over
+    char status[100];
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("3:10000100:E:0:2"));
+    start();
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(trace_is_running());
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_FALSE(trace_is_running());
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_EQUAL_UINT32(2, trace_get_num_frames());
+    trace_get_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL_STRING("T0;tpasscount:3;tframes:2;tcreated:2;tfree:1fe8;tsize:2000;circular:0;disconn:0", status);
+}
+
+void test_trace_buffer_full(void)
+{
+    // Objective: a frame that does not fit ends the tracing, the frames before are kept
+    char status[100];
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("1:10000100:E:0:0-"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("-1:10000100:M-1,20000000,200M-1,20000200,200-"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("-1:10000100:MFFFFFFFF,20000400,200M-1,20000600,200"));
+    start();
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(trace_is_running());
+    TEST_ASSERT_EQUAL(RESULT_OK, hit());
+    TEST_ASSERT_TRUE(resume);
+    TEST_ASSERT_FALSE(trace_is_running());
+    TEST_ASSERT_EQUAL_UINT32(3, trace_get_num_frames());
+    trace_get_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL_STRING_LEN("T0;tfull:0;tframes:3;", status, 21);
+}
+
+void test_trace_define_errors(void)
+{
+    // Objective: unsupported tracepoints are rejected
+    char status[100];
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_define("1:10000100:E:1:0"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_define("-1:10000100:R1"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("1:10000100:E:0:0-"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_define("-1:10000100:X3,220127"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_define("-1:10000100:M-1,20000000,201"));
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("2:10000200:E:0:0"));
+    TEST_ASSERT_EQUAL(ERR_WRONG_VALUE, trace_define("3:10000300:E:0:0"));
+    trace_get_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL_STRING_LEN("T0;tnotrun:0;", status, 13);
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_start());
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, trace_define("3:10000300:E:0:0"));
+    trace_stop();
+    trace_get_status(status, sizeof(status));
+    TEST_ASSERT_EQUAL_STRING_LEN("T0;tstop:0;", status, 11);
+}
+
+void test_trace_arm_comparator_in_use(void)
+{
+    // Objective: comparators that a breakpoint uses are neither taken nor removed
+    const uint32_t breakpoint = FP_COMP_VALUE(0x10000200);
+    TEST_ASSERT_EQUAL(RESULT_OK, trace_define("1:10000100:E:0:0"));
+    mock_core_set_fp_comp(TRACE_FIRST_COMP, breakpoint);
+    TEST_ASSERT_EQUAL(ERR_WRONG_STATE, arm(true));
+    TEST_ASSERT_EQUAL_HEX32(breakpoint, mock_core_get_fp_comp(TRACE_FIRST_COMP));
+    TEST_ASSERT_FALSE(trace_is_comparator_in_use(TRACE_FIRST_COMP));
+    TEST_ASSERT_EQUAL(RESULT_OK, arm(false));
+    TEST_ASSERT_EQUAL_HEX32(breakpoint, mock_core_get_fp_comp(TRACE_FIRST_COMP));
+
+    // the breakpoint is gone -> the tracepoint gets the comparator
+    mock_core_set_fp_comp(TRACE_FIRST_COMP, 0);
+    mock_core_set_fp_comp(TRACE_FIRST_COMP + 1, breakpoint);
+    TEST_ASSERT_EQUAL(RESULT_OK, arm(true));
+    TEST_ASSERT_EQUAL_HEX32(FP_COMP_VALUE(TP_ADDRESS), mock_core_get_fp_comp(TRACE_FIRST_COMP));
+    TEST_ASSERT_TRUE(trace_is_comparator_in_use(TRACE_FIRST_COMP));
+    TEST_ASSERT_FALSE(trace_is_comparator_in_use(TRACE_FIRST_COMP + 1));
+    TEST_ASSERT_EQUAL(RESULT_OK, arm(false));
+    TEST_ASSERT_EQUAL_HEX32(0, mock_core_get_fp_comp(TRACE_FIRST_COMP));
+    TEST_ASSERT_EQUAL_HEX32(breakpoint, mock_core_get_fp_comp(TRACE_FIRST_COMP + 1));
+    TEST_ASSERT_FALSE(trace_is_comparator_in_use(TRACE_FIRST_COMP));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_collect);
+    RUN_TEST(test_trace_condition);
+    RUN_TEST(test_trace_pass_count);
+    RUN_TEST(test_trace_buffer_full);
+    RUN_TEST(test_trace_define_errors);
+    RUN_TEST(test_trace_arm_comparator_in_use);
+    return UNITY_END();
+}